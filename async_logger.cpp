@@ -0,0 +1,219 @@
+#include "async_logger.h"
+#include <errno.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace hft {
+
+namespace {
+
+constexpr size_t WRITE_BATCH_BYTES = 64 * 1024;
+constexpr size_t DRAIN_BATCH = 256;
+constexpr auto IDLE_SLEEP = std::chrono::microseconds(200);
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO ";
+        case LogLevel::WARN:  return "WARN ";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "?????";
+    }
+}
+
+// "YYYY-MM-DD HH:MM:SS" for the second a record falls in; only the writer
+// thread calls this, and consecutive records usually share a second
+void append_wall_time(uint64_t wall_ns, std::string& out) {
+    static time_t cached_second = -1;
+    static char cached_text[32];
+    
+    time_t second = static_cast<time_t>(wall_ns / 1000000000ULL);
+    if (second != cached_second) {
+        struct tm local;
+        localtime_r(&second, &local);
+        strftime(cached_text, sizeof(cached_text), "%Y-%m-%d %H:%M:%S", &local);
+        cached_second = second;
+    }
+    
+    char fraction[16];
+    snprintf(fraction, sizeof(fraction), ".%09llu", static_cast<unsigned long long>(wall_ns % 1000000000ULL));
+    out += cached_text;
+    out += fraction;
+}
+
+} // namespace
+
+AsyncLogger& AsyncLogger::instance() {
+    // Leaked on purpose: threads may still log during static destruction
+    static AsyncLogger* logger = new AsyncLogger();
+    return *logger;
+}
+
+AsyncLogger::AsyncLogger() {
+    writer_ = std::thread(&AsyncLogger::writer_thread, this);
+    writer_.detach();
+}
+
+AsyncLogger::Producer* AsyncLogger::claim_producer() {
+    // Reuse a ring left behind by an exited thread first
+    size_t count = producer_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        Producer* producer = producers_[i].load(std::memory_order_acquire);
+        bool expected = false;
+        if (producer && producer->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return producer;
+        }
+    }
+    
+    size_t index = producer_count_.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= MAX_PRODUCERS) {
+        // Too many concurrent logging threads: this one stays silent
+        producer_count_.fetch_sub(1, std::memory_order_acq_rel);
+        return nullptr;
+    }
+    
+    Producer* producer = new Producer();
+    producer->id = static_cast<uint32_t>(index);
+    producer->in_use.store(true, std::memory_order_relaxed);
+    producers_[index].store(producer, std::memory_order_release);
+    return producer;
+}
+
+void AsyncLogger::flush() {
+    uint64_t ticket = flush_requests_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    while (flushes_done_.load(std::memory_order_acquire) < ticket) {
+        std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+}
+
+void AsyncLogger::writer_thread() {
+    std::string out;
+    out.reserve(WRITE_BATCH_BYTES * 2);
+    
+    while (true) {
+        // Everything pushed before a flush request is visible once we see it
+        uint64_t requested = flush_requests_.load(std::memory_order_acquire);
+        bool worked = drain(out);
+        
+        if (!out.empty()) {
+            write_out(out);
+        }
+        if (!worked) {
+            if (flushes_done_.load(std::memory_order_relaxed) < requested) {
+                flushes_done_.store(requested, std::memory_order_release);
+            }
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+}
+
+bool AsyncLogger::drain(std::string& out) {
+    bool worked = false;
+    size_t count = producer_count_.load(std::memory_order_acquire);
+    
+    for (size_t i = 0; i < count && i < MAX_PRODUCERS; ++i) {
+        Producer* producer = producers_[i].load(std::memory_order_acquire);
+        if (!producer) {
+            continue; // Claimed but not yet published
+        }
+        
+        size_t drained = producer->ring.consume_bulk(
+            [&](const LogRecord& record) { format(record, producer->id, out); }, DRAIN_BATCH);
+        worked |= drained > 0;
+        
+        uint64_t dropped = producer->dropped.load(std::memory_order_relaxed);
+        if (dropped != producer->reported_drops) {
+            out += "[logger] thread ";
+            out += std::to_string(producer->id);
+            out += " dropped ";
+            out += std::to_string(dropped - producer->reported_drops);
+            out += " records (ring full)\n";
+            producer->reported_drops = dropped;
+        }
+        
+        if (out.size() >= WRITE_BATCH_BYTES) {
+            write_out(out);
+        }
+    }
+    
+    return worked;
+}
+
+void AsyncLogger::format(const LogRecord& record, uint32_t thread, std::string& out) const {
+    append_wall_time(TscClock::instance().to_wall_ns(record.timestamp_ns), out);
+    out += ' ';
+    out += level_name(record.site->level);
+    out += " [T";
+    out += std::to_string(thread);
+    out += "] ";
+    
+    const char* p = record.site->format;
+    uint8_t arg = 0;
+    uint8_t slot = 0;
+    char number[32];
+    
+    while (*p) {
+        if (p[0] != '{' || p[1] != '}') {
+            out += *p++;
+            continue;
+        }
+        p += 2;
+        
+        if (arg >= record.arg_count) {
+            out += "{}";
+            continue;
+        }
+        
+        switch (record.types[arg]) {
+            case LogRecord::SIGNED:
+                snprintf(number, sizeof(number), "%lld",
+                         static_cast<long long>(static_cast<int64_t>(record.slots[slot++])));
+                out += number;
+                break;
+            case LogRecord::UNSIGNED:
+                snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(record.slots[slot++]));
+                out += number;
+                break;
+            case LogRecord::DOUBLE: {
+                double value;
+                std::memcpy(&value, &record.slots[slot++], sizeof(value));
+                snprintf(number, sizeof(number), "%.3f", value);
+                out += number;
+                break;
+            }
+            case LogRecord::STRING: {
+                size_t length = record.string_lengths[arg];
+                out.append(reinterpret_cast<const char*>(&record.slots[slot]), length);
+                slot += static_cast<uint8_t>((length + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+                break;
+            }
+        }
+        ++arg;
+    }
+    
+    out += '\n';
+}
+
+void AsyncLogger::write_out(std::string& out) {
+    const char* data = out.data();
+    size_t remaining = out.size();
+    
+    while (remaining > 0) {
+        ssize_t written = write(output_fd_, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // Nowhere to report a failing log sink; drop the batch
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    
+    out.clear();
+}
+
+} // namespace hft
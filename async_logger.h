@@ -0,0 +1,239 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include "lock_free_queue.h"
+#include "tsc_clock.h"
+
+/**
+ * @brief Lowest level compiled in: 0=TRACE 1=DEBUG 2=INFO 3=WARN 4=ERROR
+ *
+ * Log statements below this level are discarded at compile time, arguments
+ * included.
+ */
+#ifndef HFT_LOG_LEVEL
+#define HFT_LOG_LEVEL 2
+#endif
+
+namespace hft {
+
+enum class LogLevel : uint8_t {
+    TRACE = 0,
+    DEBUG = 1,
+    INFO = 2,
+    WARN = 3,
+    ERROR = 4
+};
+
+/**
+ * @brief One log statement: its level and format; lives in static storage
+ *
+ * The format uses {} placeholders, filled in order when the record is
+ * formatted on the logger thread.
+ */
+struct LogSite {
+    LogLevel level;
+    const char* format;
+};
+
+/**
+ * @brief Fixed-size binary record passed from a logging thread to the writer
+ *
+ * Arguments are stored raw. Strings are copied inline into as many slots
+ * as they need, and truncated to whatever slots remain, because the caller's
+ * buffer may not outlive the record.
+ */
+struct alignas(CACHE_LINE_SIZE) LogRecord {
+    enum ArgType : uint8_t { SIGNED, UNSIGNED, DOUBLE, STRING };
+    
+    static constexpr size_t MAX_ARGS = 8;
+    static constexpr size_t MAX_SLOTS = 8;
+    static constexpr size_t MAX_STRING = MAX_SLOTS * sizeof(uint64_t);
+    
+    const LogSite* site;
+    uint64_t timestamp_ns;          // TscClock::now_ns()
+    uint8_t arg_count;
+    uint8_t slot_count;
+    ArgType types[MAX_ARGS];
+    uint8_t string_lengths[MAX_ARGS];
+    uint64_t slots[MAX_SLOTS];
+};
+
+/**
+ * @brief Binary asynchronous logger
+ *
+ * The hot path copies a LogRecord into the calling thread's own SPSC ring
+ * (no locks, no formatting, no syscalls); a background thread drains every
+ * ring, formats the records and writes them in large batches. A full ring
+ * drops the record and counts it rather than stalling the caller; the
+ * writer reports drops. Use through the HFT_LOG_* macros.
+ */
+class AsyncLogger {
+public:
+    static constexpr size_t MAX_PRODUCERS = 64;
+    static constexpr size_t RING_SIZE = 2048;   // Records per thread
+    using Ring = ultra_hft::LockFreeRingBuffer<LogRecord, RING_SIZE>;
+    
+    /**
+     * @brief Process-wide logger; never destroyed so late logs stay safe
+     */
+    static AsyncLogger& instance();
+    
+    /**
+     * @brief Send output to fd (default stdout); call before logging starts
+     */
+    void set_output(int fd) { output_fd_ = fd; }
+    
+    /**
+     * @brief Block until every record queued before the call has been written
+     */
+    void flush();
+    
+    template<typename... Args>
+    void log(const LogSite* site, const Args&... args) {
+        Producer* producer = local_producer();
+        if (!producer) {
+            return;
+        }
+        
+        LogRecord record;
+        record.site = site;
+        record.timestamp_ns = TscClock::instance().now_ns();
+        record.arg_count = 0;
+        record.slot_count = 0;
+        (encode(record, args), ...);
+        
+        if (!producer->ring.push(record)) {
+            producer->dropped.store(producer->dropped.load(std::memory_order_relaxed) + 1,
+                                    std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Producer {
+        Ring ring;
+        std::atomic<uint64_t> dropped{0};
+        uint64_t reported_drops = 0;       // Writer thread only
+        std::atomic<bool> in_use{false};   // Claimed by a live thread
+        uint32_t id = 0;
+    };
+    
+    AsyncLogger();
+    
+    Producer* local_producer() {
+        thread_local ProducerHandle handle;
+        if (!handle.producer) {
+            handle.producer = claim_producer();
+        }
+        return handle.producer;
+    }
+    
+    // Returns the slot to the pool when its thread exits
+    struct ProducerHandle {
+        Producer* producer = nullptr;
+        ~ProducerHandle() {
+            if (producer) {
+                producer->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+    
+    Producer* claim_producer();
+    void writer_thread();
+    bool drain(std::string& out);
+    void format(const LogRecord& record, uint32_t thread, std::string& out) const;
+    void write_out(std::string& out);
+    
+    template<typename T>
+    static void encode(LogRecord& record, const T& value) {
+        if (record.arg_count == LogRecord::MAX_ARGS || record.slot_count == LogRecord::MAX_SLOTS) {
+            return;
+        }
+        
+        uint8_t arg = record.arg_count;
+        if constexpr (std::is_same_v<T, bool>) {
+            record.types[arg] = LogRecord::UNSIGNED;
+            record.slots[record.slot_count++] = value ? 1 : 0;
+        } else if constexpr (std::is_enum_v<T>) {
+            record.types[arg] = LogRecord::SIGNED;
+            record.slots[record.slot_count++] = static_cast<uint64_t>(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            record.types[arg] = LogRecord::SIGNED;
+            record.slots[record.slot_count++] = static_cast<uint64_t>(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<T>) {
+            record.types[arg] = LogRecord::UNSIGNED;
+            record.slots[record.slot_count++] = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            record.types[arg] = LogRecord::DOUBLE;
+            double d = static_cast<double>(value);
+            std::memcpy(&record.slots[record.slot_count++], &d, sizeof(d));
+        } else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) {
+            // Fixed char fields such as symbols need not be NUL-terminated
+            encode_string(record, arg, value, strnlen(value, std::extent_v<T>));
+        } else if constexpr (is_char_array<T>::value) {
+            encode_string(record, arg, value.data(), strnlen(value.data(), value.size()));
+        } else if constexpr (std::is_pointer_v<T> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>) {
+            if (value) {
+                std::string_view text(value);
+                encode_string(record, arg, text.data(), text.size());
+            } else {
+                encode_string(record, arg, "(null)", 6);
+            }
+        } else {
+            static_assert(std::is_convertible_v<const T&, std::string_view>, "Unsupported log argument type");
+            std::string_view text(value);
+            encode_string(record, arg, text.data(), text.size());
+        }
+        record.arg_count = arg + 1;
+    }
+    
+    template<typename T>
+    struct is_char_array : std::false_type {};
+    template<size_t N>
+    struct is_char_array<std::array<char, N>> : std::true_type {};
+
+    static void encode_string(LogRecord& record, uint8_t arg, const char* text, size_t length) {
+        size_t room = (LogRecord::MAX_SLOTS - record.slot_count) * sizeof(uint64_t);
+        if (length > room) {
+            length = room;
+        }
+        record.types[arg] = LogRecord::STRING;
+        record.string_lengths[arg] = static_cast<uint8_t>(length);
+        std::memcpy(&record.slots[record.slot_count], text, length);
+        record.slot_count += static_cast<uint8_t>((length + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    }
+    
+    // Allocated on first use by a thread and reused once that thread exits
+    std::atomic<Producer*> producers_[MAX_PRODUCERS] = {};
+    std::atomic<size_t> producer_count_{0};
+    std::atomic<uint64_t> flush_requests_{0};
+    std::atomic<uint64_t> flushes_done_{0};
+    int output_fd_ = 1;
+    std::thread writer_;
+};
+
+} // namespace hft
+
+#define HFT_LOG(level, fmt, ...)                                                        \
+    do {                                                                                \
+        if constexpr (static_cast<int>(level) >= HFT_LOG_LEVEL) {                       \
+            static constexpr ::hft::LogSite hft_log_site{level, fmt};                   \
+            ::hft::AsyncLogger::instance().log(&hft_log_site, ##__VA_ARGS__);           \
+        }                                                                               \
+    } while (0)
+
+#define HFT_LOG_TRACE(fmt, ...) HFT_LOG(::hft::LogLevel::TRACE, fmt, ##__VA_ARGS__)
+#define HFT_LOG_DEBUG(fmt, ...) HFT_LOG(::hft::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define HFT_LOG_INFO(fmt, ...) HFT_LOG(::hft::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define HFT_LOG_WARN(fmt, ...) HFT_LOG(::hft::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define HFT_LOG_ERROR(fmt, ...) HFT_LOG(::hft::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+
+#endif // ASYNC_LOGGER_H
@@ -91,8 +91,8 @@ set_compiler_flags() {
     # Include directories
     INCLUDES="-I."
     
-    # Linker flags
-    LDFLAGS="-pthread"
+    # Linker flags; -z now binds every symbol at load, not on its first call
+    LDFLAGS="-pthread -Wl,-z,now"
     
     print_success "Compiler flags set: $CXXFLAGS"
 }
@@ -103,7 +103,8 @@ build_hft_server() {
     
     g++ $CXXFLAGS $INCLUDES \
         -o build/bin/hft_server \
-        main.cpp hft_server.cpp \
+        main.cpp hft_server.cpp order_book.cpp instrument_directory.cpp session.cpp config_file.cpp metrics_segment.cpp risk_engine.cpp journal.cpp async_logger.cpp market_data_fanout.cpp multicast_feed.cpp \
+        transport.cpp io_uring_transport.cpp warmup.cpp \
         $LDFLAGS
     
     if [ $? -eq 0 ]; then
@@ -121,7 +122,8 @@ build_ultra_hft_server() {
     
     g++ $CXXFLAGS $INCLUDES \
         -o build/bin/ultra_hft_server \
-        ultra_main.cpp ultra_hft_server.cpp \
+        ultra_main.cpp ultra_hft_server.cpp order_book.cpp instrument_directory.cpp session.cpp config_file.cpp numa_memory.cpp metrics_segment.cpp risk_engine.cpp journal.cpp async_logger.cpp market_data_fanout.cpp multicast_feed.cpp \
+        transport.cpp io_uring_transport.cpp warmup.cpp \
         $LDFLAGS
     
     if [ $? -eq 0 ]; then
@@ -133,6 +135,24 @@ build_ultra_hft_server() {
     fi
 }
 
+# Build metrics_exporter
+build_metrics_exporter() {
+    print_info "Building metrics_exporter..."
+    
+    g++ $CXXFLAGS $INCLUDES \
+        -o build/bin/metrics_exporter \
+        metrics_exporter.cpp metrics_segment.cpp \
+        $LDFLAGS
+    
+    if [ $? -eq 0 ]; then
+        print_success "metrics_exporter built successfully"
+        print_info "Size: $(du -h build/bin/metrics_exporter | cut -f1)"
+    else
+        print_error "Failed to build metrics_exporter"
+        exit 1
+    fi
+}
+
 # Build test_client
 build_test_client() {
     print_info "Building test_client..."
@@ -169,6 +189,43 @@ build_ultra_test_client() {
     fi
 }
 
+# Build queue_benchmark
+build_queue_benchmark() {
+    print_info "Building queue_benchmark (ring buffer microbenchmark)..."
+    
+    g++ $CXXFLAGS $INCLUDES \
+        -o build/bin/queue_benchmark \
+        queue_benchmark.cpp \
+        $LDFLAGS
+    
+    if [ $? -eq 0 ]; then
+        print_success "queue_benchmark built successfully"
+        print_info "Size: $(du -h build/bin/queue_benchmark | cut -f1)"
+    else
+        print_error "Failed to build queue_benchmark"
+        exit 1
+    fi
+}
+
+# Build hot_path_benchmark
+build_hot_path_benchmark() {
+    print_info "Building hot_path_benchmark (per-component microbenchmarks)..."
+    
+    g++ $CXXFLAGS $INCLUDES \
+        -o build/bin/hot_path_benchmark \
+        hot_path_benchmark.cpp hft_server.cpp ultra_hft_server.cpp order_book.cpp instrument_directory.cpp session.cpp numa_memory.cpp metrics_segment.cpp risk_engine.cpp journal.cpp \
+        async_logger.cpp market_data_fanout.cpp multicast_feed.cpp transport.cpp io_uring_transport.cpp warmup.cpp \
+        $LDFLAGS
+    
+    if [ $? -eq 0 ]; then
+        print_success "hot_path_benchmark built successfully"
+        print_info "Size: $(du -h build/bin/hot_path_benchmark | cut -f1)"
+    else
+        print_error "Failed to build hot_path_benchmark"
+        exit 1
+    fi
+}
+
 # Verify build results
 verify_build() {
     print_info "Verifying build results..."
@@ -200,6 +257,27 @@ verify_build() {
         print_error "ultra_test_client executable not found or not executable"
         exit 1
     fi
+    
+    if [ -f "build/bin/metrics_exporter" ] && [ -x "build/bin/metrics_exporter" ]; then
+        print_success "metrics_exporter executable verified"
+    else
+        print_error "metrics_exporter executable not found or not executable"
+        exit 1
+    fi
+    
+    if [ -f "build/bin/queue_benchmark" ] && [ -x "build/bin/queue_benchmark" ]; then
+        print_success "queue_benchmark executable verified"
+    else
+        print_error "queue_benchmark executable not found or not executable"
+        exit 1
+    fi
+    
+    if [ -f "build/bin/hot_path_benchmark" ] && [ -x "build/bin/hot_path_benchmark" ]; then
+        print_success "hot_path_benchmark executable verified"
+    else
+        print_error "hot_path_benchmark executable not found or not executable"
+        exit 1
+    fi
 }
 
 # Test executables
@@ -244,8 +322,11 @@ show_summary() {
     print_success "✓ Compiler flags configured"
     print_success "✓ hft_server built successfully"
     print_success "✓ ultra_hft_server built successfully"
+    print_success "✓ metrics_exporter built successfully"
     print_success "✓ test_client built successfully"
     print_success "✓ ultra_test_client built successfully"
+    print_success "✓ queue_benchmark built successfully"
+    print_success "✓ hot_path_benchmark built successfully"
     print_success "✓ Executables verified"
     print_success "✓ Basic tests passed"
     echo ""
@@ -253,8 +334,11 @@ show_summary() {
     print_info "You can now run:"
     echo "  ./build/bin/hft_server --port 9999 --threads 4"
     echo "  ./build/bin/ultra_hft_server --port 9999 --threads 8"
+    echo "  ./build/bin/metrics_exporter --segment hft-ultra --listen 9464"
     echo "  ./build/bin/test_client --mode comprehensive"
     echo "  ./build/bin/ultra_test_client --mode latency --count 10000"
+    echo "  ./build/bin/queue_benchmark --items 10000000 --producer-cpus 2 --consumer-cpus 3"
+    echo "  ./build/bin/hot_path_benchmark --cpu 2 --pairs 2:3,2:6 --json hot_path.json"
     echo ""
     print_info "Ultra HFT Server Features:"
     echo "  • Lock-free queues for maximum performance"
@@ -304,8 +388,11 @@ main() {
     set_compiler_flags
     build_hft_server
     build_ultra_hft_server
+    build_metrics_exporter
     build_test_client
     build_ultra_test_client
+    build_queue_benchmark
+    build_hot_path_benchmark
     verify_build
     test_executables
     show_compiler_info
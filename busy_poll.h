@@ -0,0 +1,89 @@
+#ifndef BUSY_POLL_H
+#define BUSY_POLL_H
+
+#include "thread_affinity.h"
+#include <sys/socket.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+namespace hft {
+
+/**
+ * @brief Trade CPU for wakeup latency on the receive path
+ *
+ * A worker that sleeps in epoll_wait() or io_uring_enter() pays a scheduler
+ * wakeup whenever an idle socket turns busy, and that wakeup sets the tail of
+ * the latency distribution. With spin, workers poll with a zero timeout and
+ * never sleep; each then burns a whole CPU, so pin them to cores of their
+ * own (ideally isolcpus= cores) and optionally run them under SCHED_FIFO.
+ *
+ * socket_busy_poll_us sets SO_BUSY_POLL on client sockets, so that a read
+ * finding no data polls the NIC queue for that long instead of waiting for
+ * its interrupt. epoll busy polling follows the net.core.busy_poll sysctl.
+ */
+struct BusyPollOptions {
+    bool spin = false;                 // Poll with a zero timeout instead of sleeping
+    uint32_t socket_busy_poll_us = 0;  // SO_BUSY_POLL on client sockets; 0 = off
+    bool prefer_busy_poll = false;     // SO_PREFER_BUSY_POLL: defer NIC interrupts while polling
+    int realtime_priority = 0;         // SCHED_FIFO priority for polling threads; 0 = normal
+};
+
+/**
+ * @brief Apply the socket-level busy-poll options; false if the kernel refused one
+ *
+ * Raising SO_BUSY_POLL above net.core.busy_read needs CAP_NET_ADMIN.
+ */
+inline bool apply_socket_busy_poll(int fd, const BusyPollOptions& options) {
+    bool ok = true;
+    if (options.socket_busy_poll_us > 0) {
+        int usecs = static_cast<int>(options.socket_busy_poll_us);
+        ok &= setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) == 0;
+    }
+    if (options.prefer_busy_poll) {
+        int prefer = 1;
+        ok &= setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) == 0;
+    }
+    return ok;
+}
+
+/**
+ * @brief Fill in CPUs for spinning threads and warn about poor placement
+ *
+ * With spin and no explicit list, threads default to the isolated CPUs.
+ * Spinning threads left on scheduler-managed CPUs compete with everything
+ * else the kernel runs there, so each such CPU is reported.
+ */
+inline void place_spinning_threads(const BusyPollOptions& options, const char* role, std::vector<int>& cpus) {
+    if (!options.spin) {
+        return;
+    }
+    
+    std::vector<int> isolated = isolated_cpus();
+    if (cpus.empty()) {
+        if (!isolated.empty()) {
+            cpus = isolated;
+            std::cout << "Pinning spinning " << role << " threads to the isolated CPUs" << std::endl;
+        } else {
+            std::cerr << "Warning: spinning " << role << " threads are not pinned to CPUs" << std::endl;
+        }
+        return;
+    }
+    
+    size_t shared = std::count_if(cpus.begin(), cpus.end(), [&](int cpu) {
+        return std::find(isolated.begin(), isolated.end(), cpu) == isolated.end();
+    });
+    if (shared > 0) {
+        std::cerr << "Warning: " << shared << " of " << cpus.size() << " CPUs for spinning " << role
+                  << " threads are not isolated (isolcpus=)" << std::endl;
+    }
+}
+
+} // namespace hft
+
+#endif // BUSY_POLL_H
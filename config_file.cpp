@@ -0,0 +1,176 @@
+#include "config_file.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace hft {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Split "key = value"; false if there is no '=' or no key
+bool split_setting(std::string_view text, std::string_view& key, std::string_view& value) {
+    size_t equals = text.find('=');
+    if (equals == std::string_view::npos) {
+        return false;
+    }
+    key = trim(text.substr(0, equals));
+    value = trim(text.substr(equals + 1));
+    return !key.empty();
+}
+
+} // namespace
+
+bool load_settings(const std::string& path, const SettingHandler& apply) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open config " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        std::string_view text = line;
+        text = trim(text.substr(0, text.find('#')));
+        if (text.empty()) {
+            continue;
+        }
+
+        std::string_view key;
+        std::string_view value;
+        if (!split_setting(text, key, value)) {
+            std::cerr << path << ":" << number << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string error;
+        if (!apply(key, value, error)) {
+            std::cerr << path << ":" << number << ": "
+                      << (error.empty() ? "invalid value for " + std::string(key) : error) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool apply_setting(std::string_view setting, const SettingHandler& apply) {
+    std::string_view key;
+    std::string_view value;
+    if (!split_setting(setting, key, value)) {
+        std::cerr << "Expected key=value, got '" << setting << "'" << std::endl;
+        return false;
+    }
+    std::string error;
+    if (!apply(key, value, error)) {
+        std::cerr << (error.empty() ? "Invalid value for " + std::string(key) : error) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool parse_setting(std::string_view text, uint64_t max, uint64_t& value) {
+    if (text.empty() || text.front() < '0' || text.front() > '9') {
+        return false;
+    }
+    std::string digits(text);
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(digits.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || parsed > max) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parse_setting(std::string_view text, bool& value) {
+    if (text == "true" || text == "on" || text == "yes" || text == "1") {
+        value = true;
+        return true;
+    }
+    if (text == "false" || text == "off" || text == "no" || text == "0") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+bool apply_common_setting(std::string_view key, std::string_view value, const CommonSettings& settings,
+                          std::string& error) {
+    TransportOptions& transport = settings.transport;
+    BusyPollOptions& busy_poll = settings.busy_poll;
+    SessionConfig& session = settings.session;
+    uint64_t number = 0;
+
+    if (key == "transport") {
+        if (!parse_transport_kind(std::string(value), transport.kind)) {
+            error = "unknown transport '" + std::string(value) + "' (want epoll or io_uring)";
+            return false;
+        }
+        return true;
+    } else if (key == "sqpoll") {
+        return parse_setting(value, transport.sqpoll);
+    } else if (key == "io_uring_queue_depth") {
+        return parse_setting(value, transport.queue_depth) && transport.queue_depth != 0;
+    } else if (key == "io_uring_buffers") {
+        // The provided-buffer ring is indexed with a mask
+        return parse_setting(value, transport.buffer_count) && transport.buffer_count != 0 &&
+               (transport.buffer_count & (transport.buffer_count - 1)) == 0;
+    } else if (key == "io_uring_buffer_size") {
+        return parse_setting(value, transport.buffer_size) && transport.buffer_size != 0;
+    } else if (key == "socket_send_buffer" || key == "socket_receive_buffer") {
+        // setsockopt takes an int
+        if (!parse_setting(value, INT32_MAX, number)) {
+            return false;
+        }
+        (key == "socket_send_buffer" ? transport.socket_send_buffer : transport.socket_receive_buffer) =
+            static_cast<uint32_t>(number);
+        return true;
+    } else if (key == "busy_poll") {
+        return parse_setting(value, busy_poll.spin);
+    } else if (key == "so_busy_poll_us") {
+        return parse_setting(value, busy_poll.socket_busy_poll_us);
+    } else if (key == "prefer_busy_poll") {
+        return parse_setting(value, busy_poll.prefer_busy_poll);
+    } else if (key == "sched_fifo") {
+        if (!parse_setting(value, 99, number)) {
+            error = "sched_fifo must be 0 (off) or a priority of 1-99";
+            return false;
+        }
+        busy_poll.realtime_priority = static_cast<int>(number);
+        return true;
+    } else if (key == "send_high_water") {
+        return parse_setting(value, settings.outbound.high_water);
+    } else if (key == "send_limit") {
+        return parse_setting(value, settings.outbound.limit);
+    } else if (key == "heartbeat_ms") {
+        return parse_setting(value, session.heartbeat_ms);
+    } else if (key == "idle_timeout_ms") {
+        return parse_setting(value, session.idle_timeout_ms);
+    } else if (key == "require_login") {
+        return parse_setting(value, session.require_login);
+    } else if (key == "warmup_rounds") {
+        return parse_setting(value, settings.warmup.rounds);
+    } else if (key == "warmup_orders") {
+        return parse_setting(value, settings.warmup.orders) && settings.warmup.orders != 0;
+    } else if (key == "warmup_settle_rounds") {
+        return parse_setting(value, settings.warmup.settle_rounds) && settings.warmup.settle_rounds != 0;
+    } else if (key == "warmup_tolerance_pct") {
+        return parse_setting(value, settings.warmup.tolerance_pct);
+    } else if (key == "warmup_prefault_connections") {
+        return parse_setting(value, settings.warmup.prefault_connections);
+    }
+    error = "unknown setting '" + std::string(key) + "'";
+    return false;
+}
+
+} // namespace hft
@@ -0,0 +1,77 @@
+#ifndef CONFIG_FILE_H
+#define CONFIG_FILE_H
+
+#include "busy_poll.h"
+#include "outbound_queue.h"
+#include "session.h"
+#include "transport.h"
+#include "warmup.h"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace hft {
+
+/**
+ * @brief Applies one setting; false rejects it, with a reason in error if there is more to say
+ */
+using SettingHandler = std::function<bool(std::string_view key, std::string_view value, std::string& error)>;
+
+/**
+ * @brief Feed every "key = value" line of a server config file to apply; false with a logged reason
+ *
+ * '#' starts a comment and blank lines are skipped. Settings apply in file
+ * order, so a later line overrides an earlier one.
+ */
+bool load_settings(const std::string& path, const SettingHandler& apply);
+
+/**
+ * @brief Apply one "key=value" command line override the way the file would
+ */
+bool apply_setting(std::string_view setting, const SettingHandler& apply);
+
+/**
+ * @brief Unsigned decimal no larger than max
+ */
+bool parse_setting(std::string_view text, uint64_t max, uint64_t& value);
+
+template<typename T>
+bool parse_setting(std::string_view text, T& value) {
+    uint64_t parsed = 0;
+    if (!parse_setting(text, std::numeric_limits<T>::max(), parsed)) {
+        return false;
+    }
+    value = static_cast<T>(parsed);
+    return true;
+}
+
+/**
+ * @brief true/false, on/off, yes/no or 1/0
+ */
+bool parse_setting(std::string_view text, bool& value);
+
+/**
+ * @brief Option blocks both servers configure the same way
+ */
+struct CommonSettings {
+    TransportOptions& transport;
+    BusyPollOptions& busy_poll;
+    OutboundLimits& outbound;
+    SessionConfig& session;
+    WarmupConfig& warmup;
+};
+
+/**
+ * @brief Apply a socket, busy-poll, send backlog, session or warm-up setting
+ *
+ * Servers try their own keys first and hand the rest to this, which
+ * rejects keys it does not know.
+ */
+bool apply_common_setting(std::string_view key, std::string_view value, const CommonSettings& settings,
+                          std::string& error);
+
+} // namespace hft
+
+#endif // CONFIG_FILE_H
@@ -0,0 +1,190 @@
+#ifndef CONNECTION_TABLE_H
+#define CONNECTION_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include "object_pool.h"
+
+namespace hft {
+
+/**
+ * @brief Fixed-capacity slot table addressed by generation-tagged handles
+ *
+ * A handle packs a slot index with the slot's generation at the time it was
+ * acquired, so it fits in epoll_event.data.u64 and resolves in O(1) without
+ * locks. Releasing a slot bumps its generation, which turns every
+ * outstanding handle for it stale: find() returns nullptr instead of the
+ * next occupant.
+ *
+ * Objects live in a SlabArena: cache-line-aligned slabs created the first
+ * time one of their slots is used and kept until the table is destroyed. A
+ * thread still holding a pointer from before a release therefore never
+ * touches freed memory; callers must reinitialise the object after
+ * acquire(). Free slots live on a lock-free tagged stack, so acquire and
+ * release may run on any thread. Slots and slabs come from memory when
+ * given, otherwise from the heap.
+ */
+template<typename T>
+class ConnectionTable {
+public:
+    using Handle = uint64_t;
+    static constexpr Handle INVALID_HANDLE = 0;   // Never produced by acquire()
+
+    explicit ConnectionTable(uint32_t capacity, std::pmr::memory_resource* memory = nullptr)
+        : slots_(allocate_array<Slot>(memory, capacity)), objects_(capacity, memory), capacity_(capacity) {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            slots_[i].next_free.store(i + 1 < capacity ? i + 1 : NO_SLOT, std::memory_order_relaxed);
+        }
+        free_head_.store(capacity > 0 ? 0 : NO_SLOT, std::memory_order_release);
+    }
+
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    /**
+     * @brief Claim a free slot; returns nullptr when the table is full
+     */
+    T* acquire(Handle& handle) {
+        uint32_t index = pop_free();
+        if (index == NO_SLOT) {
+            return nullptr;
+        }
+
+        Slot& slot = slots_[index];
+        T* object = objects_.get(index);
+
+        // Odd generations mark live slots, so a valid handle is never zero
+        uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+        slot.generation.store(generation, std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+        handle = make_handle(index, generation);
+        return object;
+    }
+
+    /**
+     * @brief Resolve a handle; returns nullptr if its slot has been released
+     */
+    T* find(Handle handle) const {
+        uint32_t index = handle_index(handle);
+        if (index >= capacity_) {
+            return nullptr;
+        }
+
+        const Slot& slot = slots_[index];
+        if (slot.generation.load(std::memory_order_acquire) != handle_generation(handle)) {
+            return nullptr;
+        }
+        return objects_.find(index);
+    }
+
+    /**
+     * @brief Return a slot to the free list; only the first release of a handle succeeds
+     */
+    bool release(Handle handle) {
+        uint32_t index = handle_index(handle);
+        if (index >= capacity_) {
+            return false;
+        }
+
+        uint32_t generation = handle_generation(handle);
+        if ((generation & 1) == 0 ||
+            !slots_[index].generation.compare_exchange_strong(generation, generation + 1,
+                                                             std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        push_free(index);
+        return true;
+    }
+
+    /**
+     * @brief Visit every live object; not safe against concurrent acquire/release
+     */
+    template<typename Fn>
+    void for_each(Fn&& fn) {
+        for (uint32_t i = 0; i < capacity_; ++i) {
+            uint32_t generation = slots_[i].generation.load(std::memory_order_acquire);
+            if (generation & 1) {
+                fn(make_handle(i, generation), *objects_.get(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Create the objects of the first count slots and visit each; not safe against concurrent use
+     *
+     * Free slots are handed out lowest first until some are released, so
+     * these are the objects the first connections get.
+     */
+    template<typename Fn>
+    void preallocate(uint32_t count, Fn&& fn) {
+        for (uint32_t i = 0; i < count && i < capacity_; ++i) {
+            fn(*objects_.get(i));
+        }
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    uint32_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Slot of a handle, dense in [0, capacity()); reused after release
+     */
+    static uint32_t index_of(Handle handle) { return handle_index(handle); }
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<uint32_t> next_free{NO_SLOT};
+    };
+
+    static Handle make_handle(uint32_t index, uint32_t generation) {
+        return (static_cast<Handle>(generation) << 32) | index;
+    }
+    static uint32_t handle_index(Handle handle) { return static_cast<uint32_t>(handle); }
+    static uint32_t handle_generation(Handle handle) { return static_cast<uint32_t>(handle >> 32); }
+
+    // The free list head carries a modification tag in its upper half to
+    // defeat ABA between concurrent pops and pushes
+    uint32_t pop_free() {
+        uint64_t head = free_head_.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (index == NO_SLOT) {
+                return NO_SLOT;
+            }
+            uint32_t next = slots_[index].next_free.load(std::memory_order_relaxed);
+            uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+            if (free_head_.compare_exchange_weak(head, new_head, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                return index;
+            }
+        }
+    }
+
+    void push_free(uint32_t index) {
+        uint64_t head = free_head_.load(std::memory_order_relaxed);
+        uint64_t new_head;
+        do {
+            slots_[index].next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            new_head = (((head >> 32) + 1) << 32) | index;
+        } while (!free_head_.compare_exchange_weak(head, new_head, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    }
+
+    ResourceArray<Slot> slots_;
+    SlabArena<T> objects_;
+    uint32_t capacity_;
+    alignas(64) std::atomic<uint64_t> free_head_{NO_SLOT};
+    alignas(64) std::atomic<size_t> size_{0};
+};
+
+} // namespace hft
+
+#endif // CONNECTION_TABLE_H
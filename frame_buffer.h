@@ -0,0 +1,142 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include "object_pool.h"
+
+namespace hft {
+
+/**
+ * @brief Per-connection receive buffer that reassembles a TCP byte stream into frames
+ *
+ * Bytes are appended at the write cursor by recv() and consumed from the read
+ * cursor one complete frame at a time. When the tail runs out of room the
+ * unconsumed partial frame is moved back to the front, so the buffer behaves
+ * like a ring without frames ever wrapping around the end of the storage.
+ * Storage comes from memory when given, otherwise from the heap.
+ */
+class FrameBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+    static constexpr size_t ALIGNMENT = 64;
+
+    explicit FrameBuffer(size_t capacity = DEFAULT_CAPACITY, std::pmr::memory_resource* memory = nullptr)
+        : storage_(allocate(capacity, memory), ResourceFree{memory ? memory : std::pmr::new_delete_resource(), capacity}),
+          capacity_(capacity), read_pos_(0), write_pos_(0) {}
+
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    /**
+     * @brief Pointer to the free space at the end of the buffer
+     */
+    uint8_t* write_ptr() noexcept {
+        return storage_.get() + write_pos_;
+    }
+
+    /**
+     * @brief Free bytes available at the write cursor, compacting first if needed
+     */
+    size_t writable() noexcept {
+        if (write_pos_ == capacity_) {
+            compact();
+        }
+        return capacity_ - write_pos_;
+    }
+
+    /**
+     * @brief Mark bytes written by recv() as readable
+     */
+    void commit(size_t bytes) noexcept {
+        write_pos_ += bytes;
+    }
+
+    /**
+     * @brief Pointer to the first unconsumed byte
+     */
+    const uint8_t* read_ptr() const noexcept {
+        return storage_.get() + read_pos_;
+    }
+
+    /**
+     * @brief Number of unconsumed bytes
+     */
+    size_t readable() const noexcept {
+        return write_pos_ - read_pos_;
+    }
+
+    /**
+     * @brief Release a fully processed frame
+     */
+    void consume(size_t bytes) noexcept {
+        read_pos_ += bytes;
+        if (read_pos_ == write_pos_) {
+            read_pos_ = 0;
+            write_pos_ = 0;
+        }
+    }
+
+    /**
+     * @brief Move the trailing partial frame to the front of the buffer
+     */
+    void compact() noexcept {
+        if (read_pos_ == 0) {
+            return;
+        }
+        size_t remaining = readable();
+        if (remaining > 0) {
+            memmove(storage_.get(), storage_.get() + read_pos_, remaining);
+        }
+        read_pos_ = 0;
+        write_pos_ = remaining;
+    }
+
+    /**
+     * @brief Drop all buffered bytes
+     */
+    void reset() noexcept {
+        read_pos_ = 0;
+        write_pos_ = 0;
+    }
+
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    /**
+     * @brief Fault in the whole storage now rather than on the first large recv()
+     */
+    void prefault() noexcept {
+        hft::prefault(storage_.get(), capacity_);
+    }
+
+private:
+    struct ResourceFree {
+        std::pmr::memory_resource* memory;
+        size_t capacity;
+
+        void operator()(uint8_t* ptr) const noexcept {
+            memory->deallocate(ptr, capacity, ALIGNMENT);
+        }
+    };
+
+    static uint8_t* allocate(size_t capacity, std::pmr::memory_resource* memory) {
+        if (!memory) {
+            memory = std::pmr::new_delete_resource();
+        }
+        return static_cast<uint8_t*>(memory->allocate(capacity, ALIGNMENT));
+    }
+
+    std::unique_ptr<uint8_t[], ResourceFree> storage_;
+    size_t capacity_;
+    size_t read_pos_;
+    size_t write_pos_;
+};
+
+} // namespace hft
+
+#endif // FRAME_BUFFER_H
@@ -0,0 +1,61 @@
+#ifndef FRAME_SCANNER_H
+#define FRAME_SCANNER_H
+
+#include "wire_protocol.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace hft {
+namespace wire {
+
+/**
+ * @brief Frames a single scan_frames() call can return
+ */
+constexpr size_t SCAN_BATCH = 16;
+
+/**
+ * @brief Complete frames found at the front of a receive buffer
+ */
+struct FrameScan {
+    uint32_t count = 0;            // Complete, valid frames, at offsets[0..count)
+    uint32_t bytes = 0;            // Their total length: consume this much once they are handled
+    bool malformed = false;        // The header after them is invalid
+};
+
+/**
+ * @brief Locate and validate up to SCAN_BATCH frames at the front of data
+ *
+ * The batch counterpart of peek_frame(), for draining everything one recv
+ * delivered: a single pass stores each complete frame's offset, checking
+ * its header with one compare against HEADER_WORDS. Scanning stops at the
+ * first incomplete frame, the first invalid header (malformed is set; the
+ * frames before it are still returned) or after SCAN_BATCH frames.
+ *
+ * Each frame's position depends on the previous frame's length, so the scan
+ * is a chain of dependent loads; the header compare runs alongside it and
+ * costs next to nothing. offsets must have room for SCAN_BATCH entries.
+ */
+inline FrameScan scan_frames(const uint8_t* data, size_t available, uint32_t* offsets) noexcept {
+    FrameScan scan;
+    size_t position = 0;
+    while (scan.count < SCAN_BATCH && available - position >= HEADER_SIZE) {
+        uint32_t word = header_word(data + position);
+        if (word != HEADER_WORDS[(word >> 16) & 0xFF]) {
+            scan.malformed = true;
+            break;
+        }
+        size_t length = word & 0xFFFF;
+        if (available - position < length) {
+            break;
+        }
+        offsets[scan.count++] = static_cast<uint32_t>(position);
+        position += length;
+    }
+    scan.bytes = static_cast<uint32_t>(position);
+    return scan;
+}
+
+} // namespace wire
+} // namespace hft
+
+#endif // FRAME_SCANNER_H
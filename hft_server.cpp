@@ -1,4 +1,5 @@
 #include "hft_server.h"
+#include "async_logger.h"
 #include <errno.h>
 #include <cstring>
 #include <iostream>
@@ -6,9 +7,43 @@
 #include <cassert>
 #include <sstream>
 #include <iomanip>
+#include <cstddef>
+#include <cstdint>
 
 namespace hft {
 
+namespace {
+
+// Connections the calling worker queued responses for this pass, with the
+// handle each was queued under. Fills can go to a connection owned by
+// another worker, so the list belongs to the sending thread.
+thread_local std::vector<std::pair<Connection*, uint64_t>> flush_list;
+
+// The calling worker's latency recorder, and when its current read completed
+thread_local LatencyRecorder* thread_latency = nullptr;
+thread_local CounterBlock* thread_counters = nullptr;
+thread_local uint64_t read_complete_ns = 0;
+
+// The calling worker's transport and index. Non-workers have neither; their
+// sends go straight to the socket, or to the owner's inbox with per-thread transports
+thread_local Transport* thread_transport = nullptr;
+thread_local size_t thread_worker = SIZE_MAX;
+
+uint64_t monotonic_ns() {
+    return TscClock::instance().now_ns();
+}
+
+void record_since_read(LatencyStage stage) {
+    if (thread_latency) {
+        thread_latency->record(stage, monotonic_ns() - read_complete_ns);
+    }
+}
+
+} // namespace
+
+thread_local const HFTServer::DispatchTable* HFTServer::thread_dispatch_ = nullptr;
+thread_local InstrumentDirectory* HFTServer::thread_instruments_ = nullptr;
+
 // Singleton instance
 HFTServer& HFTServer::get_instance() {
     static HFTServer instance;
@@ -19,76 +54,191 @@ HFTServer::~HFTServer() {
     stop();
 }
 
-bool HFTServer::initialize(const std::string& ip, uint16_t port, size_t thread_count) {
+bool HFTServer::initialize(const std::string& ip, uint16_t port, size_t thread_count,
+                           const WorkerOptions& options) {
     server_ip_ = ip;
     server_port_ = port;
     thread_count_ = thread_count;
+    options_ = options;
+    
+    if (thread_count_ == 0) {
+        std::cerr << "At least one worker thread is required" << std::endl;
+        return false;
+    }
     
-    // Pre-allocate buffers
-    send_buffer_.resize(BUFFER_SIZE);
-    recv_buffer_.resize(BUFFER_SIZE);
+    // Calibrate the clock now rather than on the first message
+    std::cout << "Clock: ";
+    TscClock::instance().describe(std::cout);
+    std::cout << std::endl;
     
+    if (!options_.metrics_segment.empty()) {
+        MetricsLayout layout;
+        layout.threads = static_cast<uint32_t>(thread_count_);
+        metrics_ = MetricsSegment::create(options_.metrics_segment, "hft_server", layout);
+        if (!metrics_) {
+            return false;
+        }
+        std::cout << "Metrics: /dev/shm/" << options_.metrics_segment << std::endl;
+        latency_ = std::make_unique<LatencyTracker>(metrics_->recorders(), thread_count_);
+        counters_ = std::make_unique<CounterSet>(metrics_->counters(), thread_count_);
+    } else {
+        latency_ = std::make_unique<LatencyTracker>(thread_count_);
+        counters_ = std::make_unique<CounterSet>(thread_count_);
+    }
+    place_spinning_threads(options_.busy_poll, "worker", options_.cpu_affinity);
+    std::cout << "Transport: " << transport_name(options_.transport.kind)
+              << (options_.transport.sqpoll ? " (SQPOLL)" : "") << std::endl;
+    
+    size_t shard_count = options_.sharded ? thread_count_ : 1;
+    for (size_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<Shard>(options_.max_connections, monotonic_ns());
+        shard->id = i;
+        bool opened = open_shard(*shard);
+        shards_.push_back(std::move(shard));
+        if (!opened) {
+            close_shards();
+            return false;
+        }
+    }
+    
+    if (options_.transport.per_thread()) {
+        for (size_t i = 0; i < thread_count_; ++i) {
+            auto transport = make_transport(options_.transport, false);
+            if (!transport) {
+                close_shards();
+                return false;
+            }
+            worker_transports_.push_back(std::move(transport));
+        }
+        send_inboxes_.reset(new SendInbox[thread_count_]);
+    }
+    
+    std::cout << "HFT Server initialized on " << ip << ":" << port
+              << (options_.sharded ? " (sharded, " : " (shared, ") << shard_count
+              << (shard_count > 1 ? " listeners)" : " listener)") << std::endl;
+    return true;
+}
+
+bool HFTServer::open_shard(Shard& shard) {
     // Create server socket
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket_ == -1) {
+    shard.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (shard.listen_fd == -1) {
         std::cerr << "Failed to create server socket: " << strerror(errno) << std::endl;
         return false;
     }
     
     // Set socket options for high performance
-    setup_socket_options(server_socket_);
+    setup_socket_options(shard.listen_fd);
+    
+    // Every shard binds the same address; the kernel balances new
+    // connections across the listeners
+    if (options_.sharded) {
+        int opt = 1;
+        if (setsockopt(shard.listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+            std::cerr << "Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
     
     // Bind socket
     sockaddr_in server_addr{};
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    server_addr.sin_addr.s_addr = inet_addr(ip.c_str());
+    server_addr.sin_port = htons(server_port_);
+    server_addr.sin_addr.s_addr = inet_addr(server_ip_.c_str());
     
-    if (bind(server_socket_, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) == -1) {
+    // Bound now so a taken port fails initialize(); start() listens on it
+    if (bind(shard.listen_fd, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) == -1) {
         std::cerr << "Failed to bind socket: " << strerror(errno) << std::endl;
-        close(server_socket_);
-        return false;
-    }
-    
-    // Listen for connections
-    if (listen(server_socket_, BACKLOG) == -1) {
-        std::cerr << "Failed to listen: " << strerror(errno) << std::endl;
-        close(server_socket_);
         return false;
     }
     
     // Set non-blocking
-    set_non_blocking(server_socket_);
+    set_non_blocking(shard.listen_fd);
     
-    // Create epoll instance
-    epoll_fd_ = epoll_create1(0);
-    if (epoll_fd_ == -1) {
-        std::cerr << "Failed to create epoll: " << strerror(errno) << std::endl;
-        close(server_socket_);
-        return false;
+    // Accepted sockets inherit the listener's busy-poll settings
+    if (!apply_socket_busy_poll(shard.listen_fd, options_.busy_poll)) {
+        std::cerr << "Warning: busy-poll socket options refused (CAP_NET_ADMIN?): " << strerror(errno) << std::endl;
     }
     
-    // Add server socket to epoll
-    epoll_event ev{};
-    ev.events = EPOLLIN;
-    ev.data.ptr = nullptr;
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_socket_, &ev) == -1) {
-        std::cerr << "Failed to add server socket to epoll: " << strerror(errno) << std::endl;
-        close(epoll_fd_);
-        close(server_socket_);
-        return false;
+    // Per-thread transports register the listener from their own worker
+    if (options_.transport.per_thread()) {
+        return true;
     }
     
-    std::cout << "HFT Server initialized on " << ip << ":" << port << std::endl;
+    // One-shot keeps a second worker from draining the same reassembly
+    // buffer concurrently; a connection is re-armed once read
+    shard.transport = make_transport(options_.transport, true);
+    return shard.transport != nullptr;
+}
+
+bool HFTServer::open_listeners() {
+    for (auto& shard : shards_) {
+        if (listen(shard->listen_fd, static_cast<int>(options_.listen_backlog)) == -1) {
+            std::cerr << "Failed to listen: " << strerror(errno) << std::endl;
+            return false;
+        }
+        
+        // Client events carry their table handle; per-thread transports
+        // add the listener themselves once listening_ is set
+        if (shard->transport &&
+            !shard->transport->add_listener(shard->listen_fd, ConnectionTable<Connection>::INVALID_HANDLE)) {
+            std::cerr << "Failed to add server socket to epoll: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    listening_.store(true, std::memory_order_release);
     return true;
 }
 
-void HFTServer::start() {
-    if (running_.load()) {
-        return;
+void HFTServer::close_shards() {
+    worker_transports_.clear();
+    
+    for (auto& shard : shards_) {
+        if (shard->listen_fd != -1) {
+            close(shard->listen_fd);
+            shard->listen_fd = -1;
+        }
+        
+        shard->transport.reset();
+        
+        // Close all client connections
+        shard->connections.for_each([](uint64_t, Connection& conn) {
+            close(conn.fd);
+        });
+    }
+    shards_.clear();
+}
+
+bool HFTServer::start() {
+    if (running_.load() || shards_.empty()) {
+        return false;
     }
     
     running_.store(true);
+    freeze_dispatch();
+    
+    bool warm = options_.warmup.enabled() && !warmup_dispatch_.services.empty();
+    if (options_.warmup.enabled() && !warm) {
+        std::cerr << "Warm-up skipped: no warm-up services registered" << std::endl;
+    }
+    if (warm) {
+        // Fault in the receive buffers the first clients will get
+        for (auto& shard : shards_) {
+            shard->connections.preallocate(options_.warmup.prefault_connections,
+                                           [](Connection& conn) { conn.recv_buffer.prefault(); });
+        }
+        if (instruments_->open()) {
+            warmup_directory_ = std::make_unique<InstrumentDirectory>(1);
+        }
+        warmup_fds_.reset(new std::atomic<int>[thread_count_]);
+        for (size_t i = 0; i < thread_count_; ++i) {
+            warmup_fds_[i].store(-1, std::memory_order_relaxed);
+        }
+        warming_.store(true, std::memory_order_release);
+    } else if (!open_listeners()) {
+        running_.store(false);
+        return false;
+    }
     
     // Start worker threads (they will handle both accepting and processing)
     for (size_t i = 0; i < thread_count_; ++i) {
@@ -96,6 +246,104 @@ void HFTServer::start() {
     }
     
     std::cout << "HFT Server started with " << thread_count_ << " worker threads" << std::endl;
+    if (warm && !warm_up()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool HFTServer::warm_up() {
+    // One loopback connection per worker through the warm-up services
+    WarmupDriver driver(options_.warmup,
+                        warmup_instruments(warmup_directory_ ? *warmup_directory_ : *instruments_, 1));
+    std::vector<int> server_fds;
+    if (driver.connect(thread_count_, server_fds)) {
+        for (size_t i = 0; i < server_fds.size(); ++i) {
+            warmup_fds_[i].store(server_fds[i], std::memory_order_release);
+        }
+        WarmupResult result = run_warmup(options_.warmup, driver, [this] {
+            LatencyReport report;
+            latency_->report(report);
+            return report.interval[static_cast<size_t>(LatencyStage::SEND)].p99_ns;
+        }, running_);
+        print_warmup(std::cout, result);
+    } else {
+        for (int fd : server_fds) {
+            close(fd);
+        }
+    }
+    
+    // Take back connections no worker adopted; the rest close like any client
+    for (size_t i = 0; i < thread_count_; ++i) {
+        int fd = warmup_fds_[i].exchange(-1, std::memory_order_acq_rel);
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    driver.close();
+    // A worker still on the warm-up services would hand them live orders
+    if (!wait_until([this] { return active_connections_.load(std::memory_order_relaxed) == 0; }, running_, 5000)) {
+        if (running_.load()) {
+            std::cerr << "Warm-up connections still open after 5 s" << std::endl;
+        }
+        return false;
+    }
+    
+    warming_.store(false, std::memory_order_release);
+    if (!wait_until([this] { return warmed_up_.load(std::memory_order_acquire) == thread_count_; }, running_, 5000)) {
+        if (running_.load()) {
+            std::cerr << "Not every worker left warm-up within 5 s" << std::endl;
+        }
+        return false;
+    }
+    
+    // Clients see counters and latency of their own traffic only
+    latency_->reset();
+    counters_->reset();
+    total_connections_.store(0, std::memory_order_relaxed);
+    peak_connections_.store(0, std::memory_order_relaxed);
+    
+    return open_listeners();
+}
+
+bool HFTServer::poll_warmup(Shard& shard, size_t thread_id) {
+    int client_fd = warmup_fds_[thread_id].exchange(-1, std::memory_order_acq_rel);
+    if (client_fd != -1) {
+        sockaddr_in client_addr{};
+        socklen_t client_len = sizeof(client_addr);
+        getpeername(client_fd, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+        open_connection(shard, client_fd, client_addr);
+    }
+    if (warming_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    thread_dispatch_ = &dispatch_;
+    thread_instruments_ = instruments_.get();
+    warmed_up_.fetch_add(1, std::memory_order_release);
+    return false;
+}
+
+void HFTServer::freeze_dispatch() {
+    // Services are registered before start; freeze them for lock-free dispatch
+    freeze(services_, dispatch_);
+    freeze(warmup_services_, warmup_dispatch_);
+    
+    // The caller may drive dispatch_frame() itself (hot_path_benchmark.cpp)
+    thread_dispatch_ = &dispatch_;
+    thread_instruments_ = instruments_.get();
+}
+
+void HFTServer::freeze(const ServiceMap& services, DispatchTable& table) const {
+    {
+        std::lock_guard<std::mutex> lock(services_mutex_);
+        for (auto& [type, service] : services) {
+            table.by_type[static_cast<uint8_t>(type)] = service.get();
+        }
+    }
+    for (auto& service : unique_services(services)) {
+        table.services.push_back(service.get());
+    }
 }
 
 void HFTServer::stop() {
@@ -105,12 +353,6 @@ void HFTServer::stop() {
     
     running_.store(false);
     
-    // Close server socket to unblock accept
-    if (server_socket_ != -1) {
-        close(server_socket_);
-        server_socket_ = -1;
-    }
-    
     // Join threads
     for (auto& thread : worker_threads_) {
         if (thread.joinable()) {
@@ -118,120 +360,235 @@ void HFTServer::stop() {
         }
     }
     worker_threads_.clear();
+    dispatch_ = DispatchTable{};
+    warmup_dispatch_ = DispatchTable{};
+    warming_.store(false);
+    listening_.store(false);
     
-    // Close epoll
-    if (epoll_fd_ != -1) {
-        close(epoll_fd_);
-        epoll_fd_ = -1;
-    }
-    
-    // Close all client connections
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    for (auto& [fd, conn] : connections_) {
-        close(conn->fd);
-    }
-    connections_.clear();
+    // Close listeners, transports and client connections
+    close_shards();
     
+    // Drain anything the workers logged before they exited
+    AsyncLogger::instance().flush();
     std::cout << "HFT Server stopped" << std::endl;
 }
 
-void HFTServer::accept_connections() {
-    sockaddr_in client_addr{};
-    socklen_t client_len = sizeof(client_addr);
-    
-    int client_fd = accept(server_socket_, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
-    if (client_fd == -1) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return; // No pending connections
+void HFTServer::accept_connections(Shard& shard) {
+    while (true) {
+        sockaddr_in client_addr{};
+        socklen_t client_len = sizeof(client_addr);
+        
+        int client_fd = accept(shard.listen_fd, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+        if (client_fd == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return; // No pending connections
+            }
+            HFT_LOG_WARN("Accept failed: {}", strerror(errno));
+            return;
         }
-        std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+        open_connection(shard, client_fd, client_addr);
+    }
+}
+
+void HFTServer::open_connection(Shard& shard, int client_fd, const sockaddr_in& client_addr) {
+    // Set client socket options
+    setup_socket_options(client_fd);
+    set_non_blocking(client_fd);
+    
+    // Claim a connection slot; slot objects are reused, so reset every field
+    uint64_t handle;
+    Connection* conn = shard.connections.acquire(handle);
+    if (!conn) {
+        HFT_LOG_WARN("Connection table full on shard {}, rejecting client", shard.id);
+        close(client_fd);
         return;
     }
-        
-        // Set client socket options
-        setup_socket_options(client_fd);
-        set_non_blocking(client_fd);
-        
-        // Create connection object
-        auto conn = std::make_unique<Connection>();
+    {
+        // A worker still holding the slot's previous handle checks it under this lock
+        std::lock_guard<std::mutex> lock(conn->send_lock);
         conn->fd = client_fd;
-        conn->addr = client_addr;
-        conn->last_heartbeat = std::chrono::steady_clock::now();
-        conn->client_id = reinterpret_cast<uint64_t>(conn.get());
-        
-        // Add to epoll
-        epoll_event ev{};
-        ev.events = EPOLLIN | EPOLLET; // Edge-triggered
-        ev.data.ptr = conn.get();
-        
-        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) == -1) {
-            std::cerr << "Failed to add client to epoll: " << strerror(errno) << std::endl;
-            close(client_fd);
-            return;
-        }
-        
-        // Store connection
+        conn->handle = handle;
+        conn->owner = thread_worker;
+        conn->outbound.clear();
+        conn->send_scheduled = false;
+        conn->write_blocked = false;
+        conn->read_paused = false;
+        conn->send_failed = false;
+    }
+    conn->addr = client_addr;
+    conn->client_id = reinterpret_cast<uint64_t>(conn);
+    conn->shard_id = shard.id;
+    conn->client_index = static_cast<uint32_t>(shard.id * options_.max_connections +
+                                               ConnectionTable<Connection>::index_of(handle));
+    conn->account = RiskEngine::NO_ACCOUNT;
+    conn->is_authenticated = false;
+    conn->market_data_subscriber = MarketDataFanout::INVALID_SUBSCRIBER;
+    conn->recv_buffer.reset();
+    conn->session.reset(handle, monotonic_ns());
+    
+    // Let services set up per-connection state before any data arrives
+    notify_connection_established(*conn);
+    schedule_session(shard, *conn);
+    
+    // The accepting worker's transport owns the socket from here on
+    if (!thread_transport->add_connection(client_fd, handle)) {
+        HFT_LOG_WARN("Failed to add client to {}: {}", transport_name(thread_transport->kind()),
+                     strerror(errno));
         {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            connections_[client_fd] = std::move(conn);
-            stats_.total_connections++;
-            stats_.peak_connections = std::max(stats_.peak_connections, static_cast<uint64_t>(connections_.size()));
+            std::lock_guard<std::mutex> lock(shard.timer_lock);
+            shard.timers.cancel(conn->session.timer);
         }
-        
-        std::cout << "New connection from " << inet_ntoa(client_addr.sin_addr) 
-                  << ":" << ntohs(client_addr.sin_port) << std::endl;
+        notify_connection_closed(*conn);
+        close(client_fd);
+        shard.connections.release(handle);
+        return;
+    }
+    
+    total_connections_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t active = active_connections_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t peak = peak_connections_.load(std::memory_order_relaxed);
+    while (active > peak && !peak_connections_.compare_exchange_weak(peak, active, std::memory_order_relaxed)) {}
+    
+    HFT_LOG_INFO("New connection from {}:{} on shard {}", inet_ntoa(client_addr.sin_addr),
+                 ntohs(client_addr.sin_port), shard.id);
 }
 
 void HFTServer::worker_thread(size_t thread_id) {
-    std::vector<epoll_event> events(MAX_EVENTS);
+    std::vector<TransportEvent> events(std::max<uint32_t>(options_.event_batch, 1));
+    
+    if (!options_.cpu_affinity.empty()) {
+        int cpu = options_.cpu_affinity[thread_id % options_.cpu_affinity.size()];
+        if (!pin_current_thread(cpu)) {
+            std::cerr << "Worker " << thread_id << " failed to pin to CPU " << cpu << std::endl;
+        }
+    }
+    if (options_.busy_poll.realtime_priority > 0 && !set_realtime_priority(options_.busy_poll.realtime_priority)) {
+        std::cerr << "Worker " << thread_id << " failed to switch to SCHED_FIFO: " << strerror(errno) << std::endl;
+    }
+    
+    Shard& shard = *shards_[options_.sharded ? thread_id : 0];
+    thread_latency = &latency_->recorder(thread_id);
+    thread_counters = &counters_->block(thread_id);
+    
+    Transport& transport = shard.transport ? *shard.transport : *worker_transports_[thread_id];
+    if (!transport.attach_thread()) {
+        return;
+    }
+    thread_transport = &transport;
+    thread_worker = thread_id;
+    
+    // During warm-up the worker serves the warm-up services and adopts the
+    // connection start() hands it; the listener opens afterwards
+    bool warming = warming_.load(std::memory_order_acquire);
+    thread_dispatch_ = warming ? &warmup_dispatch_ : &dispatch_;
+    thread_instruments_ = warming && warmup_directory_ ? warmup_directory_.get() : instruments_.get();
+    bool watching_listener = shard.transport != nullptr;  // Shared transports are set up by open_listeners()
+    
+    // Spinning workers never sleep in the kernel, so an idle socket that
+    // turns busy is picked up without a wakeup
+    int timeout_ms = options_.busy_poll.spin ? 0 : 1;
     
     while (running_.load()) {
-        int nfds = epoll_wait(epoll_fd_, events.data(), MAX_EVENTS, 1); // 1ms timeout
+        if (warming) {
+            warming = poll_warmup(shard, thread_id);
+        }
+        if (!watching_listener && listening_.load(std::memory_order_acquire)) {
+            if (!transport.add_listener(shard.listen_fd, ConnectionTable<Connection>::INVALID_HANDLE)) {
+                HFT_LOG_ERROR("Worker {} failed to watch the listener", thread_id);
+                break;
+            }
+            watching_listener = true;
+        }
+        
+        int nfds = transport.wait(events.data(), static_cast<int>(events.size()), timeout_ms);
         
-        if (nfds == -1) {
-            if (errno == EINTR) continue;
-            std::cerr << "Worker " << thread_id << " epoll_wait failed: " << strerror(errno) << std::endl;
+        if (nfds < 0) {
+            HFT_LOG_ERROR("Worker {} {} wait failed: {}", thread_id, transport_name(transport.kind()),
+                          strerror(-nfds));
             break;
         }
         
         for (int i = 0; i < nfds; ++i) {
-            if (events[i].data.ptr == nullptr) {
-                // This is the server socket - new connection
-                accept_connections();
-            } else {
-                // This is a client connection
-                auto* conn = static_cast<Connection*>(events[i].data.ptr);
-                handle_client_events(conn->fd);
+            const TransportEvent& event = events[i];
+            switch (event.type) {
+                case TransportEvent::ACCEPT:
+                    // This is the server socket - new connection
+                    accept_connections(shard);
+                    break;
+                case TransportEvent::READABLE:
+                    // This is a client connection
+                    handle_client_events(shard, event.cookie);
+                    break;
+                case TransportEvent::DATA:
+                    handle_client_data(shard, event.cookie, event.data, event.length);
+                    break;
+                case TransportEvent::WRITABLE:
+                    handle_client_writable(shard, event.cookie);
+                    break;
+                case TransportEvent::CLOSED:
+                    if (Connection* conn = shard.connections.find(event.cookie)) {
+                        close_connection(*conn);
+                    }
+                    break;
             }
         }
-    }
-}
-
-void HFTServer::handle_client_events(int client_fd) {
-    // Find the connection for this file descriptor
-    Connection* conn = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        auto it = connections_.find(client_fd);
-        if (it == connections_.end()) {
-            return; // Connection not found
+        
+        for (IMessageService* service : thread_dispatch_->services) {
+            service->poll();
+        }
+        
+        expire_sessions(shard);
+        
+        // Everything this pass queued goes to the kernel together, along
+        // with what other workers queued for this worker's sockets
+        if (send_inboxes_) {
+            collect_posted_sends(thread_id);
         }
-        conn = it->second.get();
+        flush_outbound();
+        transport.flush();
     }
     
+    thread_transport = nullptr;
+    thread_worker = SIZE_MAX;
+}
+
+void HFTServer::handle_client_events(Shard& shard, uint64_t handle) {
+    // A stale handle means the connection closed after the event was queued
+    Connection* conn = shard.connections.find(handle);
     if (!conn) {
         return;
     }
+    int client_fd = conn->fd;
     
-    // Process all available data from the client
+    // Read until the socket is drained, handing every complete frame to the
+    // services as soon as it has been reassembled
+    FrameBuffer& buffer = conn->recv_buffer;
     while (true) {
-        ssize_t bytes_read = recv(client_fd, recv_buffer_.data(), recv_buffer_.size(), MSG_DONTWAIT);
+        if (pause_if_congested(shard, *conn)) {
+            return; // Resumed by handle_client_writable()
+        }
+        
+        size_t space = buffer.writable();
+        if (space == 0) {
+            // A frame larger than the whole buffer can never complete
+            HFT_LOG_WARN("Receive buffer overflow on fd {}", client_fd);
+            thread_counters->add(Counter::RECV_OVERFLOW);
+            close_connection(*conn);
+            return;
+        }
+        
+        uint64_t read_start = monotonic_ns();
+        ssize_t bytes_read = recv(client_fd, buffer.write_ptr(), space, MSG_DONTWAIT);
         
         if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break; // No more data
             }
-            std::cerr << "Recv failed: " << strerror(errno) << std::endl;
+            HFT_LOG_WARN("Recv failed: {}", strerror(errno));
+            close_connection(*conn);
             return;
         }
         
@@ -241,167 +598,523 @@ void HFTServer::handle_client_events(int client_fd) {
             return;
         }
         
-        // Process message - check for different message types
-        if (bytes_read >= sizeof(Message)) {
-            const Message* msg = reinterpret_cast<const Message*>(recv_buffer_.data());
-            std::cout << "Processing message type: " << static_cast<int>(msg->message_type) 
-                      << " size: " << bytes_read << " bytes" << std::endl;
-            
-            // Check if this is an OrderMessage (larger than base Message)
-            if (msg->message_type == MessageType::ORDER_NEW || 
-                msg->message_type == MessageType::ORDER_CANCEL || 
-                msg->message_type == MessageType::ORDER_REPLACE) {
-                if (bytes_read >= sizeof(OrderMessage)) {
-                    const OrderMessage* order_msg = reinterpret_cast<const OrderMessage*>(recv_buffer_.data());
-                    process_client_message(*order_msg, *conn);
-                } else {
-                    std::cout << "Incomplete order message: " << bytes_read << " bytes (need " 
-                              << sizeof(OrderMessage) << ")" << std::endl;
-                }
-            } else if (msg->message_type == MessageType::MARKET_DATA) {
-                if (bytes_read >= sizeof(MarketDataMessage)) {
-                    const MarketDataMessage* market_msg = reinterpret_cast<const MarketDataMessage*>(recv_buffer_.data());
-                    process_client_message(*market_msg, *conn);
-                } else {
-                    std::cout << "Incomplete market data message: " << bytes_read << " bytes (need " 
-                              << sizeof(MarketDataMessage) << ")" << std::endl;
-                }
-            } else {
-                // Regular message
-                process_client_message(*msg, *conn);
-            }
-        } else {
-            std::cout << "Received incomplete message: " << bytes_read << " bytes (need at least " 
-                      << sizeof(Message) << ")" << std::endl;
+        // Later stages are measured from here
+        read_complete_ns = monotonic_ns();
+        thread_latency->record(LatencyStage::RECEIVE, read_complete_ns - read_start);
+        thread_counters->add(Counter::BYTES_IN, static_cast<uint64_t>(bytes_read));
+        buffer.commit(static_cast<size_t>(bytes_read));
+        
+        if (drain_frames(*conn) == SIZE_MAX) {
+            close_connection(*conn);
+            return;
         }
     }
+    
+    rearm_connection(*conn);
 }
 
-void HFTServer::process_client_message(const Message& msg, Connection& conn) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    std::cout << "Processing base message type: " << static_cast<int>(msg.message_type) << std::endl;
+void HFTServer::handle_client_data(Shard& shard, uint64_t handle, const uint8_t* data, size_t length) {
+    // Data still queued for a connection that has since closed is dropped
+    Connection* conn = shard.connections.find(handle);
+    if (!conn) {
+        return;
+    }
     
-    // Find appropriate service
-    std::shared_ptr<IMessageService> service;
-    {
-        std::lock_guard<std::mutex> lock(services_mutex_);
-        auto it = services_.find(msg.message_type);
-        if (it != services_.end()) {
-            service = it->second;
+    // The transport has already received the bytes; reassemble them in
+    // buffer-sized pieces exactly as a recv() loop would
+    FrameBuffer& buffer = conn->recv_buffer;
+    while (length > 0) {
+        size_t space = buffer.writable();
+        if (space == 0) {
+            HFT_LOG_WARN("Receive buffer overflow on fd {}", conn->fd);
+            thread_counters->add(Counter::RECV_OVERFLOW);
+            close_connection(*conn);
+            return;
+        }
+        
+        uint64_t copy_start = monotonic_ns();
+        size_t chunk = std::min(space, length);
+        memcpy(buffer.write_ptr(), data, chunk);
+        buffer.commit(chunk);
+        data += chunk;
+        length -= chunk;
+        
+        read_complete_ns = monotonic_ns();
+        thread_latency->record(LatencyStage::RECEIVE, read_complete_ns - copy_start);
+        thread_counters->add(Counter::BYTES_IN, chunk);
+        
+        if (drain_frames(*conn) == SIZE_MAX) {
+            close_connection(*conn);
+            return;
         }
     }
+}
+
+size_t HFTServer::drain_frames(Connection& conn) {
+    FrameBuffer& buffer = conn.recv_buffer;
+    size_t frames = 0;
+    uint32_t offsets[wire::SCAN_BATCH];
+    conn.session.touch(read_complete_ns);
     
-    if (service) {
-        service->process_message(msg, conn);
+    while (true) {
+        // Headers are located and validated a batch at a time, then dispatched in order
+        wire::FrameScan scan = wire::scan_frames(buffer.read_ptr(), buffer.readable(), offsets);
+        const uint8_t* data = buffer.read_ptr();
+        for (uint32_t i = 0; i < scan.count; ++i) {
+            if (!session_frame(data + offsets[i], conn)) {
+                return SIZE_MAX;
+            }
+        }
+        buffer.consume(scan.bytes);
+        frames += scan.count;
+        
+        if (scan.malformed) {
+            // The stream cannot be resynchronised after a bad header
+            HFT_LOG_WARN("Malformed frame on fd {}", conn.fd);
+            thread_counters->add(Counter::MALFORMED);
+            return SIZE_MAX;
+        }
+        if (scan.count < wire::SCAN_BATCH) {
+            break; // Wait for the rest of the next frame
+        }
     }
     
-    // Update statistics
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    return frames;
+}
+
+bool HFTServer::session_frame(const uint8_t* frame, Connection& conn) {
+    MessageType type = wire::frame_type(frame);
+    uint32_t sequence = wire::frame_sequence(frame);
+    Session::Action action = conn.session.on_frame(type, sequence, options_.session.require_login);
+    if (action == Session::Action::DISPATCH) {
+        dispatch_frame(frame, conn);
+        return true;
+    }
     
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.total_messages_processed++;
-        
-        // Update average latency (exponential moving average)
-        constexpr double alpha = 0.01; // Smoothing factor
-        double current_latency_us = latency.count() / 1000.0;
-        stats_.avg_latency_us = alpha * current_latency_us + (1.0 - alpha) * stats_.avg_latency_us;
+    thread_counters->count_message(static_cast<uint8_t>(type));
+    switch (action) {
+        case Session::Action::LOGIN:
+            // LOGIN's message_id names the account, if any
+            conn.is_authenticated = true;
+            conn.account = wire::read_header(frame).message_id;
+            thread_counters->add(Counter::LOGINS);
+            send_session_frame(conn, MessageType::LOGIN, conn.session.next_inbound(),
+                               wire::read_header(frame).message_id);
+            break;
+        case Session::Action::LOGOUT:
+            // The client closes the connection, or the idle timeout does
+            conn.is_authenticated = false;
+            send_session_frame(conn, MessageType::LOGOUT, conn.session.next_inbound(),
+                               wire::read_header(frame).message_id);
+            break;
+        case Session::Action::RESEND:
+            // Names the sequence expected; message_id carries the one that arrived
+            thread_counters->add(Counter::SEQUENCE_GAPS);
+            send_session_frame(conn, MessageType::RESEND_REQUEST, conn.session.next_inbound(), sequence);
+            break;
+        case Session::Action::DROP:
+            if (type != MessageType::HEARTBEAT) {
+                thread_counters->add(Counter::DUPLICATES);
+            }
+            break;
+        case Session::Action::REJECT:
+            HFT_LOG_WARN("Session rejected {} on fd {}", message_type_name(type), conn.fd);
+            thread_counters->add(Counter::SESSION_REJECTS);
+            return false;
+        case Session::Action::DISPATCH:
+            break;
     }
+    return true;
 }
 
-void HFTServer::process_client_message(const OrderMessage& msg, Connection& conn) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    std::cout << "Processing ORDER message: " << msg.symbol.data() 
-              << " " << (msg.side == OrderSide::BUY ? "BUY" : "SELL")
-              << " " << msg.quantity << " @ " << msg.price << std::endl;
+void HFTServer::send_session_frame(Connection& conn, MessageType type, uint32_t sequence, uint64_t message_id) {
+    enqueue(conn, wire::HEADER_SIZE, [&](uint8_t* frame) {
+        return wire::encode_header_only(frame, type, message_id, Message::get_current_timestamp(), sequence);
+    });
+}
+
+void HFTServer::dispatch_frame(const uint8_t* frame, Connection& conn) {
+    MessageType type = wire::frame_type(frame);
+    if (thread_counters) {
+        thread_counters->count_message(static_cast<uint8_t>(type));
+    }
+    HFT_LOG_DEBUG("Processing message type: {} size: {} bytes", static_cast<int>(type),
+                  wire::HEADER_SIZE + wire::body_size(type));
     
-    // Find appropriate service
-    std::shared_ptr<IMessageService> service;
-    {
-        std::lock_guard<std::mutex> lock(services_mutex_);
-        auto it = services_.find(msg.message_type);
-        if (it != services_.end()) {
-            service = it->second;
+    switch (type) {
+        case MessageType::ORDER_NEW:
+        case MessageType::ORDER_CANCEL:
+        case MessageType::ORDER_REPLACE: {
+            OrderMessage order_msg;
+            wire::decode(frame, order_msg);
+            order_msg.instrument = thread_instruments_->resolve(order_msg.symbol.data());
+            record_since_read(LatencyStage::DECODE);
+            process_client_message(order_msg, conn);
+            break;
+        }
+        case MessageType::MARKET_DATA: {
+            MarketDataMessage market_msg;
+            wire::decode(frame, market_msg);
+            market_msg.instrument = thread_instruments_->resolve(market_msg.symbol.data());
+            record_since_read(LatencyStage::DECODE);
+            process_client_message(market_msg, conn);
+            break;
+        }
+        case MessageType::MARKET_DATA_SUBSCRIBE:
+        case MessageType::MARKET_DATA_UNSUBSCRIBE: {
+            SubscriptionMessage subscription;
+            wire::decode(frame, subscription);
+            subscription.instrument = thread_instruments_->resolve(subscription.symbol.data());
+            record_since_read(LatencyStage::DECODE);
+            process_client_message(static_cast<const Message&>(subscription), conn);
+            break;
+        }
+        case MessageType::FEED_RETRANSMIT_REQUEST:
+        case MessageType::FEED_SNAPSHOT_REQUEST: {
+            RecoveryRequestMessage recovery;
+            wire::decode(frame, recovery);
+            record_since_read(LatencyStage::DECODE);
+            process_client_message(static_cast<const Message&>(recovery), conn);
+            break;
+        }
+        default: {
+            // Regular message
+            Message msg;
+            wire::decode(frame, msg);
+            record_since_read(LatencyStage::DECODE);
+            process_client_message(msg, conn);
+            break;
         }
     }
     
-    if (service) {
-        service->process_message(msg, conn);
+    record_since_read(LatencyStage::DISPATCH);
+}
+
+void HFTServer::rearm_connection(Connection& conn) {
+    if (!thread_transport->rearm_connection(conn.fd, conn.handle)) {
+        HFT_LOG_WARN("Failed to re-arm client in epoll: {}", strerror(errno));
+        close_connection(conn);
     }
+}
+
+void HFTServer::process_client_message(const Message& msg, Connection& conn) {
+    HFT_LOG_DEBUG("Processing base message type: {}", static_cast<int>(msg.message_type));
     
-    // Update statistics
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    dispatch_message(msg, conn);
+}
+
+void HFTServer::process_client_message(const OrderMessage& msg, Connection& conn) {
+    HFT_LOG_DEBUG("Processing ORDER message: {} {} {} @ {}", msg.symbol,
+                  msg.side == OrderSide::BUY ? "BUY" : "SELL", msg.quantity, msg.price);
     
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.total_messages_processed++;
-        
-        // Update average latency (exponential moving average)
-        constexpr double alpha = 0.01; // Smoothing factor
-        double current_latency_us = latency.count() / 1000.0;
-        stats_.avg_latency_us = alpha * current_latency_us + (1.0 - alpha) * stats_.avg_latency_us;
-    }
+    dispatch_message(msg, conn);
 }
 
 void HFTServer::process_client_message(const MarketDataMessage& msg, Connection& conn) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    HFT_LOG_DEBUG("Processing MARKET_DATA message: {} Bid: {} Ask: {}", msg.symbol,
+                  msg.bid_price, msg.ask_price);
     
-    std::cout << "Processing MARKET_DATA message: " << msg.symbol.data() 
-              << " Bid: " << msg.bid_price << " Ask: " << msg.ask_price << std::endl;
+    dispatch_message(msg, conn);
+}
+
+void HFTServer::dispatch_message(const Message& msg, Connection& conn) {
+    if (IMessageService* service = thread_dispatch_->by_type[static_cast<uint8_t>(msg.message_type)]) {
+        service->process_message(msg, conn);
+    }
+}
+
+void HFTServer::handle_client_writable(Shard& shard, uint64_t handle) {
+    Connection* conn = shard.connections.find(handle);
+    if (!conn) {
+        return;
+    }
     
-    // Find appropriate service
-    std::shared_ptr<IMessageService> service;
+    bool resume = false;
     {
-        std::lock_guard<std::mutex> lock(services_mutex_);
-        auto it = services_.find(msg.message_type);
-        if (it != services_.end()) {
-            service = it->second;
+        std::lock_guard<std::mutex> lock(conn->send_lock);
+        conn->write_blocked = false;
+        write_outbound(*conn);
+        if (conn->read_paused && conn->outbound.size() <= options_.outbound.high_water / 2) {
+            conn->read_paused = false;
+            resume = true;
         }
     }
     
-    if (service) {
-        service->process_message(msg, conn);
+    // Nobody read the socket while it was paused; pick up what arrived
+    if (resume) {
+        handle_client_events(shard, handle);
+    }
+}
+
+bool HFTServer::pause_if_congested(Shard& shard, Connection& conn) {
+    std::lock_guard<std::mutex> lock(conn.send_lock);
+    if (conn.outbound.size() < options_.outbound.high_water || !shard.transport) {
+        return false;
     }
     
-    // Update statistics
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    // Left unread and, with one-shot, un-armed. The writable watch fires
+    // once the backlog can move, and its handler resumes reading
+    if (!conn.write_blocked) {
+        conn.write_blocked = shard.transport->watch_writable(conn.fd, conn.handle);
+    }
+    conn.read_paused = conn.write_blocked;
+    return conn.read_paused;
+}
+
+template<typename Encode>
+void HFTServer::enqueue(Connection& conn, size_t max_length, Encode&& encode) {
+    std::lock_guard<std::mutex> lock(conn.send_lock);
+    if (conn.fd < 0 || conn.send_failed) {
+        return; // Closed, broken or cut off
+    }
     
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.total_messages_processed++;
-        
-        // Update average latency (exponential moving average)
-        constexpr double alpha = 0.01; // Smoothing factor
-        double current_latency_us = latency.count() / 1000.0;
-        stats_.avg_latency_us = alpha * current_latency_us + (1.0 - alpha) * stats_.avg_latency_us;
+    // Encoded in place: the queue is the only copy until the kernel's.
+    // Numbered under the send lock, so numbers follow the byte stream
+    uint8_t* tail = conn.outbound.reserve(max_length);
+    size_t length = encode(tail);
+    conn.session.stamp_outbound(tail, length);
+    conn.outbound.commit(length);
+    if (thread_counters) {
+        thread_counters->add(Counter::FRAMES_OUT);
+    }
+    
+    size_t backlog = send_backlog(conn);
+    if (backlog > options_.outbound.limit) {
+        // Dropping frames would corrupt the client's view of its orders; the
+        // shutdown wakes the owning worker, which closes the connection
+        HFT_LOG_WARN("Send backlog of {} bytes on fd {}, disconnecting slow client", backlog, conn.fd);
+        if (thread_counters) {
+            thread_counters->add(Counter::SLOW_CLIENT);
+        }
+        shutdown(conn.fd, SHUT_RDWR);
+        conn.outbound.clear();
+        conn.send_failed = true;
+        return;
+    }
+    
+    schedule_send(conn);
+    record_since_read(LatencyStage::SEND);
+}
+
+void HFTServer::schedule_send(Connection& conn) {
+    // Caller holds send_lock
+    if (send_inboxes_ && thread_worker != conn.owner) {
+        if (!conn.send_scheduled && !conn.write_blocked) {
+            conn.send_scheduled = true;
+            SendInbox& inbox = send_inboxes_[conn.owner];
+            std::lock_guard<std::mutex> lock(inbox.lock);
+            inbox.connections.emplace_back(&conn, conn.handle);
+            inbox.pending.store(true, std::memory_order_release);
+        }
+    } else if (!thread_transport) {
+        write_outbound(conn); // Not a worker: nobody flushes on this thread
+    } else if (!conn.send_scheduled && !conn.write_blocked) {
+        conn.send_scheduled = true;
+        flush_list.emplace_back(&conn, conn.handle);
     }
 }
 
 void HFTServer::send_response(Connection& conn, const Message& response) {
-    // Zero-copy send using pre-allocated buffer
-    memcpy(send_buffer_.data(), &response, sizeof(Message));
+    enqueue(conn, wire::MAX_FRAME_SIZE,
+            [&](uint8_t* frame) { return wire::encode(response, frame); });
+}
+
+void HFTServer::send_response(Connection& conn, const FillMessage& response) {
+    enqueue(conn, wire::MAX_FRAME_SIZE,
+            [&](uint8_t* frame) { return wire::encode(response, frame); });
+}
+
+void HFTServer::send_frame(Connection& conn, const uint8_t* frame, size_t frame_length) {
+    enqueue(conn, frame_length, [&](uint8_t* tail) {
+        memcpy(tail, frame, frame_length);
+        return frame_length;
+    });
+}
+
+size_t HFTServer::send_backlog(const Connection& conn) const {
+    // Caller holds send_lock. What a per-thread transport holds is only
+    // visible on its own thread
+    bool visible = thread_transport && (!send_inboxes_ || thread_worker == conn.owner);
+    return conn.outbound.size() + (visible ? thread_transport->queued(conn.fd, conn.handle) : 0);
+}
+
+void HFTServer::collect_posted_sends(size_t worker) {
+    SendInbox& inbox = send_inboxes_[worker];
+    if (!inbox.pending.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(inbox.lock);
+    inbox.pending.store(false, std::memory_order_relaxed);
+    flush_list.insert(flush_list.end(), inbox.connections.begin(), inbox.connections.end());
+    inbox.connections.clear();
+}
+
+int HFTServer::send_frames(Connection& conn, const struct iovec* frames, int count) {
+    std::lock_guard<std::mutex> lock(conn.send_lock);
+    if (conn.fd < 0 || conn.send_failed) {
+        return -1;
+    }
     
-    ssize_t bytes_sent = send(conn.fd, send_buffer_.data(), sizeof(Message), MSG_NOSIGNAL);
-    if (bytes_sent == -1) {
-        std::cerr << "Send failed: " << strerror(errno) << std::endl;
+    // A backed-up connection takes nothing more; the fan-out conflates instead
+    int taken = 0;
+    size_t backlog = send_backlog(conn);
+    while (taken < count && backlog < options_.outbound.high_water) {
+        // The frames are shared by every subscriber; the copy is numbered
+        uint8_t* tail = conn.outbound.reserve(frames[taken].iov_len);
+        memcpy(tail, frames[taken].iov_base, frames[taken].iov_len);
+        conn.session.stamp_outbound(tail, frames[taken].iov_len);
+        conn.outbound.commit(frames[taken].iov_len);
+        backlog += frames[taken].iov_len;
+        ++taken;
+    }
+    if (taken > 0) {
+        if (thread_counters) {
+            thread_counters->add(Counter::FRAMES_OUT, taken);
+        }
+        schedule_send(conn);
     }
+    return taken;
+}
+
+void HFTServer::write_outbound(Connection& conn) {
+    // Caller holds send_lock
+    if (conn.outbound.empty()) {
+        return;
+    }
+    size_t queued = conn.outbound.size();
+    OutboundQueue::Result result = conn.outbound.flush(conn.fd, conn.handle, thread_transport);
+    if (thread_counters && result != OutboundQueue::Result::FAILED) {
+        thread_counters->add(Counter::BYTES_OUT, queued - conn.outbound.size());
+    }
+    switch (result) {
+        case OutboundQueue::Result::DRAINED:
+            break;
+        case OutboundQueue::Result::BLOCKED: {
+            if (thread_counters) {
+                thread_counters->add(Counter::SEND_BLOCKED);
+            }
+            // The rest waits in the queue; later frames line up behind it
+            Transport* watcher = shards_[conn.shard_id]->transport.get();
+            if (!conn.write_blocked && watcher) {
+                conn.write_blocked = watcher->watch_writable(conn.fd, conn.handle);
+            }
+            break;
+        }
+        case OutboundQueue::Result::FAILED:
+            // The receive side sees the same error and closes the connection
+            HFT_LOG_WARN("Send failed on fd {}: {}", conn.fd, strerror(errno));
+            conn.send_failed = true;
+            break;
+    }
+}
+
+void HFTServer::flush_outbound() {
+    for (auto& [conn, handle] : flush_list) {
+        std::lock_guard<std::mutex> lock(conn->send_lock);
+        conn->send_scheduled = false;
+        // The slot may have been closed, or even reused, since it was queued
+        if (conn->fd >= 0 && conn->handle == handle && !conn->write_blocked) {
+            write_outbound(*conn);
+        }
+    }
+    flush_list.clear();
 }
 
 void HFTServer::close_connection(Connection& conn) {
-    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
-    close(conn.fd);
+    notify_connection_closed(conn);
     
+    Shard& shard = *shards_[conn.shard_id];
     {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        connections_.erase(conn.fd);
+        std::lock_guard<std::mutex> lock(shard.timer_lock);
+        shard.timers.cancel(conn.session.timer);
+    }
+    thread_transport->remove_connection(conn.fd, conn.handle);
+    
+    // No worker writes to the descriptor once it is marked closed
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(conn.send_lock);
+        fd = conn.fd;
+        conn.fd = -1;
+        conn.outbound.clear();
+    }
+    close(fd);
+    
+    // Invalidates the handle; the slot object stays allocated for reuse
+    shard.connections.release(conn.handle);
+    active_connections_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void HFTServer::schedule_session(Shard& shard, Connection& conn) {
+    uint64_t deadline = Session::first_deadline(options_.session, conn.session.last_receive_ns());
+    if (deadline != 0) {
+        std::lock_guard<std::mutex> lock(shard.timer_lock);
+        shard.timers.schedule(conn.session.timer, deadline);
     }
 }
 
+void HFTServer::expire_sessions(Shard& shard) {
+    if (!options_.session.timers() || !shard.timer_lock.try_lock()) {
+        return; // Another worker of the shard is advancing the wheel
+    }
+    std::lock_guard<std::mutex> lock(shard.timer_lock, std::adopt_lock);
+    shard.timers.advance(monotonic_ns(), [&](TimerWheel::Timer& timer) { expire_session(shard, timer.cookie); });
+}
+
+void HFTServer::expire_session(Shard& shard, uint64_t handle) {
+    // Caller holds timer_lock, and close_connection() cancels under it, so the
+    // connection cannot be released while this runs
+    Connection* conn = shard.connections.find(handle);
+    if (!conn) {
+        return;
+    }
+    uint64_t now = monotonic_ns();
+    Session::TimerResult result = conn->session.on_timer(options_.session, now);
+    
+    if (result.idle) {
+        // Like a slow client: the shutdown wakes the reading worker, which closes
+        HFT_LOG_WARN("No data from fd {} for {} ms, disconnecting", conn->fd, options_.session.idle_timeout_ms);
+        thread_counters->add(Counter::IDLE_TIMEOUTS);
+        std::lock_guard<std::mutex> lock(conn->send_lock);
+        if (conn->fd >= 0 && !conn->send_failed) {
+            shutdown(conn->fd, SHUT_RDWR);
+            conn->outbound.clear();
+            conn->send_failed = true;
+        }
+        return;
+    }
+    if (result.heartbeat) {
+        send_session_frame(*conn, MessageType::HEARTBEAT, conn->session.next_inbound(), 0);
+    }
+    if (result.next_ns != 0) {
+        shard.timers.schedule(conn->session.timer, result.next_ns);
+    }
+}
+
+void HFTServer::notify_connection_established(Connection& conn) {
+    for (IMessageService* service : thread_dispatch_->services) {
+        service->on_connection_established(conn);
+    }
+}
+
+void HFTServer::notify_connection_closed(Connection& conn) {
+    for (IMessageService* service : thread_dispatch_->services) {
+        service->on_connection_closed(conn);
+    }
+}
+
+std::vector<std::shared_ptr<IMessageService>> HFTServer::unique_services(const ServiceMap& services) const {
+    // One service may be registered for several message types
+    std::vector<std::shared_ptr<IMessageService>> result;
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    for (auto& [type, service] : services) {
+        if (std::find(result.begin(), result.end(), service) == result.end()) {
+            result.push_back(service);
+        }
+    }
+    return result;
+}
+
 void HFTServer::setup_socket_options(int sock_fd) {
     // Set SO_REUSEADDR
     int opt = 1;
@@ -413,11 +1126,15 @@ void HFTServer::setup_socket_options(int sock_fd) {
     // Set SO_KEEPALIVE
     setsockopt(sock_fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
     
-    // Set send and receive buffer sizes
-    int send_buf_size = 1024 * 1024; // 1MB
-    int recv_buf_size = 1024 * 1024; // 1MB
-    setsockopt(sock_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size));
-    setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size));
+    // Set send and receive buffer sizes, unless configured to the kernel default
+    int send_buf_size = static_cast<int>(options_.transport.socket_send_buffer);
+    int recv_buf_size = static_cast<int>(options_.transport.socket_receive_buffer);
+    if (send_buf_size > 0) {
+        setsockopt(sock_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size));
+    }
+    if (recv_buf_size > 0) {
+        setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size));
+    }
 }
 
 void HFTServer::set_non_blocking(int sock_fd) {
@@ -426,29 +1143,84 @@ void HFTServer::set_non_blocking(int sock_fd) {
 }
 
 HFTServer::ServerStats HFTServer::get_stats() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    ServerStats stats{};
+    if (counters_) {
+        counters_->snapshot(stats.counters);
+    }
+    stats.total_messages_processed = stats.counters[Counter::MESSAGES];
+    stats.total_connections = total_connections_.load(std::memory_order_relaxed);
+    stats.active_connections = active_connections_.load(std::memory_order_relaxed);
+    stats.peak_connections = peak_connections_.load(std::memory_order_relaxed);
+    
+    if (latency_) {
+        latency_->report(stats.latency);
+    }
+    return stats;
+}
+
+void HFTServer::publish_metrics() {
+    if (!metrics_) {
+        return;
+    }
+    metrics_->set(Gauge::ACTIVE_CONNECTIONS, active_connections_.load(std::memory_order_relaxed));
+    metrics_->set(Gauge::PEAK_CONNECTIONS, peak_connections_.load(std::memory_order_relaxed));
+    metrics_->set(Gauge::TOTAL_CONNECTIONS, total_connections_.load(std::memory_order_relaxed));
+    metrics_->mark_updated();
+}
+
+uint32_t HFTServer::client_capacity() const {
+    return static_cast<uint32_t>(shards_.size() * options_.max_connections);
+}
+
+void HFTServer::set_instruments(std::shared_ptr<InstrumentDirectory> instruments) {
+    if (running_.load()) {
+        std::cerr << "Instrument directory replaced after start; ignored" << std::endl;
+        return;
+    }
+    instruments_ = std::move(instruments);
 }
 
 void HFTServer::register_service(MessageType type, std::shared_ptr<IMessageService> service) {
+    if (running_.load()) {
+        // Workers read the frozen table without a lock
+        std::cerr << "Service for message type " << static_cast<int>(type)
+                  << " registered after start; ignored" << std::endl;
+        return;
+    }
     std::lock_guard<std::mutex> lock(services_mutex_);
     services_[type] = service;
 }
 
+void HFTServer::register_warmup_service(MessageType type, std::shared_ptr<IMessageService> service) {
+    if (running_.load()) {
+        std::cerr << "Warm-up service for message type " << static_cast<int>(type)
+                  << " registered after start; ignored" << std::endl;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    warmup_services_[type] = service;
+}
+
 // OrderService implementation
+OrderService::OrderService(const OrderBookConfig& config, uint32_t book_shards) : book_config_(config) {
+    shards_.reserve(std::max<uint32_t>(book_shards, 1));
+    for (uint32_t i = 0; i < std::max<uint32_t>(book_shards, 1); ++i) {
+        shards_.push_back(std::make_unique<BookShard>(config));
+        shards_.back()->engine.set_fill_listener(this);
+    }
+}
+
 void OrderService::process_message(const Message& msg, Connection& conn) {
+    // Order frames are always decoded into an OrderMessage
     switch (msg.message_type) {
         case MessageType::ORDER_NEW:
-            if (msg.payload_size >= sizeof(OrderMessage)) {
-                const OrderMessage& order = *reinterpret_cast<const OrderMessage*>(&msg);
-                handle_new_order(order, conn);
-            }
+            handle_new_order(static_cast<const OrderMessage&>(msg), conn);
             break;
         case MessageType::ORDER_CANCEL:
-            handle_cancel_order(msg, conn);
+            handle_cancel_order(static_cast<const OrderMessage&>(msg), conn);
             break;
         case MessageType::ORDER_REPLACE:
-            handle_replace_order(msg, conn);
+            handle_replace_order(static_cast<const OrderMessage&>(msg), conn);
             break;
         default:
             break;
@@ -461,55 +1233,346 @@ void OrderService::on_connection_established(Connection& conn) {
 
 void OrderService::on_connection_closed(Connection& conn) {
     conn.is_authenticated = false;
+    
+    // Cancel-on-disconnect: no resting order may outlive its connection
+    // This worker owns the connection, so none of its orders can arrive meanwhile
+    size_t cancelled = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        cancelled += shard->engine.cancel_all(conn.client_id);
+    }
+    
+    // Replay needs only the disconnects that cancelled something. Those a
+    // shutdown causes stay out, so a restart brings the orders back
+    if (cancelled > 0 && journal_ && HFTServer::get_instance().is_running()) {
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        journal_->append_disconnect(conn.client_id);
+    }
+    if (cancelled > 0) {
+        HFT_LOG_INFO("Cancelled {} resting orders on disconnect", cancelled);
+    }
+}
+
+void OrderService::on_fill(const FillMessage& fill, uint64_t owner) {
+    // Called from inside the engine with the shard lock held; owner is the
+    // Connection address, kept valid by cancel-on-disconnect
+    if (JournalOwnerMap::is_recovered(owner)) {
+        // A replayed order; the connection that sent it belonged to an earlier run
+        HFT_LOG_DEBUG("Fill {} of {} on recovered order {}", fill.fill_id, fill.fill_quantity, fill.order_id);
+        return;
+    }
+    Connection& conn = *reinterpret_cast<Connection*>(owner);
+    if (risk_) {
+        std::lock_guard<std::mutex> lock(risk_mutex_);
+        risk_->on_fill(conn.client_index, conn.handle, fill.instrument, fill.side, fill.fill_quantity);
+    }
+    HFTServer::get_instance().send_response(conn, fill);
+}
+
+void OrderService::on_resting(InstrumentId instrument, OrderSide side, int64_t change, uint64_t owner) {
+    // Same context as on_fill
+    if (!risk_ || JournalOwnerMap::is_recovered(owner)) {
+        return;
+    }
+    const Connection& conn = *reinterpret_cast<const Connection*>(owner);
+    std::lock_guard<std::mutex> lock(risk_mutex_);
+    risk_->on_resting(conn.client_index, conn.handle, instrument, side, change);
+}
+
+OrderResult OrderService::check_risk(const OrderMessage& order, const Connection& conn, uint32_t replaced) {
+    uint64_t price = order.order_type == OrderType::MARKET ? 0 : order.price;
+    OrderResult result = HFTServer::get_instance().instruments().check_order(order.instrument, price, order.quantity);
+    if (is_rejected(result) || !risk_) {
+        return result;
+    }
+    std::lock_guard<std::mutex> lock(risk_mutex_);
+    return risk_->check_order(conn.client_index, conn.handle, conn.account, order.instrument, order.side, price,
+                              order.quantity, replaced, TscClock::instance().now_ns());
+}
+
+void OrderService::journal_order(const OrderMessage& order, const Connection& conn) {
+    if (journal_) {
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        journal_->append_frame(conn.client_id, frame, wire::encode(order, frame));
+    }
+}
+
+size_t OrderService::recover(JournalReader& reader, size_t& cancelled) {
+    // Runs before the server starts, so nothing else touches the shards
+    JournalOwnerMap owners;
+    JournalRecord record;
+    size_t applied = 0;
+    while (reader.next(record)) {
+        if (record.kind == JournalRecordKind::DISCONNECT) {
+            if (uint64_t owner = owners.release(record)) {
+                for (auto& shard : shards_) {
+                    shard->engine.cancel_all(owner);
+                }
+            }
+            ++applied;
+            continue;
+        }
+        
+        OrderMessage order;
+        MessageType type = wire::frame_type(record.frame);
+        if (type != MessageType::ORDER_NEW && type != MessageType::ORDER_CANCEL &&
+            type != MessageType::ORDER_REPLACE) {
+            continue;
+        }
+        wire::decode(record.frame, order);
+        order.instrument = HFTServer::get_instance().instruments().resolve(order.symbol.data());
+        
+        // The engine is deterministic, so applying the same events in the
+        // same order rebuilds the same books
+        uint64_t owner = owners.token(record);
+        MatchingEngine& engine = shard_for(order.instrument).engine;
+        if (type == MessageType::ORDER_NEW) {
+            engine.submit_order(order, owner);
+        } else if (type == MessageType::ORDER_CANCEL) {
+            engine.cancel_order(order, owner);
+        } else {
+            engine.replace_order(order, owner);
+        }
+        ++applied;
+    }
+    
+    // The books then hold nothing from earlier runs, which is what lets the
+    // caller archive the replayed segments
+    cancelled = 0;
+    for (uint64_t owner : owners.unreleased()) {
+        for (auto& shard : shards_) {
+            cancelled += shard->engine.cancel_all(owner);
+        }
+    }
+    return applied;
+}
+
+void OrderService::configure_books(const InstrumentDirectory& directory) {
+    for (InstrumentId id = 0; id < directory.size(); ++id) {
+        shard_for(id).engine.configure_book(id, directory.book_config(id, book_config_));
+    }
 }
 
 void OrderService::handle_new_order(const OrderMessage& order, Connection& conn) {
-    // Process new order (implement order matching logic here)
-    // For now, just send confirmation
-    Message response = order;
-    response.status = MessageStatus::PROCESSED;
-    response.update_timestamp();
+    BookShard& shard = shard_for(order.instrument);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    OrderResult result = check_risk(order, conn);
+    if (!is_rejected(result)) {
+        journal_order(order, conn);
+        result = shard.engine.submit_order(order, conn.client_id);
+    }
+    send_execution_report(order, result, conn);
+    
+    HFT_LOG_DEBUG("New order {}: {} {} {} @ {} -> {}", order.order_id, order.symbol,
+                  order.side == OrderSide::BUY ? "BUY" : "SELL", order.quantity, order.price,
+                  order_result_name(result));
+}
+
+void OrderService::handle_cancel_order(const OrderMessage& msg, Connection& conn) {
+    BookShard& shard = shard_for(msg.instrument);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    journal_order(msg, conn);
+    OrderResult result = shard.engine.cancel_order(msg, conn.client_id);
+    send_execution_report(msg, result, conn);
     
-    // In real implementation, you'd send this back to the client
-    // For now, just log it
-    std::cout << "New order received: " << order.symbol.data() 
-              << " " << (order.side == OrderSide::BUY ? "BUY" : "SELL")
-              << " " << order.quantity << " @ " << order.price << std::endl;
+    HFT_LOG_DEBUG("Cancel order {} -> {}", msg.order_id, order_result_name(result));
 }
 
-void OrderService::handle_cancel_order(const Message& msg, Connection& conn) {
-    // Handle order cancellation
-    std::cout << "Cancel order received" << std::endl;
+void OrderService::handle_replace_order(const OrderMessage& msg, Connection& conn) {
+    BookShard& shard = shard_for(msg.instrument);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint32_t replaced = shard.engine.open_quantity(msg.instrument, msg.order_id, conn.client_id);
+    OrderResult result = check_risk(msg, conn, replaced);
+    if (!is_rejected(result)) {
+        journal_order(msg, conn);
+        result = shard.engine.replace_order(msg, conn.client_id);
+    }
+    send_execution_report(msg, result, conn);
+    
+    HFT_LOG_DEBUG("Replace order {} -> {}", msg.order_id, order_result_name(result));
 }
 
-void OrderService::handle_replace_order(const Message& msg, Connection& conn) {
-    // Handle order replacement
-    std::cout << "Replace order received" << std::endl;
+void OrderService::send_execution_report(const OrderMessage& order, OrderResult result, Connection& conn) {
+    Message report;
+    report.message_id = order.message_id;
+    report.sequence_number = order.sequence_number;
+    report.message_type = is_rejected(result) ? MessageType::ORDER_REJECT : MessageType::ORDER_ACK;
+    report.status = is_rejected(result) ? MessageStatus::FAILED : MessageStatus::PROCESSED;
+    report.update_timestamp();
+    HFTServer::get_instance().send_response(conn, report);
 }
 
 // MarketDataService implementation
+MarketDataService::MarketDataService(const FanoutConfig& config)
+    : fanout_(config),
+      market_(std::make_shared<MarketStateCache>(config.max_symbols)) {}
+
 void MarketDataService::process_message(const Message& msg, Connection& conn) {
-    if (msg.message_type == MessageType::MARKET_DATA) {
-        if (msg.payload_size >= sizeof(MarketDataMessage)) {
-            const MarketDataMessage& data = *reinterpret_cast<const MarketDataMessage*>(&msg);
-            broadcast_market_data(data);
-        }
+    switch (msg.message_type) {
+        case MessageType::MARKET_DATA:
+            broadcast_market_data(static_cast<const MarketDataMessage&>(msg));
+            break;
+        case MessageType::MARKET_DATA_SUBSCRIBE:
+        case MessageType::MARKET_DATA_UNSUBSCRIBE:
+            handle_subscription(static_cast<const SubscriptionMessage&>(msg), conn);
+            break;
+        case MessageType::FEED_RETRANSMIT_REQUEST:
+        case MessageType::FEED_SNAPSHOT_REQUEST:
+            handle_recovery(static_cast<const RecoveryRequestMessage&>(msg), conn);
+            break;
+        default:
+            break;
     }
 }
 
-void MarketDataService::on_connection_established(Connection& conn) {
-    // Send initial market data snapshot
-    std::cout << "Market data connection established" << std::endl;
+void MarketDataService::on_connection_established(Connection&) {
+    HFT_LOG_DEBUG("Market data connection established");
 }
 
 void MarketDataService::on_connection_closed(Connection& conn) {
-    std::cout << "Market data connection closed" << std::endl;
+    // Before the socket closes, so no flush can queue for a closed connection
+    if (conn.market_data_subscriber != MarketDataFanout::INVALID_SUBSCRIBER) {
+        fanout_.remove_subscriber(conn.market_data_subscriber);
+        conn.market_data_subscriber = MarketDataFanout::INVALID_SUBSCRIBER;
+    }
+    HFT_LOG_DEBUG("Market data connection closed");
+}
+
+int MarketDataService::deliver(uint64_t target, const struct iovec* frames, int count) {
+    // target is the Connection; removal on close waits for this call, so it is still live
+    return HFTServer::get_instance().send_frames(*reinterpret_cast<Connection*>(target), frames, count);
+}
+
+void MarketDataService::poll() {
+    fanout_.flush(0, *this);
+    if (feed_) {
+        // Whatever a pass published leaves as one datagram
+        feed_->flush();
+    }
+}
+
+bool MarketDataService::enable_multicast(const MulticastConfig& config) {
+    auto feed = std::make_unique<MulticastFeed>(config);
+    if (!feed->start()) {
+        return false;
+    }
+    feed_ = std::move(feed);
+    return true;
+}
+
+void MarketDataService::handle_recovery(const RecoveryRequestMessage& msg, Connection& conn) {
+    // Recovered updates as FEED_UPDATE frames, then an ack whose sequence is their count
+    thread_local std::vector<FeedUpdate> updates;
+    thread_local std::vector<uint8_t> frames;
+    bool ok = feed_ != nullptr;
+    
+    if (ok && msg.message_type == MessageType::FEED_RETRANSMIT_REQUEST) {
+        ok = feed_->retransmit(msg.start, msg.count, updates);
+    } else if (ok) {
+        feed_->snapshot(msg.start, msg.count, updates);
+    }
+    
+    Message reply;
+    reply.message_id = msg.message_id;
+    reply.sequence_number = ok ? static_cast<uint32_t>(updates.size()) : 0;
+    reply.message_type = ok ? MessageType::MARKET_DATA_ACK : MessageType::ERROR;
+    reply.status = ok ? MessageStatus::PROCESSED : MessageStatus::FAILED;
+    reply.update_timestamp();
+    
+    size_t count = ok ? updates.size() : 0;
+    frames.resize((count + 1) * wire::MAX_FRAME_SIZE);
+    size_t length = 0;
+    uint64_t now = TscClock::instance().wall_ns();
+    for (size_t i = 0; i < count; ++i) {
+        length += wire::encode_feed_update(frames.data() + length, updates[i].sequence, now, updates[i].body);
+    }
+    length += wire::encode(reply, frames.data() + length);
+    HFTServer::get_instance().send_frame(conn, frames.data(), length);
+    
+    HFT_LOG_INFO("{} from {} x{} -> {} updates{}", msg.message_type == MessageType::FEED_RETRANSMIT_REQUEST
+                 ? "Retransmit" : "Snapshot", msg.start, msg.count, count, ok ? "" : " (unavailable)");
+}
+
+void MarketDataService::handle_subscription(const SubscriptionMessage& msg, Connection& conn) {
+    std::string_view symbol = MatchingEngine::symbol_view(msg.symbol.data(), msg.symbol.size());
+    bool ok;
+    
+    if (msg.message_type == MessageType::MARKET_DATA_SUBSCRIBE) {
+        // Registered on first use: most connections never subscribe
+        if (conn.market_data_subscriber == MarketDataFanout::INVALID_SUBSCRIBER) {
+            conn.market_data_subscriber = fanout_.add_subscriber(reinterpret_cast<uint64_t>(&conn), 0);
+        }
+        ok = fanout_.subscribe(conn.market_data_subscriber, msg.instrument);
+    } else {
+        ok = fanout_.unsubscribe(conn.market_data_subscriber, msg.instrument);
+    }
+    
+    Message reply;
+    reply.message_id = msg.message_id;
+    reply.sequence_number = msg.sequence_number;
+    reply.message_type = ok ? MessageType::MARKET_DATA_ACK : MessageType::ERROR;
+    reply.status = ok ? MessageStatus::PROCESSED : MessageStatus::FAILED;
+    reply.update_timestamp();
+    
+    // A new subscriber starts from the cached top of book rather than waiting
+    // for the next update. Its sequence is the update count it reflects, so
+    // live updates at or below it can be discarded
+    TopOfBook state;
+    if (ok && msg.message_type == MessageType::MARKET_DATA_SUBSCRIBE && market_->read(msg.instrument, state)) {
+        wire::MarketDataBody body = wire::make_market_data_body(
+            msg.symbol.data(), msg.symbol.size(), state.bid_price, state.bid_size, state.ask_price,
+            state.ask_size, state.last_price, state.last_size, state.volume, state.high_price, state.low_price);
+        uint8_t frames[2 * wire::MAX_FRAME_SIZE];
+        size_t length = wire::write_frame(frames, MessageType::MARKET_DATA, msg.message_id,
+                                          TscClock::instance().wall_ns(), state.updates, &body);
+        length += wire::encode(reply, frames + length);
+        HFTServer::get_instance().send_frame(conn, frames, length);
+    } else {
+        HFTServer::get_instance().send_response(conn, reply);
+    }
+    
+    HFT_LOG_INFO("{} {} -> {}", msg.message_type == MessageType::MARKET_DATA_SUBSCRIBE
+                 ? "Subscribe" : "Unsubscribe", symbol, ok ? "OK" : "FAILED");
 }
 
 void MarketDataService::broadcast_market_data(const MarketDataMessage& data) {
-    // Broadcast market data to all connected clients
-    // In real implementation, you'd maintain a list of market data subscribers
-    std::cout << "Broadcasting market data for " << data.symbol.data() << std::endl;
+    std::string_view symbol = MatchingEngine::symbol_view(data.symbol.data(), data.symbol.size());
+    if (data.instrument == NO_INSTRUMENT) {
+        HFT_LOG_DEBUG("Market data for unknown symbol {} dropped", symbol);
+        return;
+    }
+    
+    wire::MarketDataBody body = wire::make_market_data_body(
+        data.symbol.data(), data.symbol.size(), data.bid_price, data.bid_size, data.ask_price,
+        data.ask_size, data.last_price, data.last_size, data.volume, data.high_price, data.low_price);
+    
+    // Before the fan-out: a subscriber that misses this update live finds it in its snapshot
+    TopOfBook quote;
+    quote.bid_price = data.bid_price;
+    quote.bid_size = data.bid_size;
+    quote.ask_price = data.ask_price;
+    quote.ask_size = data.ask_size;
+    quote.last_price = data.last_price;
+    quote.last_size = data.last_size;
+    quote.volume = data.volume;
+    quote.high_price = data.high_price;
+    quote.low_price = data.low_price;
+    
+    size_t subscribers;
+    {
+        // Two workers may carry updates for one instrument
+        std::lock_guard<std::mutex> lock(publish_locks_[data.instrument % PUBLISH_STRIPES]);
+        market_->update(data.instrument, quote);
+        subscribers = fanout_.publish(data.instrument, body, data.message_id);
+        if (feed_) {
+            feed_->publish(data.instrument, body);
+        }
+    }
+    if (subscribers > 0) {
+        fanout_.flush(0, *this);
+    }
+    HFT_LOG_DEBUG("Market data for {} queued to {} subscribers", symbol, subscribers);
 }
 
-} // namespace hft 
\ No newline at end of file
+} // namespace hft
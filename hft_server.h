@@ -2,15 +2,35 @@
 #define HFT_SERVER_H
 
 #include "message.h"
+#include "wire_protocol.h"
+#include "frame_scanner.h"
+#include "frame_buffer.h"
+#include "order_book.h"
+#include "thread_affinity.h"
+#include "connection_table.h"
+#include "latency_histogram.h"
+#include "market_data_fanout.h"
+#include "market_state.h"
+#include "multicast_feed.h"
+#include "transport.h"
+#include "busy_poll.h"
+#include "outbound_queue.h"
+#include "risk_engine.h"
+#include "journal.h"
+#include "instrument_directory.h"
+#include "session.h"
+#include "server_counters.h"
+#include "metrics_segment.h"
+#include "warmup.h"
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <functional>
 #include <chrono>
 #include <mutex>
-#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -27,11 +47,32 @@ namespace hft {
 struct Connection {
     int fd;                         // File descriptor
     sockaddr_in addr;               // Client address
-    std::chrono::steady_clock::time_point last_heartbeat;
     uint64_t client_id;
+    uint64_t handle;                // Connection table handle, also the transport cookie
+    size_t shard_id;                // Worker shard whose table owns the connection
+    size_t owner;                   // Worker that accepted it; with per-thread transports, its only sender
+    uint32_t client_index;          // Dense across shards, below HFTServer::client_capacity()
+    uint64_t account;               // Named by LOGIN; risk state follows it across connections
     bool is_authenticated;
+    uint64_t market_data_subscriber; // Fan-out registration, once the client subscribes
+    FrameBuffer recv_buffer;        // Reassembly buffer for partial frames
+    Session session;                // Login, inbound sequence and liveness; timer on the shard wheel
     
-    Connection() : fd(-1), client_id(0), is_authenticated(false) {
+    // Send side. Fills arrive from whichever worker matched them, so
+    // everything below, fd and handle included, changes under send_lock.
+    // Only the owner writes with per-thread transports; other threads
+    // queue here and post the connection to the owner's SendInbox
+    std::mutex send_lock;
+    OutboundQueue outbound;         // Responses queued this pass, or a backlog
+    bool send_scheduled;            // On some worker's flush list or send inbox
+    bool write_blocked;             // Socket full; waiting for WRITABLE
+    bool read_paused;               // Backlog above the high-water mark; not reading
+    bool send_failed;               // Broken or cut off; nothing more is queued
+    
+    Connection() : fd(-1), client_id(0), handle(0), shard_id(0), owner(0), client_index(0), account(0),
+                   is_authenticated(false),
+                   market_data_subscriber(MarketDataFanout::INVALID_SUBSCRIBER),
+                   send_scheduled(false), write_blocked(false), read_paused(false), send_failed(false) {
         memset(&addr, 0, sizeof(addr));
     }
 };
@@ -45,34 +86,174 @@ public:
     virtual void process_message(const Message& msg, Connection& conn) = 0;
     virtual void on_connection_established(Connection& conn) = 0;
     virtual void on_connection_closed(Connection& conn) = 0;
+    
+    /**
+     * @brief Deferred work; every worker calls it once per event loop pass
+     */
+    virtual void poll() {}
 };
 
 /**
  * @brief Order management service
+ *
+ * Runs every order through a per-symbol MatchingEngine, acks or rejects the
+ * sender, and delivers fills to both sides. Resting orders are cancelled when
+ * their connection closes, so the engine never holds a dangling owner.
+ *
+ * Instruments are spread over book shards by id, each with its own engine
+ * and lock, so workers matching different shards never wait on each other.
+ *
+ * New orders and replaces are checked against the instrument's tick, lot
+ * and price limits and then, with a RiskEngine, against the client's risk
+ * limits, under the shard lock just before matching; cancels always go
+ * through.
+ *
+ * With a Journal, every order event that reaches the engine is appended
+ * under the shard lock before it is applied, so each instrument's events
+ * replay in the order they matched, along with cancel-on-disconnect
+ * of connections that still had orders resting. recover() replays such a
+ * journal into the engine, then cancels what the replayed connections left
+ * resting: no client could cancel those orders or receive their fills.
  */
-class OrderService : public IMessageService {
+class OrderService : public IMessageService, public IFillListener {
 public:
+    explicit OrderService(const OrderBookConfig& config = OrderBookConfig{}, uint32_t book_shards = 1);
+    
+    /**
+     * @brief Check orders before matching; call before the server starts
+     */
+    void set_risk_engine(std::shared_ptr<RiskEngine> risk) { risk_ = std::move(risk); }
+    
+    /**
+     * @brief Journal order events before matching them; call before the server starts
+     */
+    void set_journal(std::shared_ptr<Journal> journal) { journal_ = std::move(journal); }
+    
+    /**
+     * @brief Size the books of the directory's instruments from their reference data; call before the server starts
+     */
+    void configure_books(const InstrumentDirectory& directory);
+    
+    /**
+     * @brief Replay a journal and cancel the orders it leaves resting; returns the records applied
+     */
+    size_t recover(JournalReader& reader, size_t& cancelled);
+    
+    
     void process_message(const Message& msg, Connection& conn) override;
     void on_connection_established(Connection& conn) override;
     void on_connection_closed(Connection& conn) override;
+    void on_fill(const FillMessage& fill, uint64_t owner) override;
+    void on_resting(InstrumentId instrument, OrderSide side, int64_t change, uint64_t owner) override;
     
 private:
+    /**
+     * @brief Books of the instruments that map to it, behind their own lock
+     */
+    struct BookShard {
+        explicit BookShard(const OrderBookConfig& config) : engine(config) {}
+        
+        std::mutex mutex;
+        MatchingEngine engine;
+    };
+    
+    BookShard& shard_for(InstrumentId instrument) { return *shards_[instrument % shards_.size()]; }
+    
     void handle_new_order(const OrderMessage& order, Connection& conn);
-    void handle_cancel_order(const Message& msg, Connection& conn);
-    void handle_replace_order(const Message& msg, Connection& conn);
+    void handle_cancel_order(const OrderMessage& msg, Connection& conn);
+    void handle_replace_order(const OrderMessage& msg, Connection& conn);
+    void send_execution_report(const OrderMessage& order, OrderResult result, Connection& conn);
+    OrderResult check_risk(const OrderMessage& order, const Connection& conn, uint32_t replaced = 0);
+    void journal_order(const OrderMessage& order, const Connection& conn);
+    
+    OrderBookConfig book_config_;       // Defaults for books the directory says nothing about
+    std::vector<std::unique_ptr<BookShard>> shards_;
+    std::shared_ptr<RiskEngine> risk_;  // Used under risk_mutex_; null when checks are off
+    std::shared_ptr<Journal> journal_;  // Appended under journal_mutex_; null when off
+    std::mutex risk_mutex_;             // Taken inside a shard lock, for one call at a time
+    std::mutex journal_mutex_;          // Taken inside a shard lock, for one append at a time
 };
 
 /**
  * @brief Market data service
+ *
+ * Clients subscribe per symbol. Every MARKET_DATA update received is
+ * encoded once and fanned out to that symbol's subscribers, with stale
+ * updates conflated for subscribers whose connections are backed up. The
+ * worker that publishes flushes right away; poll() retries whatever the
+ * connections could not take. Frames join each connection's outbound
+ * queue behind its responses, through HFTServer::send_frames().
  */
-class MarketDataService : public IMessageService {
+class MarketDataService : public IMessageService, public FanoutSink {
 public:
+    explicit MarketDataService(const FanoutConfig& config = FanoutConfig{});
+    
     void process_message(const Message& msg, Connection& conn) override;
     void on_connection_established(Connection& conn) override;
     void on_connection_closed(Connection& conn) override;
+    void poll() override;
+    int deliver(uint64_t target, const struct iovec* frames, int count) override;
+    
+    FanoutStats fanout_stats() const { return fanout_.stats(); }
+    
+    /**
+     * @brief Also publish every update on a UDP multicast feed; call before the server starts
+     */
+    bool enable_multicast(const MulticastConfig& config);
+    
+    /**
+     * @brief The multicast feed, or nullptr when it is off
+     */
+    const MulticastFeed* multicast_feed() const { return feed_.get(); }
+    
+    /**
+     * @brief Top of book per instrument as last published; risk engines read their bands from it
+     */
+    std::shared_ptr<const MarketStateCache> market_state() const { return market_; }
     
 private:
     void broadcast_market_data(const MarketDataMessage& data);
+    void handle_subscription(const SubscriptionMessage& msg, Connection& conn);
+    void handle_recovery(const RecoveryRequestMessage& msg, Connection& conn);
+    
+    static constexpr size_t PUBLISH_STRIPES = 64;
+    
+    MarketDataFanout fanout_;
+    std::unique_ptr<MulticastFeed> feed_;
+    std::shared_ptr<MarketStateCache> market_;
+    
+    // By instrument modulo PUBLISH_STRIPES. Held across the cache update and
+    // the publishes, so they see one instrument's updates in the same order
+    // and a snapshot's update count matches the fan-out sequence
+    std::array<std::mutex, PUBLISH_STRIPES> publish_locks_;
+};
+
+/**
+ * @brief Worker threading model
+ *
+ * By default all workers wait on one epoll instance and share the listener.
+ * In sharded mode each worker owns a SO_REUSEPORT listener, its own epoll
+ * instance and the connections the kernel hands to that listener.
+ *
+ * With the io_uring transport every worker has its own ring, and a
+ * connection belongs to the ring of the worker that accepted it.
+ *
+ * Responses are queued per connection and written once per loop pass.
+ * A connection whose backlog crosses outbound.high_water stops being read
+ * (epoll only; io_uring receives on its own) until the backlog halves.
+ */
+struct WorkerOptions {
+    bool sharded = false;
+    std::vector<int> cpu_affinity;  // Worker i runs on cpu_affinity[i % size]; empty = unpinned
+    uint32_t max_connections = 16384; // Connection table capacity per shard
+    uint32_t event_batch = 1024;    // Transport events a worker takes per wait
+    uint32_t listen_backlog = 1024;
+    TransportOptions transport;
+    BusyPollOptions busy_poll;      // Spin instead of sleeping between polls
+    OutboundLimits outbound;        // Per-connection send backlog marks
+    SessionConfig session;          // Heartbeat and idle timers, login policy
+    std::string metrics_segment;    // Shared memory object for an exporter; empty = off
+    WarmupConfig warmup;            // Synthetic orders before the listeners open; off by default
 };
 
 /**
@@ -89,47 +270,190 @@ public:
     /**
      * @brief Initialize the server
      */
-    bool initialize(const std::string& ip, uint16_t port, size_t thread_count = 4);
+    bool initialize(const std::string& ip, uint16_t port, size_t thread_count = 4,
+                    const WorkerOptions& options = WorkerOptions{});
     
     /**
-     * @brief Start the server
+     * @brief Start the workers, warm them up if configured, then open the listeners
+     *
+     * With warm-up on, this returns only once the warm-up rounds are done;
+     * counters and latency start from zero when the listeners open. False,
+     * with the server stopped, if warm-up did not wind down or no listener
+     * opened.
      */
-    void start();
+    bool start();
     
     /**
      * @brief Stop the server
      */
     void stop();
     
+    bool is_running() const { return running_.load(std::memory_order_relaxed); }
+    
     /**
      * @brief Get server statistics
+     *
+     * Each call merges the workers' latency histograms and counter blocks;
+     * the latency interval view covers everything recorded since the
+     * previous call.
      */
     struct ServerStats {
         uint64_t total_messages_processed;
         uint64_t total_connections;
-        double avg_latency_us;
+        uint64_t active_connections;
         uint64_t peak_connections;
+        CounterSnapshot counters;      // Summed over the workers
+        LatencyReport latency;
     };
     
     ServerStats get_stats() const;
     
     /**
-     * @brief Register a message service
+     * @brief Segment the workers' counters and histograms live in; null when off
+     */
+    MetricsSegment* metrics() { return metrics_.get(); }
+    
+    /**
+     * @brief Sample connection gauges into the segment and stamp it; monitor thread only
+     *
+     * Callers set any gauges of their own (market data, risk) first.
+     */
+    void publish_metrics();
+    
+    /**
+     * @brief Upper bound on Connection::client_index; valid after initialize()
+     */
+    uint32_t client_capacity() const;
+    
+    /**
+     * @brief Directory every decoded symbol is resolved against; only before start()
+     *
+     * Defaults to an open directory of InstrumentDirectory::DEFAULT_CAPACITY
+     * symbols. instruments() is the one the calling worker resolves in: a
+     * private directory while it serves warm-up traffic against an open one.
+     */
+    void set_instruments(std::shared_ptr<InstrumentDirectory> instruments);
+    InstrumentDirectory& instruments() { return thread_instruments_ ? *thread_instruments_ : *instruments_; }
+    
+    /**
+     * @brief Register a message service; only before start()
+     *
+     * start() freezes the registrations into a table indexed by message
+     * type, so dispatching a message takes neither a lock nor a refcount.
      */
     void register_service(MessageType type, std::shared_ptr<IMessageService> service);
     
+    /**
+     * @brief Register the service warm-up orders go to instead; only before start()
+     *
+     * Give it a book and risk state of its own: warm-up orders are real
+     * orders as far as the service can tell.
+     */
+    void register_warmup_service(MessageType type, std::shared_ptr<IMessageService> service);
+    
+    /**
+     * @brief Encode and send a message to a connected client
+     */
+    void send_response(Connection& conn, const Message& response);
+    void send_response(Connection& conn, const FillMessage& response);
+    
+    /**
+     * @brief Queue frames that are already encoded
+     */
+    void send_frame(Connection& conn, const uint8_t* frame, size_t frame_length);
+    
+    /**
+     * @brief Queue whole frames up to the high-water mark; returns how many were taken, or -1 once closed
+     *
+     * For market data, which conflates what a backed-up connection cannot take.
+     */
+    int send_frames(Connection& conn, const struct iovec* frames, int count);
+    
 private:
+    // Drives dispatch_frame() without sockets or worker threads (hot_path_benchmark.cpp)
+    friend class DispatchBenchmark;
+    
+    /**
+     * @brief Listener, transport and connections served by one or more workers
+     */
+    struct Shard {
+        Shard(uint32_t max_connections, uint64_t now_ns)
+            : connections(max_connections), timers(SESSION_TICK_NS, now_ns) {}
+        
+        size_t id{0};
+        int listen_fd{-1};
+        std::unique_ptr<Transport> transport; // Shared by the shard's workers; null with per-thread transports
+        ConnectionTable<Connection> connections;
+        
+        // Session timers of the shard's connections. Whichever worker gets
+        // the lock advances the wheel; the others skip it for that pass
+        std::mutex timer_lock;
+        TimerWheel timers;
+    };
+    
+    /**
+     * @brief Connections other threads queued bytes for, waiting on their owning worker
+     *
+     * Only with per-thread transports: every byte of a socket goes through
+     * the ring of the worker that accepted it, so a short send there can
+     * never be overtaken by a send from another ring.
+     */
+    struct SendInbox {
+        std::mutex lock;
+        std::vector<std::pair<Connection*, uint64_t>> connections;  // With the handle each was posted under
+        std::atomic<bool> pending{false};
+    };
+    
+    /**
+     * @brief Registered services frozen for lock-free dispatch
+     */
+    struct DispatchTable {
+        std::array<IMessageService*, 256> by_type{}; // By message type; null = unhandled
+        std::vector<IMessageService*> services;      // Each registered service once
+    };
+    
+    using ServiceMap = std::unordered_map<MessageType, std::shared_ptr<IMessageService>>;
+    
     HFTServer() = default;
     ~HFTServer();
     
+    bool open_shard(Shard& shard);
+    bool open_listeners();
+    void close_shards();
+    bool warm_up();
+    bool poll_warmup(Shard& shard, size_t thread_id);
     void worker_thread(size_t thread_id);
-    void accept_connections();
-    void handle_client_events(int client_fd);
+    void accept_connections(Shard& shard);
+    void open_connection(Shard& shard, int client_fd, const sockaddr_in& client_addr);
+    void handle_client_events(Shard& shard, uint64_t handle);
+    void handle_client_data(Shard& shard, uint64_t handle, const uint8_t* data, size_t length);
+    void handle_client_writable(Shard& shard, uint64_t handle);
+    bool pause_if_congested(Shard& shard, Connection& conn);
+    template<typename Encode>
+    void enqueue(Connection& conn, size_t max_length, Encode&& encode);
+    void schedule_send(Connection& conn);
+    size_t send_backlog(const Connection& conn) const;
+    void collect_posted_sends(size_t worker);
+    void write_outbound(Connection& conn);
+    void flush_outbound();
+    size_t drain_frames(Connection& conn);
+    bool session_frame(const uint8_t* frame, Connection& conn);
+    void dispatch_frame(const uint8_t* frame, Connection& conn);
+    void rearm_connection(Connection& conn);
+    void freeze_dispatch();
+    void freeze(const ServiceMap& services, DispatchTable& table) const;
     void process_client_message(const Message& msg, Connection& conn);
     void process_client_message(const OrderMessage& msg, Connection& conn);
     void process_client_message(const MarketDataMessage& msg, Connection& conn);
-    void send_response(Connection& conn, const Message& response);
+    void dispatch_message(const Message& msg, Connection& conn);
     void close_connection(Connection& conn);
+    void schedule_session(Shard& shard, Connection& conn);
+    void expire_sessions(Shard& shard);
+    void expire_session(Shard& shard, uint64_t handle);
+    void send_session_frame(Connection& conn, MessageType type, uint32_t sequence, uint64_t message_id);
+    void notify_connection_established(Connection& conn);
+    void notify_connection_closed(Connection& conn);
+    std::vector<std::shared_ptr<IMessageService>> unique_services(const ServiceMap& services) const;
     void setup_socket_options(int sock_fd);
     void set_non_blocking(int sock_fd);
     
@@ -137,35 +461,58 @@ private:
     std::string server_ip_;
     uint16_t server_port_;
     size_t thread_count_;
+    WorkerOptions options_;
     
     // Server state
     std::atomic<bool> running_{false};
-    int server_socket_{-1};
-    int epoll_fd_{-1};
+    std::atomic<bool> listening_{false};  // Listeners open; per-thread transports then watch theirs
+    
+    // Warm-up: start() hands each worker one loopback connection through its
+    // slot (-1 = empty) and clears warming_ when done; each worker then
+    // switches to the real services and counts itself in warmed_up_
+    std::atomic<bool> warming_{false};
+    std::atomic<size_t> warmed_up_{0};
+    std::unique_ptr<std::atomic<int>[]> warmup_fds_;
     
     // Threading
     std::vector<std::thread> worker_threads_;
     
-    // Connections
-    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
-    mutable std::mutex connections_mutex_;
+    // One shard per worker in sharded mode, otherwise a single shared shard
+    std::vector<std::unique_ptr<Shard>> shards_;
+    
+    // Per-thread transports, one per worker, when the backend needs them,
+    // and each worker's inbox of connections to send for
+    std::vector<std::unique_ptr<Transport>> worker_transports_;
+    std::unique_ptr<SendInbox[]> send_inboxes_;
+    
+    // Services. The maps own the registrations; the workers only read the
+    // frozen tables below, which start() builds and stop() clears
+    ServiceMap services_;
+    ServiceMap warmup_services_;
+    mutable std::mutex services_mutex_;          // Registration only
+    DispatchTable dispatch_;
+    DispatchTable warmup_dispatch_;
+    static thread_local const DispatchTable* thread_dispatch_;  // The table the calling worker serves
     
-    // Services
-    std::unordered_map<MessageType, std::shared_ptr<IMessageService>> services_;
-    mutable std::mutex services_mutex_;
+    // Symbols resolved at decode; everything past dispatch works by instrument id.
+    // Warm-up symbols interned into an open directory would stay there for
+    // good, so warm-up traffic resolves in a directory of its own
+    std::shared_ptr<InstrumentDirectory> instruments_ = std::make_shared<InstrumentDirectory>();
+    std::unique_ptr<InstrumentDirectory> warmup_directory_;
+    static thread_local InstrumentDirectory* thread_instruments_;  // The directory the calling worker resolves in
     
-    // Statistics
-    mutable std::mutex stats_mutex_;
-    ServerStats stats_{};
+    // Connection counts; only accepts and closes touch them
+    std::atomic<uint64_t> total_connections_{0};
+    std::atomic<uint64_t> active_connections_{0};
+    std::atomic<uint64_t> peak_connections_{0};
     
-    // Performance optimization
-    static constexpr size_t MAX_EVENTS = 1024;
-    static constexpr size_t BUFFER_SIZE = 4096;
-    static constexpr int BACKLOG = 1024;
+    // One latency recorder and one counter block per worker, in metrics_
+    // when there is one
+    std::unique_ptr<MetricsSegment> metrics_;
+    std::unique_ptr<LatencyTracker> latency_;
+    std::unique_ptr<CounterSet> counters_;
     
-    // Pre-allocated buffers for zero-copy operations
-    std::vector<uint8_t> send_buffer_;
-    std::vector<uint8_t> recv_buffer_;
+    static constexpr uint64_t SESSION_TICK_NS = 1000000; // Timer wheel resolution
 };
 
 } // namespace hft
@@ -0,0 +1,647 @@
+#include "hft_server.h"
+#include "ultra_hft_server.h"
+#include "latency_histogram.h"
+#include "lock_free_queue.h"
+#include "frame_scanner.h"
+#include "instrument_directory.h"
+#include "market_state.h"
+#include "order_book.h"
+#include "server_counters.h"
+#include "thread_affinity.h"
+#include "tsc_clock.h"
+#include "wire_protocol.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hft {
+
+// Friend of HFTServer: what a worker runs once a frame is reassembled,
+// decode through service dispatch, with the production market data service
+class DispatchBenchmark {
+public:
+    DispatchBenchmark()
+        : server_(HFTServer::get_instance()), service_(std::make_shared<MarketDataService>()) {
+        server_.register_service(MessageType::MARKET_DATA, service_);
+        server_.freeze_dispatch();
+    }
+    
+    void dispatch(const uint8_t* frame) {
+        server_.dispatch_frame(frame, connection_);
+    }
+
+private:
+    HFTServer& server_;
+    std::shared_ptr<MarketDataService> service_;
+    Connection connection_;          // fd -1: responses are dropped at the send queue
+};
+
+} // namespace hft
+
+namespace ultra_hft {
+
+// Friend of UltraHFTServer: an I/O worker's decode followed by the strategy
+// lane's process_event(), run back to back on one thread
+class DispatchBenchmark {
+public:
+    bool initialize() {
+        UltraServerConfig config;
+        config.port = 0;             // Never accepts; the listener only has to open
+        config.threads = 1;
+        server_ = std::make_unique<UltraHFTServer>(config);
+        return server_->initialize();
+    }
+    
+    void dispatch(const uint8_t* frame) {
+        event_.kind = IngressEvent::MARKET_DATA;
+        decode(frame, event_.market_data);
+        event_.market_data.instrument = server_->instruments_->resolve(event_.market_data.symbol);
+        server_->process_event(*server_->lanes_[0], event_);
+        
+        // Stand in for the send thread so the egress ring never fills
+        server_->egress_rings_[0]->consume_bulk([](const EgressEvent&) {}, 64);
+    }
+
+private:
+    std::unique_ptr<UltraHFTServer> server_;
+    IngressEvent event_{};
+};
+
+} // namespace ultra_hft
+
+namespace {
+
+using namespace hft;
+
+// Calls are timed in batches: a clock read costs as much as the cheapest
+// operations here, so timing every call would mostly measure the clock
+constexpr size_t BATCH = 64;
+constexpr size_t RING_SIZE = 4096;
+
+struct alignas(64) RingItem {
+    uint64_t sequence;
+    uint8_t payload[56];
+};
+
+struct BenchOptions {
+    uint64_t iterations = 1000000;
+    uint64_t trips = 200000;
+    std::vector<std::pair<int, int>> pairs;   // Ping-pong CPU pairs for the ring handoff
+    int cpu = -1;                              // CPU for the single-threaded benchmarks
+    std::string only;                          // Run one group
+    std::string json_path;
+};
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    uint64_t operations = 0;
+    double mean_ns = 0.0;
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+    double p999_ns = 0.0;
+};
+
+// Keeps a value live so the compiler cannot drop the work that produced it
+template<typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --iterations <n>     Calls per single-threaded benchmark (default: 1000000)" << std::endl;
+    std::cout << "  --trips <n>          Round trips per ring handoff pair (default: 200000)" << std::endl;
+    std::cout << "  --pairs <a:b,...>    CPU pairs for the ring handoff (default: 0:1, or 0:0 on one CPU)" << std::endl;
+    std::cout << "  --cpu <n>            Pin the single-threaded benchmarks to a CPU" << std::endl;
+    std::cout << "  --only <group>       Run one group: ring, wire, clock, dispatch, book, stats" << std::endl;
+    std::cout << "  --json <file>        Write the platform and every result as JSON" << std::endl;
+    std::cout << "  --help               Show this help message" << std::endl;
+}
+
+bool parse_pairs(const char* text, std::vector<std::pair<int, int>>& pairs) {
+    pairs.clear();
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        long a = std::strtol(p, &end, 10);
+        if (end == p || *end != ':') return false;
+        p = end + 1;
+        long b = std::strtol(p, &end, 10);
+        if (end == p || a < 0 || b < 0) return false;
+        pairs.emplace_back(static_cast<int>(a), static_cast<int>(b));
+        p = end;
+        if (*p == ',') {
+            ++p;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return !pairs.empty();
+}
+
+bool parse_arguments(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options.iterations = std::strtoull(argv[++i], nullptr, 10);
+            if (options.iterations < BATCH) {
+                std::cerr << "Iterations must be at least " << BATCH << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--trips") == 0 && i + 1 < argc) {
+            options.trips = std::strtoull(argv[++i], nullptr, 10);
+            if (options.trips == 0) {
+                std::cerr << "Invalid trip count" << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--pairs") == 0 && i + 1 < argc) {
+            if (!parse_pairs(argv[++i], options.pairs)) {
+                std::cerr << "Invalid CPU pairs: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            options.cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            options.only = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    
+    if (options.pairs.empty()) {
+        if (std::thread::hardware_concurrency() > 1) {
+            options.pairs.emplace_back(0, 1);
+        } else {
+            options.pairs.emplace_back(0, 0);
+        }
+    }
+    return true;
+}
+
+// Platform the figures were taken on, so results from different hosts are not compared blindly
+struct Platform {
+    std::string cpu_model = "unknown";
+    unsigned cpus = 0;
+    std::string clock;
+    std::string frequency = "unavailable";
+    std::string governor = "unavailable";
+};
+
+std::string read_first_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+Platform detect_platform(int cpu) {
+    Platform platform;
+    platform.cpus = std::thread::hardware_concurrency();
+    
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos && colon + 2 <= line.size()) {
+                platform.cpu_model = line.substr(colon + 2);
+            }
+            break;
+        }
+    }
+    
+    std::ostringstream clock;
+    TscClock::instance().describe(clock);
+    platform.clock = clock.str();
+    
+    std::string cpufreq = "/sys/devices/system/cpu/cpu" + std::to_string(cpu < 0 ? 0 : cpu) + "/cpufreq/";
+    std::string current = read_first_line(cpufreq + "scaling_cur_freq");
+    std::string maximum = read_first_line(cpufreq + "cpuinfo_max_freq");
+    if (!current.empty()) {
+        platform.frequency = std::to_string(std::strtoull(current.c_str(), nullptr, 10) / 1000) + " MHz";
+        if (!maximum.empty()) {
+            platform.frequency += " (max " + std::to_string(std::strtoull(maximum.c_str(), nullptr, 10) / 1000) + " MHz)";
+        }
+    }
+    std::string governor = read_first_line(cpufreq + "scaling_governor");
+    if (!governor.empty()) {
+        platform.governor = governor;
+    }
+    return platform;
+}
+
+void print_platform(const Platform& platform, const BenchOptions& options) {
+    std::cout << "Hot path benchmark" << std::endl;
+    std::cout << "  CPU:        " << platform.cpu_model << " (" << platform.cpus << " online)" << std::endl;
+    std::cout << "  Clock:      " << platform.clock << std::endl;
+    std::cout << "  Frequency:  " << platform.frequency << ", governor " << platform.governor << std::endl;
+    std::cout << "  Pinned to:  " << (options.cpu < 0 ? std::string("unpinned") : "CPU " + std::to_string(options.cpu))
+              << ", ring pairs";
+    for (const auto& pair : options.pairs) {
+        std::cout << " " << pair.first << ":" << pair.second;
+    }
+    std::cout << std::endl;
+    if (platform.cpus < 2) {
+        std::cout << "  (single CPU: ring handoffs time-share one core, figures exclude cross-core traffic)" << std::endl;
+    }
+}
+
+BenchResult summarize(const char* group, const std::string& name, const HistogramSnapshot& snapshot,
+                      uint64_t total_ns, uint64_t operations, double scale) {
+    BenchResult result;
+    result.group = group;
+    result.name = name;
+    result.operations = operations;
+    result.mean_ns = static_cast<double>(total_ns) / static_cast<double>(operations);
+    result.p50_ns = static_cast<double>(snapshot.value_at(0.50)) / scale;
+    result.p99_ns = static_cast<double>(snapshot.value_at(0.99)) / scale;
+    result.p999_ns = static_cast<double>(snapshot.value_at(0.999)) / scale;
+    return result;
+}
+
+// Time fn(i) for i in [0, iterations) in batches of BATCH after a warm-up of
+// a tenth as many calls; percentiles are of the per-call average of each batch
+template<typename Fn>
+BenchResult measure(const char* group, const char* name, uint64_t iterations, Fn&& fn) {
+    const TscClock& clock = TscClock::instance();
+    uint64_t batches = iterations / BATCH;
+    for (uint64_t i = 0; i < iterations / 10; ++i) {
+        fn(i);
+    }
+    
+    auto histogram = std::make_unique<LatencyHistogram>();
+    uint64_t total_ns = 0;
+    for (uint64_t b = 0; b < batches; ++b) {
+        uint64_t start = clock.ticks();
+        for (uint64_t i = b * BATCH; i < (b + 1) * BATCH; ++i) {
+            fn(i);
+        }
+        uint64_t elapsed = clock.ticks_to_ns(clock.ticks_ordered() - start);
+        histogram->record(elapsed);
+        total_ns += elapsed;
+    }
+    
+    HistogramSnapshot snapshot;
+    snapshot.add(*histogram);
+    return summarize(group, name, snapshot, total_ns, batches * BATCH, BATCH);
+}
+
+// One-way handoff latency between two pinned threads: half of each ping-pong
+// round trip through a pair of SPSC rings
+BenchResult measure_handoff(const BenchOptions& options, int ping_cpu, int pong_cpu) {
+    using Ring = ultra_hft::LockFreeRingBuffer<RingItem, RING_SIZE>;
+    auto ping = std::make_unique<Ring>();
+    auto pong = std::make_unique<Ring>();
+    auto histogram = std::make_unique<LatencyHistogram>();
+    
+    // Spinners on a shared core only starve each other
+    bool yield = ping_cpu == pong_cpu || std::thread::hardware_concurrency() < 2;
+    uint64_t warmup = options.trips / 10;
+    uint64_t trips = warmup + options.trips;
+    uint64_t total_ns = 0;
+    
+    std::thread echo([&]() {
+        pin_current_thread(pong_cpu);
+        RingItem item;
+        for (uint64_t i = 0; i < trips; ++i) {
+            while (!ping->pop(item)) {
+                if (yield) std::this_thread::yield();
+            }
+            while (!pong->push(item)) {
+                if (yield) std::this_thread::yield();
+            }
+        }
+    });
+    
+    std::thread driver([&]() {
+        pin_current_thread(ping_cpu);
+        const TscClock& clock = TscClock::instance();
+        RingItem item{};
+        for (uint64_t i = 0; i < trips; ++i) {
+            item.sequence = i;
+            uint64_t start = clock.ticks();
+            while (!ping->push(item)) {
+                if (yield) std::this_thread::yield();
+            }
+            while (!pong->pop(item)) {
+                if (yield) std::this_thread::yield();
+            }
+            uint64_t elapsed = clock.ticks_to_ns(clock.ticks_ordered() - start);
+            if (i >= warmup) {
+                histogram->record(elapsed);
+                total_ns += elapsed;
+            }
+        }
+    });
+    
+    driver.join();
+    echo.join();
+    
+    HistogramSnapshot snapshot;
+    snapshot.add(*histogram);
+    std::string name = "SPSC handoff CPU " + std::to_string(ping_cpu) + " -> " + std::to_string(pong_cpu);
+    return summarize("ring", name, snapshot, total_ns / 2, options.trips, 2.0);
+}
+
+void report(const BenchResult& result) {
+    std::cout << "  " << std::left << std::setw(42) << result.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << result.mean_ns << std::setw(10) << result.p50_ns
+              << std::setw(10) << result.p99_ns << std::setw(10) << result.p999_ns << std::endl;
+}
+
+bool write_json(const std::string& path, const Platform& platform, const BenchOptions& options,
+                const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    
+    // Nothing written here needs escaping beyond quotes in the CPU model
+    auto quoted = [](const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return "\"" + escaped + "\"";
+    };
+    
+    out << "{" << std::endl;
+    out << "  \"platform\": {\"cpu_model\": " << quoted(platform.cpu_model) << ", \"cpus\": " << platform.cpus
+        << ", \"clock\": " << quoted(platform.clock) << ", \"frequency\": " << quoted(platform.frequency)
+        << ", \"governor\": " << quoted(platform.governor) << ", \"cpu\": " << options.cpu << ", \"pairs\": [";
+    for (size_t i = 0; i < options.pairs.size(); ++i) {
+        out << (i ? ", " : "") << "[" << options.pairs[i].first << ", " << options.pairs[i].second << "]";
+    }
+    out << "]}," << std::endl;
+    
+    out << "  \"results\": [" << std::endl << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"group\": " << quoted(r.group) << ", \"name\": " << quoted(r.name)
+            << ", \"operations\": " << r.operations << ", \"mean_ns\": " << r.mean_ns << ", \"p50_ns\": "
+            << r.p50_ns << ", \"p99_ns\": " << r.p99_ns << ", \"p999_ns\": " << r.p999_ns << "}"
+            << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl << "}" << std::endl;
+    return static_cast<bool>(out);
+}
+
+OrderMessage sample_order(uint64_t i) {
+    OrderMessage order;
+    order.message_id = i + 1;
+    order.timestamp = 1700000000000000000ULL + i;
+    memcpy(order.symbol.data(), "AAPL", 4);
+    order.order_id = i + 1;
+    order.client_order_id = i + 1;
+    order.quantity = 100;
+    order.price = 1500000 + (i & 0xFF);
+    return order;
+}
+
+MarketDataMessage sample_market_data(uint64_t i) {
+    MarketDataMessage data;
+    data.message_id = i + 1;
+    data.timestamp = 1700000000000000000ULL + i;
+    memcpy(data.symbol.data(), "AAPL", 4);
+    data.bid_price = 1500000 + (i & 0xFF);
+    data.bid_size = 1000;
+    data.ask_price = data.bid_price + 100;
+    data.ask_size = 1000;
+    data.last_price = data.bid_price + 50;
+    data.volume = 10000 + i;
+    return data;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parse_arguments(argc, argv, options)) {
+        return 1;
+    }
+    if (options.cpu >= 0 && !pin_current_thread(options.cpu)) {
+        std::cerr << "Failed to pin to CPU " << options.cpu << std::endl;
+        return 1;
+    }
+    
+    // Calibrate before anything is timed; the ultra server prints its banner as it starts
+    Platform platform = detect_platform(options.cpu);
+    ultra_hft::DispatchBenchmark ultra_dispatch;
+    bool run_dispatch = options.only.empty() || options.only == "dispatch";
+    if (run_dispatch && !ultra_dispatch.initialize()) {
+        std::cerr << "Failed to initialize the ultra server for the dispatch benchmark" << std::endl;
+        return 1;
+    }
+    
+    print_platform(platform, options);
+    std::cout << "  " << std::left << std::setw(42) << "ns per operation" << std::right << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::endl;
+    
+    std::vector<BenchResult> results;
+    auto group = [&](const char* name) {
+        if (!options.only.empty() && options.only != name) return false;
+        std::cout << name << std::endl;
+        return true;
+    };
+    auto track = [&results](const BenchResult& result) {
+        report(result);
+        results.push_back(result);
+    };
+    uint64_t n = options.iterations;
+    
+    if (group("ring")) {
+        using Ring = ultra_hft::LockFreeRingBuffer<RingItem, RING_SIZE>;
+        auto ring = std::make_unique<Ring>();
+        RingItem item{};
+        track(measure("ring", "SPSC push + pop, one thread", n, [&](uint64_t i) {
+            item.sequence = i;
+            ring->push(item);
+            ring->pop(item);
+            keep(item.sequence);
+        }));
+        for (const auto& pair : options.pairs) {
+            track(measure_handoff(options, pair.first, pair.second));
+        }
+    }
+    
+    if (group("wire")) {
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        OrderMessage order = sample_order(0);
+        MarketDataMessage data = sample_market_data(0);
+        track(measure("wire", "encode ORDER_NEW", n, [&](uint64_t i) {
+            order.order_id = i;
+            keep(wire::encode(order, frame));
+            keep(frame);
+        }));
+        track(measure("wire", "decode ORDER_NEW", n, [&](uint64_t) {
+            OrderMessage decoded;
+            wire::decode(frame, decoded);
+            keep(decoded);
+        }));
+        track(measure("wire", "encode MARKET_DATA", n, [&](uint64_t i) {
+            data.volume = i;
+            keep(wire::encode(data, frame));
+            keep(frame);
+        }));
+        track(measure("wire", "decode MARKET_DATA", n, [&](uint64_t) {
+            MarketDataMessage decoded;
+            wire::decode(frame, decoded);
+            keep(decoded);
+        }));
+        track(measure("wire", "peek_frame", n, [&](uint64_t) {
+            size_t length = 0;
+            keep(wire::peek_frame(frame, sizeof(frame), length));
+            keep(length);
+        }));
+        
+        // One recv's worth of a burst: orders and market data interleaved
+        std::vector<uint8_t> burst(wire::SCAN_BATCH * wire::MAX_FRAME_SIZE);
+        size_t burst_length = 0;
+        for (size_t i = 0; i < wire::SCAN_BATCH; ++i) {
+            burst_length += i % 2 ? wire::encode(order, burst.data() + burst_length)
+                                  : wire::encode(data, burst.data() + burst_length);
+        }
+        uint32_t offsets[wire::SCAN_BATCH];
+        track(measure("wire", "peek_frame x16", n, [&](uint64_t) {
+            size_t position = 0;
+            size_t length = 0;
+            while (wire::peek_frame(burst.data() + position, burst_length - position, length) ==
+                   wire::FrameStatus::COMPLETE) {
+                position += length;
+            }
+            keep(position);
+        }));
+        track(measure("wire", "scan_frames x16", n, [&](uint64_t) {
+            keep(wire::scan_frames(burst.data(), burst_length, offsets));
+            keep(offsets);
+        }));
+        
+        // A directory about as full as a busy session's
+        InstrumentDirectory instruments;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            instruments.resolve("SYM" + std::to_string(i));
+        }
+        instruments.resolve(order.symbol.data());
+        track(measure("wire", "InstrumentDirectory::resolve", n, [&](uint64_t) {
+            keep(instruments.resolve(order.symbol.data()));
+        }));
+    }
+    
+    if (group("clock")) {
+        const TscClock& clock = TscClock::instance();
+        track(measure("clock", "TscClock::ticks", n, [&](uint64_t) { keep(clock.ticks()); }));
+        track(measure("clock", "TscClock::now_ns", n, [&](uint64_t) { keep(clock.now_ns()); }));
+        track(measure("clock", "TscClock::wall_ns", n, [&](uint64_t) { keep(clock.wall_ns()); }));
+        track(measure("clock", "clock_gettime(CLOCK_MONOTONIC)", n, [&](uint64_t) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            keep(ts.tv_nsec);
+        }));
+        track(measure("clock", "clock_gettime(CLOCK_REALTIME)", n, [&](uint64_t) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            keep(ts.tv_nsec);
+        }));
+        track(measure("clock", "steady_clock::now", n, [&](uint64_t) {
+            keep(std::chrono::steady_clock::now().time_since_epoch().count());
+        }));
+        track(measure("clock", "system_clock::now", n, [&](uint64_t) {
+            keep(std::chrono::system_clock::now().time_since_epoch().count());
+        }));
+    }
+    
+    if (run_dispatch && group("dispatch")) {
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        MarketDataMessage data = sample_market_data(0);
+        wire::encode(data, frame);
+        
+        hft::DispatchBenchmark hft_dispatch;
+        track(measure("dispatch", "HFTServer MARKET_DATA frame", n, [&](uint64_t) {
+            hft_dispatch.dispatch(frame);
+        }));
+        track(measure("dispatch", "UltraHFTServer MARKET_DATA frame", n, [&](uint64_t) {
+            ultra_dispatch.dispatch(frame);
+        }));
+    }
+    
+    if (group("book")) {
+        // Every order is out of the book again by the end of its iteration
+        MatchingEngine engine;
+        constexpr InstrumentId AAPL = 0;
+        constexpr InstrumentId MSFT = 1;
+        track(measure("book", "submit resting limit + cancel", n, [&](uint64_t i) {
+            uint64_t order_id = i + 1;
+            keep(engine.submit_order(AAPL, "AAPL", order_id, OrderSide::BUY, OrderType::LIMIT, TimeInForce::GTC,
+                                     1500000 - (i & 0xFF), 100, 1));
+            keep(engine.cancel_order(AAPL, order_id, 1));
+        }));
+        track(measure("book", "submit resting limit + crossing IOC", n, [&](uint64_t i) {
+            uint64_t order_id = 2 * i + 1;
+            keep(engine.submit_order(MSFT, "MSFT", order_id, OrderSide::SELL, OrderType::LIMIT, TimeInForce::GTC,
+                                     3000000, 100, 1));
+            keep(engine.submit_order(MSFT, "MSFT", order_id + 1, OrderSide::BUY, OrderType::LIMIT, TimeInForce::IOC,
+                                     3000000, 100, 2));
+        }));
+        
+        MarketStateCache market(1024);
+        TopOfBook quote;
+        quote.bid_price = 1500000;
+        quote.ask_price = 1500100;
+        quote.bid_size = quote.ask_size = 100;
+        track(measure("book", "MarketStateCache::update", n, [&](uint64_t i) {
+            quote.last_price = 1500000 + (i & 0xFF);
+            market.update(static_cast<InstrumentId>(i & 1023), quote);
+        }));
+        track(measure("book", "MarketStateCache::read", n, [&](uint64_t i) {
+            TopOfBook state;
+            keep(market.read(static_cast<InstrumentId>(i & 1023), state));
+            keep(state);
+        }));
+    }
+    
+    if (group("stats")) {
+        auto histogram = std::make_unique<LatencyHistogram>();
+        auto counters = std::make_unique<CounterBlock>();
+        std::atomic<uint64_t> shared{0};
+        track(measure("stats", "LatencyHistogram::record", n, [&](uint64_t i) {
+            histogram->record(1000 + (i & 0x3FFF));
+        }));
+        track(measure("stats", "CounterBlock::add", n, [&](uint64_t) {
+            counters->add(Counter::BYTES_IN, 64);
+        }));
+        track(measure("stats", "CounterBlock::count_message", n, [&](uint64_t i) {
+            counters->count_message(static_cast<uint8_t>(i & 0x0F));
+        }));
+        track(measure("stats", "atomic fetch_add (shared counter)", n, [&](uint64_t) {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        }));
+        keep(shared.load());
+    }
+    
+    if (!options.json_path.empty() && !write_json(options.json_path, platform, options, results)) {
+        return 1;
+    }
+    return 0;
+}
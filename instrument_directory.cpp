@@ -0,0 +1,195 @@
+#include "instrument_directory.h"
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+namespace hft {
+
+namespace {
+
+bool parse_field(std::string_view text, uint64_t max, uint64_t& value) {
+    if (text.empty() || text.front() < '0' || text.front() > '9') {
+        return false;
+    }
+    std::string digits(text);
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(digits.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || parsed > max) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+bool load_instruments(const std::string& path, std::vector<InstrumentSpec>& instruments) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open instrument master " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::vector<InstrumentSpec> parsed;
+    std::unordered_set<std::string> seen;
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        InstrumentSpec spec;
+        if (!(fields >> spec.symbol)) {
+            continue;
+        }
+        if (spec.symbol.size() > InstrumentDirectory::SYMBOL_SIZE) {
+            std::cerr << path << ":" << number << ": symbol '" << spec.symbol << "' is longer than "
+                      << InstrumentDirectory::SYMBOL_SIZE << " characters" << std::endl;
+            return false;
+        }
+        if (!seen.insert(spec.symbol).second) {
+            std::cerr << path << ":" << number << ": duplicate symbol '" << spec.symbol << "'" << std::endl;
+            return false;
+        }
+
+        std::string field;
+        while (fields >> field) {
+            size_t equals = field.find('=');
+            if (equals == std::string::npos) {
+                std::cerr << path << ":" << number << ": expected key=value, got '" << field << "'" << std::endl;
+                return false;
+            }
+            std::string_view key = std::string_view(field).substr(0, equals);
+            std::string_view value_text = std::string_view(field).substr(equals + 1);
+
+            uint64_t value = 0;
+            bool ok;
+            if (key == "tick_size") {
+                ok = parse_field(value_text, UINT64_MAX, value) && value != 0;
+                spec.tick_size = value;
+            } else if (key == "lot_size") {
+                ok = parse_field(value_text, UINT32_MAX, value) && value != 0;
+                spec.lot_size = static_cast<uint32_t>(value);
+            } else if (key == "min_price") {
+                ok = parse_field(value_text, UINT64_MAX, value);
+                spec.min_price = value;
+            } else if (key == "max_price") {
+                ok = parse_field(value_text, UINT64_MAX, value);
+                spec.max_price = value;
+            } else if (key == "max_orders") {
+                ok = parse_field(value_text, UINT32_MAX, value) && value != 0;
+                spec.max_orders = static_cast<uint32_t>(value);
+            } else {
+                std::cerr << path << ":" << number << ": unknown instrument field '" << key << "'" << std::endl;
+                return false;
+            }
+
+            if (!ok) {
+                std::cerr << path << ":" << number << ": invalid value for " << key << std::endl;
+                return false;
+            }
+        }
+        if (spec.max_price != 0 && spec.max_price < spec.min_price) {
+            std::cerr << path << ":" << number << ": max_price is below min_price" << std::endl;
+            return false;
+        }
+        parsed.push_back(std::move(spec));
+    }
+
+    if (parsed.empty()) {
+        std::cerr << "Instrument master " << path << " lists no instruments" << std::endl;
+        return false;
+    }
+    instruments = std::move(parsed);
+    return true;
+}
+
+// InstrumentDirectory implementation
+InstrumentDirectory::InstrumentDirectory(uint32_t capacity) {
+    allocate(std::max<uint32_t>(capacity, 1));
+}
+
+InstrumentDirectory::InstrumentDirectory(const std::vector<InstrumentSpec>& master) {
+    allocate(std::max<uint32_t>(static_cast<uint32_t>(master.size()), 1));
+    for (const InstrumentSpec& spec : master) {
+        char field[SYMBOL_SIZE] = {};
+        memcpy(field, spec.symbol.data(), std::min(spec.symbol.size(), SYMBOL_SIZE));
+        if (find(field) == NO_INSTRUMENT) {
+            intern(pack(field), spec);
+        }
+    }
+    open_ = false;
+}
+
+void InstrumentDirectory::allocate(uint32_t capacity) {
+    capacity_ = capacity;
+
+    // Open addressing at no more than 50% load
+    size_t slot_count = std::bit_ceil(std::max<size_t>(static_cast<size_t>(capacity) * 2, 16));
+    slot_mask_ = slot_count - 1;
+    slot_shift_ = static_cast<uint32_t>(64 - std::countr_zero(slot_count));
+    slots_.reset(new Slot[slot_count]);
+
+    symbols_.reset(new std::array<char, SYMBOL_SIZE>[capacity]());
+    tick_size_.reset(new uint64_t[capacity]());
+    lot_size_.reset(new uint32_t[capacity]());
+    min_price_.reset(new uint64_t[capacity]());
+    max_price_.reset(new uint64_t[capacity]());
+    max_orders_.reset(new uint32_t[capacity]());
+}
+
+OrderBookConfig InstrumentDirectory::book_config(InstrumentId id, const OrderBookConfig& defaults) const {
+    OrderBookConfig config = defaults;
+    if (id >= size()) {
+        return config;
+    }
+    if (max_price_[id] != 0 && max_price_[id] - min_price_[id] < MAX_BOOK_LEVELS) {
+        config.base_price = min_price_[id];
+        config.price_levels = static_cast<uint32_t>(max_price_[id] - min_price_[id] + 1);
+    }
+    if (max_orders_[id] != 0) {
+        config.max_orders = max_orders_[id];
+    }
+    return config;
+}
+
+InstrumentId InstrumentDirectory::intern(const Key& key, const InstrumentSpec& spec) {
+    if (key[0] == 0 && key[1] == 0) {
+        return NO_INSTRUMENT; // Empty symbol
+    }
+
+    std::lock_guard<std::mutex> lock(intern_mutex_);
+    size_t index = slot_of(key);
+    for (;; index = (index + 1) & slot_mask_) {
+        Slot& slot = slots_[index];
+        InstrumentId existing = slot.id.load(std::memory_order_relaxed);
+        if (existing == NO_INSTRUMENT) {
+            break;
+        }
+        if (slot.key[0] == key[0] && slot.key[1] == key[1]) {
+            return existing; // Another thread interned it first
+        }
+    }
+
+    InstrumentId id = count_.load(std::memory_order_relaxed);
+    if (id == capacity_) {
+        return NO_INSTRUMENT;
+    }
+    memcpy(symbols_[id].data(), key.data(), SYMBOL_SIZE);
+    tick_size_[id] = spec.tick_size;
+    lot_size_[id] = spec.lot_size;
+    min_price_[id] = spec.min_price;
+    max_price_[id] = spec.max_price;
+    max_orders_[id] = spec.max_orders;
+
+    // Reference data and key first: a reader that sees the id sees them too
+    Slot& slot = slots_[index];
+    slot.key = key;
+    slot.id.store(id, std::memory_order_release);
+    count_.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+} // namespace hft
@@ -0,0 +1,214 @@
+#ifndef INSTRUMENT_DIRECTORY_H
+#define INSTRUMENT_DIRECTORY_H
+
+#include "message.h"
+#include "order_book.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Static reference data for one instrument; zero price limits leave that side open
+ */
+struct InstrumentSpec {
+    std::string symbol;
+    uint64_t tick_size = 1;            // Limit prices must be a multiple of it
+    uint32_t lot_size = 1;             // Quantities must be a multiple of it
+    uint64_t min_price = 0;
+    uint64_t max_price = 0;
+    uint32_t max_orders = 0;           // Resting orders its book holds; 0 = the server default
+};
+
+/**
+ * @brief Read an instrument master; false with a logged reason
+ *
+ * One instrument per line: the symbol, then any of tick_size, lot_size,
+ * min_price, max_price and max_orders as key=value; '#' starts a comment. Fields a
+ * line leaves out keep the InstrumentSpec defaults.
+ */
+bool load_instruments(const std::string& path, std::vector<InstrumentSpec>& instruments);
+
+/**
+ * @brief Symbols interned to dense instrument ids, with their reference data
+ *
+ * The servers resolve a frame's symbol once, right after decoding it; the
+ * books, risk state, market data fan-out and multicast snapshot table are
+ * then arrays indexed by the id. Ids run from 0 in the order instruments
+ * were added and never change while the directory lives.
+ *
+ * Lookup is an open-addressing table keyed by the 16-byte symbol field
+ * read as two 64-bit words: one multiply-shift hash and a compare, with no
+ * string handling. Reference data is kept as a struct of arrays, so an
+ * order check loads only the fields it tests.
+ *
+ * Built from an instrument master the directory is closed: other symbols
+ * resolve to NO_INSTRUMENT and their orders are rejected. Otherwise it is
+ * open and interns any symbol on first sight, up to capacity, with no
+ * tick, lot or price constraints.
+ *
+ * Lookups and the accessors are lock-free and safe from any thread.
+ * Interning takes a mutex, which only the first frame of a new symbol
+ * pays.
+ */
+class InstrumentDirectory {
+public:
+    static constexpr uint32_t DEFAULT_CAPACITY = 8192;
+    static constexpr size_t SYMBOL_SIZE = 16;
+    static constexpr uint32_t MAX_BOOK_LEVELS = 1 << 20;
+
+    /**
+     * @brief An open directory for up to capacity symbols
+     */
+    explicit InstrumentDirectory(uint32_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief A closed directory holding exactly the master's instruments, in its order
+     */
+    explicit InstrumentDirectory(const std::vector<InstrumentSpec>& master);
+
+    InstrumentDirectory(const InstrumentDirectory&) = delete;
+    InstrumentDirectory& operator=(const InstrumentDirectory&) = delete;
+
+    /**
+     * @brief Id of a NUL-padded SYMBOL_SIZE symbol field; NO_INSTRUMENT if unknown
+     */
+    InstrumentId find(const char* symbol) const {
+        Key key = pack(symbol);
+        for (size_t index = slot_of(key);; index = (index + 1) & slot_mask_) {
+            const Slot& slot = slots_[index];
+            InstrumentId id = slot.id.load(std::memory_order_acquire);
+            if (id == NO_INSTRUMENT || (slot.key[0] == key[0] && slot.key[1] == key[1])) {
+                return id;
+            }
+        }
+    }
+
+    /**
+     * @brief Id of a symbol field, interning it if the directory is open
+     *
+     * NO_INSTRUMENT for an empty symbol, an unknown one in a closed
+     * directory, or a new one once capacity is reached.
+     */
+    InstrumentId resolve(const char* symbol) {
+        InstrumentId id = find(symbol);
+        return id != NO_INSTRUMENT || !open_ ? id : intern(pack(symbol), InstrumentSpec{});
+    }
+
+    InstrumentId resolve(std::string_view symbol) {
+        char field[SYMBOL_SIZE] = {};
+        memcpy(field, symbol.data(), std::min(symbol.size(), SYMBOL_SIZE));
+        return resolve(field);
+    }
+
+    /**
+     * @brief ACCEPTED, or why the instrument's reference data rules the order out
+     *
+     * A zero price (market order) is exempt from the tick and price limits.
+     */
+    OrderResult check_order(InstrumentId id, uint64_t price, uint32_t quantity) const {
+        if (id >= capacity_) {
+            return OrderResult::REJECTED_UNKNOWN_INSTRUMENT;
+        }
+        if (lot_size_[id] > 1 && quantity % lot_size_[id] != 0) {
+            return OrderResult::REJECTED_LOT_SIZE;
+        }
+        if (price != 0) {
+            if (tick_size_[id] > 1 && price % tick_size_[id] != 0) {
+                return OrderResult::REJECTED_TICK_SIZE;
+            }
+            if (price < min_price_[id] || (max_price_[id] != 0 && price > max_price_[id])) {
+                return OrderResult::REJECTED_PRICE_LIMIT;
+            }
+        }
+        return OrderResult::ACCEPTED;
+    }
+
+    std::string_view symbol(InstrumentId id) const {
+        return std::string_view(symbols_[id].data(), strnlen(symbols_[id].data(), SYMBOL_SIZE));
+    }
+    uint64_t tick_size(InstrumentId id) const { return tick_size_[id]; }
+    uint32_t lot_size(InstrumentId id) const { return lot_size_[id]; }
+    uint64_t min_price(InstrumentId id) const { return min_price_[id]; }
+    uint64_t max_price(InstrumentId id) const { return max_price_[id]; }
+
+    /**
+     * @brief Sizing for an instrument's book: defaults, narrowed by its reference data
+     *
+     * With both price limits set the ladder covers exactly that range, if it
+     * is at most MAX_BOOK_LEVELS wide; max_orders replaces the default
+     * capacity.
+     */
+    OrderBookConfig book_config(InstrumentId id, const OrderBookConfig& defaults) const;
+
+    /**
+     * @brief Upper bound on every id; size arrays indexed by instrument with it
+     */
+    uint32_t capacity() const { return capacity_; }
+    uint32_t size() const { return count_.load(std::memory_order_acquire); }
+    bool open() const { return open_; }
+
+private:
+    using Key = std::array<uint64_t, 2>;
+
+    // Written once, before id is published, and never changed
+    struct Slot {
+        std::atomic<InstrumentId> id{NO_INSTRUMENT};
+        Key key{};
+    };
+
+    static Key pack(const char* symbol) {
+        Key key;
+        memcpy(key.data(), symbol, SYMBOL_SIZE);
+
+        // Whatever follows the terminator is not part of the symbol. The
+        // lowest flagged byte of the zero-byte test is exactly the first NUL
+        constexpr uint64_t ONES = 0x0101010101010101ULL;
+        constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+        uint64_t zero = (key[0] - ONES) & ~key[0] & HIGHS;
+        if (zero != 0) {
+            key[0] &= ((zero & -zero) >> 7) - 1;
+            key[1] = 0;
+        } else if ((zero = (key[1] - ONES) & ~key[1] & HIGHS) != 0) {
+            key[1] &= ((zero & -zero) >> 7) - 1;
+        }
+        return key;
+    }
+
+    size_t slot_of(const Key& key) const {
+        uint64_t mixed = (key[0] ^ (key[1] * 0xC2B2AE3D27D4EB4FULL)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(mixed >> slot_shift_);
+    }
+
+    void allocate(uint32_t capacity);
+    InstrumentId intern(const Key& key, const InstrumentSpec& spec);
+
+    uint32_t capacity_ = 0;
+    bool open_ = true;
+    std::unique_ptr<Slot[]> slots_;
+    size_t slot_mask_ = 0;
+    uint32_t slot_shift_ = 0;
+    std::mutex intern_mutex_;              // Writers only
+    std::atomic<uint32_t> count_{0};
+
+    // Reference data, by id
+    std::unique_ptr<std::array<char, SYMBOL_SIZE>[]> symbols_;
+    std::unique_ptr<uint64_t[]> tick_size_;
+    std::unique_ptr<uint32_t[]> lot_size_;
+    std::unique_ptr<uint64_t[]> min_price_;
+    std::unique_ptr<uint64_t[]> max_price_;
+    std::unique_ptr<uint32_t[]> max_orders_;
+};
+
+} // namespace hft
+
+#endif // INSTRUMENT_DIRECTORY_H
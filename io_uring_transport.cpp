@@ -0,0 +1,628 @@
+#include "io_uring_transport.h"
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+namespace hft {
+
+namespace {
+
+constexpr int TAG_SHIFT = 56;
+constexpr uint64_t VALUE_MASK = (1ULL << TAG_SHIFT) - 1;
+constexpr uint32_t MAX_BUFFERS = 32768;    // Buffer ids are 16 bits
+
+int sys_io_uring_setup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags,
+                       const void* arg, size_t arg_size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int sys_io_uring_register(int fd, uint32_t opcode, const void* arg, uint32_t count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+uint32_t load_acquire(const uint32_t* value) {
+    return std::atomic_ref<const uint32_t>(*value).load(std::memory_order_acquire);
+}
+
+void store_release(uint32_t* value, uint32_t update) {
+    std::atomic_ref<uint32_t>(*value).store(update, std::memory_order_release);
+}
+
+uint64_t user_data(uint64_t tag, uint64_t value) {
+    return (tag << TAG_SHIFT) | (value & VALUE_MASK);
+}
+
+uint32_t round_up_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+IoUringTransport::IoUringTransport(const TransportOptions& options) : options_(options) {
+    if (options_.buffer_count > 0) {
+        options_.buffer_count = std::min(round_up_pow2(options_.buffer_count), MAX_BUFFERS);
+    }
+}
+
+IoUringTransport::~IoUringTransport() {
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+    if (buffers_) {
+        munmap(buffers_, buffers_size_);
+    }
+    if (buf_ring_) {
+        munmap(buf_ring_, buf_ring_size_);
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+}
+
+bool IoUringTransport::open() {
+    // Multishot recvs complete far more often than anything is submitted
+    uint32_t base = IORING_SETUP_CQSIZE;
+    uint32_t preferred = IORING_SETUP_R_DISABLED | IORING_SETUP_SINGLE_ISSUER;
+    if (options_.sqpoll) {
+        base |= IORING_SETUP_SQPOLL;
+    } else {
+        // Completions are posted when this thread next enters the kernel
+        // rather than by interrupting it
+        preferred |= IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+    }
+    
+    io_uring_params params{};
+    for (uint32_t flags : {base | preferred, base}) {
+        params = io_uring_params{};
+        params.flags = flags;
+        params.cq_entries = options_.queue_depth * 4;
+        params.sq_thread_idle = options_.sqpoll_idle_ms;
+        ring_fd_ = sys_io_uring_setup(options_.queue_depth, &params);
+        if (ring_fd_ >= 0 || errno != EINVAL) {
+            break;
+        }
+    }
+    if (ring_fd_ < 0) {
+        std::cerr << "Failed to create io_uring: " << strerror(errno) << std::endl;
+        return false;
+    }
+    setup_flags_ = params.flags;
+    
+    uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required) != required) {
+        std::cerr << "io_uring transport needs Linux 5.11 or later" << std::endl;
+        return false;
+    }
+    
+    // One mapping covers both rings
+    sq_ring_size_ = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                                     params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        std::cerr << "Failed to map io_uring: " << strerror(errno) << std::endl;
+        return false;
+    }
+    cq_ring_ = sq_ring_;
+    cq_ring_size_ = sq_ring_size_;
+    
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::cerr << "Failed to map io_uring entries: " << strerror(errno) << std::endl;
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sq_flags_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.flags);
+    sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+    
+    // Entries are always used in ring order, so the indirection array is fixed
+    auto* array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    for (uint32_t i = 0; i < sq_entries_; ++i) {
+        array[i] = i;
+    }
+    
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    
+    if (options_.buffer_count == 0) {
+        return true; // Send-only
+    }
+    
+    buf_ring_size_ = options_.buffer_count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    buffers_size_ = static_cast<size_t>(options_.buffer_count) * options_.buffer_size;
+    void* buffers = mmap(nullptr, buffers_size_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (ring == MAP_FAILED || buffers == MAP_FAILED) {
+        if (ring != MAP_FAILED) {
+            munmap(ring, buf_ring_size_);
+        }
+        if (buffers != MAP_FAILED) {
+            munmap(buffers, buffers_size_);
+        }
+        std::cerr << "Failed to allocate io_uring receive buffers: " << strerror(errno) << std::endl;
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+    buffers_ = static_cast<uint8_t*>(buffers);
+    
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = options_.buffer_count;
+    reg.bgid = BUFFER_GROUP;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        std::cerr << "Failed to register io_uring buffers (needs Linux 5.19): " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < options_.buffer_count; ++i) {
+        recycle(static_cast<uint16_t>(i));
+    }
+    publish_buffers();
+    return true;
+}
+
+bool IoUringTransport::attach_thread() {
+    // A disabled ring binds its single issuer to whichever thread enables it
+    if (!enabled_ && (setup_flags_ & IORING_SETUP_R_DISABLED)) {
+        if (sys_io_uring_register(ring_fd_, IORING_REGISTER_ENABLE_RINGS, nullptr, 0) < 0) {
+            std::cerr << "Failed to enable io_uring: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    enabled_ = true;
+    return true;
+}
+
+io_uring_sqe* IoUringTransport::get_sqe() {
+    while (sq_local_tail_ - load_acquire(sq_head_) >= sq_entries_) {
+        if (setup_flags_ & IORING_SETUP_SQPOLL) {
+            // Wait for the poller to catch up
+            sys_io_uring_enter(ring_fd_, 0, 0, IORING_ENTER_SQ_WAIT, nullptr, 0);
+        } else if (submit(false, 0) < 0) {
+            return nullptr;
+        }
+    }
+    
+    io_uring_sqe* sqe = &sqes_[sq_local_tail_ & sq_mask_];
+    memset(sqe, 0, sizeof(*sqe));
+    ++sq_local_tail_;
+    ++to_submit_;
+    return sqe;
+}
+
+int IoUringTransport::submit(bool wait_for_completion, int timeout_ms) {
+    store_release(sq_tail_, sq_local_tail_);
+    
+    uint32_t flags = 0;
+    uint32_t to_submit = to_submit_;
+    if (setup_flags_ & IORING_SETUP_SQPOLL) {
+        // New entries are visible to the poller; wake it only if it slept
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (to_submit_ > 0 && (load_acquire(sq_flags_) & IORING_SQ_NEED_WAKEUP)) {
+            flags |= IORING_ENTER_SQ_WAKEUP;
+        }
+        to_submit = 0;
+        to_submit_ = 0;
+    }
+    if (load_acquire(sq_flags_) & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW)) {
+        flags |= IORING_ENTER_GETEVENTS; // Completions are waiting to be posted
+    }
+    
+    if (!wait_for_completion && to_submit == 0 && flags == 0) {
+        return 0; // Nothing to tell the kernel
+    }
+    
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    uint32_t min_complete = 0;
+    if (wait_for_completion) {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000LL;
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        min_complete = 1;
+    }
+    
+    int submitted = sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags,
+                                       wait_for_completion ? &arg : nullptr,
+                                       wait_for_completion ? sizeof(arg) : 0);
+    if (submitted < 0) {
+        if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+            return 0;
+        }
+        return -errno;
+    }
+    to_submit_ -= std::min<uint32_t>(to_submit_, static_cast<uint32_t>(submitted));
+    return submitted;
+}
+
+bool IoUringTransport::add_listener(int fd, uint64_t cookie) {
+    listeners_.push_back(Listener{fd, cookie});
+    arm_poll(static_cast<uint32_t>(listeners_.size() - 1));
+    return true;
+}
+
+void IoUringTransport::arm_poll(uint32_t index) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = listeners_[index].fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = user_data(TAG_POLL, index);
+}
+
+bool IoUringTransport::add_connection(int fd, uint64_t cookie) {
+    if (!buf_ring_) {
+        errno = ENOTSUP;
+        return false;
+    }
+    
+    uint32_t slot;
+    if (!free_receivers_.empty()) {
+        slot = free_receivers_.back();
+        free_receivers_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(receivers_.size());
+        receivers_.emplace_back();
+    }
+    receivers_[slot].fd = fd;
+    receivers_[slot].cookie = cookie;
+    receiver_of_fd_[fd] = slot;
+    arm_recv(slot);
+    return true;
+}
+
+void IoUringTransport::arm_recv(uint32_t slot) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = receivers_[slot].fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = user_data(TAG_RECV, slot);
+    receivers_[slot].armed = true;
+}
+
+void IoUringTransport::remove_connection(int fd, uint64_t cookie) {
+    // Whatever was queued can no longer be delivered. A send still in
+    // flight keeps its chain until it completes, but nothing follows it
+    auto chain = chain_of_cookie_.find(cookie);
+    if (chain != chain_of_cookie_.end()) {
+        uint32_t slot = chain->second;
+        chain_of_cookie_.erase(chain);
+        if (chains_[slot].busy) {
+            chains_[slot].closing = true;
+            chains_[slot].pending.clear();
+        } else {
+            release_chain(slot);
+        }
+    }
+    
+    auto it = receiver_of_fd_.find(fd);
+    if (it == receiver_of_fd_.end()) {
+        return;
+    }
+    uint32_t slot = it->second;
+    receiver_of_fd_.erase(it);
+    
+    Receiver& receiver = receivers_[slot];
+    receiver.closing = true;
+    if (!receiver.armed) {
+        release_receiver(slot);
+        return;
+    }
+    
+    // The armed recv holds its own reference to the socket, so closing the
+    // descriptor alone would leave the connection open until it is cancelled
+    io_uring_sqe* sqe = get_sqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = user_data(TAG_RECV, slot);
+        sqe->user_data = user_data(TAG_CANCEL, 0);
+        submit(false, 0);
+    }
+}
+
+void IoUringTransport::release_receiver(uint32_t slot) {
+    receivers_[slot] = Receiver{};
+    free_receivers_.push_back(slot);
+}
+
+int IoUringTransport::wait(TransportEvent* events, int max_events, int timeout_ms) {
+    // The caller is done with the previous events' data
+    for (int32_t buffer : lent_) {
+        recycle(static_cast<uint16_t>(buffer));
+    }
+    lent_.clear();
+    publish_buffers();
+    
+    for (uint32_t slot : rearm_) {
+        Receiver& receiver = receivers_[slot];
+        if (receiver.fd >= 0 && !receiver.closing && !receiver.armed) {
+            arm_recv(slot);
+        }
+    }
+    rearm_.clear();
+    
+    if (completions_head_ == completions_.size()) {
+        reap();
+    }
+    if (completions_head_ == completions_.size() && timeout_ms == 0) {
+        // Polling: the completion ring is shared memory, so looking at it
+        // needs no syscall unless there is something to submit
+        submit(false, 0);
+        reap();
+    } else if (completions_head_ == completions_.size()) {
+        int result = submit(true, timeout_ms);
+        if (result < 0) {
+            return result;
+        }
+        reap();
+    } else if (to_submit_ > 0) {
+        submit(false, 0);
+    }
+    
+    int count = 0;
+    while (count < max_events && completions_head_ < completions_.size()) {
+        const Completion& completion = completions_[completions_head_++];
+        events[count++] = completion.event;
+        if (completion.buffer >= 0) {
+            lent_.push_back(completion.buffer);
+        }
+    }
+    if (completions_head_ == completions_.size()) {
+        completions_.clear();
+        completions_head_ = 0;
+    }
+    return count;
+}
+
+void IoUringTransport::reap() {
+    uint32_t head = *cq_head_;
+    uint32_t tail = load_acquire(cq_tail_);
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        uint64_t tag = cqe.user_data >> TAG_SHIFT;
+        uint64_t value = cqe.user_data & VALUE_MASK;
+        
+        switch (tag) {
+            case TAG_POLL:
+                if (cqe.res > 0) {
+                    completions_.push_back(Completion{
+                        TransportEvent{TransportEvent::ACCEPT, listeners_[value].cookie, nullptr, 0}, -1});
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE) && cqe.res != -ECANCELED) {
+                    arm_poll(static_cast<uint32_t>(value));
+                }
+                break;
+            case TAG_RECV:
+                handle_recv(static_cast<uint32_t>(value), cqe.res, cqe.flags);
+                break;
+            case TAG_SEND:
+                handle_send(static_cast<uint32_t>(value), cqe.res);
+                break;
+            default:
+                break;
+        }
+        ++head;
+    }
+    store_release(cq_head_, head);
+}
+
+void IoUringTransport::handle_recv(uint32_t slot, int32_t result, uint32_t flags) {
+    Receiver& receiver = receivers_[slot];
+    if (!(flags & IORING_CQE_F_MORE)) {
+        receiver.armed = false;
+    }
+    
+    if (result > 0) {
+        uint16_t buffer = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (receiver.closing) {
+            recycle(buffer);
+        } else {
+            completions_.push_back(Completion{
+                TransportEvent{TransportEvent::DATA, receiver.cookie,
+                               buffers_ + static_cast<size_t>(buffer) * options_.buffer_size,
+                               static_cast<uint32_t>(result)},
+                buffer});
+            if (!receiver.armed) {
+                rearm_.push_back(slot);
+            }
+        }
+    } else if (result == -ENOBUFS) {
+        // Every buffer is lent out; re-arm once some come back
+        if (!receiver.closing) {
+            rearm_.push_back(slot);
+        }
+    } else if (!receiver.closing) {
+        // End of stream or a socket error
+        completions_.push_back(Completion{
+            TransportEvent{TransportEvent::CLOSED, receiver.cookie, nullptr, 0}, -1});
+    }
+    
+    if (receiver.closing && !receiver.armed) {
+        release_receiver(slot);
+    }
+}
+
+ssize_t IoUringTransport::send(int fd, uint64_t cookie, const void* data, size_t length) {
+    auto [it, added] = chain_of_cookie_.try_emplace(cookie, 0);
+    if (added) {
+        if (!free_chains_.empty()) {
+            it->second = free_chains_.back();
+            free_chains_.pop_back();
+        } else {
+            it->second = static_cast<uint32_t>(chains_.size());
+            chains_.emplace_back();
+        }
+        chains_[it->second].fd = fd;
+        chains_[it->second].cookie = cookie;
+    }
+    uint32_t slot = it->second;
+    SendChain& chain = chains_[slot];
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    chain.pending.insert(chain.pending.end(), bytes, bytes + length);
+    if (!chain.ready) {
+        chain.ready = true;
+        ready_sends_.push_back(slot);
+    }
+    return static_cast<ssize_t>(length);
+}
+
+size_t IoUringTransport::queued(int, uint64_t cookie) const {
+    auto it = chain_of_cookie_.find(cookie);
+    if (it == chain_of_cookie_.end()) {
+        return 0;
+    }
+    const SendChain& chain = chains_[it->second];
+    return chain.in_flight.size() - chain.offset + chain.pending.size();
+}
+
+void IoUringTransport::submit_send(uint32_t slot) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    SendChain& chain = chains_[slot];
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = chain.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(chain.in_flight.data() + chain.offset);
+    sqe->len = static_cast<uint32_t>(chain.in_flight.size() - chain.offset);
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = user_data(TAG_SEND, slot);
+    chain.busy = true;
+}
+
+void IoUringTransport::release_chain(uint32_t slot) {
+    // Keeps the buffers' capacity for the slot's next connection
+    SendChain& chain = chains_[slot];
+    chain.fd = -1;
+    chain.cookie = 0;
+    chain.in_flight.clear();
+    chain.offset = 0;
+    chain.pending.clear();
+    chain.busy = false;
+    chain.closing = false;
+    if (!chain.ready) {
+        free_chains_.push_back(slot);
+    }
+}
+
+void IoUringTransport::flush() {
+    for (uint32_t slot : ready_sends_) {
+        SendChain& chain = chains_[slot];
+        chain.ready = false;
+        if (chain.fd < 0) {
+            free_chains_.push_back(slot); // Released while it waited here
+            continue;
+        }
+        if (chain.busy) {
+            continue; // Goes out when the send ahead of it completes
+        }
+        if (chain.offset == chain.in_flight.size()) {
+            if (chain.pending.empty()) {
+                continue;
+            }
+            chain.in_flight.swap(chain.pending);
+            chain.pending.clear();
+            chain.offset = 0;
+        }
+        submit_send(slot);
+    }
+    ready_sends_.clear();
+    
+    // One syscall for the whole batch, none at all when the poller is awake
+    submit(false, 0);
+    reap();
+}
+
+void IoUringTransport::handle_send(uint32_t slot, int32_t result) {
+    SendChain& chain = chains_[slot];
+    chain.busy = false;
+    if (chain.closing) {
+        // Its connection is gone; a short send's remainder must not follow
+        release_chain(slot);
+        return;
+    }
+    
+    if (result > 0) {
+        chain.offset += static_cast<size_t>(result);
+    } else if (result != -EAGAIN && result != -EINTR) {
+        // The socket is gone; its close arrives through the receive side
+        chain.in_flight.clear();
+        chain.pending.clear();
+        chain.offset = 0;
+    }
+    if (chain.offset == chain.in_flight.size()) {
+        chain.in_flight.clear();
+        chain.offset = 0;
+    }
+    
+    // A short send's remainder, or bytes queued behind it, go out on the next flush
+    if ((chain.offset < chain.in_flight.size() || !chain.pending.empty()) && !chain.ready) {
+        chain.ready = true;
+        ready_sends_.push_back(slot);
+    }
+}
+
+void IoUringTransport::recycle(uint16_t buffer) {
+    // Entries start at the ring's base; the header's flexible array member
+    // is shifted by a padding struct when compiled as C++
+    io_uring_buf* entries = reinterpret_cast<io_uring_buf*>(buf_ring_);
+    io_uring_buf& entry = entries[(buf_tail_ + buf_added_) & (options_.buffer_count - 1)];
+    entry.addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(buffer) * options_.buffer_size);
+    entry.len = options_.buffer_size;
+    entry.bid = buffer;
+    ++buf_added_;
+}
+
+void IoUringTransport::publish_buffers() {
+    if (buf_added_ == 0) {
+        return;
+    }
+    buf_tail_ = static_cast<uint16_t>(buf_tail_ + buf_added_);
+    buf_added_ = 0;
+    std::atomic_ref<uint16_t>(buf_ring_->tail).store(buf_tail_, std::memory_order_release);
+}
+
+} // namespace hft
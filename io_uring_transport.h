@@ -0,0 +1,162 @@
+#ifndef IO_URING_TRANSPORT_H
+#define IO_URING_TRANSPORT_H
+
+#include "transport.h"
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Completion-based transport on one io_uring instance
+ *
+ * Every connection keeps a multishot recv armed that picks its buffer from
+ * a ring of provided buffers registered with the kernel, so reading costs
+ * no syscall per socket: a single io_uring_enter() returns the data of
+ * every connection that received something. wait() hands that data out as
+ * DATA events; the buffers go back to the kernel on the following wait().
+ *
+ * Listeners carry a multishot poll and produce ACCEPT events; the caller
+ * keeps its own accept() loop.
+ *
+ * send() copies into a per-connection chain and returns at once. flush()
+ * submits one SEND per connection with queued bytes, all in one io_uring_enter()
+ * (or none with SQPOLL, where a kernel thread picks them up). While a send
+ * is in flight later bytes for the connection coalesce behind it, which keeps
+ * them in order. Chains are keyed by cookie, never by descriptor:
+ * remove_connection() drops the chain's queued bytes, and a send still in
+ * flight then retires its chain on completion instead of continuing.
+ *
+ * Not thread-safe: one instance per thread, driven only by the thread that
+ * called attach_thread().
+ */
+class IoUringTransport final : public Transport {
+public:
+    explicit IoUringTransport(const TransportOptions& options);
+    ~IoUringTransport() override;
+    
+    IoUringTransport(const IoUringTransport&) = delete;
+    IoUringTransport& operator=(const IoUringTransport&) = delete;
+    
+    /**
+     * @brief Create the ring and register the receive buffers; false with a logged reason
+     */
+    bool open();
+    
+    TransportKind kind() const override { return TransportKind::IO_URING; }
+    bool attach_thread() override;
+    bool add_listener(int fd, uint64_t cookie) override;
+    bool add_connection(int fd, uint64_t cookie) override;
+    bool rearm_connection(int, uint64_t) override { return true; }
+    void remove_connection(int fd, uint64_t cookie) override;
+    int wait(TransportEvent* events, int max_events, int timeout_ms) override;
+    ssize_t send(int fd, uint64_t cookie, const void* data, size_t length) override;
+    size_t queued(int fd, uint64_t cookie) const override;
+    void flush() override;
+
+private:
+    static constexpr uint16_t BUFFER_GROUP = 0;
+    
+    // user_data layout: operation tag in the top byte, operation value below
+    enum Tag : uint64_t {
+        TAG_POLL = 1,                  // Value: listener index
+        TAG_RECV = 2,                  // Value: connection slot
+        TAG_SEND = 3,                  // Value: send chain slot
+        TAG_CANCEL = 4
+    };
+    
+    struct Listener {
+        int fd;
+        uint64_t cookie;
+    };
+    
+    struct Receiver {
+        int fd = -1;
+        uint64_t cookie = 0;
+        bool armed = false;            // Multishot recv outstanding
+        bool closing = false;          // Removed; freed by the recv's final completion
+    };
+    
+    struct SendChain {
+        int fd = -1;
+        uint64_t cookie = 0;
+        std::vector<uint8_t> in_flight;    // Owned by the kernel until its completion
+        size_t offset = 0;                 // Bytes of in_flight already sent
+        std::vector<uint8_t> pending;      // Queued behind in_flight
+        bool busy = false;
+        bool ready = false;                // On ready_sends_
+        bool closing = false;              // Removed; freed by the busy send's completion
+    };
+    
+    struct Completion {
+        TransportEvent event;
+        int32_t buffer;                    // Provided buffer to recycle, or -1
+    };
+    
+    io_uring_sqe* get_sqe();
+    int submit(bool wait_for_completion, int timeout_ms);
+    void arm_poll(uint32_t index);
+    void arm_recv(uint32_t slot);
+    void submit_send(uint32_t slot);
+    void reap();
+    void handle_recv(uint32_t slot, int32_t result, uint32_t flags);
+    void handle_send(uint32_t slot, int32_t result);
+    void release_chain(uint32_t slot);
+    void recycle(uint16_t buffer);
+    void publish_buffers();
+    void release_receiver(uint32_t slot);
+    
+    TransportOptions options_;
+    int ring_fd_ = -1;
+    uint32_t setup_flags_ = 0;
+    bool enabled_ = false;
+    
+    // Mapped rings
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    uint32_t* sq_head_ = nullptr;
+    uint32_t* sq_tail_ = nullptr;
+    uint32_t* sq_flags_ = nullptr;
+    uint32_t sq_mask_ = 0;
+    uint32_t sq_entries_ = 0;
+    uint32_t* cq_head_ = nullptr;
+    uint32_t* cq_tail_ = nullptr;
+    uint32_t cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    uint32_t sq_local_tail_ = 0;
+    uint32_t to_submit_ = 0;
+    
+    // Provided receive buffers
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    size_t buf_ring_size_ = 0;
+    uint8_t* buffers_ = nullptr;
+    size_t buffers_size_ = 0;
+    uint16_t buf_tail_ = 0;
+    uint16_t buf_added_ = 0;           // Recycled since the tail was last published
+    
+    std::vector<Listener> listeners_;
+    std::vector<Receiver> receivers_;
+    std::vector<uint32_t> free_receivers_;
+    std::unordered_map<int, uint32_t> receiver_of_fd_;
+    
+    std::vector<SendChain> chains_;
+    std::vector<uint32_t> free_chains_;
+    std::unordered_map<uint64_t, uint32_t> chain_of_cookie_;
+    std::vector<uint32_t> ready_sends_;    // Chain slots
+    
+    std::vector<Completion> completions_;  // Reaped, not yet handed out
+    size_t completions_head_ = 0;
+    std::vector<int32_t> lent_;            // Buffers behind the last wait()'s events
+    std::vector<uint32_t> rearm_;          // Receivers whose multishot recv ended
+};
+
+} // namespace hft
+
+#endif // IO_URING_TRANSPORT_H
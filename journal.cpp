@@ -0,0 +1,591 @@
+#include "journal.h"
+#include "server_counters.h"
+#include "wire_protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hft {
+
+namespace {
+
+constexpr char SEGMENT_MAGIC[8] = {'H', 'F', 'T', 'J', 'R', 'N', 'L', '\0'};
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr uint64_t MIN_SEGMENT_BYTES = 1ULL << 20;
+constexpr std::string_view SEGMENT_SUFFIX = ".journal";
+constexpr const char* ARCHIVE_DIRECTORY = "archive";
+
+// Start of every segment file; records follow at HEADER_BYTES
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t epoch;
+    uint64_t index;
+    uint64_t segment_bytes;
+    uint64_t reserved;
+    char stream[16];
+};
+
+struct RecordHeader {
+    uint32_t size;         // Header plus payload, padded to 8 bytes; 0 ends the segment
+    uint8_t kind;          // JournalRecordKind
+    uint8_t reserved[3];
+    uint64_t sequence;
+    uint64_t owner;
+    uint64_t checksum;     // Over the fields above and the payload
+};
+
+constexpr uint64_t HEADER_BYTES = 64;
+static_assert(sizeof(SegmentHeader) == HEADER_BYTES, "segment header is one cache line");
+static_assert(sizeof(RecordHeader) == 32, "record header layout is part of the file format");
+
+constexpr uint64_t MAX_RECORD_BYTES = sizeof(RecordHeader) + ((wire::MAX_FRAME_SIZE + 7) & ~size_t{7});
+
+uint64_t checksum(const RecordHeader& header, const uint8_t* payload, size_t length) {
+    // A word at a time; this catches torn and stale records, not tampering
+    uint64_t hash = 0x9E3779B97F4A7C15ULL;
+    auto mix = [&hash](uint64_t word) {
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    };
+    mix(static_cast<uint64_t>(header.size) | static_cast<uint64_t>(header.kind) << 32);
+    mix(header.sequence);
+    mix(header.owner);
+    size_t offset = 0;
+    for (; offset + 8 <= length; offset += 8) {
+        uint64_t word;
+        memcpy(&word, payload + offset, 8);
+        mix(word);
+    }
+    if (offset < length) {
+        uint64_t word = 0;
+        memcpy(&word, payload + offset, length - offset);
+        mix(word);
+    }
+    return hash;
+}
+
+bool ensure_directory(const std::string& directory) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Failed to create journal directory " << directory << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Make a new file's directory entry durable
+void sync_directory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+// Journal implementation
+Journal::Journal(const JournalConfig& config, std::string stream)
+    : config_(config),
+      stream_(std::move(stream)) {
+    config_.segment_bytes = std::max(config_.segment_bytes, MIN_SEGMENT_BYTES);
+    if (stream_.size() >= sizeof(SegmentHeader::stream)) {
+        stream_.resize(sizeof(SegmentHeader::stream) - 1);
+    }
+}
+
+Journal::~Journal() {
+    close();
+}
+
+bool Journal::open(uint64_t epoch) {
+    if (current_ || !ensure_directory(config_.directory)) {
+        return false;
+    }
+    epoch_ = epoch;
+    next_index_ = 1;
+    next_sequence_ = 1;
+    stopping_ = false;
+    if (!roll()) {
+        return false;
+    }
+    flusher_ = std::thread(&Journal::flush_thread, this);
+    return true;
+}
+
+void Journal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+
+    // The flush thread is gone; nothing else touches the segments now
+    for (auto& segment : retired_) {
+        sync_segment(*segment);
+        release_segment(*segment, false);
+    }
+    retired_.clear();
+    if (active_) {
+        sync_segment(*active_);
+        release_segment(*active_, false);
+        active_.reset();
+    }
+    if (spare_) {
+        release_segment(*spare_, true);
+        spare_.reset();
+    }
+    current_ = nullptr;
+}
+
+bool Journal::append(JournalRecordKind kind, uint64_t owner, const uint8_t* payload, size_t length) {
+    uint64_t size = (sizeof(RecordHeader) + length + 7) & ~uint64_t{7};
+    if (!current_ || (write_offset_ + size > config_.segment_bytes && !roll())) {
+        bump(lost_);
+        return false;
+    }
+
+    RecordHeader header{};
+    header.size = static_cast<uint32_t>(size);
+    header.kind = static_cast<uint8_t>(kind);
+    header.sequence = next_sequence_;
+    header.owner = owner;
+    header.checksum = checksum(header, payload, length);
+
+    // The segment was zero-filled, so the padding and the end marker after
+    // this record are already in place
+    uint8_t* at = current_->base + write_offset_;
+    if (length != 0) {
+        memcpy(at + sizeof(RecordHeader), payload, length);
+    }
+    memcpy(at, &header, sizeof(header));
+    write_offset_ += size;
+    ++next_sequence_;
+    current_->committed.store(write_offset_, std::memory_order_release);
+
+    bump(records_);
+    bump(bytes_, size);
+    return true;
+}
+
+bool Journal::roll() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // A segment the flush thread is still preparing carries the next index
+    wake_.wait(lock, [this] { return !preparing_; });
+    std::unique_ptr<Segment> next = std::move(spare_);
+    if (!next) {
+        // The flush thread fell behind; open one here rather than lose records
+        next = create_segment(next_index_++);
+        if (!next) {
+            return false;
+        }
+    }
+
+    if (active_) {
+        retired_.push_back(std::move(active_));
+    }
+    active_ = std::move(next);
+    current_ = active_.get();
+    write_offset_ = HEADER_BYTES;
+    lock.unlock();
+
+    wake_.notify_all();
+    return true;
+}
+
+std::unique_ptr<Journal::Segment> Journal::create_segment(uint64_t index) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s-%06llu-%06llu.journal", stream_.c_str(),
+             static_cast<unsigned long long>(epoch_), static_cast<unsigned long long>(index));
+
+    auto segment = std::make_unique<Segment>();
+    segment->index = index;
+    segment->path = config_.directory + "/" + name;
+    segment->fd = ::open(segment->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        std::cerr << "Failed to create journal segment " << segment->path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    // Allocate the blocks now so appends never wait on the filesystem
+    int error = posix_fallocate(segment->fd, 0, static_cast<off_t>(config_.segment_bytes));
+    if (error == EOPNOTSUPP || error == EINVAL) {
+        error = ftruncate(segment->fd, static_cast<off_t>(config_.segment_bytes)) == 0 ? 0 : errno;
+    }
+    if (error != 0) {
+        std::cerr << "Failed to size journal segment " << segment->path << ": " << strerror(error) << std::endl;
+        release_segment(*segment, true);
+        return nullptr;
+    }
+
+    void* base = mmap(nullptr, config_.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      segment->fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map journal segment " << segment->path << ": " << strerror(errno) << std::endl;
+        release_segment(*segment, true);
+        return nullptr;
+    }
+    segment->base = static_cast<uint8_t*>(base);
+
+    SegmentHeader header{};
+    memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = SEGMENT_VERSION;
+    header.header_bytes = HEADER_BYTES;
+    header.epoch = epoch_;
+    header.index = index;
+    header.segment_bytes = config_.segment_bytes;
+    memcpy(header.stream, stream_.data(), stream_.size());
+    memcpy(segment->base, &header, sizeof(header));
+
+    // The header and the file's size are durable before any record lands
+    msync(segment->base, HEADER_BYTES, MS_SYNC);
+    fdatasync(segment->fd);
+    sync_directory(config_.directory);
+
+    segment->committed.store(HEADER_BYTES, std::memory_order_relaxed);
+    segment->synced = HEADER_BYTES;
+    segments_.fetch_add(1, std::memory_order_relaxed);
+    return segment;
+}
+
+void Journal::sync_segment(Segment& segment) {
+    uint64_t committed = segment.committed.load(std::memory_order_acquire);
+    if (committed <= segment.synced) {
+        return;
+    }
+
+    // msync wants a page-aligned start
+    static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = segment.synced & ~(page - 1);
+    if (msync(segment.base + start, committed - start, MS_SYNC) != 0) {
+        std::cerr << "Journal msync failed on " << segment.path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    segment.synced = committed;
+    syncs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Journal::release_segment(Segment& segment, bool discard) {
+    if (segment.base) {
+        munmap(segment.base, config_.segment_bytes);
+        segment.base = nullptr;
+    }
+    if (segment.fd >= 0) {
+        ::close(segment.fd);
+        segment.fd = -1;
+    }
+    if (discard) {
+        unlink(segment.path.c_str());
+    }
+}
+
+void Journal::flush_thread() {
+    // With no periodic sync the thread still retires segments and keeps a spare
+    auto interval = std::chrono::milliseconds(config_.flush_interval_ms != 0 ? config_.flush_interval_ms : 100);
+    bool spare_failed = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (!spare_ && !spare_failed) {
+            uint64_t index = next_index_++;
+            preparing_ = true;
+            lock.unlock();
+            std::unique_ptr<Segment> segment = create_segment(index);
+            lock.lock();
+            preparing_ = false;
+            spare_failed = !segment;
+            spare_ = std::move(segment);
+            wake_.notify_all();
+        }
+
+        // A retired segment stays mapped until it is synced here, so the
+        // active one can be synced without the lock even if the writer rolls
+        std::vector<std::unique_ptr<Segment>> retired;
+        retired.swap(retired_);
+        Segment* active = active_.get();
+        lock.unlock();
+
+        for (auto& segment : retired) {
+            sync_segment(*segment);
+            release_segment(*segment, false);
+        }
+        if (active && config_.flush_interval_ms != 0) {
+            sync_segment(*active);
+        }
+
+        lock.lock();
+        if (!retired_.empty()) {
+            continue;
+        }
+        wake_.wait_for(lock, interval, [&] {
+            return stopping_ || !retired_.empty() || (!spare_ && !spare_failed);
+        });
+        spare_failed = false;   // Try again at most once an interval
+    }
+}
+
+JournalStats Journal::stats() const {
+    JournalStats stats;
+    stats.records = records_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.segments = segments_.load(std::memory_order_relaxed);
+    stats.syncs = syncs_.load(std::memory_order_relaxed);
+    stats.lost = lost_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// JournalReader implementation
+JournalReader::~JournalReader() {
+    unmap_segment();
+}
+
+bool JournalReader::open(const std::string& directory) {
+    if (!ensure_directory(directory)) {
+        return false;
+    }
+    directory_ = directory;
+    segments_.clear();
+    if (!scan(directory, true)) {
+        return false;
+    }
+
+    // Archived epochs are never replayed, but a new run must not reuse their numbers
+    struct stat st {};
+    if (stat((directory + "/" + ARCHIVE_DIRECTORY).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        scan(directory + "/" + ARCHIVE_DIRECTORY, false);
+    }
+
+    std::sort(segments_.begin(), segments_.end(), [](const SegmentInfo& a, const SegmentInfo& b) {
+        if (a.epoch != b.epoch) return a.epoch < b.epoch;
+        if (a.stream != b.stream) return a.stream < b.stream;
+        return a.index < b.index;
+    });
+    position_ = 0;
+    return true;
+}
+
+bool JournalReader::scan(const std::string& directory, bool replay) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::cerr << "Failed to open journal directory " << directory << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        std::string_view name = entry->d_name;
+        if (name.size() <= SEGMENT_SUFFIX.size() ||
+            name.substr(name.size() - SEGMENT_SUFFIX.size()) != SEGMENT_SUFFIX) {
+            continue;
+        }
+
+        std::string path = directory + "/" + std::string(name);
+        SegmentHeader header{};
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        bool readable = fd >= 0 && pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (!readable || memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SEGMENT_VERSION || header.header_bytes != HEADER_BYTES) {
+            // A crash while the segment was being created
+            std::cerr << "Skipping journal segment without a valid header: " << path << std::endl;
+            continue;
+        }
+
+        header.stream[sizeof(header.stream) - 1] = '\0';
+        if (replay) {
+            segments_.push_back(SegmentInfo{path, header.stream, header.epoch, header.index, 0});
+        }
+        max_epoch_ = std::max(max_epoch_, header.epoch);
+    }
+    closedir(dir);
+    return true;
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    while (position_ < segments_.size()) {
+        if (!data_ && !map_segment(position_)) {
+            ++position_;
+            continue;
+        }
+
+        if (offset_ + sizeof(RecordHeader) <= size_) {
+            RecordHeader header;
+            memcpy(&header, data_ + offset_, sizeof(header));
+            if (header.size == 0) {
+                // End of the records written to this segment
+                unmap_segment();
+                ++position_;
+                continue;
+            }
+
+            const uint8_t* payload = data_ + offset_ + sizeof(RecordHeader);
+            size_t length = 0;
+            bool valid = header.size >= sizeof(RecordHeader) && header.size <= MAX_RECORD_BYTES &&
+                         header.size % 8 == 0 && offset_ + header.size <= size_;
+            if (valid && header.kind == static_cast<uint8_t>(JournalRecordKind::FRAME)) {
+                size_t available = header.size - sizeof(RecordHeader);
+                valid = wire::peek_frame(payload, available, length) == wire::FrameStatus::COMPLETE;
+            } else if (valid) {
+                valid = header.kind == static_cast<uint8_t>(JournalRecordKind::DISCONNECT) &&
+                        header.size == sizeof(RecordHeader);
+            }
+            if (valid && checksum(header, payload, length) == header.checksum) {
+                if (header.sequence != expected_sequence_) {
+                    std::cerr << "Journal sequence gap in " << segments_[position_].path << ": expected "
+                              << expected_sequence_ << ", found " << header.sequence << std::endl;
+                }
+                expected_sequence_ = header.sequence + 1;
+                offset_ += header.size;
+                ++records_;
+                ++segments_[position_].records;
+
+                record.epoch = segments_[position_].epoch;
+                record.sequence = header.sequence;
+                record.owner = header.owner;
+                record.kind = static_cast<JournalRecordKind>(header.kind);
+                record.frame = length != 0 ? payload : nullptr;
+                record.frame_length = length;
+                return true;
+            }
+        }
+
+        // A torn write, or a segment filled right up; either way nothing
+        // after this point in the segment can be trusted
+        if (offset_ + sizeof(RecordHeader) <= size_) {
+            std::cerr << "Journal segment " << segments_[position_].path << " is damaged at offset " << offset_
+                      << "; replaying what precedes it" << std::endl;
+            ++damaged_;
+        }
+        unmap_segment();
+        ++position_;
+    }
+    return false;
+}
+
+size_t JournalReader::discard_empty_segments() {
+    size_t discarded = 0;
+    for (size_t i = 0; i < position_ && i < segments_.size(); ++i) {
+        if (segments_[i].records == 0 && unlink(segments_[i].path.c_str()) == 0) {
+            ++discarded;
+        }
+    }
+    return discarded;
+}
+
+size_t JournalReader::archive_segments() {
+    std::string archive = directory_ + "/" + ARCHIVE_DIRECTORY;
+    if (!ensure_directory(archive)) {
+        return 0;
+    }
+    size_t archived = 0;
+    for (size_t i = 0; i < position_ && i < segments_.size(); ++i) {
+        const std::string& path = segments_[i].path;
+        std::string target = archive + path.substr(path.rfind('/'));
+        if (rename(path.c_str(), target.c_str()) == 0) {
+            ++archived;
+        } else if (errno != ENOENT) {
+            // Left in place, it is replayed again next time, which agrees with this run
+            std::cerr << "Failed to archive journal segment " << path << ": " << strerror(errno) << std::endl;
+        }
+    }
+    sync_directory(archive);
+    sync_directory(directory_);
+    return archived;
+}
+
+bool JournalReader::map_segment(size_t position) {
+    const SegmentInfo& info = segments_[position];
+    int fd = ::open(info.path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < HEADER_BYTES) {
+        std::cerr << "Failed to open journal segment " << info.path << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map journal segment " << info.path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    // Sequences run on across the segments of one stream and epoch
+    bool continues = position > 0 && segments_[position - 1].epoch == info.epoch &&
+                     segments_[position - 1].stream == info.stream;
+    if (!continues) {
+        expected_sequence_ = 1;
+    }
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = static_cast<size_t>(st.st_size);
+    offset_ = HEADER_BYTES;
+    return true;
+}
+
+void JournalReader::unmap_segment() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+// JournalOwnerMap implementation
+uint64_t JournalOwnerMap::token(const JournalRecord& record) {
+    enter_epoch(record.epoch);
+    auto [it, inserted] = tokens_.try_emplace(record.owner, 0);
+    if (inserted) {
+        it->second = RECOVERED_OWNER | next_token_++;
+    }
+    return it->second;
+}
+
+uint64_t JournalOwnerMap::release(const JournalRecord& record) {
+    enter_epoch(record.epoch);
+    auto it = tokens_.find(record.owner);
+    if (it == tokens_.end()) {
+        return 0;
+    }
+    uint64_t token = it->second;
+    tokens_.erase(it);
+    return token;
+}
+
+std::vector<uint64_t> JournalOwnerMap::unreleased() const {
+    std::vector<uint64_t> tokens = orphaned_;
+    for (const auto& [owner, token] : tokens_) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+void JournalOwnerMap::enter_epoch(uint64_t epoch) {
+    // Every connection of an earlier run is gone; a reused owner value is someone new
+    if (epoch != epoch_) {
+        for (const auto& [owner, token] : tokens_) {
+            orphaned_.push_back(token);
+        }
+        tokens_.clear();
+        epoch_ = epoch;
+    }
+}
+
+} // namespace hft
@@ -0,0 +1,278 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Settings for an order journal; an empty directory leaves it off
+ */
+struct JournalConfig {
+    std::string directory;
+    uint64_t segment_bytes = 64ULL << 20;  // Size of every preallocated segment file
+    uint32_t flush_interval_ms = 10;       // msync period; 0 syncs only when a segment is retired
+
+    bool enabled() const { return !directory.empty(); }
+};
+
+/**
+ * @brief What a journal record holds
+ */
+enum class JournalRecordKind : uint8_t {
+    FRAME = 1,         // An inbound order frame, exactly as the wire protocol encodes it
+    DISCONNECT = 2     // Cancel-on-disconnect of every order the owner had resting
+};
+
+/**
+ * @brief Journal writer counters since start
+ */
+struct JournalStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t segments = 0;         // Segment files opened
+    uint64_t syncs = 0;            // msync calls that wrote something
+    uint64_t lost = 0;             // Records dropped because no segment could be opened
+};
+
+/**
+ * @brief Append-only journal of inbound order events in fixed-size mmap'd segments
+ *
+ * Each record is copied into a segment file that was preallocated and
+ * mapped (with its pages faulted in) before it was needed, so an append is
+ * a memcpy and a release store: no syscall and no page fault. A background
+ * thread msyncs what has been written every flush_interval_ms, retires full
+ * segments and keeps the next one ready, so a roll is a pointer swap too.
+ *
+ * Records are checksummed; replay stops at the first record that does not
+ * verify, which is where a crash cut a write short. Data written before a
+ * process crash is in the page cache either way; the flush interval bounds
+ * what a power loss can take.
+ *
+ * One thread appends, normally the one that owns the matching engine.
+ * Segments are named <stream>-<epoch>-<index>.journal; every run of the
+ * server is a new epoch and starts a new segment.
+ */
+class Journal {
+public:
+    Journal(const JournalConfig& config, std::string stream);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * @brief Create the first segment of epoch and start the flush thread; false with a logged reason
+     */
+    bool open(uint64_t epoch);
+
+    /**
+     * @brief Sync everything written, unmap the segments and stop the flush thread
+     */
+    void close();
+
+    /**
+     * @brief Record an inbound frame submitted for owner
+     */
+    bool append_frame(uint64_t owner, const uint8_t* frame, size_t length) {
+        return append(JournalRecordKind::FRAME, owner, frame, length);
+    }
+
+    /**
+     * @brief Record that owner's resting orders were cancelled on disconnect
+     */
+    bool append_disconnect(uint64_t owner) {
+        return append(JournalRecordKind::DISCONNECT, owner, nullptr, 0);
+    }
+
+    JournalStats stats() const;
+
+private:
+    struct Segment {
+        int fd = -1;
+        uint8_t* base = nullptr;
+        uint64_t index = 0;
+        std::string path;
+        std::atomic<uint64_t> committed{0};  // Bytes holding complete records
+        uint64_t synced = 0;                 // Flush thread only
+    };
+
+    bool append(JournalRecordKind kind, uint64_t owner, const uint8_t* payload, size_t length);
+    bool roll();
+    std::unique_ptr<Segment> create_segment(uint64_t index);
+    void sync_segment(Segment& segment);
+    void release_segment(Segment& segment, bool discard);
+    void flush_thread();
+
+    JournalConfig config_;
+    std::string stream_;
+    uint64_t epoch_ = 0;
+
+    // Writer state
+    Segment* current_ = nullptr;
+    uint64_t write_offset_ = 0;
+    uint64_t next_sequence_ = 1;
+
+    // Shared with the flush thread; the writer only locks to roll
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unique_ptr<Segment> active_;
+    std::unique_ptr<Segment> spare_;         // Next segment, already mapped
+    std::vector<std::unique_ptr<Segment>> retired_;
+    uint64_t next_index_ = 0;
+    bool preparing_ = false;                 // The flush thread is creating the spare
+    bool stopping_ = false;
+    std::thread flusher_;
+
+    // Written by one thread each
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> segments_{0};
+    std::atomic<uint64_t> syncs_{0};
+    std::atomic<uint64_t> lost_{0};
+};
+
+/**
+ * @brief One record read back from a journal
+ */
+struct JournalRecord {
+    uint64_t epoch;
+    uint64_t sequence;             // Per stream and epoch, from 1
+    uint64_t owner;                // Owner token the record was written with
+    JournalRecordKind kind;
+    const uint8_t* frame;          // Validated wire frame; nullptr for DISCONNECT
+    size_t frame_length;
+};
+
+/**
+ * @brief Reads every segment in a journal directory in replay order
+ *
+ * Segments are visited by epoch, then stream, then index. Within a stream
+ * and epoch that is the order the records were written in; different
+ * streams hold disjoint symbols, so their interleaving does not matter.
+ */
+class JournalReader {
+public:
+    JournalReader() = default;
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    /**
+     * @brief List the segments in directory; a missing directory is created and reads as empty
+     */
+    bool open(const std::string& directory);
+
+    /**
+     * @brief Next record, or false once every segment is exhausted
+     *
+     * The frame stays valid until the following call.
+     */
+    bool next(JournalRecord& record);
+
+    uint64_t segments() const { return segments_.size(); }
+    uint64_t records() const { return records_; }
+    uint64_t damaged() const { return damaged_; }     // Segments whose tail did not verify
+
+    /**
+     * @brief Epoch for the next run: one past the newest epoch found
+     */
+    uint64_t next_epoch() const { return max_epoch_ + 1; }
+
+    /**
+     * @brief Delete the segments read so far that held no records
+     *
+     * A run that stops uncleanly leaves its prepared spare segment behind.
+     */
+    size_t discard_empty_segments();
+
+    /**
+     * @brief Move the segments read so far into the archive subdirectory
+     *
+     * The checkpoint after a recovery that left no order resting: the next
+     * replay starts from the segments written after it. Archived epochs
+     * still count towards next_epoch().
+     */
+    size_t archive_segments();
+
+private:
+    struct SegmentInfo {
+        std::string path;
+        std::string stream;
+        uint64_t epoch;
+        uint64_t index;
+        uint64_t records;
+    };
+
+    bool scan(const std::string& directory, bool replay);
+    bool map_segment(size_t position);
+    void unmap_segment();
+
+    std::string directory_;
+    std::vector<SegmentInfo> segments_;
+    size_t position_ = 0;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    uint64_t expected_sequence_ = 0;
+    uint64_t max_epoch_ = 0;
+    uint64_t records_ = 0;
+    uint64_t damaged_ = 0;
+};
+
+/**
+ * @brief Owner tokens for replayed orders
+ *
+ * The owners in a journal are connections of an earlier run, so replayed
+ * orders rest under recovered tokens instead: bit 63 set, which no live
+ * owner carries (connection addresses are user space; connection refs
+ * would need 2^31 reuses of one slot). Fills for a recovered token go to
+ * no one. Each owner keeps its token until its disconnect record, and
+ * owners never carry across epochs.
+ */
+class JournalOwnerMap {
+public:
+    static constexpr uint64_t RECOVERED_OWNER = 1ULL << 63;
+
+    static bool is_recovered(uint64_t owner) { return (owner & RECOVERED_OWNER) != 0; }
+
+    /**
+     * @brief Token for the record's owner, allocating one if it has none
+     */
+    uint64_t token(const JournalRecord& record);
+
+    /**
+     * @brief Token for a DISCONNECT record's owner, which is then forgotten; 0 if it had none
+     */
+    uint64_t release(const JournalRecord& record);
+
+    /**
+     * @brief Tokens whose owner never disconnected, from every epoch read
+     *
+     * Nobody can cancel these orders or receive their fills, so recovery
+     * cancels them once replay is done.
+     */
+    std::vector<uint64_t> unreleased() const;
+
+private:
+    void enter_epoch(uint64_t epoch);
+
+    std::unordered_map<uint64_t, uint64_t> tokens_;
+    std::vector<uint64_t> orphaned_;           // Unreleased tokens of earlier epochs
+    uint64_t epoch_ = 0;
+    uint64_t next_token_ = 1;
+};
+
+} // namespace hft
+
+#endif // JOURNAL_H
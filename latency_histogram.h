@@ -0,0 +1,335 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include "object_pool.h"
+
+namespace hft {
+
+/**
+ * @brief Points along a message's path where latency is recorded
+ *
+ * RECEIVE is the time spent inside the recv() call that returned the bytes.
+ * The other stages are measured from the moment that recv() returned, so
+ * each one includes every stage before it (and any queueing in between).
+ */
+enum class LatencyStage : uint8_t {
+    RECEIVE = 0,    // recv() call duration
+    DECODE,         // Read complete -> message decoded
+    DISPATCH,       // Read complete -> handler / matching engine returned
+    SEND,           // Read complete -> response send() returned
+    COUNT
+};
+
+constexpr size_t LATENCY_STAGE_COUNT = static_cast<size_t>(LatencyStage::COUNT);
+
+inline const char* latency_stage_name(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::RECEIVE: return "receive";
+        case LatencyStage::DECODE: return "decode";
+        case LatencyStage::DISPATCH: return "dispatch";
+        case LatencyStage::SEND: return "send";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Bucket layout shared by recorders and snapshots
+ *
+ * Log-linear: values below 2 * SUB_BUCKETS are exact, above that every
+ * power of two is split into SUB_BUCKETS equal buckets, so any recorded
+ * value is reported within 1 / SUB_BUCKETS (~1.6%) of its true value.
+ * Values above HIGHEST_TRACKABLE (~68 s) are clamped.
+ */
+struct HistogramLayout {
+    static constexpr uint32_t SUB_BUCKET_BITS = 6;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint32_t HIGHEST_BIT = 35;
+    static constexpr uint64_t HIGHEST_TRACKABLE = (1ULL << (HIGHEST_BIT + 1)) - 1;
+    static constexpr size_t BUCKET_COUNT = (HIGHEST_BIT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    
+    static size_t index_of(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        if (value > HIGHEST_TRACKABLE) {
+            value = HIGHEST_TRACKABLE;
+        }
+        uint32_t shift = (63 - static_cast<uint32_t>(__builtin_clzll(value))) - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift * SUB_BUCKETS + (value >> shift));
+    }
+    
+    /**
+     * @brief Largest value that maps to the bucket, as HDR histograms report
+     */
+    static uint64_t highest_equivalent(size_t index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = index / SUB_BUCKETS - 1;
+        uint64_t top = index - shift * SUB_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+};
+
+/**
+ * @brief Single-writer histogram; any thread may read it while it is written
+ *
+ * Counters are atomics updated with relaxed load/store pairs, which compile
+ * to plain increments on x86: a record is a bit scan and three adds with no
+ * locked instruction. Only the owning thread may call record().
+ */
+class LatencyHistogram {
+public:
+    void record(uint64_t value_ns) {
+        bump(buckets_[HistogramLayout::index_of(value_ns)], 1);
+        bump(count_, 1);
+        bump(sum_, value_ns);
+    }
+
+    /**
+     * @brief Zero every count; only while the owning thread is not recording
+     */
+    void clear() {
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    friend class HistogramSnapshot;
+    
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> buckets_[HistogramLayout::BUCKET_COUNT];
+};
+
+/**
+ * @brief Percentiles and extremes of one stage; values in nanoseconds
+ */
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_ns = 0.0;
+    uint64_t min_ns = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+/**
+ * @brief Plain copy of histogram counts used to merge and diff recorders
+ */
+class HistogramSnapshot {
+public:
+    void clear() {
+        count_ = 0;
+        sum_ = 0;
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            buckets_[i] = 0;
+        }
+    }
+    
+    void add(const LatencyHistogram& histogram) {
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            buckets_[i] += histogram.buckets_[i].load(std::memory_order_relaxed);
+        }
+        count_ += histogram.count_.load(std::memory_order_relaxed);
+        sum_ += histogram.sum_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Counts recorded since an earlier snapshot of the same histograms
+     */
+    void subtract(const HistogramSnapshot& earlier) {
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            buckets_[i] -= earlier.buckets_[i];
+        }
+        count_ -= earlier.count_;
+        sum_ -= earlier.sum_;
+    }
+    
+    /**
+     * @brief Value at quantile q in [0, 1]; 0 when empty
+     */
+    uint64_t value_at(double q) const {
+        // Bucket totals are the source of truth: count_ may run slightly
+        // ahead of them in a snapshot taken while a writer is mid-record
+        uint64_t total = 0;
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            total += buckets_[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+        
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        if (rank == 0) {
+            rank = 1;
+        } else if (rank > total) {
+            rank = total;
+        }
+        
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HistogramLayout::BUCKET_COUNT; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                return HistogramLayout::highest_equivalent(i);
+            }
+        }
+        return HistogramLayout::HIGHEST_TRACKABLE;
+    }
+    
+    void summarize(LatencySummary& summary) const {
+        summary.count = count_;
+        summary.mean_ns = count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+        summary.min_ns = value_at(0.0);
+        summary.p50_ns = value_at(0.50);
+        summary.p90_ns = value_at(0.90);
+        summary.p99_ns = value_at(0.99);
+        summary.p999_ns = value_at(0.999);
+        summary.max_ns = value_at(1.0);
+    }
+
+private:
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t buckets_[HistogramLayout::BUCKET_COUNT] = {};
+};
+
+/**
+ * @brief Interval and cumulative latency for every stage
+ *
+ * The interval view covers everything recorded since the previous report.
+ */
+struct LatencyReport {
+    LatencySummary interval[LATENCY_STAGE_COUNT];
+    LatencySummary cumulative[LATENCY_STAGE_COUNT];
+};
+
+/**
+ * @brief One latency histogram per stage for a single thread
+ */
+struct alignas(CACHE_LINE_SIZE) LatencyRecorder {
+    LatencyHistogram stages[LATENCY_STAGE_COUNT];
+    
+    void record(LatencyStage stage, uint64_t value_ns) {
+        stages[static_cast<size_t>(stage)].record(value_ns);
+    }
+};
+
+/**
+ * @brief Fixed set of per-thread recorders merged on demand
+ *
+ * Each recording thread is handed its own recorder by index up front, so
+ * the hot path never touches shared state. report() merges every recorder
+ * and diffs against the previous report for the interval view; it is the
+ * only locked operation and runs off the hot path. The recorders may live
+ * in a MetricsSegment, where other processes read them.
+ */
+class LatencyTracker {
+public:
+    explicit LatencyTracker(size_t recorders)
+        : owned_(new LatencyRecorder[recorders]), recorders_(owned_.get()), recorder_count_(recorders),
+          previous_(new HistogramSnapshot[LATENCY_STAGE_COUNT]),
+          current_(new HistogramSnapshot[LATENCY_STAGE_COUNT]) {}
+    
+    /**
+     * @brief Use recorders someone else owns and keeps alive
+     */
+    LatencyTracker(LatencyRecorder* recorders, size_t count)
+        : recorders_(recorders), recorder_count_(count),
+          previous_(new HistogramSnapshot[LATENCY_STAGE_COUNT]),
+          current_(new HistogramSnapshot[LATENCY_STAGE_COUNT]) {}
+    
+    LatencyTracker(const LatencyTracker&) = delete;
+    LatencyTracker& operator=(const LatencyTracker&) = delete;
+    
+    LatencyRecorder& recorder(size_t index) { return recorders_[index]; }
+    size_t recorder_count() const { return recorder_count_; }
+    
+    void report(LatencyReport& out) const {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        HistogramSnapshot interval;
+        
+        for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+            HistogramSnapshot& current = current_[stage];
+            current.clear();
+            for (size_t i = 0; i < recorder_count_; ++i) {
+                current.add(recorders_[i].stages[stage]);
+            }
+            current.summarize(out.cumulative[stage]);
+            
+            interval = current;
+            interval.subtract(previous_[stage]);
+            interval.summarize(out.interval[stage]);
+            
+            previous_[stage] = current;
+        }
+    }
+
+    /**
+     * @brief Forget everything recorded so far; only while no thread is recording
+     */
+    void reset() {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        for (size_t i = 0; i < recorder_count_; ++i) {
+            for (LatencyHistogram& histogram : recorders_[i].stages) {
+                histogram.clear();
+            }
+        }
+        for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+            previous_[stage].clear();
+        }
+    }
+
+private:
+    std::unique_ptr<LatencyRecorder[]> owned_;   // Null when the recorders live elsewhere
+    LatencyRecorder* recorders_;
+    size_t recorder_count_;
+    
+    // Reader-side state for interval diffs
+    mutable std::mutex report_mutex_;
+    std::unique_ptr<HistogramSnapshot[]> previous_;
+    std::unique_ptr<HistogramSnapshot[]> current_;
+};
+
+/**
+ * @brief Print one row per stage: count, mean and percentiles in microseconds
+ */
+inline void print_latency_summaries(std::ostream& out, const char* title,
+                                    const LatencySummary (&summaries)[LATENCY_STAGE_COUNT]) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    
+    out << title << " (μs)" << std::endl;
+    out << "  " << std::left << std::setw(10) << "stage" << std::right
+        << std::setw(12) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+        << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+        << std::setw(10) << "max" << std::endl;
+    
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        const LatencySummary& s = summaries[stage];
+        out << "  " << std::left << std::setw(10) << latency_stage_name(static_cast<LatencyStage>(stage))
+            << std::right << std::setw(12) << s.count << std::fixed << std::setprecision(2)
+            << std::setw(10) << s.mean_ns / 1000.0 << std::setw(10) << us(s.p50_ns)
+            << std::setw(10) << us(s.p90_ns) << std::setw(10) << us(s.p99_ns)
+            << std::setw(10) << us(s.p999_ns) << std::setw(10) << us(s.max_ns) << std::endl;
+    }
+}
+
+} // namespace hft
+
+#endif // LATENCY_HISTOGRAM_H
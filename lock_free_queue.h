@@ -0,0 +1,333 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <variant>
+#include "object_pool.h"
+
+namespace ultra_hft {
+
+// Single-producer/single-consumer ring buffer.
+//
+// head_ and tail_ are free-running counters on their own cache lines; each
+// side also keeps a cached copy of the other side's counter and only reloads
+// it (one cross-core acquire load) when the cached value says the ring looks
+// full or empty. The bulk operations move up to N items per index publish.
+template<typename T, size_t SIZE>
+class LockFreeRingBuffer {
+    static_assert(SIZE > 0 && ((SIZE & (SIZE - 1)) == 0), "Size must be a power of 2");
+
+private:
+    static constexpr size_t MASK = SIZE - 1;
+    
+    // Consumer-owned line
+    alignas(hft::CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+    
+    // Producer-owned line
+    alignas(hft::CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+    
+    alignas(hft::CACHE_LINE_SIZE) std::array<T, SIZE> buffer_;
+
+public:
+    LockFreeRingBuffer() = default;
+    
+    bool push(const T& item) noexcept {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        
+        if (tail - cached_head_ == SIZE) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == SIZE) {
+                return false; // Full
+            }
+        }
+        
+        buffer_[tail & MASK] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool pop(T& item) noexcept {
+        size_t head = head_.load(std::memory_order_relaxed);
+        
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false; // Empty
+            }
+        }
+        
+        item = buffer_[head & MASK];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Push up to count items with a single tail publish; returns how many fit
+    size_t push_bulk(const T* items, size_t count) noexcept {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t free_slots = SIZE - (tail - cached_head_);
+        
+        if (free_slots < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free_slots = SIZE - (tail - cached_head_);
+        }
+        
+        size_t n = count < free_slots ? count : free_slots;
+        for (size_t i = 0; i < n; ++i) {
+            buffer_[(tail + i) & MASK] = items[i];
+        }
+        
+        if (n > 0) {
+            tail_.store(tail + n, std::memory_order_release);
+        }
+        return n;
+    }
+    
+    // Pop up to max_count items with a single head publish; returns how many were taken
+    size_t pop_bulk(T* items, size_t max_count) noexcept {
+        return consume_bulk([items](const T& item) mutable { *items++ = item; }, max_count);
+    }
+    
+    // Hand up to max_count items to fn in place, then release them all at once.
+    // Avoids copying large items out of the ring.
+    template<typename Fn>
+    size_t consume_bulk(Fn&& fn, size_t max_count) noexcept {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t ready = cached_tail_ - head;
+        
+        if (ready < max_count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            ready = cached_tail_ - head;
+        }
+        
+        size_t n = max_count < ready ? max_count : ready;
+        for (size_t i = 0; i < n; ++i) {
+            fn(buffer_[(head + i) & MASK]);
+        }
+        
+        if (n > 0) {
+            head_.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
+    
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    
+    bool full() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) == SIZE;
+    }
+    
+    size_t size() const noexcept {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+    
+    size_t capacity() const noexcept {
+        return SIZE;
+    }
+};
+
+// Capacities a SizedRingBuffer can be created with. Each one is its own
+// LockFreeRingBuffer instantiation, so the index mask stays a constant.
+constexpr size_t RING_SIZE_CLASSES[] = {1024, 4096, 16384, 65536};
+
+constexpr bool is_ring_size_class(size_t size) noexcept {
+    for (size_t supported : RING_SIZE_CLASSES) {
+        if (size == supported) return true;
+    }
+    return false;
+}
+
+// SPSC ring whose capacity is picked at startup from RING_SIZE_CLASSES.
+// Each call dispatches on the size class, a branch that never changes
+// once the ring exists. The ring comes from memory when given, otherwise
+// from the heap.
+template<typename T>
+class SizedRingBuffer {
+    template<size_t SIZE>
+    using RingPtr = hft::ResourcePtr<LockFreeRingBuffer<T, SIZE>>;
+    using Ring = std::variant<RingPtr<1024>, RingPtr<4096>, RingPtr<16384>, RingPtr<65536>>;
+    Ring ring_;
+
+    static Ring make(size_t size, std::pmr::memory_resource* memory) {
+        switch (size) {
+            case 1024: return hft::allocate_object<LockFreeRingBuffer<T, 1024>>(memory);
+            case 16384: return hft::allocate_object<LockFreeRingBuffer<T, 16384>>(memory);
+            case 65536: return hft::allocate_object<LockFreeRingBuffer<T, 65536>>(memory);
+            default: return hft::allocate_object<LockFreeRingBuffer<T, 4096>>(memory);
+        }
+    }
+
+public:
+    // Sizes outside RING_SIZE_CLASSES get 4096; callers check is_ring_size_class() first
+    explicit SizedRingBuffer(size_t size, std::pmr::memory_resource* memory = nullptr)
+        : ring_(make(size, memory)) {}
+
+    bool push(const T& item) noexcept {
+        return std::visit([&](auto& ring) { return ring->push(item); }, ring_);
+    }
+
+    bool pop(T& item) noexcept {
+        return std::visit([&](auto& ring) { return ring->pop(item); }, ring_);
+    }
+
+    template<typename Fn>
+    size_t consume_bulk(Fn&& fn, size_t max_count) noexcept {
+        return std::visit([&](auto& ring) { return ring->consume_bulk(fn, max_count); }, ring_);
+    }
+
+    size_t size() const noexcept {
+        return std::visit([](const auto& ring) { return ring->size(); }, ring_);
+    }
+
+    size_t capacity() const noexcept {
+        return std::visit([](const auto& ring) { return ring->capacity(); }, ring_);
+    }
+};
+
+// Bounded multi-producer/multi-consumer queue (Vyukov). Each cell carries a
+// sequence number that tells producers and consumers whose turn it is, so
+// the only contended writes are the CAS on enqueue_pos_/dequeue_pos_.
+template<typename T, size_t SIZE>
+class MPMCRingBuffer {
+    static_assert(SIZE >= 2 && ((SIZE & (SIZE - 1)) == 0), "Size must be a power of 2");
+
+protected:
+    static constexpr size_t MASK = SIZE - 1;
+    
+    struct alignas(hft::CACHE_LINE_SIZE) Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    
+    alignas(hft::CACHE_LINE_SIZE) std::array<Cell, SIZE> cells_;
+    alignas(hft::CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_{0};
+    alignas(hft::CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_{0};
+
+public:
+    MPMCRingBuffer() {
+        for (size_t i = 0; i < SIZE; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    bool push(const T& item) noexcept {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        
+        while (true) {
+            cell = &cells_[pos & MASK];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool pop(T& item) noexcept {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        
+        while (true) {
+            cell = &cells_[pos & MASK];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        item = cell->data;
+        cell->sequence.store(pos + MASK + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Approximate: producers and consumers may be mid-operation
+    size_t size() const noexcept {
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        return enqueued >= dequeued ? enqueued - dequeued : 0;
+    }
+    
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+    
+    size_t capacity() const noexcept {
+        return SIZE;
+    }
+};
+
+// Multi-producer/single-consumer queue for fan-in, e.g. many I/O threads
+// feeding one strategy thread. Producers use the MPMC protocol; the lone
+// consumer needs no CAS and can drain a run of ready cells in one pass.
+template<typename T, size_t SIZE>
+class MPSCRingBuffer : public MPMCRingBuffer<T, SIZE> {
+    using Base = MPMCRingBuffer<T, SIZE>;
+    using Base::MASK;
+    using Base::cells_;
+    using Base::dequeue_pos_;
+
+public:
+    // Single consumer only
+    bool pop(T& item) noexcept {
+        return consume_bulk([&item](const T& value) { item = value; }, 1) == 1;
+    }
+    
+    // Single consumer only
+    size_t pop_bulk(T* items, size_t max_count) noexcept {
+        return consume_bulk([items](const T& item) mutable { *items++ = item; }, max_count);
+    }
+    
+    // Single consumer only: visit up to max_count ready items in FIFO order.
+    // Stops at the first cell a producer has claimed but not yet published.
+    template<typename Fn>
+    size_t consume_bulk(Fn&& fn, size_t max_count) noexcept {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t n = 0;
+        
+        while (n < max_count) {
+            auto& cell = cells_[(pos + n) & MASK];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + n + 1) {
+                break;
+            }
+            fn(cell.data);
+            cell.sequence.store(pos + n + MASK + 1, std::memory_order_release);
+            ++n;
+        }
+        
+        if (n > 0) {
+            dequeue_pos_.store(pos + n, std::memory_order_relaxed);
+        }
+        return n;
+    }
+};
+
+} // namespace ultra_hft
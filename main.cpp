@@ -1,17 +1,26 @@
 #include "hft_server.h"
+#include "config_file.h"
 #include <iostream>
 #include <csignal>
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <iomanip>
 
 namespace hft {
 
 // Global server instance for signal handling
 HFTServer* g_server = nullptr;
 
+// Set by SIGHUP; the main loop reloads the risk limits
+volatile sig_atomic_t g_reload_risk = 0;
+
 // Signal handler for graceful shutdown
 void signal_handler(int signal) {
+    if (signal == SIGHUP) {
+        g_reload_risk = 1;
+        return;
+    }
     if (g_server && signal == SIGINT) {
         std::cout << "\nReceived SIGINT, shutting down gracefully..." << std::endl;
         g_server->stop();
@@ -27,22 +36,164 @@ int main(int argc, char* argv[]) {
     std::string server_ip = "127.0.0.1";
     uint16_t server_port = 8888;
     size_t thread_count = 4;
+    WorkerOptions worker_options;
+    MulticastConfig multicast;
+    RiskLimits risk_limits;
+    std::string risk_limits_path;
+    std::vector<InstrumentSpec> instruments;
+    JournalConfig journal_config;
+    
+    // Config file and --set keys
+    auto apply = [&](std::string_view key, std::string_view value, std::string& error) {
+        if (key == "ip") {
+            server_ip = std::string(value);
+            return !server_ip.empty();
+        } else if (key == "port") {
+            return parse_setting(value, server_port) && server_port != 0;
+        } else if (key == "threads") {
+            return parse_setting(value, thread_count) && thread_count != 0;
+        } else if (key == "sharded") {
+            return parse_setting(value, worker_options.sharded);
+        } else if (key == "cpus") {
+            worker_options.cpu_affinity.clear();
+            return value.empty() || parse_cpu_list(std::string(value), worker_options.cpu_affinity);
+        } else if (key == "max_connections") {
+            return parse_setting(value, worker_options.max_connections) && worker_options.max_connections != 0;
+        } else if (key == "event_batch") {
+            return parse_setting(value, worker_options.event_batch) && worker_options.event_batch != 0;
+        } else if (key == "listen_backlog") {
+            uint64_t backlog = 0;
+            if (!parse_setting(value, INT32_MAX, backlog)) {
+                return false;
+            }
+            worker_options.listen_backlog = static_cast<uint32_t>(backlog);
+            return true;
+        } else if (key == "metrics_segment") {
+            worker_options.metrics_segment = std::string(value);
+            return true;
+        }
+        return apply_common_setting(key, value, {worker_options.transport, worker_options.busy_poll,
+                                                 worker_options.outbound, worker_options.session,
+                                                 worker_options.warmup}, error);
+    };
+    
+    // The config file goes first wherever it appears, so options override it
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--config" && !load_settings(argv[i + 1], apply)) {
+            return 1;
+        }
+    }
     
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg == "--ip" && i + 1 < argc) {
+        if (arg == "--config" && i + 1 < argc) {
+            ++i; // Already loaded
+        } else if (arg == "--set" && i + 1 < argc) {
+            if (!apply_setting(argv[++i], apply)) {
+                return 1;
+            }
+        } else if (arg == "--ip" && i + 1 < argc) {
             server_ip = argv[++i];
         } else if (arg == "--port" && i + 1 < argc) {
             server_port = static_cast<uint16_t>(std::stoi(argv[++i]));
         } else if (arg == "--threads" && i + 1 < argc) {
             thread_count = std::stoul(argv[++i]);
+        } else if (arg == "--sharded") {
+            worker_options.sharded = true;
+        } else if (arg == "--cpus" && i + 1 < argc) {
+            if (!parse_cpu_list(argv[++i], worker_options.cpu_affinity)) {
+                std::cerr << "Invalid CPU list: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--multicast" && i + 1 < argc) {
+            if (!parse_multicast_endpoint(argv[++i], multicast)) {
+                std::cerr << "Invalid multicast endpoint (want group:port): " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--multicast-if" && i + 1 < argc) {
+            multicast.interface_ip = argv[++i];
+        } else if (arg == "--multicast-ttl" && i + 1 < argc) {
+            multicast.ttl = static_cast<uint8_t>(std::stoul(argv[++i]));
+        } else if (arg == "--transport" && i + 1 < argc) {
+            if (!parse_transport_kind(argv[++i], worker_options.transport.kind)) {
+                std::cerr << "Unknown transport (want epoll or io_uring): " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sqpoll") {
+            worker_options.transport.sqpoll = true;
+        } else if (arg == "--busy-poll") {
+            worker_options.busy_poll.spin = true;
+        } else if (arg == "--so-busy-poll" && i + 1 < argc) {
+            worker_options.busy_poll.socket_busy_poll_us = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--prefer-busy-poll") {
+            worker_options.busy_poll.prefer_busy_poll = true;
+        } else if (arg == "--sched-fifo" && i + 1 < argc) {
+            worker_options.busy_poll.realtime_priority = std::stoi(argv[++i]);
+            if (worker_options.busy_poll.realtime_priority < 1 || worker_options.busy_poll.realtime_priority > 99) {
+                std::cerr << "SCHED_FIFO priority must be 1-99" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--send-high-water" && i + 1 < argc) {
+            worker_options.outbound.high_water = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--send-limit" && i + 1 < argc) {
+            worker_options.outbound.limit = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--heartbeat" && i + 1 < argc) {
+            worker_options.session.heartbeat_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--idle-timeout" && i + 1 < argc) {
+            worker_options.session.idle_timeout_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--require-login") {
+            worker_options.session.require_login = true;
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            worker_options.metrics_segment = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            worker_options.warmup.rounds = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--risk-limits" && i + 1 < argc) {
+            risk_limits_path = argv[++i];
+            if (!load_risk_limits(risk_limits_path, risk_limits)) {
+                return 1;
+            }
+        } else if (arg == "--instruments" && i + 1 < argc) {
+            if (!load_instruments(argv[++i], instruments)) {
+                return 1;
+            }
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journal_config.directory = argv[++i];
+        } else if (arg == "--journal-segment-mb" && i + 1 < argc) {
+            journal_config.segment_bytes = std::stoull(argv[++i]) << 20;
+        } else if (arg == "--journal-flush-ms" && i + 1 < argc) {
+            journal_config.flush_interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (arg == "--help") {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
+                      << "  --config <file>  Read settings from a key = value file; other options override it\n"
+                      << "  --set <key=value>  Override one config file setting\n"
                       << "  --ip <ip>        Server IP address (default: 127.0.0.1)\n"
                       << "  --port <port>    Server port (default: 8888)\n"
                       << "  --threads <n>    Number of worker threads (default: 4)\n"
+                      << "  --sharded        Per-worker SO_REUSEPORT listener and epoll\n"
+                      << "  --cpus <list>    Pin workers to CPUs, e.g. 2,3 or 4-7\n"
+                      << "  --transport <epoll|io_uring>  Socket I/O backend (default: epoll)\n"
+                      << "  --sqpoll         io_uring: kernel thread polls the submission queue\n"
+                      << "  --busy-poll      Workers spin with zero-timeout polls instead of sleeping\n"
+                      << "  --so-busy-poll <us>   SO_BUSY_POLL on client sockets\n"
+                      << "  --prefer-busy-poll    SO_PREFER_BUSY_POLL on client sockets\n"
+                      << "  --sched-fifo <prio>   Run workers under SCHED_FIFO (1-99)\n"
+                      << "  --send-high-water <bytes>  Stop reading a client with this much unsent (default: 262144)\n"
+                      << "  --send-limit <bytes>       Disconnect a client with this much unsent (default: 4194304)\n"
+                      << "  --heartbeat <ms>           HEARTBEAT logged-in sessions this often (default: off)\n"
+                      << "  --idle-timeout <ms>        Disconnect a client silent this long (default: off)\n"
+                      << "  --require-login            Disconnect a client whose first frame is not LOGIN\n"
+                      << "  --metrics <name>           Publish counters and latency in /dev/shm/<name> for metrics_exporter\n"
+                      << "  --warmup <rounds>          Run up to this many rounds of synthetic orders before listening (default: off)\n"
+                      << "  --multicast <group:port>  Also publish market data on a UDP multicast feed\n"
+                      << "  --multicast-if <ip>       Interface for the feed (default: routing table)\n"
+                      << "  --multicast-ttl <n>       Feed TTL (default: 1)\n"
+                      << "  --risk-limits <file>      Pre-trade risk limits, reloaded on SIGHUP\n"
+                      << "  --instruments <file>      Instrument master; other symbols are rejected\n"
+                      << "  --journal <dir>           Journal orders to dir and replay it at startup\n"
+                      << "  --journal-segment-mb <n>  Journal segment file size (default: 64)\n"
+                      << "  --journal-flush-ms <ms>   Journal msync interval; 0 = on segment roll only (default: 10)\n"
                       << "  --help           Show this help message\n";
             return 0;
         }
@@ -52,6 +203,16 @@ int main(int argc, char* argv[]) {
     std::cout << "Server IP: " << server_ip << std::endl;
     std::cout << "Server Port: " << server_port << std::endl;
     std::cout << "Worker Threads: " << thread_count << std::endl;
+    std::cout << "Worker Mode: " << (worker_options.sharded ? "sharded" : "shared")
+              << (worker_options.busy_poll.spin ? ", busy-poll" : "") << std::endl;
+    if (multicast.enabled()) {
+        std::cout << "Multicast Feed: " << multicast.group << ":" << multicast.port << std::endl;
+    }
+    if (worker_options.session.timers() || worker_options.session.require_login) {
+        std::cout << "Sessions: heartbeat " << worker_options.session.heartbeat_ms << " ms, idle timeout "
+                  << worker_options.session.idle_timeout_ms << " ms"
+                  << (worker_options.session.require_login ? ", login required" : "") << std::endl;
+    }
     std::cout << "Target Latency: < 20μs" << std::endl;
     std::cout << "==========================" << std::endl;
     
@@ -62,26 +223,95 @@ int main(int argc, char* argv[]) {
     // Set up signal handling
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGHUP, signal_handler);
     
     // Initialize server
-    if (!server.initialize(server_ip, server_port, thread_count)) {
+    if (!server.initialize(server_ip, server_port, thread_count, worker_options)) {
         std::cerr << "Failed to initialize HFT server" << std::endl;
         return 1;
     }
     
+    // Without a master any symbol is interned on first sight; either way the
+    // per-instrument arrays below are sized to the directory
+    auto directory = instruments.empty() ? std::make_shared<InstrumentDirectory>()
+                                         : std::make_shared<InstrumentDirectory>(instruments);
+    server.set_instruments(directory);
+    if (!instruments.empty()) {
+        std::cout << "Instruments: " << directory->size() << " from the instrument master" << std::endl;
+    }
+    
     // Create and register services
-    auto order_service = std::make_shared<OrderService>();
-    auto market_data_service = std::make_shared<MarketDataService>();
+    FanoutConfig fanout_config;
+    fanout_config.max_symbols = directory->capacity();
+    // One book shard per worker, so workers rarely contend for a book
+    auto order_service = std::make_shared<OrderService>(OrderBookConfig{}, static_cast<uint32_t>(thread_count));
+    order_service->configure_books(*directory);
+    auto market_data_service = std::make_shared<MarketDataService>(fanout_config);
+    auto risk_store = std::make_shared<RiskLimitsStore>(risk_limits);
+    RiskConfig risk_config;
+    risk_config.max_clients = server.client_capacity();
+    risk_config.max_symbols = directory->capacity();
+    auto risk_engine = std::make_shared<RiskEngine>(risk_config, risk_store, market_data_service->market_state());
+    order_service->set_risk_engine(risk_engine);
+    if (multicast.enabled() && !market_data_service->enable_multicast(multicast)) {
+        std::cerr << "Failed to start the multicast feed" << std::endl;
+        return 1;
+    }
+    
+    // Replay the journal before any client can connect, then keep appending to it
+    std::shared_ptr<Journal> journal;
+    if (journal_config.enabled()) {
+        JournalReader reader;
+        if (!reader.open(journal_config.directory)) {
+            return 1;
+        }
+        auto replay_start = std::chrono::steady_clock::now();
+        size_t cancelled = 0;
+        size_t replayed = order_service->recover(reader, cancelled);
+        auto replay_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - replay_start).count();
+        std::cout << "Journal: replayed " << replayed << " records from " << reader.segments() << " segments in "
+                  << replay_us << "us, cancelled " << cancelled << " orphaned orders";
+        if (reader.damaged() > 0) {
+            std::cout << " (" << reader.damaged() << " segments cut short)";
+        }
+        std::cout << std::endl;
+        reader.discard_empty_segments();
+        reader.archive_segments();
+        
+        journal = std::make_shared<Journal>(journal_config, "orders");
+        if (!journal->open(reader.next_epoch())) {
+            std::cerr << "Failed to open the journal in " << journal_config.directory << std::endl;
+            return 1;
+        }
+        order_service->set_journal(journal);
+    }
     
     server.register_service(MessageType::ORDER_NEW, order_service);
     server.register_service(MessageType::ORDER_CANCEL, order_service);
     server.register_service(MessageType::ORDER_REPLACE, order_service);
     server.register_service(MessageType::MARKET_DATA, market_data_service);
+    server.register_service(MessageType::MARKET_DATA_SUBSCRIBE, market_data_service);
+    server.register_service(MessageType::MARKET_DATA_UNSUBSCRIBE, market_data_service);
+    server.register_service(MessageType::FEED_RETRANSMIT_REQUEST, market_data_service);
+    server.register_service(MessageType::FEED_SNAPSHOT_REQUEST, market_data_service);
+    
+    // Warm-up orders match in a book of their own, with their own positions,
+    // so none of them reaches the real book or the journal
+    if (worker_options.warmup.enabled()) {
+        auto warmup_service = std::make_shared<OrderService>();
+        warmup_service->set_risk_engine(
+            std::make_shared<RiskEngine>(risk_config, risk_store, market_data_service->market_state()));
+        server.register_warmup_service(MessageType::ORDER_NEW, warmup_service);
+    }
     
     std::cout << "Services registered successfully" << std::endl;
     
     // Start server
-    server.start();
+    if (!server.start()) {
+        std::cerr << "Failed to start HFT Server" << std::endl;
+        return 1;
+    }
     
     // Main server loop with statistics reporting
     auto last_stats_time = std::chrono::steady_clock::now();
@@ -90,22 +320,89 @@ int main(int argc, char* argv[]) {
     while (true) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         
+        if (g_reload_risk) {
+            g_reload_risk = 0;
+            RiskLimits reloaded;
+            if (risk_limits_path.empty()) {
+                std::cerr << "SIGHUP ignored: no --risk-limits file to reload" << std::endl;
+            } else if (load_risk_limits(risk_limits_path, reloaded)) {
+                risk_store->publish(reloaded);
+                std::cout << "Reloaded risk limits from " << risk_limits_path << std::endl;
+            }
+        }
+        
+        // The exporter reads worker counters straight from the segment; only
+        // the gauges are sampled here
+        if (MetricsSegment* metrics = server.metrics()) {
+            hft::FanoutStats fanout = market_data_service->fanout_stats();
+            metrics->set(Gauge::MARKET_DATA_UPDATES, fanout.updates);
+            metrics->set(Gauge::MARKET_DATA_FRAMES, fanout.frames_sent);
+            metrics->set(Gauge::MARKET_DATA_CONFLATED, fanout.conflated);
+            metrics->set(Gauge::MARKET_DATA_DROPPED, fanout.dropped);
+            metrics->set(Gauge::MARKET_DATA_SUBSCRIBERS, fanout.subscribers);
+            if (const MulticastFeed* feed = market_data_service->multicast_feed()) {
+                hft::MulticastStats multicast_stats = feed->stats();
+                metrics->set(Gauge::MULTICAST_PACKETS, multicast_stats.packets);
+                metrics->set(Gauge::MULTICAST_SEND_ERRORS, multicast_stats.send_errors);
+            }
+            hft::RiskStats risk = risk_engine->stats();
+            metrics->set(Gauge::RISK_CHECKED, risk.checked);
+            metrics->set(Gauge::RISK_REJECTED, risk.rejected());
+            if (journal) {
+                hft::JournalStats journal_stats = journal->stats();
+                metrics->set(Gauge::JOURNAL_RECORDS, journal_stats.records);
+                metrics->set(Gauge::JOURNAL_BYTES, journal_stats.bytes);
+                metrics->set(Gauge::JOURNAL_LOST, journal_stats.lost);
+            }
+            server.publish_metrics();
+        }
+        
         auto now = std::chrono::steady_clock::now();
         if (now - last_stats_time >= stats_interval) {
             auto stats = server.get_stats();
             
             std::cout << "\n=== Server Statistics ===" << std::endl;
             std::cout << "Total Messages: " << stats.total_messages_processed << std::endl;
-            std::cout << "Active Connections: " << stats.total_connections << std::endl;
+            std::cout << "Active Connections: " << stats.active_connections << " (" << stats.total_connections
+                      << " total)" << std::endl;
             std::cout << "Peak Connections: " << stats.peak_connections << std::endl;
-            std::cout << "Average Latency: " << std::fixed << std::setprecision(2) 
-                      << stats.avg_latency_us << " μs" << std::endl;
+            hft::print_counters(std::cout, stats.counters);
+            
+            hft::FanoutStats fanout = market_data_service->fanout_stats();
+            std::cout << "Market Data: " << fanout.updates << " updates -> " << fanout.frames_sent
+                      << " frames sent, " << fanout.conflated << " conflated, " << fanout.dropped
+                      << " dropped, " << fanout.subscribers << " subscribers" << std::endl;
+            if (const MulticastFeed* feed = market_data_service->multicast_feed()) {
+                hft::MulticastStats multicast_stats = feed->stats();
+                std::cout << "Multicast: " << multicast_stats.updates << " updates in " << multicast_stats.packets
+                          << " datagrams, " << multicast_stats.send_errors << " send errors, "
+                          << multicast_stats.retransmit_requests << " retransmits, "
+                          << multicast_stats.snapshot_requests << " snapshots" << std::endl;
+            }
+            hft::RiskStats risk = risk_engine->stats();
+            std::cout << "Risk: " << risk.checked << " checked, " << risk.rejected() << " rejected ("
+                      << risk.rejected_quantity << " size, " << risk.rejected_notional << " notional, "
+                      << risk.rejected_price << " price, " << risk.rejected_position << " position, "
+                      << risk.rejected_throttle << " throttle)" << std::endl;
+            if (journal) {
+                hft::JournalStats journal_stats = journal->stats();
+                std::cout << "Journal: " << journal_stats.records << " records, " << journal_stats.bytes
+                          << " bytes in " << journal_stats.segments << " segments, " << journal_stats.syncs
+                          << " syncs, " << journal_stats.lost << " lost" << std::endl;
+            }
+            hft::print_latency_summaries(std::cout, "Latency, last interval", stats.latency.interval);
+            hft::print_latency_summaries(std::cout, "Latency, since start", stats.latency.cumulative);
             
-            // Check if we're meeting latency requirements
-            if (stats.avg_latency_us < 20.0) {
-                std::cout << "✓ Latency target met (< 20μs)" << std::endl;
+            // Check the tail against the latency requirement, not the mean
+            const hft::LatencySummary& dispatch =
+                stats.latency.interval[static_cast<size_t>(hft::LatencyStage::DISPATCH)];
+            if (dispatch.count == 0) {
+                std::cout << "No messages this interval" << std::endl;
+            } else if (dispatch.p99_ns < 20000) {
+                std::cout << "✓ Latency target met (p99 < 20μs)" << std::endl;
             } else {
-                std::cout << "⚠ Latency target exceeded: " << stats.avg_latency_us << "μs" << std::endl;
+                std::cout << "⚠ Latency target exceeded: p99 " << std::fixed << std::setprecision(2)
+                          << dispatch.p99_ns / 1000.0 << "μs" << std::endl;
             }
             std::cout << "========================" << std::endl;
             
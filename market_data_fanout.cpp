@@ -0,0 +1,408 @@
+#include "market_data_fanout.h"
+#include "tsc_clock.h"
+#include <algorithm>
+
+namespace hft {
+
+namespace {
+
+uint32_t clamp_subscribers(uint32_t requested) {
+    return std::min(std::max(requested, 1u), MarketDataFanout::MAX_SUBSCRIBERS);
+}
+
+// Room for every symbol's latest frame, plus one per subscriber,
+// plus several queue depths of recent updates shared by subscribers that
+// keep up. Beyond that publish() drops and counts.
+uint32_t frame_capacity(const FanoutConfig& config) {
+    return config.max_symbols * 2 + clamp_subscribers(config.max_subscribers) + config.max_queue * 8;
+}
+
+} // namespace
+
+MarketDataFanout::MarketDataFanout(const FanoutConfig& config)
+    : config_(config),
+      subscribers_(clamp_subscribers(config.max_subscribers)),
+      frames_(frame_capacity(config)),
+      flushers_(new Flusher[std::max(config.flushers, 1u)]),
+      symbols_(new SymbolEntry[config.max_symbols]) {
+    config_.flushers = std::max(config_.flushers, 1u);
+    config_.max_batch = std::min(std::max(config_.max_batch, 1u), MAX_BATCH);
+    config_.max_queue = std::max(config_.max_queue, 1u);
+}
+
+MarketDataFanout::~MarketDataFanout() {
+    // Return every queued frame so nothing outlives its table
+    subscribers_.for_each([this](SubscriberId, Subscriber& subscriber) {
+        clear_queue(subscriber);
+    });
+}
+
+MarketDataFanout::SubscriberId MarketDataFanout::add_subscriber(uint64_t target, uint32_t flusher) {
+    SubscriberId id;
+    Subscriber* subscriber = subscribers_.acquire(id);
+    if (!subscriber) {
+        return INVALID_SUBSCRIBER;
+    }
+    
+    // Slot objects are reused; scheduled is left alone because the object
+    // may still sit on a flusher ring from its previous occupant
+    std::lock_guard<std::mutex> lock(subscriber->lock);
+    subscriber->id = id;
+    subscriber->target = target;
+    subscriber->flusher = flusher % config_.flushers;
+    subscriber->broken = false;
+    subscriber->backlogged = false;
+    subscriber->slots.clear();
+    subscriber->free_slots.clear();
+    subscriber->slot_of_symbol.clear();
+    subscriber->queue.clear();
+    subscriber->queue_head = 0;
+    subscriber->queue_base = 0;
+    return id;
+}
+
+void MarketDataFanout::remove_subscriber(SubscriberId id) {
+    Subscriber* subscriber = subscribers_.find(id);
+    if (!subscriber) {
+        return;
+    }
+    
+    // Retire the subscriber first, then unlink it from its symbols; symbol
+    // locks are never taken while holding a subscriber lock
+    std::vector<uint32_t> symbols;
+    {
+        std::lock_guard<std::mutex> lock(subscriber->lock);
+        if (subscriber->id != id) {
+            return;
+        }
+        subscriber->id = INVALID_SUBSCRIBER;
+        for (const Slot& slot : subscriber->slots) {
+            if (slot.symbol != NO_INSTRUMENT) {
+                symbols.push_back(slot.symbol);
+            }
+        }
+        clear_queue(*subscriber);
+    }
+    
+    for (uint32_t symbol : symbols) {
+        SymbolEntry& entry = symbols_[symbol];
+        std::lock_guard<std::mutex> lock(entry.lock);
+        auto& list = entry.subscribers;
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [id](const SubscriberRef& ref) { return ref.id == id; }),
+                   list.end());
+    }
+    
+    subscribers_.release(id);
+}
+
+bool MarketDataFanout::subscribe(SubscriberId id, InstrumentId instrument) {
+    Subscriber* subscriber = subscribers_.find(id);
+    if (!subscriber || instrument >= config_.max_symbols) {
+        return false;
+    }
+    
+    uint32_t slot_index;
+    {
+        std::lock_guard<std::mutex> lock(subscriber->lock);
+        if (subscriber->id != id) {
+            return false;
+        }
+        if (subscriber->slot_of_symbol.count(instrument)) {
+            return true; // Already subscribed
+        }
+        
+        if (!subscriber->free_slots.empty()) {
+            slot_index = subscriber->free_slots.back();
+            subscriber->free_slots.pop_back();
+        } else {
+            slot_index = static_cast<uint32_t>(subscriber->slots.size());
+            subscriber->slots.emplace_back();
+        }
+        subscriber->slots[slot_index].symbol = instrument;
+        subscriber->slot_of_symbol[instrument] = slot_index;
+    }
+    
+    // A removal racing with this leaves a stale ref, pruned by publish()
+    SymbolEntry& entry = symbols_[instrument];
+    std::lock_guard<std::mutex> lock(entry.lock);
+    entry.subscribers.push_back(SubscriberRef{id, slot_index});
+    return true;
+}
+
+bool MarketDataFanout::unsubscribe(SubscriberId id, InstrumentId instrument) {
+    Subscriber* subscriber = subscribers_.find(id);
+    if (!subscriber || instrument >= config_.max_symbols) {
+        return false;
+    }
+    
+    uint32_t slot_index;
+    {
+        std::lock_guard<std::mutex> lock(subscriber->lock);
+        auto it = subscriber->slot_of_symbol.find(instrument);
+        if (subscriber->id != id || it == subscriber->slot_of_symbol.end()) {
+            return false;
+        }
+        slot_index = it->second;
+        subscriber->slot_of_symbol.erase(it);
+        
+        // Drop its queued frames so the slot can be reused for another symbol
+        for (size_t i = subscriber->queue_head; i < subscriber->queue.size(); ++i) {
+            QueuedFrame& queued = subscriber->queue[i];
+            if (queued.slot == slot_index && queued.frame) {
+                release(queued.frame);
+                queued.frame = nullptr;
+            }
+        }
+        Slot& slot = subscriber->slots[slot_index];
+        slot.symbol = NO_INSTRUMENT;
+        slot.latest = NOT_QUEUED;
+        subscriber->free_slots.push_back(slot_index);
+    }
+    
+    SymbolEntry& entry = symbols_[instrument];
+    std::lock_guard<std::mutex> lock(entry.lock);
+    auto& list = entry.subscribers;
+    list.erase(std::remove_if(list.begin(), list.end(), [id, slot_index](const SubscriberRef& ref) {
+                   return ref.id == id && ref.slot == slot_index;
+               }),
+               list.end());
+    return true;
+}
+
+size_t MarketDataFanout::publish(InstrumentId instrument, const wire::MarketDataBody& body,
+                                 uint64_t message_id) {
+    if (instrument >= config_.max_symbols) {
+        return 0;
+    }
+    
+    SymbolEntry& entry = symbols_[instrument];
+    std::lock_guard<std::mutex> symbol_lock(entry.lock);
+    ++entry.sequence;
+    if (entry.subscribers.empty()) {
+        return 0;
+    }
+    
+    uint64_t handle;
+    MarketDataFrame* frame = frames_.acquire(handle);
+    if (!frame) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    
+    // Encoded once; every queue below shares these bytes
+    frame->handle = handle;
+    frame->length = static_cast<uint32_t>(wire::write_frame(
+        frame->bytes, MessageType::MARKET_DATA, message_id, TscClock::instance().wall_ns(),
+        entry.sequence, &body));
+    frame->refs.store(1, std::memory_order_relaxed); // Held until the fan-out loop ends
+    
+    size_t queued = 0;
+    size_t conflated = 0;
+    auto& list = entry.subscribers;
+    for (size_t i = 0; i < list.size();) {
+        SubscriberRef ref = list[i];
+        Subscriber* subscriber = subscribers_.find(ref.id);
+        bool live = false;
+        bool enqueued = false;
+        
+        if (subscriber) {
+            std::lock_guard<std::mutex> lock(subscriber->lock);
+            live = subscriber->id == ref.id;
+            Slot* slot = live && ref.slot < subscriber->slots.size() ? &subscriber->slots[ref.slot] : nullptr;
+            if (slot && !subscriber->broken && slot->symbol == instrument) {
+                frame->refs.fetch_add(1, std::memory_order_relaxed);
+                size_t depth = subscriber->queue.size() - subscriber->queue_head;
+                if (slot->latest != NOT_QUEUED && (subscriber->backlogged || depth >= config_.max_queue)) {
+                    // Behind: the newer state replaces the unwritten one in place
+                    QueuedFrame& queued = subscriber->queue[slot->latest - subscriber->queue_base];
+                    release(queued.frame);
+                    queued.frame = frame;
+                    ++conflated;
+                } else {
+                    slot->latest = subscriber->queue_base + subscriber->queue.size();
+                    subscriber->queue.push_back(QueuedFrame{ref.slot, frame});
+                }
+                enqueued = true;
+            }
+        }
+        
+        if (!live) {
+            // Left behind by a removal that raced with subscribe()
+            list[i] = list.back();
+            list.pop_back();
+            continue;
+        }
+        if (enqueued) {
+            schedule(*subscriber);
+            ++queued;
+        }
+        ++i;
+    }
+    
+    release(frame);
+    
+    if (queued > 0) {
+        updates_.fetch_add(1, std::memory_order_relaxed);
+        frames_queued_.fetch_add(queued, std::memory_order_relaxed);
+    }
+    if (conflated > 0) {
+        conflated_.fetch_add(conflated, std::memory_order_relaxed);
+    }
+    return queued;
+}
+
+void MarketDataFanout::schedule(Subscriber& subscriber) {
+    // Only the thread that flips the flag pushes, so capacity suffices
+    if (!subscriber.scheduled.exchange(true, std::memory_order_acq_rel)) {
+        flushers_[subscriber.flusher].ring.push(&subscriber);
+    }
+}
+
+size_t MarketDataFanout::flush(uint32_t flusher_index, FanoutSink& sink) {
+    Flusher& flusher = flushers_[flusher_index % config_.flushers];
+    if (flusher.busy.exchange(true, std::memory_order_acquire)) {
+        return 0;
+    }
+    
+    size_t frames = 0;
+    size_t bytes = 0;
+    size_t budget = flusher.ring.size();
+    
+    flusher.ring.consume_bulk([&](Subscriber* subscriber) {
+        if (subscriber->flusher != flusher_index % config_.flushers) {
+            // Slot reused by a subscriber on another flusher while queued here
+            flushers_[subscriber->flusher].ring.push(subscriber);
+            return;
+        }
+        if (flush_subscriber(*subscriber, sink, frames, bytes)) {
+            flusher.retry.push_back(subscriber);
+        }
+    }, budget);
+    
+    // Still backed up (connection full or more than one batch): try next pass
+    for (Subscriber* subscriber : flusher.retry) {
+        schedule(*subscriber);
+    }
+    flusher.retry.clear();
+    
+    flusher.busy.store(false, std::memory_order_release);
+    
+    if (frames > 0) {
+        frames_sent_.fetch_add(frames, std::memory_order_relaxed);
+        bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    return frames;
+}
+
+bool MarketDataFanout::flush_subscriber(Subscriber& subscriber, FanoutSink& sink, size_t& frames, size_t& bytes) {
+    std::lock_guard<std::mutex> lock(subscriber.lock);
+    
+    // Cleared before delivering: a publish from here on reschedules it
+    subscriber.scheduled.store(false, std::memory_order_release);
+    if (subscriber.id == INVALID_SUBSCRIBER || subscriber.broken) {
+        return false;
+    }
+    
+    // Gather queued frames, oldest first
+    struct iovec iov[MAX_BATCH];
+    uint32_t count = 0;
+    for (size_t i = subscriber.queue_head; i < subscriber.queue.size() && count < config_.max_batch; ++i) {
+        MarketDataFrame* frame = subscriber.queue[i].frame;
+        if (frame) {
+            iov[count].iov_base = frame->bytes;
+            iov[count].iov_len = frame->length;
+            ++count;
+        }
+    }
+    if (count == 0) {
+        reset_queue(subscriber);
+        return false;
+    }
+    
+    int taken = sink.deliver(subscriber.target, iov, static_cast<int>(count));
+    if (taken < 0) {
+        // The connection is going away; its owner will remove the subscriber
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        subscriber.broken = true;
+        clear_queue(subscriber);
+        return false;
+    }
+    if (static_cast<uint32_t>(taken) < count) {
+        subscriber.backlogged = true;
+    }
+    
+    // Frames leave the queue whole, so nothing is ever cut mid-frame
+    for (int delivered = 0; delivered < taken && subscriber.queue_head < subscriber.queue.size();) {
+        uint64_t position = subscriber.queue_base + subscriber.queue_head;
+        QueuedFrame& queued = subscriber.queue[subscriber.queue_head++];
+        MarketDataFrame* frame = queued.frame;
+        if (!frame) {
+            continue;
+        }
+        queued.frame = nullptr;
+        Slot& slot = subscriber.slots[queued.slot];
+        if (slot.latest == position) {
+            slot.latest = NOT_QUEUED;
+        }
+        bytes += frame->length;
+        release(frame);
+        ++delivered;
+        ++frames;
+    }
+    
+    // Skip entries emptied by conflation or unsubscribe, then compact
+    while (subscriber.queue_head < subscriber.queue.size() && !subscriber.queue[subscriber.queue_head].frame) {
+        ++subscriber.queue_head;
+    }
+    if (subscriber.queue_head == subscriber.queue.size()) {
+        reset_queue(subscriber);
+        subscriber.backlogged = false; // Caught up
+    } else if (subscriber.queue_head > subscriber.queue.size() / 2) {
+        subscriber.queue.erase(subscriber.queue.begin(), subscriber.queue.begin() + subscriber.queue_head);
+        subscriber.queue_base += subscriber.queue_head;
+        subscriber.queue_head = 0;
+    }
+    
+    return subscriber.queue_head < subscriber.queue.size();
+}
+
+void MarketDataFanout::reset_queue(Subscriber& subscriber) {
+    // Only called with nothing left queued; positions stay monotonic
+    subscriber.queue_base += subscriber.queue.size();
+    subscriber.queue.clear();
+    subscriber.queue_head = 0;
+}
+
+void MarketDataFanout::clear_queue(Subscriber& subscriber) {
+    for (size_t i = subscriber.queue_head; i < subscriber.queue.size(); ++i) {
+        if (subscriber.queue[i].frame) {
+            release(subscriber.queue[i].frame);
+        }
+    }
+    for (Slot& slot : subscriber.slots) {
+        slot.latest = NOT_QUEUED;
+    }
+    reset_queue(subscriber);
+    subscriber.backlogged = false;
+}
+
+void MarketDataFanout::release(MarketDataFrame* frame) {
+    if (frame->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        frames_.release(frame->handle);
+    }
+}
+
+FanoutStats MarketDataFanout::stats() const {
+    FanoutStats stats;
+    stats.updates = updates_.load(std::memory_order_relaxed);
+    stats.frames_queued = frames_queued_.load(std::memory_order_relaxed);
+    stats.frames_sent = frames_sent_.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    stats.conflated = conflated_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.subscribers = subscribers_.size();
+    return stats;
+}
+
+} // namespace hft
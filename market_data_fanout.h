@@ -0,0 +1,219 @@
+#ifndef MARKET_DATA_FANOUT_H
+#define MARKET_DATA_FANOUT_H
+
+#include "wire_protocol.h"
+#include "connection_table.h"
+#include "lock_free_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/uio.h>
+
+namespace hft {
+
+/**
+ * @brief Sizing for a MarketDataFanout
+ */
+struct FanoutConfig {
+    uint32_t max_subscribers = 4096;   // Connections with a subscription, at most MAX_SUBSCRIBERS
+    uint32_t max_symbols = 8192;       // Instrument ids run from 0 to max_symbols - 1
+    uint32_t flushers = 1;             // Threads draining subscriber queues
+    uint32_t max_batch = 64;           // Frames per FanoutSink::deliver(), at most MAX_BATCH
+    uint32_t max_queue = 1024;         // Frames queued per subscriber before updates conflate
+};
+
+/**
+ * @brief Fan-out counters since start
+ */
+struct FanoutStats {
+    uint64_t updates = 0;              // publish() calls that reached a subscriber
+    uint64_t frames_queued = 0;        // Subscriber queue entries created
+    uint64_t frames_sent = 0;          // Frames handed to a connection's send path
+    uint64_t bytes_sent = 0;
+    uint64_t conflated = 0;            // Queued frames replaced by a newer update
+    uint64_t dropped = 0;              // Updates lost to frame exhaustion or broken sockets
+    uint64_t subscribers = 0;          // Currently registered
+};
+
+/**
+ * @brief One encoded MARKET_DATA frame shared by every queue that holds it
+ *
+ * Released back to the fan-out's frame table when the last reference goes.
+ */
+struct MarketDataFrame {
+    std::atomic<uint32_t> refs{0};
+    uint32_t length = 0;
+    uint64_t handle = 0;               // Frame table handle
+    uint8_t bytes[wire::HEADER_SIZE + sizeof(wire::MarketDataBody)];
+};
+
+/**
+ * @brief A connection's send path, as seen by the fan-out
+ *
+ * The fan-out never writes to a socket itself. Frames go through the same
+ * queue as the connection's other responses, so a partial write on one
+ * path can never be interleaved with a frame from the other.
+ */
+class FanoutSink {
+public:
+    virtual ~FanoutSink() = default;
+    
+    /**
+     * @brief Queue whole frames for target; returns how many were taken, or -1 once it is gone
+     *
+     * Taking fewer than count means the connection is backed up; the rest
+     * are offered again on a later flush.
+     */
+    virtual int deliver(uint64_t target, const struct iovec* frames, int count) = 0;
+};
+
+/**
+ * @brief Per-symbol market data distribution to subscribed connections
+ *
+ * publish() encodes an update once into a refcounted MarketDataFrame and
+ * hands a reference to every subscriber of the symbol; nothing is copied
+ * per subscriber. A subscriber that keeps up receives every update in
+ * order. Once its connection pushes back (the sink takes fewer frames than
+ * offered) or its queue reaches max_queue, a newer update replaces the symbol's frame
+ * still waiting in the queue (conflation), so a slow consumer gets the
+ * latest state of every symbol instead of an ever-growing backlog. Each
+ * frame's header sequence counts updates of its symbol, so receivers can
+ * see how many were conflated away.
+ *
+ * Subscribers belong to one flusher. flush() drains that flusher's
+ * subscribers into a FanoutSink, up to max_batch whole frames each, and
+ * the sink queues them behind the connection's responses. A subscriber is
+ * locked while the sink runs, so remove_subscriber() waits for a delivery
+ * in progress.
+ *
+ * Symbols are known by instrument id and their subscriber lists sit in an
+ * array indexed by it. All operations are thread-safe. Publishing locks
+ * the symbol's subscriber list and each subscriber briefly.
+ */
+class MarketDataFanout {
+public:
+    using SubscriberId = uint64_t;
+    static constexpr SubscriberId INVALID_SUBSCRIBER = 0;
+    static constexpr uint32_t MAX_SUBSCRIBERS = 16384;
+    static constexpr uint32_t MAX_BATCH = 64;
+    
+    explicit MarketDataFanout(const FanoutConfig& config = FanoutConfig{});
+    ~MarketDataFanout();
+    
+    MarketDataFanout(const MarketDataFanout&) = delete;
+    MarketDataFanout& operator=(const MarketDataFanout&) = delete;
+    
+    /**
+     * @brief Register a connection, as the sink knows it; INVALID_SUBSCRIBER when the table is full
+     */
+    SubscriberId add_subscriber(uint64_t target, uint32_t flusher);
+    
+    /**
+     * @brief Drop a subscriber and everything queued for it; call before its target goes away
+     */
+    void remove_subscriber(SubscriberId id);
+    
+    bool subscribe(SubscriberId id, InstrumentId instrument);
+    bool unsubscribe(SubscriberId id, InstrumentId instrument);
+    
+    /**
+     * @brief Queue an update for every subscriber of the instrument
+     *
+     * body is already in wire byte order. Returns the number of subscribers
+     * it was queued for.
+     */
+    size_t publish(InstrumentId instrument, const wire::MarketDataBody& body, uint64_t message_id);
+    
+    /**
+     * @brief Hand queued frames for the flusher's subscribers to sink
+     *
+     * Returns the number of frames delivered. A concurrent call for the
+     * same flusher returns 0 immediately rather than waiting.
+     */
+    size_t flush(uint32_t flusher, FanoutSink& sink);
+    
+    FanoutStats stats() const;
+
+private:
+    static constexpr uint64_t NOT_QUEUED = UINT64_MAX;
+    
+    // A subscriber's entry for one symbol
+    struct Slot {
+        InstrumentId symbol = NO_INSTRUMENT;
+        uint64_t latest = NOT_QUEUED;  // Queue position of its newest frame: the conflation point
+    };
+    
+    struct QueuedFrame {
+        uint32_t slot;
+        MarketDataFrame* frame;        // nullptr once delivered, conflated or unsubscribed
+    };
+    
+    struct Subscriber {
+        std::mutex lock;
+        SubscriberId id = INVALID_SUBSCRIBER;  // Current occupant; cleared on removal
+        uint64_t target = 0;                   // Passed to FanoutSink::deliver()
+        uint32_t flusher = 0;
+        bool broken = false;                   // Connection gone; stop queueing
+        bool backlogged = false;               // Connection pushed back; conflate until drained
+        std::atomic<bool> scheduled{false};    // Queued on a flusher ring
+        
+        std::vector<Slot> slots;
+        std::vector<uint32_t> free_slots;
+        std::unordered_map<uint32_t, uint32_t> slot_of_symbol;
+        
+        // Frames to write, oldest first. Positions are absolute:
+        // queue[i] sits at queue_base + i
+        std::vector<QueuedFrame> queue;
+        size_t queue_head = 0;
+        uint64_t queue_base = 0;
+    };
+    
+    struct SubscriberRef {
+        SubscriberId id;
+        uint32_t slot;
+    };
+    
+    struct SymbolEntry {
+        std::mutex lock;
+        uint32_t sequence = 0;                 // Updates published for the symbol
+        std::vector<SubscriberRef> subscribers;
+    };
+    
+    // Every live subscriber is on at most one ring at a time, so a ring
+    // never has to hold more than MAX_SUBSCRIBERS entries
+    using ScheduleRing = ultra_hft::MPSCRingBuffer<Subscriber*, MAX_SUBSCRIBERS>;
+    
+    struct alignas(CACHE_LINE_SIZE) Flusher {
+        ScheduleRing ring;
+        std::atomic<bool> busy{false};
+        std::vector<Subscriber*> retry;        // Owner of busy only
+    };
+    
+    void schedule(Subscriber& subscriber);
+    bool flush_subscriber(Subscriber& subscriber, FanoutSink& sink, size_t& frames, size_t& bytes);
+    void reset_queue(Subscriber& subscriber);
+    void clear_queue(Subscriber& subscriber);
+    void release(MarketDataFrame* frame);
+    
+    FanoutConfig config_;
+    ConnectionTable<Subscriber> subscribers_;
+    ConnectionTable<MarketDataFrame> frames_;
+    std::unique_ptr<Flusher[]> flushers_;
+    
+    std::unique_ptr<SymbolEntry[]> symbols_;   // By instrument id
+    
+    std::atomic<uint64_t> updates_{0};
+    std::atomic<uint64_t> frames_queued_{0};
+    std::atomic<uint64_t> frames_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> conflated_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace hft
+
+#endif // MARKET_DATA_FANOUT_H
@@ -0,0 +1,183 @@
+#ifndef MARKET_STATE_H
+#define MARKET_STATE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "message.h"
+#include "object_pool.h"
+
+namespace hft {
+
+/**
+ * @brief One instrument's top of book and trading summary, as last published
+ *
+ * Prices are in ticks; zero means no value yet. updates counts the market
+ * data messages applied, so it matches the per-symbol fan-out sequence.
+ */
+struct TopOfBook {
+    uint64_t bid_price = 0;
+    uint64_t ask_price = 0;
+    uint64_t last_price = 0;
+    uint64_t volume = 0;
+    uint64_t high_price = 0;
+    uint64_t low_price = 0;
+    uint32_t bid_size = 0;
+    uint32_t ask_size = 0;
+    uint32_t last_size = 0;
+    uint32_t updates = 0;
+
+    /**
+     * @brief Last trade, or the mid before the first one; zero if neither is known
+     */
+    uint64_t reference_price() const {
+        if (last_price != 0) {
+            return last_price;
+        }
+        return bid_price != 0 && ask_price != 0 ? (bid_price + ask_price) / 2 : 0;
+    }
+};
+
+/**
+ * @brief Latest top of book per instrument, read without locks
+ *
+ * One cache line per instrument, indexed by instrument id, guarded by a
+ * sequence lock: the writer makes the sequence odd, stores the fields and
+ * makes it even again; a reader copies the fields between two loads of the
+ * sequence and retries if it changed or was odd. Readers never write the
+ * line, so any number of them (risk checks, strategy threads, snapshot
+ * replies) share it without invalidating each other or the writer.
+ *
+ * Updates to one instrument are expected from one thread at a time. Should
+ * two collide, the second claims the odd sequence with a compare-exchange
+ * and waits for the first, so the line is never torn either way.
+ *
+ * A quote without a trade (zero last price) keeps the previous last trade.
+ * High and low come from the update when it carries them and otherwise
+ * track the last trade price.
+ */
+class MarketStateCache {
+public:
+    explicit MarketStateCache(uint32_t capacity)
+        : capacity_(std::max<uint32_t>(capacity, 1)),
+          slots_(new Slot[capacity_]) {}
+
+    MarketStateCache(const MarketStateCache&) = delete;
+    MarketStateCache& operator=(const MarketStateCache&) = delete;
+
+    /**
+     * @brief Apply a market data update; ids outside the capacity are ignored
+     */
+    void update(InstrumentId instrument, const TopOfBook& quote) noexcept {
+        if (instrument >= capacity_) {
+            return;
+        }
+        Slot& slot = slots_[instrument];
+
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        while ((sequence & 1) != 0 ||
+               !slot.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+            __builtin_ia32_pause();
+            sequence = slot.sequence.load(std::memory_order_relaxed);
+        }
+        // The odd sequence is visible before any field changes
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t last = quote.last_price;
+        uint32_t last_size = quote.last_size;
+        if (last == 0) {
+            last = slot.last_price.load(std::memory_order_relaxed);
+            last_size = slot.last_size.load(std::memory_order_relaxed);
+        }
+        uint64_t high = quote.high_price;
+        uint64_t low = quote.low_price;
+        if (high == 0) {
+            high = std::max(slot.high_price.load(std::memory_order_relaxed), last);
+        }
+        if (low == 0) {
+            uint64_t previous = slot.low_price.load(std::memory_order_relaxed);
+            low = previous == 0 ? last : (last == 0 ? previous : std::min(previous, last));
+        }
+
+        slot.bid_price.store(quote.bid_price, std::memory_order_relaxed);
+        slot.ask_price.store(quote.ask_price, std::memory_order_relaxed);
+        slot.last_price.store(last, std::memory_order_relaxed);
+        slot.volume.store(quote.volume, std::memory_order_relaxed);
+        slot.high_price.store(high, std::memory_order_relaxed);
+        slot.low_price.store(low, std::memory_order_relaxed);
+        slot.bid_size.store(quote.bid_size, std::memory_order_relaxed);
+        slot.ask_size.store(quote.ask_size, std::memory_order_relaxed);
+        slot.last_size.store(last_size, std::memory_order_relaxed);
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consistent copy of an instrument's state; false if it has none yet
+     */
+    bool read(InstrumentId instrument, TopOfBook& out) const noexcept {
+        if (instrument >= capacity_) {
+            return false;
+        }
+        const Slot& slot = slots_[instrument];
+
+        for (;;) {
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                __builtin_ia32_pause();
+                continue;
+            }
+            out.bid_price = slot.bid_price.load(std::memory_order_relaxed);
+            out.ask_price = slot.ask_price.load(std::memory_order_relaxed);
+            out.last_price = slot.last_price.load(std::memory_order_relaxed);
+            out.volume = slot.volume.load(std::memory_order_relaxed);
+            out.high_price = slot.high_price.load(std::memory_order_relaxed);
+            out.low_price = slot.low_price.load(std::memory_order_relaxed);
+            out.bid_size = slot.bid_size.load(std::memory_order_relaxed);
+            out.ask_size = slot.ask_size.load(std::memory_order_relaxed);
+            out.last_size = slot.last_size.load(std::memory_order_relaxed);
+
+            // The field loads complete before the sequence is checked again
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                out.updates = before / 2;
+                return before != 0;
+            }
+        }
+    }
+
+    /**
+     * @brief The instrument's TopOfBook::reference_price(); zero if unknown
+     */
+    uint64_t reference_price(InstrumentId instrument) const noexcept {
+        TopOfBook state;
+        return read(instrument, state) ? state.reference_price() : 0;
+    }
+
+    uint32_t capacity() const { return capacity_; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<uint32_t> sequence{0};     // Odd while an update is in progress
+        std::atomic<uint32_t> bid_size{0};
+        std::atomic<uint32_t> ask_size{0};
+        std::atomic<uint32_t> last_size{0};
+        std::atomic<uint64_t> bid_price{0};
+        std::atomic<uint64_t> ask_price{0};
+        std::atomic<uint64_t> last_price{0};
+        std::atomic<uint64_t> volume{0};
+        std::atomic<uint64_t> high_price{0};
+        std::atomic<uint64_t> low_price{0};
+    };
+    static_assert(sizeof(Slot) == CACHE_LINE_SIZE, "one instrument per cache line");
+
+    uint32_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+};
+
+} // namespace hft
+
+#endif // MARKET_STATE_H
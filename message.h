@@ -5,9 +5,16 @@
 #include <string>
 #include <chrono>
 #include <array>
+#include "tsc_clock.h"
 
 namespace hft {
 
+/**
+ * @brief Dense index of a symbol in the InstrumentDirectory
+ */
+using InstrumentId = uint32_t;
+constexpr InstrumentId NO_INSTRUMENT = UINT32_MAX;
+
 /**
  * @brief Message types for different trading operations
  */
@@ -21,9 +28,41 @@ enum class MessageType : uint8_t {
     HEARTBEAT = 0x07,
     LOGIN = 0x08,
     LOGOUT = 0x09,
+    ORDER_ACK = 0x0A,
+    MARKET_DATA_ACK = 0x0B,
+    MARKET_DATA_SUBSCRIBE = 0x0C,
+    MARKET_DATA_UNSUBSCRIBE = 0x0D,
+    FEED_RETRANSMIT_REQUEST = 0x0E,
+    FEED_SNAPSHOT_REQUEST = 0x0F,
+    FEED_UPDATE = 0x10,
+    RESEND_REQUEST = 0x11,
     ERROR = 0xFF
 };
 
+inline const char* message_type_name(MessageType type) {
+    switch (type) {
+        case MessageType::ORDER_NEW: return "ORDER_NEW";
+        case MessageType::ORDER_CANCEL: return "ORDER_CANCEL";
+        case MessageType::ORDER_REPLACE: return "ORDER_REPLACE";
+        case MessageType::ORDER_FILL: return "ORDER_FILL";
+        case MessageType::ORDER_REJECT: return "ORDER_REJECT";
+        case MessageType::MARKET_DATA: return "MARKET_DATA";
+        case MessageType::HEARTBEAT: return "HEARTBEAT";
+        case MessageType::LOGIN: return "LOGIN";
+        case MessageType::LOGOUT: return "LOGOUT";
+        case MessageType::ORDER_ACK: return "ORDER_ACK";
+        case MessageType::MARKET_DATA_ACK: return "MARKET_DATA_ACK";
+        case MessageType::MARKET_DATA_SUBSCRIBE: return "MARKET_DATA_SUBSCRIBE";
+        case MessageType::MARKET_DATA_UNSUBSCRIBE: return "MARKET_DATA_UNSUBSCRIBE";
+        case MessageType::FEED_RETRANSMIT_REQUEST: return "FEED_RETRANSMIT_REQUEST";
+        case MessageType::FEED_SNAPSHOT_REQUEST: return "FEED_SNAPSHOT_REQUEST";
+        case MessageType::FEED_UPDATE: return "FEED_UPDATE";
+        case MessageType::RESEND_REQUEST: return "RESEND_REQUEST";
+        case MessageType::ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
 /**
  * @brief Order side (buy/sell)
  */
@@ -75,16 +114,13 @@ struct Message {
     uint32_t source_id;            // Source system identifier
     uint32_t destination_id;       // Destination system identifier
     
-    // Payload size and data
-    uint32_t payload_size;         // Size of payload in bytes
-    std::array<uint8_t, 1024> payload; // Fixed-size payload buffer
+    // Type-specific fields live in the derived structs; on the wire each
+    // type is encoded to its own compact body (see wire_protocol.h)
     
     // Constructor
     Message() : message_id(0), timestamp(0), sequence_number(0), 
                 message_type(MessageType::HEARTBEAT), status(MessageStatus::PENDING),
-                source_id(0), destination_id(0), payload_size(0) {
-        payload.fill(0);
-    }
+                source_id(0), destination_id(0) {}
     
     // Copy constructor
     Message(const Message& other) = default;
@@ -96,12 +132,13 @@ struct Message {
     ~Message() = default;
     
     /**
-     * @brief Get current timestamp in nanoseconds
+     * @brief Get current wall-clock timestamp in nanoseconds since the epoch
+     *
+     * For timestamps that go on the wire; time intervals inside the process
+     * with TscClock::now_ns() instead.
      */
     static uint64_t get_current_timestamp() {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto duration = now.time_since_epoch();
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return TscClock::instance().wall_ns();
     }
     
     /**
@@ -115,7 +152,7 @@ struct Message {
      * @brief Check if message is valid
      */
     bool is_valid() const {
-        return message_id != 0 && timestamp != 0 && payload_size <= payload.size();
+        return message_id != 0 && timestamp != 0;
     }
     
     /**
@@ -129,8 +166,6 @@ struct Message {
         status = MessageStatus::PENDING;
         source_id = 0;
         destination_id = 0;
-        payload_size = 0;
-        payload.fill(0);
     }
 };
 
@@ -148,10 +183,11 @@ struct OrderMessage : public Message {
     uint32_t quantity;                 // Order quantity
     uint64_t price;                    // Order price (in ticks)
     uint64_t stop_price;               // Stop price for stop orders
+    InstrumentId instrument;           // Resolved from symbol by the server; not on the wire
     
     OrderMessage() : side(OrderSide::BUY), order_type(OrderType::LIMIT),
                     time_in_force(TimeInForce::DAY), order_id(0), client_order_id(0),
-                    quantity(0), price(0), stop_price(0) {
+                    quantity(0), price(0), stop_price(0), instrument(NO_INSTRUMENT) {
         message_type = MessageType::ORDER_NEW;
         symbol.fill('\0');
     }
@@ -172,14 +208,46 @@ struct MarketDataMessage : public Message {
     uint64_t volume;                  // Total volume
     uint64_t high_price;              // High price
     uint64_t low_price;                // Low price
+    InstrumentId instrument;          // Resolved from symbol by the server; not on the wire
     
     MarketDataMessage() : bid_price(0), bid_size(0), ask_price(0), ask_size(0),
-                          last_price(0), last_size(0), volume(0), high_price(0), low_price(0) {
+                          last_price(0), last_size(0), volume(0), high_price(0), low_price(0),
+                          instrument(NO_INSTRUMENT) {
         message_type = MessageType::MARKET_DATA;
         symbol.fill('\0');
     }
 };
 
+/**
+ * @brief Market data subscription request for one symbol
+ *
+ * message_type is MARKET_DATA_SUBSCRIBE or MARKET_DATA_UNSUBSCRIBE.
+ */
+struct SubscriptionMessage : public Message {
+    std::array<char, 16> symbol;      // Trading symbol
+    InstrumentId instrument;          // Resolved from symbol by the server; not on the wire
+    
+    SubscriptionMessage() : instrument(NO_INSTRUMENT) {
+        message_type = MessageType::MARKET_DATA_SUBSCRIBE;
+        symbol.fill('\0');
+    }
+};
+
+/**
+ * @brief Multicast feed recovery request
+ *
+ * FEED_RETRANSMIT_REQUEST: start is the first feed sequence to resend.
+ * FEED_SNAPSHOT_REQUEST: start is the symbol offset to page from (0 first).
+ */
+struct RecoveryRequestMessage : public Message {
+    uint64_t start;                   // Feed sequence or symbol offset
+    uint32_t count;                   // Updates wanted
+    
+    RecoveryRequestMessage() : start(0), count(0) {
+        message_type = MessageType::FEED_RETRANSMIT_REQUEST;
+    }
+};
+
 /**
  * @brief Fill message structure
  */
@@ -191,9 +259,11 @@ struct FillMessage : public Message {
     uint64_t fill_price;              // Price at which filled
     uint64_t commission;              // Commission amount
     std::array<char, 16> execution_venue; // Execution venue
+    OrderSide side;                   // Side of the filled order; not on the wire
+    InstrumentId instrument;          // Book the fill came from; not on the wire
     
     FillMessage() : order_id(0), fill_id(0), fill_quantity(0), 
-                    fill_price(0), commission(0) {
+                    fill_price(0), commission(0), side(OrderSide::BUY), instrument(NO_INSTRUMENT) {
         message_type = MessageType::ORDER_FILL;
         execution_venue.fill('\0');
     }
@@ -0,0 +1,288 @@
+#include "metrics_segment.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace hft {
+
+struct ExporterOptions {
+    std::string segment = "hft-ultra";
+    uint16_t listen_port = 0;          // 0 = print once to stdout and exit
+};
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void handle_signal(int) {
+    g_stop = 1;
+}
+
+void write_type(std::ostream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+double seconds(uint64_t ns) {
+    return static_cast<double>(ns) / 1e9;
+}
+
+void write_counters(std::ostream& out, const MetricsSegment& segment) {
+    CounterSnapshot counters;
+    CounterSet::sum(segment.counters(), segment.header().threads, counters);
+    for (size_t counter = 0; counter < COUNTER_COUNT; ++counter) {
+        std::string name = std::string("hft_") + counter_name(static_cast<Counter>(counter)) + "_total";
+        write_type(out, name.c_str(), "counter", "Server counter summed over all threads");
+        out << name << " " << counters.values[counter] << "\n";
+    }
+
+    write_type(out, "hft_messages_by_type_total", "counter", "Decoded messages by message type");
+    for (size_t type = 0; type < CounterBlock::MESSAGE_TYPES; ++type) {
+        if (counters.messages_by_type[type] == 0) {
+            continue;
+        }
+        out << "hft_messages_by_type_total{type=\"" << message_type_name(static_cast<MessageType>(type));
+        if (std::strcmp(message_type_name(static_cast<MessageType>(type)), "UNKNOWN") == 0) {
+            out << "_" << type;
+        }
+        out << "\"} " << counters.messages_by_type[type] << "\n";
+    }
+}
+
+void write_latency(std::ostream& out, const MetricsSegment& segment) {
+    static constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+    write_type(out, "hft_latency_seconds", "summary", "Latency by pipeline stage since server start");
+    const LatencyRecorder* recorders = segment.recorders();
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        // ~16 KB of buckets per stage; keep it off the stack
+        auto merged = std::make_unique<HistogramSnapshot>();
+        merged->clear();
+        for (uint32_t thread = 0; thread < segment.header().threads; ++thread) {
+            merged->add(recorders[thread].stages[stage]);
+        }
+        LatencySummary summary;
+        merged->summarize(summary);
+
+        const char* name = latency_stage_name(static_cast<LatencyStage>(stage));
+        for (double q : QUANTILES) {
+            out << "hft_latency_seconds{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << seconds(merged->value_at(q)) << "\n";
+        }
+        out << "hft_latency_seconds_sum{stage=\"" << name << "\"} "
+            << summary.mean_ns * static_cast<double>(summary.count) / 1e9 << "\n";
+        out << "hft_latency_seconds_count{stage=\"" << name << "\"} " << summary.count << "\n";
+    }
+}
+
+void write_gauges(std::ostream& out, const MetricsSegment& segment) {
+    for (size_t gauge = 0; gauge < GAUGE_COUNT; ++gauge) {
+        GaugeInfo info = gauge_info(static_cast<Gauge>(gauge));
+        std::string name = std::string("hft_") + info.name + (info.monotonic ? "_total" : "");
+        write_type(out, name.c_str(), info.monotonic ? "counter" : "gauge", "Sampled by the server's monitor thread");
+        out << name << " " << segment.get(static_cast<Gauge>(gauge)) << "\n";
+    }
+}
+
+void write_connections(std::ostream& out, const MetricsSegment& segment) {
+    const MetricsHeader& header = segment.header();
+    uint64_t slots = static_cast<uint64_t>(header.shards) * header.shard_connections;
+    if (slots == 0) {
+        return;
+    }
+
+    std::ostringstream messages_in, bytes_in, frames_out, bytes_out;
+    const ConnectionMetrics* connections = segment.connections();
+    for (uint64_t slot = 0; slot < slots; ++slot) {
+        const ConnectionMetrics& metrics = connections[slot];
+        uint64_t ref = metrics.connection.load(std::memory_order_acquire);
+        if (ref == 0) {
+            continue;
+        }
+        std::ostringstream labels;
+        labels << "{connection=\"" << ref << "\",client=\"" << metrics.client_id.load(std::memory_order_relaxed)
+               << "\",shard=\"" << slot / header.shard_connections << "\"} ";
+        messages_in << "hft_connection_messages_in_total" << labels.str()
+                    << metrics.messages_in.load(std::memory_order_relaxed) << "\n";
+        bytes_in << "hft_connection_bytes_in_total" << labels.str()
+                 << metrics.bytes_in.load(std::memory_order_relaxed) << "\n";
+
+        // Until the send side has stamped this connection its counts belong to the slot's last one
+        bool sending = metrics.out_connection.load(std::memory_order_acquire) == ref;
+        frames_out << "hft_connection_frames_out_total" << labels.str()
+                   << (sending ? metrics.frames_out.load(std::memory_order_relaxed) : 0) << "\n";
+        bytes_out << "hft_connection_bytes_out_total" << labels.str()
+                  << (sending ? metrics.bytes_out.load(std::memory_order_relaxed) : 0) << "\n";
+    }
+
+    write_type(out, "hft_connection_messages_in_total", "counter", "Messages decoded from an open connection");
+    out << messages_in.str();
+    write_type(out, "hft_connection_bytes_in_total", "counter", "Bytes received on an open connection");
+    out << bytes_in.str();
+    write_type(out, "hft_connection_frames_out_total", "counter", "Frames queued to an open connection");
+    out << frames_out.str();
+    write_type(out, "hft_connection_bytes_out_total", "counter", "Bytes written to an open connection");
+    out << bytes_out.str();
+}
+
+} // namespace
+
+/**
+ * @brief Prometheus text for the named segment; false if its server is not running
+ *
+ * A segment that cannot be mapped renders as hft_up 0 and nothing else.
+ * The segment is mapped afresh every time, so a restarted server (which
+ * replaces the object) is picked up without restarting the exporter.
+ */
+bool render_metrics(const std::string& name, std::string& text) {
+    std::ostringstream out;
+    out.precision(15);  // Whole-second timestamps need 10 digits before the point
+    std::unique_ptr<MetricsSegment> segment = MetricsSegment::open(name);
+    const MetricsHeader* header = segment ? &segment->header() : nullptr;
+    bool up = header && kill(static_cast<pid_t>(header->pid), 0) == 0;
+
+    write_type(out, "hft_up", "gauge", "Whether the server owning the segment is running");
+    out << "hft_up" << (header ? std::string("{server=\"") + header->server + "\"}" : std::string()) << " "
+        << (up ? 1 : 0) << "\n";
+    if (!header) {
+        text = out.str();
+        return false;
+    }
+
+    write_type(out, "hft_start_time_seconds", "gauge", "Wall clock time the server created the segment");
+    out << "hft_start_time_seconds " << seconds(header->started_ns) << "\n";
+    write_type(out, "hft_metrics_updated_seconds", "gauge", "Wall clock time of the last gauge sample");
+    out << "hft_metrics_updated_seconds " << seconds(header->updated_ns.load(std::memory_order_acquire)) << "\n";
+
+    write_counters(out, *segment);
+    write_latency(out, *segment);
+    write_gauges(out, *segment);
+    write_connections(out, *segment);
+    text = out.str();
+    return up;
+}
+
+/**
+ * @brief Serve GET /metrics on port until SIGINT or SIGTERM
+ */
+bool serve_metrics(const ExporterOptions& options) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(options.listen_port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        std::cerr << "Failed to listen on port " << options.listen_port << ": " << strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+    std::cout << "Serving /dev/shm/" << options.segment << " on http://0.0.0.0:" << options.listen_port
+              << "/metrics" << std::endl;
+
+    while (!g_stop) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno != EINTR) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            continue;
+        }
+        // Scrapers send a small GET; the request line is all that matters
+        char request[1024];
+        ssize_t length = recv(client, request, sizeof(request) - 1, 0);
+        request[length > 0 ? length : 0] = '\0';
+
+        std::string body;
+        const char* status = "200 OK";
+        if (strncmp(request, "GET /metrics", 12) == 0 || strncmp(request, "GET / ", 6) == 0) {
+            render_metrics(options.segment, body);
+        } else {
+            status = "404 Not Found";
+            body = "Try /metrics\n";
+        }
+        std::string response = std::string("HTTP/1.1 ") + status +
+                               "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        for (size_t sent = 0; sent < response.size();) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        close(client);
+    }
+    close(listener);
+    return true;
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --segment <name>         Metrics segment in /dev/shm (default: hft-ultra)" << std::endl;
+    std::cout << "  --listen <port>          Serve Prometheus text on /metrics (default: print once)" << std::endl;
+    std::cout << "  --help                   Show this help message" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[], ExporterOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--segment") == 0 && i + 1 < argc) {
+            options.segment = argv[++i];
+        } else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            int port = atoi(argv[++i]);
+            if (port <= 0 || port > 65535) {
+                std::cerr << "Invalid port: " << argv[i] << std::endl;
+                return false;
+            }
+            options.listen_port = static_cast<uint16_t>(port);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            exit(0);
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace hft
+
+int main(int argc, char* argv[]) {
+    hft::ExporterOptions options;
+    if (!hft::parse_arguments(argc, argv, options)) {
+        return 1;
+    }
+
+    if (options.listen_port == 0) {
+        std::string text;
+        bool up = hft::render_metrics(options.segment, text);
+        std::cout << text;
+        return up ? 0 : 1;
+    }
+
+    // No SA_RESTART, so a signal breaks the blocking accept
+    struct sigaction action{};
+    action.sa_handler = hft::handle_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    return hft::serve_metrics(options) ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#include "metrics_segment.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace hft {
+
+namespace {
+
+uint64_t align_up(uint64_t offset) {
+    return (offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+uint64_t wall_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+template<typename T>
+void construct(uint8_t* at, uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        new (at + i * sizeof(T)) T();
+    }
+}
+
+// shm_open wants exactly one leading slash
+std::string object_name(const std::string& name) {
+    return name.empty() || name.front() != '/' ? "/" + name : name;
+}
+
+} // namespace
+
+GaugeInfo gauge_info(Gauge gauge) {
+    switch (gauge) {
+        case Gauge::ACTIVE_CONNECTIONS: return {"connections_active", false};
+        case Gauge::PEAK_CONNECTIONS: return {"connections_peak", false};
+        case Gauge::TOTAL_CONNECTIONS: return {"connections_accepted", true};
+        case Gauge::INGRESS_DEPTH: return {"ingress_queue_depth", false};
+        case Gauge::EGRESS_DEPTH: return {"egress_queue_depth", false};
+        case Gauge::MARKET_DATA_UPDATES: return {"market_data_updates", true};
+        case Gauge::MARKET_DATA_FRAMES: return {"market_data_frames", true};
+        case Gauge::MARKET_DATA_CONFLATED: return {"market_data_conflated", true};
+        case Gauge::MARKET_DATA_DROPPED: return {"market_data_dropped", true};
+        case Gauge::MARKET_DATA_SUBSCRIBERS: return {"market_data_subscribers", false};
+        case Gauge::MULTICAST_PACKETS: return {"multicast_packets", true};
+        case Gauge::MULTICAST_SEND_ERRORS: return {"multicast_send_errors", true};
+        case Gauge::RISK_CHECKED: return {"risk_checked", true};
+        case Gauge::RISK_REJECTED: return {"risk_rejected", true};
+        case Gauge::JOURNAL_RECORDS: return {"journal_records", true};
+        case Gauge::JOURNAL_BYTES: return {"journal_bytes", true};
+        case Gauge::JOURNAL_LOST: return {"journal_lost", true};
+        default: return {"unknown", false};
+    }
+}
+
+std::unique_ptr<MetricsSegment> MetricsSegment::create(const std::string& name, const std::string& server,
+                                                       const MetricsLayout& layout) {
+    uint64_t connection_slots = static_cast<uint64_t>(layout.shards) * layout.shard_connections;
+    uint64_t counters_offset = align_up(sizeof(MetricsHeader));
+    uint64_t recorders_offset = align_up(counters_offset + layout.threads * sizeof(CounterBlock));
+    uint64_t gauges_offset = align_up(recorders_offset + layout.threads * sizeof(LatencyRecorder));
+    uint64_t connections_offset = align_up(gauges_offset + GAUGE_COUNT * sizeof(std::atomic<uint64_t>));
+    uint64_t size = connections_offset + connection_slots * sizeof(ConnectionMetrics);
+
+    // A segment left behind by a crashed server is replaced, not reused
+    std::string path = object_name(name);
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create metrics segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to size metrics segment " << path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map metrics segment " << path << ": " << strerror(errno) << std::endl;
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+
+    // The object starts zero-filled; construct every array in place
+    auto* bytes = static_cast<uint8_t*>(base);
+    auto* header = new (bytes) MetricsHeader{};
+    construct<CounterBlock>(bytes + counters_offset, layout.threads);
+    construct<LatencyRecorder>(bytes + recorders_offset, layout.threads);
+    construct<std::atomic<uint64_t>>(bytes + gauges_offset, GAUGE_COUNT);
+    construct<ConnectionMetrics>(bytes + connections_offset, connection_slots);
+
+    header->version = MetricsHeader::VERSION;
+    header->counter_block_size = sizeof(CounterBlock);
+    header->recorder_size = sizeof(LatencyRecorder);
+    header->connection_size = sizeof(ConnectionMetrics);
+    header->gauge_count = GAUGE_COUNT;
+    header->threads = layout.threads;
+    header->shards = layout.shards;
+    header->shard_connections = layout.shard_connections;
+    header->pid = getpid();
+    header->started_ns = wall_clock_ns();
+    header->counters_offset = counters_offset;
+    header->recorders_offset = recorders_offset;
+    header->gauges_offset = gauges_offset;
+    header->connections_offset = connections_offset;
+    header->size = size;
+    strncpy(header->server, server.c_str(), sizeof(header->server) - 1);
+    header->updated_ns.store(0, std::memory_order_relaxed);
+    header->magic.store(MetricsHeader::MAGIC, std::memory_order_release);
+
+    return std::unique_ptr<MetricsSegment>(new MetricsSegment(path, bytes, size, true));
+}
+
+std::unique_ptr<MetricsSegment> MetricsSegment::open(const std::string& name) {
+    std::string path = object_name(name);
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to open metrics segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MetricsHeader)) {
+        std::cerr << "Metrics segment " << path << " is too small" << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map metrics segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<MetricsSegment> segment(new MetricsSegment(path, static_cast<uint8_t*>(base), size, false));
+    const MetricsHeader& header = segment->header();
+    if (header.magic.load(std::memory_order_acquire) != MetricsHeader::MAGIC ||
+        header.version != MetricsHeader::VERSION || header.size != size ||
+        header.counter_block_size != sizeof(CounterBlock) || header.recorder_size != sizeof(LatencyRecorder) ||
+        header.connection_size != sizeof(ConnectionMetrics) || header.gauge_count != GAUGE_COUNT) {
+        std::cerr << "Metrics segment " << path << " is not ready or was written by a different build" << std::endl;
+        return nullptr;
+    }
+    return segment;
+}
+
+MetricsSegment::~MetricsSegment() {
+    munmap(base_, size_);
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+void MetricsSegment::mark_updated() {
+    reinterpret_cast<MetricsHeader*>(base_)->updated_ns.store(wall_clock_ns(), std::memory_order_release);
+}
+
+} // namespace hft
@@ -0,0 +1,209 @@
+#ifndef METRICS_SEGMENT_H
+#define METRICS_SEGMENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "latency_histogram.h"
+#include "object_pool.h"
+#include "server_counters.h"
+
+namespace hft {
+
+/**
+ * @brief Values a monitor thread samples into the segment; never written by workers
+ */
+enum class Gauge : uint8_t {
+    ACTIVE_CONNECTIONS = 0,
+    PEAK_CONNECTIONS,
+    TOTAL_CONNECTIONS,
+    INGRESS_DEPTH,          // Events waiting in the ultra server's ingress rings
+    EGRESS_DEPTH,           // Events waiting in its egress rings
+    MARKET_DATA_UPDATES,
+    MARKET_DATA_FRAMES,
+    MARKET_DATA_CONFLATED,
+    MARKET_DATA_DROPPED,
+    MARKET_DATA_SUBSCRIBERS,
+    MULTICAST_PACKETS,
+    MULTICAST_SEND_ERRORS,
+    RISK_CHECKED,
+    RISK_REJECTED,
+    JOURNAL_RECORDS,
+    JOURNAL_BYTES,
+    JOURNAL_LOST,
+    COUNT
+};
+
+constexpr size_t GAUGE_COUNT = static_cast<size_t>(Gauge::COUNT);
+
+/**
+ * @brief Exported name of a gauge, and whether it only ever grows
+ */
+struct GaugeInfo {
+    const char* name;
+    bool monotonic;
+};
+
+GaugeInfo gauge_info(Gauge gauge);
+
+/**
+ * @brief One connection's traffic, indexed by shard and table slot
+ *
+ * The I/O worker handling the connection owns the first line and the send
+ * thread owns the second, so neither shares a written line with the other.
+ * Each side stamps the connection ref it is counting for; a reader shows
+ * the send side's counts only once the two agree, which hides counts left
+ * over from the slot's previous connection.
+ */
+struct alignas(CACHE_LINE_SIZE) ConnectionMetrics {
+    std::atomic<uint64_t> connection{0};      // Ref while open, 0 once closed
+    std::atomic<uint64_t> client_id{0};
+    std::atomic<uint64_t> messages_in{0};
+    std::atomic<uint64_t> bytes_in{0};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> out_connection{0};
+    std::atomic<uint64_t> frames_out{0};
+    std::atomic<uint64_t> bytes_out{0};
+
+    void opened(uint64_t ref, uint64_t client) noexcept {
+        client_id.store(client, std::memory_order_relaxed);
+        messages_in.store(0, std::memory_order_relaxed);
+        bytes_in.store(0, std::memory_order_relaxed);
+        connection.store(ref, std::memory_order_release);
+    }
+    void closed() noexcept { connection.store(0, std::memory_order_release); }
+    void received(uint64_t bytes) noexcept { bump(bytes_in, bytes); }
+    void decoded(uint64_t messages) noexcept { bump(messages_in, messages); }
+
+    /**
+     * @brief Send side: start counting for ref if it is not already
+     */
+    void sending_to(uint64_t ref) noexcept {
+        if (out_connection.load(std::memory_order_relaxed) != ref) {
+            frames_out.store(0, std::memory_order_relaxed);
+            bytes_out.store(0, std::memory_order_relaxed);
+            out_connection.store(ref, std::memory_order_release);
+        }
+    }
+    void queued(uint64_t frames) noexcept { bump(frames_out, frames); }
+    void sent(uint64_t bytes) noexcept { bump(bytes_out, bytes); }
+
+private:
+    static void bump(std::atomic<uint64_t>& value, uint64_t amount) noexcept {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Sizes of the per-thread and per-connection arrays a server needs
+ */
+struct MetricsLayout {
+    uint32_t threads = 0;              // One counter block and latency recorder each
+    uint32_t shards = 0;               // Connection metrics: shards * shard_connections slots
+    uint32_t shard_connections = 0;
+};
+
+/**
+ * @brief Fixed header at offset 0; every array offset is cache-line aligned
+ */
+struct MetricsHeader {
+    static constexpr uint64_t MAGIC = 0x3152544D54464848ULL;   // "HHFTMTR1"
+    static constexpr uint32_t VERSION = 1;
+
+    std::atomic<uint64_t> magic;       // Stored last, so a reader never sees a half-built header
+    uint32_t version;
+    uint32_t counter_block_size;       // Sizes of the array elements, to refuse a different build
+    uint32_t recorder_size;
+    uint32_t connection_size;
+    uint32_t gauge_count;
+    uint32_t threads;
+    uint32_t shards;
+    uint32_t shard_connections;
+    int64_t pid;
+    uint64_t started_ns;               // Wall clock
+    uint64_t counters_offset;
+    uint64_t recorders_offset;
+    uint64_t gauges_offset;
+    uint64_t connections_offset;
+    uint64_t size;
+    char server[32];                   // NUL-terminated server name
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> updated_ns; // Wall clock of the last gauge sample
+};
+
+/**
+ * @brief Server metrics in a POSIX shared memory object (/dev/shm/<name>)
+ *
+ * The server creates the segment at startup and places its per-thread
+ * CounterBlocks and LatencyRecorders in it, so workers keep doing the same
+ * single-writer stores they always did, now into memory another process
+ * can map. A monitor thread samples gauges into it; an exporter maps it
+ * read-only and does all formatting and I/O. Nothing on the hot path reads,
+ * formats or locks anything for monitoring.
+ *
+ * The creator unlinks the object when it is destroyed.
+ */
+class MetricsSegment {
+public:
+    /**
+     * @brief Create and size the object for layout; nullptr with a logged reason on failure
+     */
+    static std::unique_ptr<MetricsSegment> create(const std::string& name, const std::string& server,
+                                                  const MetricsLayout& layout);
+
+    /**
+     * @brief Map an existing segment read-only; nullptr if missing or from a different build
+     */
+    static std::unique_ptr<MetricsSegment> open(const std::string& name);
+
+    ~MetricsSegment();
+
+    MetricsSegment(const MetricsSegment&) = delete;
+    MetricsSegment& operator=(const MetricsSegment&) = delete;
+
+    const MetricsHeader& header() const { return *reinterpret_cast<const MetricsHeader*>(base_); }
+
+    CounterBlock* counters() { return at<CounterBlock>(header().counters_offset); }
+    LatencyRecorder* recorders() { return at<LatencyRecorder>(header().recorders_offset); }
+    ConnectionMetrics* connections() { return at<ConnectionMetrics>(header().connections_offset); }
+    const CounterBlock* counters() const { return at<CounterBlock>(header().counters_offset); }
+    const LatencyRecorder* recorders() const { return at<LatencyRecorder>(header().recorders_offset); }
+    const ConnectionMetrics* connections() const { return at<ConnectionMetrics>(header().connections_offset); }
+
+    /**
+     * @brief Connection metrics of a shard's table slot
+     */
+    ConnectionMetrics* connection(uint32_t shard, uint32_t slot) {
+        return connections() + static_cast<size_t>(shard) * header().shard_connections + slot;
+    }
+
+    void set(Gauge gauge, uint64_t value) {
+        gauges()[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+    }
+    uint64_t get(Gauge gauge) const {
+        return gauges()[static_cast<size_t>(gauge)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Stamp the end of a gauge sample
+     */
+    void mark_updated();
+
+private:
+    MetricsSegment(std::string name, uint8_t* base, size_t size, bool owner)
+        : name_(std::move(name)), base_(base), size_(size), owner_(owner) {}
+
+    template<typename T>
+    T* at(uint64_t offset) const { return reinterpret_cast<T*>(base_ + offset); }
+    std::atomic<uint64_t>* gauges() const { return at<std::atomic<uint64_t>>(header().gauges_offset); }
+
+    std::string name_;
+    uint8_t* base_;
+    size_t size_;
+    bool owner_;
+};
+
+} // namespace hft
+
+#endif // METRICS_SEGMENT_H
@@ -0,0 +1,221 @@
+#include "multicast_feed.h"
+#include "tsc_clock.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace hft {
+
+namespace {
+
+uint64_t round_up_pow2(uint64_t value) {
+    uint64_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+MulticastFeed::MulticastFeed(const MulticastConfig& config) : config_(config) {
+    config_.max_payload = std::max<uint32_t>(config_.max_payload,
+                                             sizeof(wire::FeedPacketHeader) + sizeof(wire::MarketDataBody));
+    updates_per_packet_ = static_cast<uint32_t>(
+        std::min<size_t>((config_.max_payload - sizeof(wire::FeedPacketHeader)) / sizeof(wire::MarketDataBody),
+                         UINT16_MAX));
+    history_mask_ = round_up_pow2(std::max(config_.history, MAX_RECOVERY)) - 1;
+}
+
+MulticastFeed::~MulticastFeed() {
+    stop();
+}
+
+bool MulticastFeed::start() {
+    struct sockaddr_in group{};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.group.c_str(), &group.sin_addr) != 1 ||
+        !IN_MULTICAST(ntohl(group.sin_addr.s_addr))) {
+        std::cerr << "Invalid multicast group: " << config_.group << std::endl;
+        return false;
+    }
+    if (config_.port == 0) {
+        std::cerr << "Multicast feed needs a port" << std::endl;
+        return false;
+    }
+    
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        std::cerr << "Failed to create multicast socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    int ttl = config_.ttl;
+    int loopback = config_.loopback ? 1 : 0;
+    if (setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0 ||
+        setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback)) < 0) {
+        std::cerr << "Failed to set multicast options: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    
+    if (!config_.interface_ip.empty()) {
+        struct in_addr interface{};
+        if (inet_pton(AF_INET, config_.interface_ip.c_str(), &interface) != 1 ||
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) < 0) {
+            std::cerr << "Failed to use multicast interface " << config_.interface_ip << std::endl;
+            stop();
+            return false;
+        }
+    }
+    
+    // Connected, so each datagram is a plain send()
+    if (connect(fd_, reinterpret_cast<struct sockaddr*>(&group), sizeof(group)) < 0) {
+        std::cerr << "Failed to connect multicast socket: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Any value that differs across restarts tells receivers to resynchronise
+    session_ = static_cast<uint32_t>(TscClock::instance().wall_ns() / 1000000ULL);
+    next_sequence_ = 1;
+    pending_ = 0;
+    packet_.assign(config_.max_payload, 0);
+    history_.assign(history_mask_ + 1, FeedUpdate{});
+    snapshot_index_.clear();
+    latest_.clear();
+    return true;
+}
+
+void MulticastFeed::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return;
+    }
+    if (pending_ > 0) {
+        send_pending();
+    }
+    close(fd_);
+    fd_ = -1;
+}
+
+uint64_t MulticastFeed::publish(InstrumentId instrument, const wire::MarketDataBody& body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return 0;
+    }
+    
+    uint64_t sequence = next_sequence_++;
+    history_[sequence & history_mask_] = FeedUpdate{sequence, body};
+    
+    if (instrument != NO_INSTRUMENT) {
+        if (instrument >= snapshot_index_.size()) {
+            snapshot_index_.resize(static_cast<size_t>(instrument) + 1, NO_SNAPSHOT);
+        }
+        uint32_t& entry = snapshot_index_[instrument];
+        if (entry != NO_SNAPSHOT) {
+            latest_[entry] = FeedUpdate{sequence, body};
+        } else {
+            entry = static_cast<uint32_t>(latest_.size());
+            latest_.push_back(FeedUpdate{sequence, body});
+        }
+    }
+    
+    if (pending_ == 0) {
+        wire::FeedPacketHeader header{};
+        header.sequence = wire::to_wire(sequence);
+        header.session = wire::to_wire(session_);
+        memcpy(packet_.data(), &header, sizeof(header));
+    }
+    memcpy(packet_.data() + sizeof(wire::FeedPacketHeader) + pending_ * sizeof(wire::MarketDataBody),
+           &body, sizeof(body));
+    if (++pending_ == updates_per_packet_) {
+        send_pending();
+    }
+    
+    updates_.fetch_add(1, std::memory_order_relaxed);
+    return sequence;
+}
+
+size_t MulticastFeed::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t updates = pending_;
+    if (fd_ >= 0 && pending_ > 0) {
+        send_pending();
+    }
+    return updates;
+}
+
+void MulticastFeed::send_pending() {
+    // The count is the only header field not known when the packet was started
+    uint16_t count = wire::to_wire(static_cast<uint16_t>(pending_));
+    memcpy(packet_.data() + offsetof(wire::FeedPacketHeader, count), &count, sizeof(count));
+    
+    size_t length = sizeof(wire::FeedPacketHeader) + pending_ * sizeof(wire::MarketDataBody);
+    pending_ = 0;
+    
+    ssize_t sent;
+    do {
+        sent = send(fd_, packet_.data(), length, MSG_DONTWAIT);
+    } while (sent < 0 && errno == EINTR);
+    
+    if (sent != static_cast<ssize_t>(length)) {
+        // Never block publishers on the network; the gap is recoverable
+        send_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    packets_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(length, std::memory_order_relaxed);
+}
+
+bool MulticastFeed::retransmit(uint64_t start, uint32_t count, std::vector<FeedUpdate>& out) {
+    retransmit_requests_.fetch_add(1, std::memory_order_relaxed);
+    out.clear();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t oldest = next_sequence_ > history_.size() ? next_sequence_ - history_.size() : 1;
+    if (fd_ < 0 || start < oldest || start >= next_sequence_) {
+        return false;
+    }
+    
+    uint64_t end = std::min(start + std::min(count, MAX_RECOVERY), next_sequence_);
+    for (uint64_t sequence = start; sequence < end; ++sequence) {
+        out.push_back(history_[sequence & history_mask_]);
+    }
+    recovered_.fetch_add(out.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void MulticastFeed::snapshot(uint64_t offset, uint32_t count, std::vector<FeedUpdate>& out) {
+    snapshot_requests_.fetch_add(1, std::memory_order_relaxed);
+    out.clear();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset >= latest_.size()) {
+        return;
+    }
+    uint64_t end = std::min<uint64_t>(offset + std::min(count, MAX_RECOVERY), latest_.size());
+    out.assign(latest_.begin() + offset, latest_.begin() + end);
+    recovered_.fetch_add(out.size(), std::memory_order_relaxed);
+}
+
+MulticastStats MulticastFeed::stats() const {
+    MulticastStats stats;
+    stats.updates = updates_.load(std::memory_order_relaxed);
+    stats.packets = packets_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.send_errors = send_errors_.load(std::memory_order_relaxed);
+    stats.retransmit_requests = retransmit_requests_.load(std::memory_order_relaxed);
+    stats.snapshot_requests = snapshot_requests_.load(std::memory_order_relaxed);
+    stats.recovered = recovered_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace hft
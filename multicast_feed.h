@@ -0,0 +1,166 @@
+#ifndef MULTICAST_FEED_H
+#define MULTICAST_FEED_H
+
+#include "wire_protocol.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Settings for a MulticastFeed; an empty group leaves the feed off
+ */
+struct MulticastConfig {
+    std::string group;                 // IPv4 multicast group, e.g. 239.1.1.1
+    uint16_t port = 0;
+    std::string interface_ip;          // Outgoing interface; empty = routing table default
+    uint8_t ttl = 1;                   // Hops; 1 keeps the feed on the local subnet
+    bool loopback = true;              // Deliver to listeners on this host too
+    uint32_t max_payload = 1400;       // Datagram bytes, kept under a 1500-byte MTU
+    uint32_t history = 65536;          // Updates kept for retransmission, rounded up to a power of two
+    
+    bool enabled() const { return !group.empty(); }
+};
+
+/**
+ * @brief Fill group and port from "group:port", e.g. 239.1.1.1:30001
+ */
+inline bool parse_multicast_endpoint(const std::string& text, MulticastConfig& config) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == text.size()) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long port = strtoul(text.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || port == 0 || port > UINT16_MAX) {
+        return false;
+    }
+    config.group = text.substr(0, colon);
+    config.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+/**
+ * @brief Feed counters since start
+ */
+struct MulticastStats {
+    uint64_t updates = 0;              // Updates assigned a feed sequence
+    uint64_t packets = 0;              // Datagrams sent
+    uint64_t bytes = 0;
+    uint64_t send_errors = 0;          // Datagrams the kernel refused; receivers recover them
+    uint64_t retransmit_requests = 0;
+    uint64_t snapshot_requests = 0;
+    uint64_t recovered = 0;            // Updates returned by either request
+};
+
+/**
+ * @brief One update as kept for recovery
+ */
+struct FeedUpdate {
+    uint64_t sequence;                 // Feed sequence; for snapshots, the symbol's last update
+    wire::MarketDataBody body;         // Wire byte order
+};
+
+/**
+ * @brief UDP multicast market data feed with TCP gap recovery
+ *
+ * Every published update gets the next feed sequence and is packed into
+ * the pending datagram (a FeedPacketHeader followed by MarketDataBody
+ * updates); the datagram goes out when it is full or on flush(). The cost
+ * is one sendto() per datagram however many receivers have joined the
+ * group.
+ *
+ * UDP can drop, so the last history updates are kept in a ring and the
+ * latest update of every symbol in a snapshot table. A receiver that sees
+ * a gap in the sequence asks for it with retransmit() over TCP; one that
+ * joins late, or falls behind the history, takes a snapshot() and then
+ * applies only live updates newer than each symbol's snapshot sequence.
+ *
+ * All operations are thread-safe; publishers are serialised so that
+ * sequences leave in datagram order.
+ */
+class MulticastFeed {
+public:
+    static constexpr uint32_t MAX_RECOVERY = 256;  // Updates returned per request
+    
+    explicit MulticastFeed(const MulticastConfig& config);
+    ~MulticastFeed();
+    
+    MulticastFeed(const MulticastFeed&) = delete;
+    MulticastFeed& operator=(const MulticastFeed&) = delete;
+    
+    /**
+     * @brief Open and connect the multicast socket; false with a logged reason on failure
+     */
+    bool start();
+    void stop();
+    
+    /**
+     * @brief Sequence and batch an update; body is already in wire byte order
+     *
+     * The update replaces the instrument's snapshot entry. Returns the
+     * update's feed sequence, or 0 if the feed is not started.
+     */
+    uint64_t publish(InstrumentId instrument, const wire::MarketDataBody& body);
+    
+    /**
+     * @brief Send the pending datagram, if any; returns the updates it carried
+     */
+    size_t flush();
+    
+    /**
+     * @brief Fetch updates start .. start + count - 1 (at most MAX_RECOVERY)
+     *
+     * Stops early at the newest update. False when start has already left
+     * the history, or has not been published yet.
+     */
+    bool retransmit(uint64_t start, uint32_t count, std::vector<FeedUpdate>& out);
+    
+    /**
+     * @brief Latest update of up to count symbols, from symbol offset onwards
+     *
+     * Symbols are in first-published order, so a receiver pages through
+     * them by asking again from offset + out.size() until fewer come back.
+     */
+    void snapshot(uint64_t offset, uint32_t count, std::vector<FeedUpdate>& out);
+    
+    uint32_t session() const { return session_; }
+    const MulticastConfig& config() const { return config_; }
+    MulticastStats stats() const;
+
+private:
+    static constexpr uint32_t NO_SNAPSHOT = UINT32_MAX;
+    
+    void send_pending();
+    
+    MulticastConfig config_;
+    int fd_ = -1;
+    uint32_t session_ = 0;
+    uint32_t updates_per_packet_ = 0;
+    
+    std::mutex mutex_;
+    uint64_t next_sequence_ = 1;
+    std::vector<uint8_t> packet_;          // Pending datagram
+    uint32_t pending_ = 0;                 // Updates in packet_
+    std::vector<FeedUpdate> history_;
+    uint64_t history_mask_ = 0;
+    std::vector<uint32_t> snapshot_index_; // By instrument id: its entry in latest_, or NO_SNAPSHOT
+    std::vector<FeedUpdate> latest_;       // Snapshot table, first-published order
+    
+    std::atomic<uint64_t> updates_{0};
+    std::atomic<uint64_t> packets_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> send_errors_{0};
+    std::atomic<uint64_t> retransmit_requests_{0};
+    std::atomic<uint64_t> snapshot_requests_{0};
+    std::atomic<uint64_t> recovered_{0};
+};
+
+} // namespace hft
+
+#endif // MULTICAST_FEED_H
@@ -0,0 +1,216 @@
+#include "numa_memory.h"
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace hft {
+
+namespace {
+
+constexpr size_t PAGE_4KB = 4096;
+constexpr size_t PAGE_2MB = 2ULL << 20;
+constexpr size_t PAGE_1GB = 1ULL << 30;
+
+size_t round_up(size_t bytes, size_t page) {
+    return (bytes + page - 1) / page * page;
+}
+
+// MAP_HUGETLB with an explicit page size; falls through to the next smaller one
+void* map_pages(size_t bytes, size_t page) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (page == PAGE_1GB) {
+        flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+    } else if (page == PAGE_2MB) {
+        flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return base == MAP_FAILED ? nullptr : base;
+}
+
+bool bind_to_node(void* base, size_t bytes, int node) {
+    constexpr size_t BITS = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(static_cast<size_t>(node) / BITS + 1, 0);
+    mask[static_cast<size_t>(node) / BITS] |= 1UL << (static_cast<size_t>(node) % BITS);
+    // The kernel reads maxnode - 1 bits
+    return syscall(SYS_mbind, base, bytes, MPOL_BIND, mask.data(), mask.size() * BITS + 1, 0) == 0;
+}
+
+} // namespace
+
+bool parse_huge_pages(const std::string& text, HugePages& pages) {
+    if (text == "off" || text == "4k") {
+        pages = HugePages::OFF;
+    } else if (text == "2m" || text == "2M") {
+        pages = HugePages::HUGE_2MB;
+    } else if (text == "1g" || text == "1G") {
+        pages = HugePages::HUGE_1GB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* huge_pages_name(HugePages pages) {
+    switch (pages) {
+        case HugePages::OFF: return "4 KB";
+        case HugePages::HUGE_2MB: return "2 MB";
+        case HugePages::HUGE_1GB: return "1 GB";
+    }
+    return "unknown";
+}
+
+int numa_node_of_cpu(int cpu) {
+    if (cpu < 0) {
+        return -1;
+    }
+    // The CPU's sysfs directory links to its node as "node<N>"
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// NumaArena implementation
+NumaArena::NumaArena(int node, const MemoryOptions& options)
+    : node_(node), options_(options) {
+    // Later chunks are only mapped when this one runs out
+    map_chunk(static_cast<size_t>(options_.arena_mb) << 20);
+}
+
+NumaArena::~NumaArena() {
+    for (const Chunk& chunk : chunks_) {
+        munmap(chunk.base, chunk.size);
+    }
+}
+
+size_t NumaArena::mapped_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const Chunk& chunk : chunks_) {
+        total += chunk.size;
+    }
+    return total;
+}
+
+size_t NumaArena::used_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_;
+}
+
+size_t NumaArena::page_size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t smallest = 0;
+    for (const Chunk& chunk : chunks_) {
+        smallest = smallest == 0 ? chunk.page_size : std::min(smallest, chunk.page_size);
+    }
+    return smallest;
+}
+
+void* NumaArena::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!chunks_.empty()) {
+        const Chunk& chunk = chunks_.back();
+        size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= chunk.size) {
+            offset_ = start + bytes;
+            used_ += bytes;
+            return chunk.base + start;
+        }
+    }
+
+    // Chunks are page aligned, which covers any alignment asked for. The
+    // build has no exceptions, so a failed mapping falls back to the heap
+    if (!map_chunk(std::max(bytes, static_cast<size_t>(options_.arena_mb) << 20))) {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    offset_ = bytes;
+    used_ += bytes;
+    return chunks_.back().base;
+}
+
+bool NumaArena::map_chunk(size_t min_bytes) {
+    std::vector<size_t> pages;
+    if (options_.huge_pages == HugePages::HUGE_1GB) {
+        pages.push_back(PAGE_1GB);
+    }
+    if (options_.huge_pages != HugePages::OFF) {
+        pages.push_back(PAGE_2MB);
+    }
+    pages.push_back(PAGE_4KB);
+
+    Chunk chunk{nullptr, 0, 0};
+    for (size_t page : pages) {
+        size_t size = round_up(std::max<size_t>(min_bytes, 1), page);
+        if (void* base = map_pages(size, page)) {
+            chunk = Chunk{static_cast<uint8_t*>(base), size, page};
+            break;
+        }
+    }
+    if (!chunk.base) {
+        std::cerr << "Arena for node " << node_ << " failed to map " << min_bytes << " bytes: "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+    if (options_.huge_pages != HugePages::OFF && chunk.page_size == PAGE_4KB) {
+        // No hugetlbfs pages reserved (vm.nr_hugepages); let THP back what it can
+        madvise(chunk.base, chunk.size, MADV_HUGEPAGE);
+        std::cerr << "Arena for node " << node_ << ": no " << huge_pages_name(options_.huge_pages)
+                  << " pages free, using transparent huge pages" << std::endl;
+    }
+
+    // Bind before the first touch, or the pages land wherever this thread runs
+    if (options_.numa && node_ >= 0 && !bind_to_node(chunk.base, chunk.size, node_)) {
+        std::cerr << "Arena failed to bind to node " << node_ << ": " << strerror(errno) << std::endl;
+    }
+    for (size_t offset = 0; offset < chunk.size; offset += PAGE_4KB) {
+        chunk.base[offset] = 0;
+    }
+    if (options_.lock && mlock(chunk.base, chunk.size) != 0) {
+        std::cerr << "Arena for node " << node_ << " failed to mlock " << chunk.size << " bytes: "
+                  << strerror(errno) << " (check RLIMIT_MEMLOCK)" << std::endl;
+    }
+
+    chunks_.push_back(chunk);
+    return true;
+}
+
+// NumaArenas implementation
+NumaArena& NumaArenas::for_cpu(int cpu) {
+    int node = options_.numa ? numa_node_of_cpu(cpu) : -1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& arena : arenas_) {
+        if (arena->node() == node) {
+            return *arena;
+        }
+    }
+    arenas_.push_back(std::make_unique<NumaArena>(node, options_));
+    return *arenas_.back();
+}
+
+void NumaArenas::describe(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& arena : arenas_) {
+        out << "Arena node " << arena->node() << ": " << (arena->mapped_bytes() >> 20) << " MB mapped on "
+            << (arena->page_size() >> 10) << " KB pages, " << (arena->used_bytes() >> 20) << " MB used"
+            << (options_.lock ? ", locked" : "") << std::endl;
+    }
+}
+
+} // namespace hft
@@ -0,0 +1,135 @@
+#ifndef NUMA_MEMORY_H
+#define NUMA_MEMORY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Page size requested for arena memory
+ */
+enum class HugePages : uint8_t {
+    OFF,                               // Regular 4 KB pages
+    HUGE_2MB,                          // MAP_HUGETLB 2 MB pages, else transparent huge pages
+    HUGE_1GB                           // MAP_HUGETLB 1 GB pages, else 2 MB, else transparent
+};
+
+/**
+ * @brief Where long-lived server memory comes from; all off keeps plain heap allocation
+ */
+struct MemoryOptions {
+    HugePages huge_pages = HugePages::OFF;
+    bool numa = false;                 // Bind each thread's memory to the node of the CPU it is pinned to
+    bool lock = false;                 // mlock arena memory so it is never paged out
+    uint32_t arena_mb = 256;           // Mapped, pre-faulted and locked per arena at startup
+
+    bool enabled() const { return huge_pages != HugePages::OFF || numa || lock; }
+};
+
+/**
+ * @brief Parse "off", "2m" or "1g"
+ */
+bool parse_huge_pages(const std::string& text, HugePages& pages);
+const char* huge_pages_name(HugePages pages);
+
+/**
+ * @brief NUMA node of a CPU, or -1 if the system does not say
+ */
+int numa_node_of_cpu(int cpu);
+
+/**
+ * @brief Monotonic allocator over huge pages bound to one NUMA node
+ *
+ * Memory is mapped in chunks, each bound to the node with mbind() before
+ * it is touched, pre-faulted, and locked when asked. The first chunk is
+ * mapped by the constructor, so everything that fits in it costs no page
+ * fault at run time. A chunk that cannot get huge pages falls back to the
+ * next smaller size, down to 4 KB pages with MADV_HUGEPAGE. If no chunk
+ * can be mapped at all the allocation comes from the heap instead.
+ *
+ * Allocation takes a mutex: it is meant for startup and for slabs created
+ * on first use, not for the hot path. deallocate() is a no-op; chunks are
+ * unmapped when the arena is destroyed, so the arena must outlive every
+ * container that allocates from it.
+ */
+class NumaArena : public std::pmr::memory_resource {
+public:
+    NumaArena(int node, const MemoryOptions& options);
+    ~NumaArena() override;
+
+    NumaArena(const NumaArena&) = delete;
+    NumaArena& operator=(const NumaArena&) = delete;
+
+    int node() const { return node_; }
+    size_t mapped_bytes() const;
+    size_t used_bytes() const;
+
+    /**
+     * @brief Smallest page size any chunk ended up on
+     */
+    size_t page_size() const;
+
+private:
+    struct Chunk {
+        uint8_t* base;
+        size_t size;
+        size_t page_size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    bool map_chunk(size_t min_bytes);
+
+    int node_;
+    MemoryOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<Chunk> chunks_;
+    size_t offset_ = 0;                // Into chunks_.back()
+    size_t used_ = 0;
+};
+
+/**
+ * @brief One arena per NUMA node, created on first use
+ *
+ * Without NUMA binding every thread shares the arena of node -1, which
+ * still provides huge pages and locking.
+ */
+class NumaArenas {
+public:
+    explicit NumaArenas(const MemoryOptions& options) : options_(options) {}
+
+    /**
+     * @brief Arena for a thread pinned to cpu (-1 = unpinned)
+     */
+    NumaArena& for_cpu(int cpu);
+
+    /**
+     * @brief Arena for a thread pinned per affinity[index % size], as the servers pin threads
+     */
+    NumaArena& for_thread(const std::vector<int>& affinity, size_t index) {
+        return for_cpu(affinity.empty() ? -1 : affinity[index % affinity.size()]);
+    }
+
+    /**
+     * @brief One line per arena: node, pages, mapped and used bytes
+     */
+    void describe(std::ostream& out) const;
+
+private:
+    MemoryOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<NumaArena>> arenas_;
+};
+
+} // namespace hft
+
+#endif // NUMA_MEMORY_H
@@ -0,0 +1,306 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace hft {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Write to every 4 KB page of a range so none faults on the hot path later
+ *
+ * Each page keeps its contents; a read alone would only map the shared
+ * zero page.
+ */
+inline void prefault(void* data, size_t size) {
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(data);
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        bytes[offset] = bytes[offset];
+    }
+}
+
+/**
+ * @brief Raw storage for one pooled object, padded to whole cache lines
+ *
+ * Neighbouring objects never share a line, so objects handed to different
+ * threads cannot false-share.
+ */
+template<typename T>
+struct alignas(alignof(T) > CACHE_LINE_SIZE ? alignof(T) : CACHE_LINE_SIZE) PoolSlot {
+    unsigned char storage[sizeof(T)];
+
+    T* object() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+};
+
+/**
+ * @brief Destroys and frees objects that allocate_array() took from a memory resource
+ */
+template<typename T>
+struct ResourceDeleter {
+    std::pmr::memory_resource* memory = nullptr;
+    size_t count = 0;
+
+    void operator()(T* objects) const noexcept {
+        std::destroy_n(objects, count);
+        memory->deallocate(objects, count * sizeof(T), alignof(T));
+    }
+};
+
+template<typename T>
+using ResourceArray = std::unique_ptr<T[], ResourceDeleter<T>>;
+
+template<typename T>
+using ResourcePtr = std::unique_ptr<T, ResourceDeleter<T>>;
+
+/**
+ * @brief count value-initialised objects from memory, or from the heap when memory is null
+ */
+template<typename T>
+ResourceArray<T> allocate_array(std::pmr::memory_resource* memory, size_t count) {
+    if (!memory) {
+        memory = std::pmr::new_delete_resource();
+    }
+    T* objects = static_cast<T*>(memory->allocate(count * sizeof(T), alignof(T)));
+    for (size_t i = 0; i < count; ++i) {
+        new (objects + i) T();
+    }
+    return ResourceArray<T>(objects, ResourceDeleter<T>{memory, count});
+}
+
+/**
+ * @brief One object from memory, or from the heap when memory is null
+ */
+template<typename T, typename... Args>
+ResourcePtr<T> allocate_object(std::pmr::memory_resource* memory, Args&&... args) {
+    if (!memory) {
+        memory = std::pmr::new_delete_resource();
+    }
+    void* storage = memory->allocate(sizeof(T), alignof(T));
+    return ResourcePtr<T>(new (storage) T(std::forward<Args>(args)...), ResourceDeleter<T>{memory, 1});
+}
+
+template<typename T> class ObjectPool;
+
+/**
+ * @brief Returns an object to the pool it came from
+ */
+template<typename T>
+struct PoolDeleter {
+    ObjectPool<T>* pool = nullptr;
+
+    void operator()(T* object) const noexcept {
+        if (pool) {
+            pool->release(object);
+        }
+    }
+};
+
+/**
+ * @brief Unique ownership of a pooled object; releases it when destroyed
+ */
+template<typename T>
+using PoolPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+/**
+ * @brief Fixed-capacity object pool owned by a single thread
+ *
+ * All storage is one cache-line-aligned slab allocated up front, so memory
+ * use is fixed at capacity * sizeof(PoolSlot<T>) and acquire/release are a
+ * pop/push on a free index stack with no atomics. Objects are constructed on
+ * acquire and destroyed on release, so a slot is never handed out while its
+ * previous user still owns it. Exhaustion returns nullptr rather than
+ * growing. Only the owning thread may acquire or release. Storage comes from
+ * memory when given (a NumaArena, say), otherwise from the heap.
+ */
+template<typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(uint32_t capacity, std::pmr::memory_resource* memory = nullptr)
+        : slots_(allocate_array<PoolSlot<T>>(memory, capacity)),
+          free_stack_(allocate_array<uint32_t>(memory, capacity)),
+          in_use_(allocate_array<bool>(memory, capacity)),
+          capacity_(capacity), free_count_(capacity),
+          owner_(std::this_thread::get_id()) {
+        // Hand out low indices first so a lightly used pool stays cache-warm
+        for (uint32_t i = 0; i < capacity; ++i) {
+            free_stack_[i] = capacity - 1 - i;
+        }
+    }
+
+    ~ObjectPool() {
+        for (uint32_t i = 0; i < capacity_; ++i) {
+            if (in_use_[i]) {
+                slots_[i].object()->~T();
+            }
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief Construct an object in a free slot; nullptr when the pool is exhausted
+     */
+    template<typename... Args>
+    T* acquire(Args&&... args) {
+        assert(std::this_thread::get_id() == owner_);
+        if (free_count_ == 0) {
+            return nullptr;
+        }
+
+        uint32_t index = free_stack_[--free_count_];
+        in_use_[index] = true;
+        return new (slots_[index].storage) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Acquire wrapped in a PoolPtr that releases on destruction
+     */
+    template<typename... Args>
+    PoolPtr<T> acquire_owned(Args&&... args) {
+        return PoolPtr<T>(acquire(std::forward<Args>(args)...), PoolDeleter<T>{this});
+    }
+
+    /**
+     * @brief Destroy an object and return its slot; false for foreign or already released objects
+     */
+    bool release(T* object) {
+        assert(std::this_thread::get_id() == owner_);
+        uint32_t index = index_of(object);
+        if (index >= capacity_ || !in_use_[index]) {
+            return false;
+        }
+
+        object->~T();
+        in_use_[index] = false;
+        free_stack_[free_count_++] = index;
+        return true;
+    }
+
+    uint32_t capacity() const { return capacity_; }
+    uint32_t available() const { return free_count_; }
+    uint32_t in_use() const { return capacity_ - free_count_; }
+
+private:
+    uint32_t index_of(const T* object) const {
+        auto address = reinterpret_cast<uintptr_t>(object);
+        auto base = reinterpret_cast<uintptr_t>(slots_.get());
+        if (address < base || (address - base) % sizeof(PoolSlot<T>) != 0) {
+            return UINT32_MAX;
+        }
+        return static_cast<uint32_t>((address - base) / sizeof(PoolSlot<T>));
+    }
+
+    ResourceArray<PoolSlot<T>> slots_;
+    ResourceArray<uint32_t> free_stack_;
+    ResourceArray<bool> in_use_;
+    uint32_t capacity_;
+    uint32_t free_count_;
+    std::thread::id owner_;
+};
+
+/**
+ * @brief Index-addressed arena that grows in cache-line-aligned slabs up to a fixed bound
+ *
+ * Slab k holds objects [k * SLAB_OBJECTS, (k + 1) * SLAB_OBJECTS) and is
+ * allocated, with every object in it default-constructed, the first time one
+ * of its indices is requested. Objects keep their address until the arena is
+ * destroyed. Slab creation is lock-free, so any thread may call get().
+ *
+ * Slabs come from memory when given, otherwise from the heap. Objects that
+ * can be built from a memory resource are given it, so their own buffers
+ * land in the same place.
+ */
+template<typename T, size_t SLAB_OBJECTS = 16>
+class SlabArena {
+public:
+    explicit SlabArena(size_t capacity, std::pmr::memory_resource* memory = nullptr)
+        : memory_(memory ? memory : std::pmr::new_delete_resource()),
+          slab_count_((capacity + SLAB_OBJECTS - 1) / SLAB_OBJECTS),
+          slabs_(allocate_array<std::atomic<PoolSlot<T>*>>(memory, slab_count_)) {}
+
+    ~SlabArena() {
+        for (size_t i = 0; i < slab_count_; ++i) {
+            destroy_slab(slabs_[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    /**
+     * @brief Object at index, creating its slab on first use
+     */
+    T* get(size_t index) {
+        std::atomic<PoolSlot<T>*>& entry = slabs_[index / SLAB_OBJECTS];
+        PoolSlot<T>* slab = entry.load(std::memory_order_acquire);
+        if (!slab) {
+            PoolSlot<T>* created = create_slab();
+            if (entry.compare_exchange_strong(slab, created, std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+                slab = created;
+            } else {
+                destroy_slab(created);   // Another thread installed it first
+            }
+        }
+        return slab[index % SLAB_OBJECTS].object();
+    }
+
+    /**
+     * @brief Object at index if its slab exists, otherwise nullptr
+     */
+    T* find(size_t index) const {
+        PoolSlot<T>* slab = slabs_[index / SLAB_OBJECTS].load(std::memory_order_acquire);
+        return slab ? slab[index % SLAB_OBJECTS].object() : nullptr;
+    }
+
+    size_t allocated_slabs() const {
+        size_t count = 0;
+        for (size_t i = 0; i < slab_count_; ++i) {
+            count += slabs_[i].load(std::memory_order_relaxed) != nullptr;
+        }
+        return count;
+    }
+
+private:
+    PoolSlot<T>* create_slab() {
+        auto* slab = static_cast<PoolSlot<T>*>(
+            memory_->allocate(SLAB_OBJECTS * sizeof(PoolSlot<T>), alignof(PoolSlot<T>)));
+        for (size_t i = 0; i < SLAB_OBJECTS; ++i) {
+            if constexpr (std::is_constructible_v<T, std::pmr::memory_resource*>) {
+                new (slab[i].storage) T(memory_);
+            } else {
+                new (slab[i].storage) T();
+            }
+        }
+        return slab;
+    }
+
+    void destroy_slab(PoolSlot<T>* slab) {
+        if (!slab) {
+            return;
+        }
+        for (size_t i = 0; i < SLAB_OBJECTS; ++i) {
+            slab[i].object()->~T();
+        }
+        memory_->deallocate(slab, SLAB_OBJECTS * sizeof(PoolSlot<T>), alignof(PoolSlot<T>));
+    }
+
+    std::pmr::memory_resource* memory_;
+    size_t slab_count_;
+    ResourceArray<std::atomic<PoolSlot<T>*>> slabs_;
+};
+
+} // namespace hft
+
+#endif // OBJECT_POOL_H
@@ -0,0 +1,614 @@
+#include "order_book.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace hft {
+
+namespace {
+
+// Side and time in force arrive as raw wire bytes
+bool valid_order(uint64_t order_id, OrderSide side, TimeInForce tif, uint32_t quantity) {
+    return order_id != 0 && quantity != 0 && (side == OrderSide::BUY || side == OrderSide::SELL) &&
+           static_cast<uint8_t>(tif) >= static_cast<uint8_t>(TimeInForce::DAY) &&
+           static_cast<uint8_t>(tif) <= static_cast<uint8_t>(TimeInForce::GTC);
+}
+
+} // namespace
+
+const char* order_result_name(OrderResult result) {
+    switch (result) {
+        case OrderResult::ACCEPTED: return "ACCEPTED";
+        case OrderResult::FILLED: return "FILLED";
+        case OrderResult::PARTIALLY_FILLED: return "PARTIALLY_FILLED";
+        case OrderResult::CANCELLED: return "CANCELLED";
+        case OrderResult::REPLACED: return "REPLACED";
+        case OrderResult::REJECTED_INVALID: return "REJECTED_INVALID";
+        case OrderResult::REJECTED_UNSUPPORTED: return "REJECTED_UNSUPPORTED";
+        case OrderResult::REJECTED_PRICE_BAND: return "REJECTED_PRICE_BAND";
+        case OrderResult::REJECTED_DUPLICATE_ID: return "REJECTED_DUPLICATE_ID";
+        case OrderResult::REJECTED_BOOK_FULL: return "REJECTED_BOOK_FULL";
+        case OrderResult::REJECTED_FOK: return "REJECTED_FOK";
+        case OrderResult::UNKNOWN_ORDER: return "UNKNOWN_ORDER";
+        case OrderResult::REJECTED_RISK_SIZE: return "REJECTED_RISK_SIZE";
+        case OrderResult::REJECTED_RISK_NOTIONAL: return "REJECTED_RISK_NOTIONAL";
+        case OrderResult::REJECTED_RISK_PRICE: return "REJECTED_RISK_PRICE";
+        case OrderResult::REJECTED_RISK_POSITION: return "REJECTED_RISK_POSITION";
+        case OrderResult::REJECTED_RISK_THROTTLE: return "REJECTED_RISK_THROTTLE";
+        case OrderResult::REJECTED_UNKNOWN_INSTRUMENT: return "REJECTED_UNKNOWN_INSTRUMENT";
+        case OrderResult::REJECTED_TICK_SIZE: return "REJECTED_TICK_SIZE";
+        case OrderResult::REJECTED_LOT_SIZE: return "REJECTED_LOT_SIZE";
+        case OrderResult::REJECTED_PRICE_LIMIT: return "REJECTED_PRICE_LIMIT";
+    }
+    return "UNKNOWN";
+}
+
+namespace {
+
+std::pmr::memory_resource* book_memory(const OrderBookConfig& config) {
+    return config.memory ? config.memory : std::pmr::get_default_resource();
+}
+
+} // namespace
+
+// OrderBook implementation
+// OwnerIndex implementation
+OwnerIndex::OwnerIndex() {
+    slots_.resize(64);
+    mask_ = slots_.size() - 1;
+    shift_ = 64 - static_cast<uint32_t>(std::countr_zero(slots_.size()));
+}
+
+OwnerIndex::Ref OwnerIndex::head(uint64_t owner) const {
+    for (size_t slot = slot_of(owner);; slot = (slot + 1) & mask_) {
+        const Slot& entry = slots_[slot];
+        if (!entry.head.book || entry.owner == owner) {
+            return entry.head;
+        }
+    }
+}
+
+void OwnerIndex::set_head(uint64_t owner, Ref head) {
+    size_t slot = slot_of(owner);
+    while (slots_[slot].head.book && slots_[slot].owner != owner) {
+        slot = (slot + 1) & mask_;
+    }
+
+    if (head.book) {
+        if (!slots_[slot].head.book) {
+            if ((count_ + 1) * 2 > slots_.size()) {
+                grow();
+                set_head(owner, head);
+                return;
+            }
+            ++count_;
+        }
+        slots_[slot] = Slot{owner, head};
+        return;
+    }
+    if (!slots_[slot].head.book) {
+        return;
+    }
+
+    // Backward-shift deletion, as in the books' order id index
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask_; slots_[next].head.book; next = (next + 1) & mask_) {
+        size_t home = slot_of(slots_[next].owner);
+        if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole] = Slot{};
+    --count_;
+}
+
+void OwnerIndex::grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    shift_ = 64 - static_cast<uint32_t>(std::countr_zero(slots_.size()));
+    count_ = 0;
+    for (const Slot& entry : old) {
+        if (entry.head.book) {
+            set_head(entry.owner, entry.head);
+        }
+    }
+}
+
+// OrderBook implementation
+OrderBook::OrderBook(InstrumentId instrument, std::string_view symbol, uint64_t base_price,
+                     const OrderBookConfig& config, IFillListener* listener, OwnerIndex* owners)
+    : instrument_(instrument),
+      symbol_length_(std::min(symbol.size(), symbol_.size())),
+      base_price_(base_price),
+      price_levels_(config.price_levels),
+      levels_(config.price_levels, PriceLevel{0, INVALID_INDEX, INVALID_INDEX}, book_memory(config)),
+      level_bitmap_((config.price_levels + 63) / 64, 0, book_memory(config)),
+      best_bid_(INVALID_INDEX),
+      best_ask_(INVALID_INDEX),
+      nodes_(config.max_orders, book_memory(config)),
+      free_head_(config.max_orders > 0 ? 0 : INVALID_INDEX),
+      resting_orders_(0),
+      index_(book_memory(config)),
+      next_fill_id_(1),
+      listener_(listener),
+      own_owners_(owners ? nullptr : std::make_unique<OwnerIndex>()),
+      owners_(owners ? owners : own_owners_.get()) {
+    symbol_.fill('\0');
+    memcpy(symbol_.data(), symbol.data(), symbol_length_);
+
+    // Thread every node onto the free list
+    for (uint32_t i = 0; i < config.max_orders; ++i) {
+        nodes_[i].order_id = 0;
+        nodes_[i].next = (i + 1 < config.max_orders) ? i + 1 : INVALID_INDEX;
+    }
+
+    // Size the id index to at most 50% load
+    size_t index_size = std::bit_ceil(std::max<size_t>(static_cast<size_t>(config.max_orders) * 2, 16));
+    index_.assign(index_size, IndexSlot{0, INVALID_INDEX});
+    index_mask_ = index_size - 1;
+    index_shift_ = 64 - static_cast<uint32_t>(std::countr_zero(index_size));
+}
+
+OrderResult OrderBook::add_order(uint64_t order_id, OrderSide side, OrderType type, TimeInForce tif,
+                                 uint64_t price, uint32_t quantity, uint64_t owner) {
+    if (!valid_order(order_id, side, tif, quantity)) {
+        return OrderResult::REJECTED_INVALID;
+    }
+    if (type != OrderType::LIMIT && type != OrderType::MARKET) {
+        return OrderResult::REJECTED_UNSUPPORTED;
+    }
+    if (index_find(order_id) != INVALID_INDEX) {
+        return OrderResult::REJECTED_DUPLICATE_ID;
+    }
+
+    // A market order may trade through the whole ladder
+    uint32_t limit_level;
+    if (type == OrderType::MARKET) {
+        limit_level = side == OrderSide::BUY ? price_levels_ - 1 : 0;
+    } else {
+        if (!in_band(price)) {
+            return OrderResult::REJECTED_PRICE_BAND;
+        }
+        limit_level = static_cast<uint32_t>(price - base_price_);
+    }
+
+    if (tif == TimeInForce::FOK && !can_fill(side, limit_level, quantity)) {
+        return OrderResult::REJECTED_FOK;
+    }
+
+    uint32_t remaining = match(side, limit_level, quantity, order_id, owner);
+    if (remaining == 0) {
+        return OrderResult::FILLED;
+    }
+
+    // Market and IOC remainders never rest
+    if (type == OrderType::MARKET || tif == TimeInForce::IOC) {
+        return remaining == quantity ? OrderResult::CANCELLED : OrderResult::PARTIALLY_FILLED;
+    }
+
+    OrderResult rested = rest(order_id, side, limit_level, remaining, owner);
+    if (rested != OrderResult::ACCEPTED) {
+        return rested;
+    }
+    return remaining == quantity ? OrderResult::ACCEPTED : OrderResult::PARTIALLY_FILLED;
+}
+
+OrderResult OrderBook::cancel_order(uint64_t order_id, uint64_t owner) {
+    uint32_t node_index = index_find(order_id);
+    if (node_index == INVALID_INDEX || nodes_[node_index].owner != owner) {
+        return OrderResult::UNKNOWN_ORDER;
+    }
+    remove_node(node_index);
+    return OrderResult::CANCELLED;
+}
+
+OrderResult OrderBook::replace_order(uint64_t order_id, uint64_t price, uint32_t quantity, uint64_t owner) {
+    uint32_t node_index = index_find(order_id);
+    if (node_index == INVALID_INDEX || nodes_[node_index].owner != owner) {
+        return OrderResult::UNKNOWN_ORDER;
+    }
+    if (quantity == 0) {
+        remove_node(node_index);
+        return OrderResult::CANCELLED;
+    }
+    if (!in_band(price)) {
+        return OrderResult::REJECTED_PRICE_BAND;
+    }
+
+    OrderNode& node = nodes_[node_index];
+    uint32_t level = static_cast<uint32_t>(price - base_price_);
+
+    // Quantity down at the same price keeps the order's place in the queue
+    if (level == node.level && quantity <= node.quantity) {
+        levels_[level].total_quantity -= node.quantity - quantity;
+        emit_resting(node, static_cast<int64_t>(quantity) - node.quantity);
+        node.quantity = quantity;
+        return OrderResult::REPLACED;
+    }
+
+    OrderSide side = node.side;
+    remove_node(node_index);
+    return add_order(order_id, side, OrderType::LIMIT, TimeInForce::GTC, price, quantity, owner);
+}
+
+size_t OrderBook::cancel_all(uint64_t owner) {
+    // The owner's list runs through every book sharing the index
+    size_t cancelled = 0;
+    for (OwnerIndex::Ref order = owners_->head(owner); order.book; order = owners_->head(owner)) {
+        order.book->remove_node(order.node);
+        ++cancelled;
+    }
+    return cancelled;
+}
+
+uint32_t OrderBook::open_quantity(uint64_t order_id, uint64_t owner) const {
+    uint32_t node_index = index_find(order_id);
+    if (node_index == INVALID_INDEX || nodes_[node_index].owner != owner) {
+        return 0;
+    }
+    return nodes_[node_index].quantity;
+}
+
+uint64_t OrderBook::quantity_at(uint64_t price) const {
+    if (!in_band(price)) {
+        return 0;
+    }
+    return levels_[price - base_price_].total_quantity;
+}
+
+uint32_t OrderBook::match(OrderSide side, uint32_t limit_level, uint32_t quantity,
+                          uint64_t order_id, uint64_t owner) {
+    uint32_t remaining = quantity;
+    uint64_t timestamp = 0;
+    OrderSide opposite = side == OrderSide::BUY ? OrderSide::SELL : OrderSide::BUY;
+
+    while (remaining > 0) {
+        // Best opposite level that the limit allows
+        uint32_t level_index;
+        if (side == OrderSide::BUY) {
+            if (best_ask_ == INVALID_INDEX || best_ask_ > limit_level) break;
+            level_index = best_ask_;
+        } else {
+            if (best_bid_ == INVALID_INDEX || best_bid_ < limit_level) break;
+            level_index = best_bid_;
+        }
+
+        if (timestamp == 0) {
+            timestamp = Message::get_current_timestamp();
+        }
+
+        PriceLevel& level = levels_[level_index];
+        uint64_t price = base_price_ + level_index;
+
+        // Walk the FIFO from the oldest order
+        while (remaining > 0 && level.head != INVALID_INDEX) {
+            uint32_t resting_index = level.head;
+            OrderNode& resting = nodes_[resting_index];
+            uint32_t traded = std::min(remaining, resting.quantity);
+            uint64_t fill_id = next_fill_id_++;
+
+            emit_fill(order_id, owner, side, fill_id, traded, price, timestamp);
+            emit_fill(resting.order_id, resting.owner, opposite, fill_id, traded, price, timestamp);
+
+            remaining -= traded;
+            if (traded == resting.quantity) {
+                remove_node(resting_index);
+            } else {
+                resting.quantity -= traded;
+                level.total_quantity -= traded;
+                emit_resting(resting, -static_cast<int64_t>(traded));
+            }
+        }
+    }
+
+    return remaining;
+}
+
+bool OrderBook::can_fill(OrderSide side, uint32_t limit_level, uint32_t quantity) const {
+    uint64_t available = 0;
+    if (side == OrderSide::BUY) {
+        for (uint32_t level = best_ask_; level != INVALID_INDEX && level <= limit_level;
+             level = next_level_above(level)) {
+            available += levels_[level].total_quantity;
+            if (available >= quantity) return true;
+        }
+    } else {
+        for (uint32_t level = best_bid_; level != INVALID_INDEX && level >= limit_level;
+             level = next_level_below(level)) {
+            available += levels_[level].total_quantity;
+            if (available >= quantity) return true;
+        }
+    }
+    return false;
+}
+
+OrderResult OrderBook::rest(uint64_t order_id, OrderSide side, uint32_t level_index,
+                            uint32_t quantity, uint64_t owner) {
+    if (free_head_ == INVALID_INDEX) {
+        return OrderResult::REJECTED_BOOK_FULL;
+    }
+
+    uint32_t node_index = free_head_;
+    OrderNode& node = nodes_[node_index];
+    free_head_ = node.next;
+
+    node.order_id = order_id;
+    node.owner = owner;
+    node.quantity = quantity;
+    node.level = level_index;
+    node.side = side;
+    node.next = INVALID_INDEX;
+
+    // Append to the level's FIFO
+    PriceLevel& level = levels_[level_index];
+    node.prev = level.tail;
+    if (level.tail != INVALID_INDEX) {
+        nodes_[level.tail].next = node_index;
+    } else {
+        level.head = node_index;
+        level_bitmap_[level_index >> 6] |= 1ULL << (level_index & 63);
+    }
+    level.tail = node_index;
+    level.total_quantity += quantity;
+
+    if (side == OrderSide::BUY) {
+        if (best_bid_ == INVALID_INDEX || level_index > best_bid_) best_bid_ = level_index;
+    } else {
+        if (best_ask_ == INVALID_INDEX || level_index < best_ask_) best_ask_ = level_index;
+    }
+
+    index_insert(order_id, node_index);
+    link_owner(node_index);
+    ++resting_orders_;
+    emit_resting(node, quantity);
+    return OrderResult::ACCEPTED;
+}
+
+void OrderBook::remove_node(uint32_t node_index) {
+    OrderNode& node = nodes_[node_index];
+    PriceLevel& level = levels_[node.level];
+
+    // Unlink from the level's FIFO
+    if (node.prev != INVALID_INDEX) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        level.head = node.next;
+    }
+    if (node.next != INVALID_INDEX) {
+        nodes_[node.next].prev = node.prev;
+    } else {
+        level.tail = node.prev;
+    }
+    level.total_quantity -= node.quantity;
+
+    if (level.head == INVALID_INDEX) {
+        level_bitmap_[node.level >> 6] &= ~(1ULL << (node.level & 63));
+        if (node.level == best_bid_) {
+            best_bid_ = next_level_below(node.level);
+        } else if (node.level == best_ask_) {
+            best_ask_ = next_level_above(node.level);
+        }
+    }
+
+    index_erase(node.order_id);
+    unlink_owner(node_index);
+    node.order_id = 0;
+    node.next = free_head_;
+    free_head_ = node_index;
+    --resting_orders_;
+    emit_resting(node, -static_cast<int64_t>(node.quantity));
+}
+
+void OrderBook::link_owner(uint32_t node_index) {
+    // New orders go to the front; the list's order does not matter
+    OrderNode& node = nodes_[node_index];
+    OwnerIndex::Ref head = owners_->head(node.owner);
+    node.owner_prev = OwnerIndex::Ref{};
+    node.owner_next = head;
+    if (head.book) {
+        head.book->nodes_[head.node].owner_prev = OwnerIndex::Ref{this, node_index};
+    }
+    owners_->set_head(node.owner, OwnerIndex::Ref{this, node_index});
+}
+
+void OrderBook::unlink_owner(uint32_t node_index) {
+    OrderNode& node = nodes_[node_index];
+    if (node.owner_prev.book) {
+        node.owner_prev.book->nodes_[node.owner_prev.node].owner_next = node.owner_next;
+    } else {
+        owners_->set_head(node.owner, node.owner_next);
+    }
+    if (node.owner_next.book) {
+        node.owner_next.book->nodes_[node.owner_next.node].owner_prev = node.owner_prev;
+    }
+}
+
+void OrderBook::emit_fill(uint64_t order_id, uint64_t owner, OrderSide side, uint64_t fill_id,
+                          uint32_t quantity, uint64_t price, uint64_t timestamp) {
+    if (!listener_) {
+        return;
+    }
+
+    FillMessage fill;
+    fill.message_id = fill_id;
+    fill.timestamp = timestamp;
+    fill.status = MessageStatus::COMPLETED;
+    fill.order_id = order_id;
+    fill.fill_id = fill_id;
+    fill.fill_quantity = quantity;
+    fill.fill_price = price;
+    fill.side = side;
+    fill.instrument = instrument_;
+    memcpy(fill.execution_venue.data(), symbol_.data(), fill.execution_venue.size());
+    listener_->on_fill(fill, owner);
+}
+
+uint32_t OrderBook::next_level_above(uint32_t level) const {
+    size_t word = level >> 6;
+    uint64_t bits = level_bitmap_[word] & ~((2ULL << (level & 63)) - 1);
+    while (bits == 0) {
+        if (++word >= level_bitmap_.size()) return INVALID_INDEX;
+        bits = level_bitmap_[word];
+    }
+    return static_cast<uint32_t>((word << 6) + std::countr_zero(bits));
+}
+
+uint32_t OrderBook::next_level_below(uint32_t level) const {
+    size_t word = level >> 6;
+    uint64_t bits = level_bitmap_[word] & ((1ULL << (level & 63)) - 1);
+    while (bits == 0) {
+        if (word == 0) return INVALID_INDEX;
+        bits = level_bitmap_[--word];
+    }
+    return static_cast<uint32_t>((word << 6) + 63 - std::countl_zero(bits));
+}
+
+uint32_t OrderBook::index_find(uint64_t order_id) const {
+    for (size_t slot = index_slot(order_id);; slot = (slot + 1) & index_mask_) {
+        const IndexSlot& entry = index_[slot];
+        if (entry.order_id == order_id) return entry.node;
+        if (entry.order_id == 0) return INVALID_INDEX;
+    }
+}
+
+bool OrderBook::index_insert(uint64_t order_id, uint32_t node) {
+    for (size_t slot = index_slot(order_id);; slot = (slot + 1) & index_mask_) {
+        IndexSlot& entry = index_[slot];
+        if (entry.order_id == order_id) return false;
+        if (entry.order_id == 0) {
+            entry.order_id = order_id;
+            entry.node = node;
+            return true;
+        }
+    }
+}
+
+void OrderBook::index_erase(uint64_t order_id) {
+    size_t slot = index_slot(order_id);
+    while (index_[slot].order_id != order_id) {
+        if (index_[slot].order_id == 0) return;
+        slot = (slot + 1) & index_mask_;
+    }
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & index_mask_; index_[next].order_id != 0;
+         next = (next + 1) & index_mask_) {
+        size_t home = index_slot(index_[next].order_id);
+        if (((next - home) & index_mask_) >= ((next - hole) & index_mask_)) {
+            index_[hole] = index_[next];
+            hole = next;
+        }
+    }
+    index_[hole] = IndexSlot{0, INVALID_INDEX};
+}
+
+// MatchingEngine implementation
+MatchingEngine::MatchingEngine(const OrderBookConfig& config)
+    : config_(config), listener_(nullptr), book_count_(0) {}
+
+void MatchingEngine::set_fill_listener(IFillListener* listener) {
+    listener_ = listener;
+    for (auto& book : books_) {
+        if (book) {
+            book->set_fill_listener(listener);
+        }
+    }
+}
+
+OrderResult MatchingEngine::submit_order(InstrumentId instrument, std::string_view symbol, uint64_t order_id,
+                                         OrderSide side, OrderType type, TimeInForce tif, uint64_t price,
+                                         uint32_t quantity, uint64_t owner) {
+    OrderBook* book = find_book(instrument);
+    if (!book) {
+        if (instrument == NO_INSTRUMENT) {
+            return OrderResult::REJECTED_UNKNOWN_INSTRUMENT;
+        }
+        if (!valid_order(order_id, side, tif, quantity)) {
+            return OrderResult::REJECTED_INVALID;     // Before a book is created for it
+        }
+        if (type == OrderType::MARKET) {
+            // Nothing to trade against and no price to centre a ladder on
+            return tif == TimeInForce::FOK ? OrderResult::REJECTED_FOK : OrderResult::CANCELLED;
+        }
+        book = create_book(instrument, symbol, price);
+    }
+    return book->add_order(order_id, side, type, tif, price, quantity, owner);
+}
+
+OrderResult MatchingEngine::cancel_order(InstrumentId instrument, uint64_t order_id, uint64_t owner) {
+    OrderBook* book = find_book(instrument);
+    return book ? book->cancel_order(order_id, owner) : OrderResult::UNKNOWN_ORDER;
+}
+
+OrderResult MatchingEngine::replace_order(InstrumentId instrument, uint64_t order_id, uint64_t price,
+                                          uint32_t quantity, uint64_t owner) {
+    OrderBook* book = find_book(instrument);
+    return book ? book->replace_order(order_id, price, quantity, owner) : OrderResult::UNKNOWN_ORDER;
+}
+
+OrderResult MatchingEngine::submit_order(const OrderMessage& order, uint64_t owner) {
+    return submit_order(order.instrument, symbol_view(order.symbol.data(), order.symbol.size()),
+                        order.order_id, order.side, order.order_type, order.time_in_force, order.price,
+                        order.quantity, owner);
+}
+
+OrderResult MatchingEngine::cancel_order(const OrderMessage& cancel, uint64_t owner) {
+    return cancel_order(cancel.instrument, cancel.order_id, owner);
+}
+
+OrderResult MatchingEngine::replace_order(const OrderMessage& replace, uint64_t owner) {
+    return replace_order(replace.instrument, replace.order_id, replace.price, replace.quantity, owner);
+}
+
+uint32_t MatchingEngine::open_quantity(InstrumentId instrument, uint64_t order_id, uint64_t owner) const {
+    const OrderBook* book = instrument < books_.size() ? books_[instrument].get() : nullptr;
+    return book ? book->open_quantity(order_id, owner) : 0;
+}
+
+size_t MatchingEngine::cancel_all(uint64_t owner) {
+    OwnerIndex::Ref head = owners_.head(owner);
+    return head.book ? head.book->cancel_all(owner) : 0;
+}
+
+void MatchingEngine::configure_book(InstrumentId instrument, const OrderBookConfig& config) {
+    book_configs_[instrument] = config;
+}
+
+size_t MatchingEngine::resting_orders() const {
+    size_t resting = 0;
+    for (const auto& book : books_) {
+        if (book) {
+            resting += book->resting_orders();
+        }
+    }
+    return resting;
+}
+
+std::string_view MatchingEngine::symbol_view(const char* symbol, size_t capacity) {
+    return std::string_view(symbol, strnlen(symbol, capacity));
+}
+
+OrderBook* MatchingEngine::create_book(InstrumentId instrument, std::string_view symbol, uint64_t reference_price) {
+    // Ids are dense, so the array only grows as far as the directory does
+    if (instrument >= books_.size()) {
+        books_.resize(static_cast<size_t>(instrument) + 1);
+    }
+
+    auto configured = book_configs_.find(instrument);
+    const OrderBookConfig& config = configured != book_configs_.end() ? configured->second : config_;
+
+    // Centre the ladder on the first price seen for the instrument, unless its range is known
+    uint64_t base_price = config.base_price;
+    if (base_price == OrderBookConfig::CENTRED) {
+        uint64_t half = config.price_levels / 2;
+        base_price = reference_price > half ? reference_price - half : 0;
+    }
+    books_[instrument] = std::make_unique<OrderBook>(instrument, symbol, base_price, config, listener_, &owners_);
+    ++book_count_;
+    return books_[instrument].get();
+}
+
+} // namespace hft
@@ -0,0 +1,337 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include "message.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Outcome of submitting, cancelling or replacing an order
+ */
+enum class OrderResult : uint8_t {
+    ACCEPTED = 0x01,           // Rested on the book without trading
+    FILLED = 0x02,             // Fully executed
+    PARTIALLY_FILLED = 0x03,   // Traded and the remainder rests on the book
+    CANCELLED = 0x04,          // Cancel succeeded, or IOC/MARKET remainder expired
+    REPLACED = 0x05,           // Quantity reduced in place, priority kept
+    REJECTED_INVALID = 0x10,   // Zero quantity or order id, unknown side or time in force
+    REJECTED_UNSUPPORTED = 0x11, // Order type not handled by the engine
+    REJECTED_PRICE_BAND = 0x12, // Price outside the book's tick ladder
+    REJECTED_DUPLICATE_ID = 0x13,
+    REJECTED_BOOK_FULL = 0x14,
+    REJECTED_FOK = 0x15,       // Fill-or-kill could not be filled completely
+    UNKNOWN_ORDER = 0x16,      // Cancel/replace for an order not resting under this owner
+    REJECTED_RISK_SIZE = 0x17, // Pre-trade risk: quantity above the per-order limit
+    REJECTED_RISK_NOTIONAL = 0x18,
+    REJECTED_RISK_PRICE = 0x19, // Pre-trade risk: too far from the last market data
+    REJECTED_RISK_POSITION = 0x1A,
+    REJECTED_RISK_THROTTLE = 0x1B, // Pre-trade risk: client over its order rate
+    REJECTED_UNKNOWN_INSTRUMENT = 0x1C, // Symbol not in the instrument master
+    REJECTED_TICK_SIZE = 0x1D, // Price not a multiple of the instrument's tick
+    REJECTED_LOT_SIZE = 0x1E,  // Quantity not a multiple of the instrument's lot
+    REJECTED_PRICE_LIMIT = 0x1F // Price outside the instrument's static limits
+};
+
+inline bool is_rejected(OrderResult result) {
+    return static_cast<uint8_t>(result) >= static_cast<uint8_t>(OrderResult::REJECTED_INVALID);
+}
+
+const char* order_result_name(OrderResult result);
+
+/**
+ * @brief Receives executions produced by the matching engine
+ *
+ * owner is the opaque token supplied when the order was submitted; the
+ * servers use it to find the connection that owns the order.
+ */
+class IFillListener {
+public:
+    virtual ~IFillListener() = default;
+    virtual void on_fill(const FillMessage& fill, uint64_t owner) = 0;
+
+    /**
+     * @brief Quantity resting for owner changed: positive when an order rests,
+     * negative when resting quantity trades, is cancelled or is reduced
+     */
+    virtual void on_resting(InstrumentId, OrderSide, int64_t /*change*/, uint64_t /*owner*/) {}
+};
+
+/**
+ * @brief Sizing for a single instrument's book; all memory is allocated up front
+ */
+struct OrderBookConfig {
+    static constexpr uint64_t CENTRED = UINT64_MAX;
+
+    uint32_t price_levels = 1 << 16;   // Ticks covered by the price ladder
+    uint32_t max_orders = 1 << 16;     // Resting order capacity
+    uint64_t base_price = CENTRED;     // Price of the lowest level; CENTRED = around the first order
+    std::pmr::memory_resource* memory = nullptr; // Ladder, order pool and index; null = heap
+};
+
+class OrderBook;
+
+/**
+ * @brief Head of each owner's list of resting orders, shared by an engine's books
+ *
+ * The lists themselves are intrusive, threaded through the books' order
+ * nodes, so cancelling everything an owner has resting visits only those
+ * orders. Open addressing keyed by owner at no more than 50% load; the
+ * table doubles when a new peak of owners with resting orders would pass
+ * that, which is the only time it allocates.
+ */
+class OwnerIndex {
+public:
+    struct Ref {
+        OrderBook* book = nullptr;     // Null: no order
+        uint32_t node = 0;
+    };
+
+    OwnerIndex();
+
+    Ref head(uint64_t owner) const;
+
+    /**
+     * @brief Make head the first order of owner's list; a null book removes the owner
+     */
+    void set_head(uint64_t owner, Ref head);
+
+private:
+    struct Slot {
+        uint64_t owner = 0;
+        Ref head;                      // Null book marks an empty slot
+    };
+
+    size_t slot_of(uint64_t owner) const {
+        return static_cast<size_t>((owner * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+    void grow();
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    uint32_t shift_ = 0;
+    size_t count_ = 0;
+};
+
+/**
+ * @brief Price-time priority limit order book for one instrument
+ *
+ * Prices map to a flat array of levels indexed by tick offset from
+ * base_price. Each level is an intrusive FIFO of order nodes taken from a
+ * preallocated pool, and an open-addressing hash map resolves order ids to
+ * pool slots. A bitmap of non-empty levels lets the best bid/ask advance
+ * over gaps a word at a time. Nothing on the add/cancel/match path allocates.
+ *
+ * Bids always sit strictly below asks, so a single level array serves both
+ * sides: every order resting at a level is on the same side.
+ */
+class OrderBook {
+public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    /**
+     * @brief owners is shared with the other books of an engine; null gives the book its own
+     */
+    OrderBook(InstrumentId instrument, std::string_view symbol, uint64_t base_price,
+              const OrderBookConfig& config, IFillListener* listener, OwnerIndex* owners = nullptr);
+
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
+
+    /**
+     * @brief Match an incoming order and rest any remainder its time in force allows
+     */
+    OrderResult add_order(uint64_t order_id, OrderSide side, OrderType type, TimeInForce tif,
+                          uint64_t price, uint32_t quantity, uint64_t owner);
+
+    /**
+     * @brief Remove a resting order owned by owner
+     */
+    OrderResult cancel_order(uint64_t order_id, uint64_t owner);
+
+    /**
+     * @brief Change price and/or quantity of a resting order
+     *
+     * Reducing quantity at the same price keeps time priority; any other
+     * change re-enters the order at the back of its new level and may trade.
+     */
+    OrderResult replace_order(uint64_t order_id, uint64_t price, uint32_t quantity, uint64_t owner);
+
+    /**
+     * @brief Cancel every resting order belonging to owner (cancel-on-disconnect)
+     *
+     * Covers every book sharing this book's OwnerIndex, in time proportional
+     * to the orders cancelled.
+     */
+    size_t cancel_all(uint64_t owner);
+
+    /**
+     * @brief Quantity still resting of owner's order; 0 if it is not on the book
+     */
+    uint32_t open_quantity(uint64_t order_id, uint64_t owner) const;
+
+    void set_fill_listener(IFillListener* listener) { listener_ = listener; }
+
+    bool has_bid() const { return best_bid_ != INVALID_INDEX; }
+    bool has_ask() const { return best_ask_ != INVALID_INDEX; }
+    uint64_t best_bid_price() const { return has_bid() ? base_price_ + best_bid_ : 0; }
+    uint64_t best_ask_price() const { return has_ask() ? base_price_ + best_ask_ : 0; }
+    uint64_t quantity_at(uint64_t price) const;
+    size_t resting_orders() const { return resting_orders_; }
+    uint64_t base_price() const { return base_price_; }
+    uint32_t price_levels() const { return price_levels_; }
+    std::string_view symbol() const { return std::string_view(symbol_.data(), symbol_length_); }
+    InstrumentId instrument() const { return instrument_; }
+
+    bool in_band(uint64_t price) const {
+        return price >= base_price_ && price - base_price_ < price_levels_;
+    }
+
+private:
+    struct OrderNode {
+        uint64_t order_id;
+        uint64_t owner;
+        uint32_t quantity;
+        uint32_t level;
+        uint32_t prev;
+        uint32_t next;
+        OrderSide side;
+        OwnerIndex::Ref owner_prev;    // Owner's list, across the engine's books
+        OwnerIndex::Ref owner_next;
+    };
+
+    struct PriceLevel {
+        uint64_t total_quantity;
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    struct IndexSlot {
+        uint64_t order_id;     // 0 marks an empty slot
+        uint32_t node;
+    };
+
+    uint32_t match(OrderSide side, uint32_t limit_level, uint32_t quantity,
+                   uint64_t order_id, uint64_t owner);
+    bool can_fill(OrderSide side, uint32_t limit_level, uint32_t quantity) const;
+    OrderResult rest(uint64_t order_id, OrderSide side, uint32_t level, uint32_t quantity, uint64_t owner);
+    void remove_node(uint32_t node_index);
+    void link_owner(uint32_t node_index);
+    void unlink_owner(uint32_t node_index);
+    void emit_fill(uint64_t order_id, uint64_t owner, OrderSide side, uint64_t fill_id,
+                   uint32_t quantity, uint64_t price, uint64_t timestamp);
+    void emit_resting(const OrderNode& node, int64_t change) {
+        if (listener_) {
+            listener_->on_resting(instrument_, node.side, change, node.owner);
+        }
+    }
+
+    uint32_t next_level_above(uint32_t level) const;
+    uint32_t next_level_below(uint32_t level) const;
+
+    uint32_t index_find(uint64_t order_id) const;
+    bool index_insert(uint64_t order_id, uint32_t node);
+    void index_erase(uint64_t order_id);
+    size_t index_slot(uint64_t order_id) const {
+        return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ULL) >> index_shift_);
+    }
+
+    InstrumentId instrument_;
+    std::array<char, 16> symbol_;
+    size_t symbol_length_;
+    uint64_t base_price_;
+    uint32_t price_levels_;
+
+    std::pmr::vector<PriceLevel> levels_;
+    std::pmr::vector<uint64_t> level_bitmap_;
+    uint32_t best_bid_;
+    uint32_t best_ask_;
+
+    std::pmr::vector<OrderNode> nodes_;
+    uint32_t free_head_;
+    size_t resting_orders_;
+
+    std::pmr::vector<IndexSlot> index_;
+    size_t index_mask_;
+    uint32_t index_shift_;
+
+    uint64_t next_fill_id_;
+    IFillListener* listener_;
+    std::unique_ptr<OwnerIndex> own_owners_;   // Standalone books only
+    OwnerIndex* owners_;
+};
+
+/**
+ * @brief Per-instrument collection of order books
+ *
+ * Books sit in an array indexed by instrument id, so finding one is a
+ * bounds check and a load. A book is created on the first order for its
+ * instrument, sized by the configuration given for that instrument or else
+ * the engine's, with the ladder centred on that order's price unless the
+ * configuration fixes its base; the symbol is only read then, to stamp the
+ * book's fills. The books share one OwnerIndex, so cancel_all() touches
+ * only the owner's orders. Callers serialise access; the engine itself
+ * takes no locks.
+ */
+class MatchingEngine {
+public:
+    explicit MatchingEngine(const OrderBookConfig& config = OrderBookConfig{});
+
+    // Books point at the engine's owner index
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    /**
+     * @brief Size an instrument's book; takes effect if the book does not exist yet
+     */
+    void configure_book(InstrumentId instrument, const OrderBookConfig& config);
+
+    void set_fill_listener(IFillListener* listener);
+
+    OrderResult submit_order(InstrumentId instrument, std::string_view symbol, uint64_t order_id,
+                             OrderSide side, OrderType type, TimeInForce tif, uint64_t price,
+                             uint32_t quantity, uint64_t owner);
+    OrderResult cancel_order(InstrumentId instrument, uint64_t order_id, uint64_t owner);
+    OrderResult replace_order(InstrumentId instrument, uint64_t order_id, uint64_t price,
+                              uint32_t quantity, uint64_t owner);
+
+    OrderResult submit_order(const OrderMessage& order, uint64_t owner);
+    OrderResult cancel_order(const OrderMessage& cancel, uint64_t owner);
+    OrderResult replace_order(const OrderMessage& replace, uint64_t owner);
+
+    size_t cancel_all(uint64_t owner);
+    uint32_t open_quantity(InstrumentId instrument, uint64_t order_id, uint64_t owner) const;
+
+    OrderBook* find_book(InstrumentId instrument) {
+        return instrument < books_.size() ? books_[instrument].get() : nullptr;
+    }
+    size_t book_count() const { return book_count_; }
+    size_t resting_orders() const;
+
+    /**
+     * @brief Symbol text of a fixed-size, NUL-padded symbol field
+     */
+    static std::string_view symbol_view(const char* symbol, size_t capacity);
+
+private:
+    OrderBook* create_book(InstrumentId instrument, std::string_view symbol, uint64_t reference_price);
+
+    OrderBookConfig config_;
+    std::unordered_map<InstrumentId, OrderBookConfig> book_configs_; // Overrides of config_
+    IFillListener* listener_;
+    std::vector<std::unique_ptr<OrderBook>> books_;   // By instrument id; null until its first order
+    size_t book_count_;
+    OwnerIndex owners_;
+};
+
+} // namespace hft
+
+#endif // ORDER_BOOK_H
@@ -0,0 +1,140 @@
+#ifndef OUTBOUND_QUEUE_H
+#define OUTBOUND_QUEUE_H
+
+#include "transport.h"
+#include <errno.h>
+#include <sys/socket.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace hft {
+
+/**
+ * @brief Backpressure marks for bytes waiting on a slow reader
+ *
+ * Above high_water a connection is congested: the server stops reading its
+ * requests until the backlog falls to half the mark, so a client that does
+ * not read its acks cannot keep generating them. A backlog past limit cuts
+ * the client off (its socket is shut down) instead of dropping frames out
+ * of the middle of its stream.
+ */
+struct OutboundLimits {
+    uint32_t high_water = 256 * 1024;
+    uint32_t limit = 4 * 1024 * 1024;
+};
+
+/**
+ * @brief Responses waiting to be written to one socket
+ *
+ * Frames are appended back to back during an event loop pass, so a single
+ * send at the end of the pass carries all of them. A partial write keeps
+ * the unsent tail at the front, ahead of anything appended later: frames
+ * are never torn or lost while the socket pushes back.
+ *
+ * Not thread-safe; the owner serialises access.
+ */
+class OutboundQueue {
+public:
+    enum class Result : uint8_t {
+        DRAINED,      // Everything written
+        BLOCKED,      // The socket is full; wait for it to become writable
+        FAILED        // The socket is broken; the queued bytes were discarded
+    };
+    
+    static constexpr size_t INITIAL_CAPACITY = 4096;
+    
+    OutboundQueue() = default;
+    OutboundQueue(const OutboundQueue&) = delete;
+    OutboundQueue& operator=(const OutboundQueue&) = delete;
+    
+    /**
+     * @brief Space for length bytes at the tail; commit() what was written
+     */
+    uint8_t* reserve(size_t length) {
+        if (capacity_ - tail_ < length) {
+            make_room(length);
+        }
+        return storage_.get() + tail_;
+    }
+    
+    void commit(size_t length) noexcept {
+        tail_ += length;
+    }
+    
+    void append(const void* data, size_t length) {
+        memcpy(reserve(length), data, length);
+        commit(length);
+    }
+    
+    size_t size() const noexcept { return tail_ - head_; }
+    bool empty() const noexcept { return head_ == tail_; }
+    
+    /**
+     * @brief Drop everything queued, keeping the storage
+     */
+    void clear() noexcept {
+        head_ = 0;
+        tail_ = 0;
+    }
+    
+    /**
+     * @brief Write as much as the socket takes, through transport as cookie's bytes or directly when null
+     */
+    Result flush(int fd, uint64_t cookie, Transport* transport) {
+        while (head_ < tail_) {
+            size_t length = tail_ - head_;
+            ssize_t written = transport ? transport->send(fd, cookie, storage_.get() + head_, length)
+                                        : ::send(fd, storage_.get() + head_, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return Result::BLOCKED;
+                }
+                clear();
+                return Result::FAILED;
+            }
+            
+            head_ += static_cast<size_t>(written);
+            if (static_cast<size_t>(written) < length) {
+                return Result::BLOCKED; // Socket buffer full
+            }
+        }
+        clear();
+        return Result::DRAINED;
+    }
+
+private:
+    void make_room(size_t length) {
+        // Slide the unsent tail to the front before growing
+        size_t queued = tail_ - head_;
+        if (head_ > 0 && capacity_ - queued >= length) {
+            memmove(storage_.get(), storage_.get() + head_, queued);
+        } else {
+            size_t capacity = capacity_ ? capacity_ : INITIAL_CAPACITY;
+            while (capacity - queued < length) {
+                capacity *= 2;
+            }
+            std::unique_ptr<uint8_t[]> storage(new uint8_t[capacity]);
+            if (queued > 0) {
+                memcpy(storage.get(), storage_.get() + head_, queued);
+            }
+            storage_ = std::move(storage);
+            capacity_ = capacity;
+        }
+        head_ = 0;
+        tail_ = queued;
+    }
+    
+    std::unique_ptr<uint8_t[]> storage_;
+    size_t capacity_ = 0;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
+
+} // namespace hft
+
+#endif // OUTBOUND_QUEUE_H
@@ -0,0 +1,237 @@
+#include "lock_free_queue.h"
+#include "thread_affinity.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ultra_hft {
+
+// Queue sizes and payload match the server's pipeline rings
+constexpr size_t BENCH_QUEUE_SIZE = 4096;
+constexpr size_t BENCH_BATCH = 64;
+
+struct alignas(64) BenchItem {
+    uint64_t sequence;
+    uint64_t producer;
+    uint8_t payload[48];
+};
+
+struct BenchOptions {
+    uint64_t items = 10000000;
+    std::vector<int> producer_cpus;
+    std::vector<int> consumer_cpus;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --items <n>              Items per run (default: 10000000)" << std::endl;
+    std::cout << "  --producer-cpus <list>   Pin producer threads to CPUs, e.g. 2,3" << std::endl;
+    std::cout << "  --consumer-cpus <list>   Pin consumer threads to CPUs" << std::endl;
+    std::cout << "  --help                   Show this help message" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--items") == 0 && i + 1 < argc) {
+            options.items = std::strtoull(argv[++i], nullptr, 10);
+            if (options.items == 0) {
+                std::cerr << "Invalid item count" << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--producer-cpus") == 0 && i + 1 < argc) {
+            if (!hft::parse_cpu_list(argv[++i], options.producer_cpus)) {
+                std::cerr << "Invalid CPU list: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--consumer-cpus") == 0 && i + 1 < argc) {
+            if (!hft::parse_cpu_list(argv[++i], options.consumer_cpus)) {
+                std::cerr << "Invalid CPU list: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void pin(const std::vector<int>& cpus, size_t index) {
+    if (!cpus.empty()) {
+        hft::pin_current_thread(cpus[index % cpus.size()]);
+    }
+}
+
+// The consumer checks per-producer ordering so a broken queue cannot post a good number
+struct BenchResult {
+    double ns_per_item = 0.0;
+    bool ordered = true;
+};
+
+template<typename Queue, typename ProduceFn, typename ConsumeFn>
+BenchResult run_benchmark(const BenchOptions& options, int producers, int consumers,
+                          ProduceFn produce, ConsumeFn consume) {
+    auto queue = std::make_unique<Queue>();
+    uint64_t per_producer = options.items / producers;
+    uint64_t total = per_producer * producers;
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<bool> ordered{true};
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            pin(options.producer_cpus, p);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {}
+            produce(*queue, static_cast<uint64_t>(p), per_producer);
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            pin(options.consumer_cpus, c);
+            std::vector<uint64_t> last(producers, 0);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {}
+            
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                size_t n = consume(*queue, [&](const BenchItem& item) {
+                    // Multiple consumers may interleave, so only single-consumer runs check order
+                    if (consumers == 1 && item.sequence != ++last[item.producer]) {
+                        ordered.store(false, std::memory_order_relaxed);
+                    }
+                });
+                if (n > 0) {
+                    consumed.fetch_add(n, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    
+    while (ready.load() < producers + consumers) {}
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    BenchResult result;
+    result.ns_per_item = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / total;
+    result.ordered = ordered.load();
+    return result;
+}
+
+// Producers spin on a full queue, yielding so single-CPU hosts still make progress
+template<typename Queue>
+void produce_single(Queue& queue, uint64_t producer, uint64_t count) {
+    BenchItem item{};
+    item.producer = producer;
+    for (uint64_t i = 1; i <= count; ++i) {
+        item.sequence = i;
+        while (!queue.push(item)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template<typename Queue>
+void produce_bulk(Queue& queue, uint64_t producer, uint64_t count) {
+    BenchItem batch[BENCH_BATCH];
+    uint64_t next = 1;
+    while (next <= count) {
+        size_t n = count - next + 1 < BENCH_BATCH ? count - next + 1 : BENCH_BATCH;
+        for (size_t i = 0; i < n; ++i) {
+            batch[i].producer = producer;
+            batch[i].sequence = next + i;
+        }
+        
+        size_t pushed = 0;
+        while (pushed < n) {
+            size_t step = queue.push_bulk(batch + pushed, n - pushed);
+            if (step == 0) {
+                std::this_thread::yield();
+            }
+            pushed += step;
+        }
+        next += n;
+    }
+}
+
+template<typename Queue, typename Fn>
+size_t consume_single(Queue& queue, Fn&& fn) {
+    BenchItem item;
+    if (!queue.pop(item)) {
+        return 0;
+    }
+    fn(item);
+    return 1;
+}
+
+template<typename Queue, typename Fn>
+size_t consume_bulk(Queue& queue, Fn&& fn) {
+    return queue.consume_bulk(fn, BENCH_BATCH);
+}
+
+void report(const char* name, const BenchResult& result) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << result.ns_per_item << " ns/item"
+              << std::setw(12) << std::setprecision(1) << 1000.0 / result.ns_per_item << " M items/s"
+              << (result.ordered ? "" : "  ORDER VIOLATION") << std::endl;
+}
+
+} // namespace ultra_hft
+
+int main(int argc, char* argv[]) {
+    using namespace ultra_hft;
+    
+    BenchOptions options;
+    if (!parse_arguments(argc, argv, options)) {
+        return 1;
+    }
+    
+    using Spsc = LockFreeRingBuffer<BenchItem, BENCH_QUEUE_SIZE>;
+    using Mpsc = MPSCRingBuffer<BenchItem, BENCH_QUEUE_SIZE>;
+    using Mpmc = MPMCRingBuffer<BenchItem, BENCH_QUEUE_SIZE>;
+    
+    auto single = [](auto& queue, auto&& fn) { return consume_single(queue, fn); };
+    auto bulk = [](auto& queue, auto&& fn) { return consume_bulk(queue, fn); };
+    
+    std::cout << "Queue benchmark: " << options.items << " items of " << sizeof(BenchItem)
+              << " bytes, queue size " << BENCH_QUEUE_SIZE << ", batch " << BENCH_BATCH << std::endl;
+    if (std::thread::hardware_concurrency() < 2) {
+        std::cout << "  (single CPU: threads time-share, figures exclude cross-core traffic)" << std::endl;
+    }
+    
+    bool ordered = true;
+    auto track = [&ordered](const char* name, const BenchResult& result) {
+        report(name, result);
+        ordered = ordered && result.ordered;
+    };
+    
+    track("SPSC push/pop", run_benchmark<Spsc>(options, 1, 1, produce_single<Spsc>, single));
+    track("SPSC push_bulk/consume_bulk", run_benchmark<Spsc>(options, 1, 1, produce_bulk<Spsc>, bulk));
+    track("MPSC 1 producer, consume_bulk", run_benchmark<Mpsc>(options, 1, 1, produce_single<Mpsc>, bulk));
+    track("MPSC 2 producers, consume_bulk", run_benchmark<Mpsc>(options, 2, 1, produce_single<Mpsc>, bulk));
+    track("MPMC 1 producer, 1 consumer", run_benchmark<Mpmc>(options, 1, 1, produce_single<Mpmc>, single));
+    track("MPMC 2 producers, 2 consumers", run_benchmark<Mpmc>(options, 2, 2, produce_single<Mpmc>, single));
+    
+    return ordered ? 0 : 1;
+}
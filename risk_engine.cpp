@@ -0,0 +1,314 @@
+#include "risk_engine.h"
+#include "server_counters.h"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace hft {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parse_limit(std::string_view text, uint64_t max, uint64_t& value) {
+    if (text.empty() || text.front() < '0' || text.front() > '9') {
+        return false;
+    }
+    std::string digits(text);
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(digits.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || parsed > max) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+bool load_risk_limits(const std::string& path, RiskLimits& limits) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open risk limits " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    RiskLimits parsed = limits;
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        std::string_view text = line;
+        text = trim(text.substr(0, text.find('#')));
+        if (text.empty()) {
+            continue;
+        }
+
+        size_t equals = text.find('=');
+        if (equals == std::string_view::npos) {
+            std::cerr << path << ":" << number << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string_view key = trim(text.substr(0, equals));
+        std::string_view value_text = trim(text.substr(equals + 1));
+
+        uint64_t value = 0;
+        bool ok;
+        if (key == "max_order_quantity") {
+            ok = parse_limit(value_text, UINT32_MAX, value);
+            parsed.max_order_quantity = static_cast<uint32_t>(value);
+        } else if (key == "max_order_notional") {
+            ok = parse_limit(value_text, UINT64_MAX, value);
+            parsed.max_order_notional = value;
+        } else if (key == "price_band_bps") {
+            ok = parse_limit(value_text, UINT32_MAX, value);
+            parsed.price_band_bps = static_cast<uint32_t>(value);
+        } else if (key == "max_position") {
+            ok = parse_limit(value_text, INT64_MAX, value);
+            parsed.max_position = value;
+        } else if (key == "max_orders_per_second") {
+            ok = parse_limit(value_text, 1000000000, value);
+            parsed.max_orders_per_second = static_cast<uint32_t>(value);
+        } else if (key == "order_burst") {
+            ok = parse_limit(value_text, UINT32_MAX, value);
+            parsed.order_burst = static_cast<uint32_t>(value);
+        } else {
+            std::cerr << path << ":" << number << ": unknown risk limit '" << key << "'" << std::endl;
+            return false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << number << ": invalid value for " << key << std::endl;
+            return false;
+        }
+    }
+
+    limits = parsed;
+    return true;
+}
+
+// RiskLimitsStore implementation
+RiskLimitsStore::RiskLimitsStore(const RiskLimits& limits) {
+    versions_.push_back(std::make_unique<RiskLimits>(limits));
+    current_.store(versions_.back().get(), std::memory_order_release);
+}
+
+void RiskLimitsStore::publish(const RiskLimits& limits) {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    versions_.push_back(std::make_unique<RiskLimits>(limits));
+    current_.store(versions_.back().get(), std::memory_order_release);
+}
+
+// RiskEngine implementation
+RiskEngine::RiskEngine(const RiskConfig& config, std::shared_ptr<const RiskLimitsStore> limits,
+                       std::shared_ptr<const MarketStateCache> market)
+    : config_(config),
+      limits_(std::move(limits)),
+      market_(std::move(market)) {
+    config_.symbols_per_client = std::max<uint32_t>(config_.symbols_per_client, 1);
+
+    size_t states = static_cast<size_t>(config_.max_clients) + config_.max_accounts;
+    bindings_.reset(new Binding[config_.max_clients]);
+    states_.reset(new State[states]);
+    positions_.reset(new Position[states * config_.symbols_per_client]);
+
+    // Size the account index to at most 50% load
+    size_t account_slots = std::bit_ceil(std::max<size_t>(static_cast<size_t>(config_.max_accounts) * 2, 16));
+    accounts_.reset(new AccountSlot[account_slots]);
+    account_mask_ = account_slots - 1;
+}
+
+OrderResult RiskEngine::check_order(uint32_t client, uint64_t session, uint64_t account, InstrumentId instrument,
+                                    OrderSide side, uint64_t price, uint32_t quantity, uint32_t replaced,
+                                    uint64_t now_ns) {
+    const RiskLimits& limits = limits_->current();
+    bump(checked_);
+
+    uint32_t state_index = client < config_.max_clients ? bind(client, session, account) : NO_STATE;
+    if (state_index == NO_STATE) {
+        bump(rejected_position_);
+        return OrderResult::REJECTED_RISK_POSITION;
+    }
+    State& state = states_[state_index];
+
+    if (!throttle(state, limits, now_ns)) {
+        bump(rejected_throttle_);
+        return OrderResult::REJECTED_RISK_THROTTLE;
+    }
+
+    if (limits.max_order_quantity != 0 && quantity > limits.max_order_quantity) {
+        bump(rejected_quantity_);
+        return OrderResult::REJECTED_RISK_SIZE;
+    }
+
+    bool tracked = instrument < config_.max_symbols;
+    uint64_t reference = market_->reference_price(instrument);
+
+    // Market orders are valued at the reference; unknown until market data arrives
+    uint64_t value_price = price != 0 ? price : reference;
+    if (limits.max_order_notional != 0 && quantity != 0 &&
+        value_price > limits.max_order_notional / quantity) {
+        bump(rejected_notional_);
+        return OrderResult::REJECTED_RISK_NOTIONAL;
+    }
+
+    if (limits.price_band_bps != 0 && price != 0 && reference != 0) {
+        uint64_t distance = price > reference ? price - reference : reference - price;
+        if (static_cast<unsigned __int128>(distance) * 10000 >
+            static_cast<unsigned __int128>(reference) * limits.price_band_bps) {
+            bump(rejected_price_);
+            return OrderResult::REJECTED_RISK_PRICE;
+        }
+    }
+
+    if (limits.max_position != 0) {
+        Position* position = tracked ? find_position(state_index, instrument, false) : nullptr;
+        Position current = position ? *position : Position{};
+
+        // Worst case on the order's side: it and everything working there fills
+        int64_t added = static_cast<int64_t>(quantity) - replaced;
+        int64_t exposure = side == OrderSide::BUY ? current.quantity + current.buying + added
+                                                  : current.selling + added - current.quantity;
+
+        // Fills and resting orders need a slot to be tracked in; refuse rather than lose them
+        bool trackable = position || (tracked && find_position(state_index, instrument, true));
+        if (exposure > static_cast<int64_t>(limits.max_position) || !trackable) {
+            bump(rejected_position_);
+            return OrderResult::REJECTED_RISK_POSITION;
+        }
+    }
+
+    return OrderResult::ACCEPTED;
+}
+
+void RiskEngine::on_fill(uint32_t client, uint64_t session, InstrumentId instrument, OrderSide side,
+                         uint32_t quantity) {
+    uint32_t state = bound_state(client, session);
+    if (state == NO_STATE || instrument >= config_.max_symbols) {
+        return;
+    }
+
+    Position* position = find_position(state, instrument, true);
+    if (position) {
+        position->quantity += side == OrderSide::BUY ? quantity : -static_cast<int64_t>(quantity);
+    }
+}
+
+void RiskEngine::on_resting(uint32_t client, uint64_t session, InstrumentId instrument, OrderSide side,
+                            int64_t change) {
+    uint32_t state = bound_state(client, session);
+    if (state == NO_STATE || instrument >= config_.max_symbols) {
+        return;
+    }
+
+    Position* position = find_position(state, instrument, true);
+    if (position) {
+        // Orders sent before a login rested on the connection's own state, so
+        // the account they now count against may see more leave than arrived
+        int64_t& working = side == OrderSide::BUY ? position->buying : position->selling;
+        working = std::max<int64_t>(working + change, 0);
+    }
+}
+
+RiskStats RiskEngine::stats() const {
+    RiskStats stats;
+    stats.checked = checked_.load(std::memory_order_relaxed);
+    stats.rejected_quantity = rejected_quantity_.load(std::memory_order_relaxed);
+    stats.rejected_notional = rejected_notional_.load(std::memory_order_relaxed);
+    stats.rejected_price = rejected_price_.load(std::memory_order_relaxed);
+    stats.rejected_position = rejected_position_.load(std::memory_order_relaxed);
+    stats.rejected_throttle = rejected_throttle_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint32_t RiskEngine::bind(uint32_t client, uint64_t session, uint64_t account) {
+    Binding& binding = bindings_[client];
+    if (binding.session == session && binding.account == account && binding.state != NO_STATE) {
+        return binding.state;
+    }
+
+    uint32_t state;
+    if (account == NO_ACCOUNT) {
+        state = client;
+        if (binding.session != session) {
+            // A new connection in a reused slot starts flat and unthrottled
+            states_[state] = State{};
+            Position* positions = &positions_[static_cast<size_t>(state) * config_.symbols_per_client];
+            std::fill(positions, positions + config_.symbols_per_client, Position{});
+        }
+    } else {
+        state = account_state(account);
+    }
+    binding = Binding{session, account, state};
+    return state;
+}
+
+uint32_t RiskEngine::bound_state(uint32_t client, uint64_t session) const {
+    if (client >= config_.max_clients || bindings_[client].session != session) {
+        return NO_STATE;
+    }
+    return bindings_[client].state;
+}
+
+uint32_t RiskEngine::account_state(uint64_t account) {
+    for (size_t slot = (account * 0x9E3779B97F4A7C15ULL) & account_mask_;; slot = (slot + 1) & account_mask_) {
+        AccountSlot& entry = accounts_[slot];
+        if (entry.account == account) {
+            return entry.state;
+        }
+        if (entry.account == NO_ACCOUNT) {
+            if (account_count_ >= config_.max_accounts) {
+                return NO_STATE;
+            }
+            entry.account = account;
+            entry.state = config_.max_clients + account_count_++;
+            return entry.state;
+        }
+    }
+}
+
+RiskEngine::Position* RiskEngine::find_position(uint32_t state, InstrumentId instrument, bool create) {
+    Position* positions = &positions_[static_cast<size_t>(state) * config_.symbols_per_client];
+    Position* free_slot = nullptr;
+    for (uint32_t i = 0; i < config_.symbols_per_client; ++i) {
+        if (positions[i].instrument == instrument) {
+            return &positions[i];
+        }
+        if (!free_slot && (positions[i].instrument == NO_INSTRUMENT || positions[i].empty())) {
+            free_slot = &positions[i];
+        }
+    }
+    if (!create || !free_slot) {
+        return nullptr;
+    }
+    *free_slot = Position{instrument, 0, 0, 0};
+    return free_slot;
+}
+
+bool RiskEngine::throttle(State& state, const RiskLimits& limits, uint64_t now_ns) {
+    if (limits.max_orders_per_second == 0) {
+        return true;
+    }
+
+    // GCRA: each order moves the theoretical arrival time one interval on;
+    // orders may run ahead of it by up to the burst
+    uint64_t interval = 1000000000ULL / limits.max_orders_per_second;
+    uint64_t tolerance = interval * limits.order_burst;
+    if (state.next_allowed_ns > now_ns + tolerance) {
+        return false;
+    }
+    state.next_allowed_ns = std::max(state.next_allowed_ns, now_ns) + interval;
+    return true;
+}
+
+} // namespace hft
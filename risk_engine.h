@@ -0,0 +1,211 @@
+#ifndef RISK_ENGINE_H
+#define RISK_ENGINE_H
+
+#include "market_state.h"
+#include "message.h"
+#include "order_book.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Pre-trade limits; a zero disables the check
+ *
+ * Notional is price times quantity in ticks. Positions are net filled
+ * quantity per account and symbol; an order is checked as if it and every
+ * order the account has working on the same side filled completely.
+ */
+struct RiskLimits {
+    uint32_t max_order_quantity = 100000;
+    uint64_t max_order_notional = 10000000000ULL;
+    uint32_t price_band_bps = 1000;        // Distance allowed from the reference price
+    uint64_t max_position = 1000000;
+    uint32_t max_orders_per_second = 0;    // Per client; cancels are exempt
+    uint32_t order_burst = 100;            // Orders allowed back to back above the rate
+};
+
+/**
+ * @brief Read limits from a "key = value" file; false with a logged reason
+ *
+ * Keys are the RiskLimits field names; '#' starts a comment. Fields the
+ * file leaves out keep the values already in limits.
+ */
+bool load_risk_limits(const std::string& path, RiskLimits& limits);
+
+/**
+ * @brief Published limits, swapped RCU-style
+ *
+ * Readers take the current set with one acquire load and use it for the
+ * whole check. publish() installs a complete new set; the old one is
+ * retired but never freed while the store lives, so a reader still holding
+ * it is never left with a dangling pointer. Limit sets are small and
+ * reloads rare, which makes that cheaper than tracking grace periods.
+ */
+class RiskLimitsStore {
+public:
+    explicit RiskLimitsStore(const RiskLimits& limits);
+
+    RiskLimitsStore(const RiskLimitsStore&) = delete;
+    RiskLimitsStore& operator=(const RiskLimitsStore&) = delete;
+
+    const RiskLimits& current() const noexcept {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Make limits the current set; safe against concurrent readers
+     */
+    void publish(const RiskLimits& limits);
+
+private:
+    std::atomic<const RiskLimits*> current_;
+    std::mutex publish_mutex_;                     // Publishers only
+    std::vector<std::unique_ptr<RiskLimits>> versions_;
+};
+
+/**
+ * @brief Sizing for a RiskEngine; all state is allocated up front
+ */
+struct RiskConfig {
+    uint32_t max_clients = 16384;          // Client indexes run from 0 to max_clients - 1
+    uint32_t max_accounts = 4096;          // Distinct login accounts tracked over the engine's life
+    uint32_t max_symbols = 8192;           // Instrument ids run from 0 to max_symbols - 1
+    uint32_t symbols_per_client = 8;       // Symbols an account can hold a position or orders in
+};
+
+/**
+ * @brief Risk check counters since start
+ */
+struct RiskStats {
+    uint64_t checked = 0;
+    uint64_t rejected_quantity = 0;
+    uint64_t rejected_notional = 0;
+    uint64_t rejected_price = 0;
+    uint64_t rejected_position = 0;
+    uint64_t rejected_throttle = 0;
+
+    uint64_t rejected() const {
+        return rejected_quantity + rejected_notional + rejected_price + rejected_position + rejected_throttle;
+    }
+};
+
+/**
+ * @brief Inline pre-trade checks between decoding an order and matching it
+ *
+ * Checks order size, notional, a price band around the instrument's last
+ * market data, the account's position including its working orders, and
+ * its order rate. Callers name a connection by a dense client index (its
+ * slot) and a session, its generation-tagged handle, plus the account it
+ * logged in with. The first order of a session binds the slot to that
+ * account's state, which outlives the connection, so reconnecting keeps
+ * the position. A connection without an account gets state of its own
+ * that starts flat with each new session, as there is nothing to carry it
+ * over by. Account state is never dropped: once max_accounts accounts have
+ * been seen, orders from further ones are rejected on position.
+ *
+ * Reference prices are read from the shared MarketStateCache, which the
+ * market data path keeps current. Nothing on the checking path locks or
+ * allocates; only binding a new session looks the account up.
+ *
+ * check_order(), on_fill() and on_resting() must come from one thread at a
+ * time, normally the thread that owns the matching engine. stats() may be
+ * called from any thread.
+ */
+class RiskEngine {
+public:
+    RiskEngine(const RiskConfig& config, std::shared_ptr<const RiskLimitsStore> limits,
+               std::shared_ptr<const MarketStateCache> market);
+
+    RiskEngine(const RiskEngine&) = delete;
+    RiskEngine& operator=(const RiskEngine&) = delete;
+
+    static constexpr uint64_t NO_ACCOUNT = 0;
+
+    /**
+     * @brief ACCEPTED, or the REJECTED_RISK_* reason
+     *
+     * A zero price (market order) is valued at the reference price.
+     * replaced is the open quantity of the order a replace supersedes, which
+     * stops counting as working once it goes through. Clients, accounts and
+     * instruments beyond the configured capacity are rejected on position,
+     * since there is nowhere to track them.
+     */
+    OrderResult check_order(uint32_t client, uint64_t session, uint64_t account, InstrumentId instrument,
+                            OrderSide side, uint64_t price, uint32_t quantity, uint32_t replaced,
+                            uint64_t now_ns);
+
+    /**
+     * @brief Apply an execution to the position of the account the session is bound to
+     */
+    void on_fill(uint32_t client, uint64_t session, InstrumentId instrument, OrderSide side, uint32_t quantity);
+
+    /**
+     * @brief Apply a change in the session's resting quantity: positive when an order rests
+     */
+    void on_resting(uint32_t client, uint64_t session, InstrumentId instrument, OrderSide side, int64_t change);
+
+    RiskStats stats() const;
+
+private:
+    static constexpr uint32_t NO_STATE = UINT32_MAX;
+
+    struct Position {
+        InstrumentId instrument = NO_INSTRUMENT;
+        int64_t quantity = 0;                  // Net filled
+        int64_t buying = 0;                    // Resting on each side
+        int64_t selling = 0;
+
+        bool empty() const { return quantity == 0 && buying == 0 && selling == 0; }
+    };
+
+    // Risk state of one account, or of one connection without an account
+    struct State {
+        uint64_t next_allowed_ns = 0;          // Rate throttle: theoretical arrival time
+    };
+
+    // Which state a client slot's current session draws on
+    struct Binding {
+        uint64_t session = 0;
+        uint64_t account = NO_ACCOUNT;
+        uint32_t state = NO_STATE;
+    };
+
+    struct AccountSlot {
+        uint64_t account = NO_ACCOUNT;         // NO_ACCOUNT marks an empty slot
+        uint32_t state = NO_STATE;
+    };
+
+    uint32_t bind(uint32_t client, uint64_t session, uint64_t account);
+    uint32_t bound_state(uint32_t client, uint64_t session) const;
+    uint32_t account_state(uint64_t account);
+    Position* find_position(uint32_t state, InstrumentId instrument, bool create);
+    bool throttle(State& state, const RiskLimits& limits, uint64_t now_ns);
+
+    RiskConfig config_;
+    std::shared_ptr<const RiskLimitsStore> limits_;
+    std::shared_ptr<const MarketStateCache> market_;   // Reference prices
+    std::unique_ptr<Binding[]> bindings_;      // By client index
+    std::unique_ptr<State[]> states_;          // Per-client states first, then accounts'
+    std::unique_ptr<Position[]> positions_;    // symbols_per_client per state
+    std::unique_ptr<AccountSlot[]> accounts_;  // Open addressing, at most half full
+    size_t account_mask_ = 0;
+    uint32_t account_count_ = 0;
+
+    // Written by the checking thread only
+    std::atomic<uint64_t> checked_{0};
+    std::atomic<uint64_t> rejected_quantity_{0};
+    std::atomic<uint64_t> rejected_notional_{0};
+    std::atomic<uint64_t> rejected_price_{0};
+    std::atomic<uint64_t> rejected_position_{0};
+    std::atomic<uint64_t> rejected_throttle_{0};
+};
+
+} // namespace hft
+
+#endif // RISK_ENGINE_H
@@ -0,0 +1,214 @@
+#ifndef SERVER_COUNTERS_H
+#define SERVER_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include "message.h"
+#include "object_pool.h"
+
+namespace hft {
+
+/**
+ * @brief Event counts kept by every server thread
+ */
+enum class Counter : uint8_t {
+    MESSAGES = 0,       // Frames decoded and handed on
+    BYTES_IN,           // Bytes received from clients
+    FRAMES_OUT,         // Response frames queued for clients
+    BYTES_OUT,          // Bytes the kernel accepted for clients
+    SEND_BLOCKED,       // Writes cut short by a full socket buffer
+    MALFORMED,          // Connections dropped for an undecodable frame
+    RECV_OVERFLOW,      // Connections dropped for a frame larger than the receive buffer
+    SLOW_CLIENT,        // Connections cut off past the send backlog limit
+    STALE_FRAMES,       // Responses dropped because their connection had closed
+    INGRESS_FULL,       // Pipeline pushes that had to wait for ring space
+    LOGINS,             // Sessions logged in
+    SEQUENCE_GAPS,      // Inbound gaps answered with RESEND_REQUEST
+    DUPLICATES,         // Sequenced frames dropped as already seen or inside a gap
+    IDLE_TIMEOUTS,      // Connections cut off for sending nothing within the idle timeout
+    SESSION_REJECTS,    // Connections dropped for a missing or repeated LOGIN
+    COUNT
+};
+
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+
+/**
+ * @brief snake_case name, as exported metrics use it
+ */
+inline const char* counter_name(Counter counter) {
+    switch (counter) {
+        case Counter::MESSAGES: return "messages";
+        case Counter::BYTES_IN: return "bytes_in";
+        case Counter::FRAMES_OUT: return "frames_out";
+        case Counter::BYTES_OUT: return "bytes_out";
+        case Counter::SEND_BLOCKED: return "send_blocked";
+        case Counter::MALFORMED: return "malformed";
+        case Counter::RECV_OVERFLOW: return "receive_overflows";
+        case Counter::SLOW_CLIENT: return "slow_clients";
+        case Counter::STALE_FRAMES: return "stale_frames";
+        case Counter::INGRESS_FULL: return "ingress_waits";
+        case Counter::LOGINS: return "logins";
+        case Counter::SEQUENCE_GAPS: return "sequence_gaps";
+        case Counter::DUPLICATES: return "duplicates";
+        case Counter::IDLE_TIMEOUTS: return "idle_timeouts";
+        case Counter::SESSION_REJECTS: return "session_rejects";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Add to a counter that only one thread writes
+ *
+ * A plain load and store rather than a locked read-modify-write; readers
+ * on other threads still see whole values.
+ */
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief One thread's counters, on cache lines of its own
+ *
+ * Only the owning thread writes a block, so an increment is a plain load
+ * and store rather than a locked read-modify-write, and no other thread's
+ * counters share its lines. Readers may sum the blocks at any time.
+ */
+struct alignas(CACHE_LINE_SIZE) CounterBlock {
+    static constexpr size_t MESSAGE_TYPES = 256;
+
+    std::atomic<uint64_t> values[COUNTER_COUNT] = {};
+    std::atomic<uint64_t> messages_by_type[MESSAGE_TYPES] = {};
+
+    void add(Counter counter, uint64_t amount = 1) noexcept {
+        bump(values[static_cast<size_t>(counter)], amount);
+    }
+
+    /**
+     * @brief One decoded message of the given wire type
+     */
+    void count_message(uint8_t type) noexcept {
+        bump(messages_by_type[type]);
+        add(Counter::MESSAGES);
+    }
+
+    /**
+     * @brief Zero every count; only while the owning thread is not counting
+     */
+    void clear() noexcept {
+        for (std::atomic<uint64_t>& value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        for (std::atomic<uint64_t>& value : messages_by_type) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief Counter totals over every thread
+ */
+struct CounterSnapshot {
+    uint64_t values[COUNTER_COUNT] = {};
+    uint64_t messages_by_type[CounterBlock::MESSAGE_TYPES] = {};
+
+    uint64_t operator[](Counter counter) const { return values[static_cast<size_t>(counter)]; }
+};
+
+/**
+ * @brief Fixed set of per-thread counter blocks summed on demand
+ *
+ * Like LatencyTracker, each thread is handed its block by index up front;
+ * the hot path never touches a line another thread writes. The blocks may
+ * live in a MetricsSegment, where other processes read them.
+ */
+class CounterSet {
+public:
+    explicit CounterSet(size_t blocks)
+        : owned_(new CounterBlock[blocks]), blocks_(owned_.get()), block_count_(blocks) {}
+    
+    /**
+     * @brief Use blocks someone else owns and keeps alive
+     */
+    CounterSet(CounterBlock* blocks, size_t count) : blocks_(blocks), block_count_(count) {}
+
+    CounterSet(const CounterSet&) = delete;
+    CounterSet& operator=(const CounterSet&) = delete;
+
+    CounterBlock& block(size_t index) { return blocks_[index]; }
+    size_t block_count() const { return block_count_; }
+
+    void snapshot(CounterSnapshot& out) const { sum(blocks_, block_count_, out); }
+
+    /**
+     * @brief Zero every block; only while no thread is counting
+     */
+    void reset() {
+        for (size_t i = 0; i < block_count_; ++i) {
+            blocks_[i].clear();
+        }
+    }
+
+    /**
+     * @brief Totals of count blocks, e.g. read from a mapped segment
+     */
+    static void sum(const CounterBlock* blocks, size_t count, CounterSnapshot& out) {
+        out = CounterSnapshot{};
+        for (size_t i = 0; i < count; ++i) {
+            const CounterBlock& block = blocks[i];
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+                out.values[c] += block.values[c].load(std::memory_order_relaxed);
+            }
+            for (size_t t = 0; t < CounterBlock::MESSAGE_TYPES; ++t) {
+                out.messages_by_type[t] += block.messages_by_type[t].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<CounterBlock[]> owned_;   // Null when the blocks live elsewhere
+    CounterBlock* blocks_;
+    size_t block_count_;
+};
+
+/**
+ * @brief Print traffic, per-type and drop counts, skipping types never seen
+ */
+inline void print_counters(std::ostream& out, const CounterSnapshot& counters) {
+    out << "Traffic: " << counters[Counter::MESSAGES] << " messages, " << counters[Counter::BYTES_IN]
+        << " bytes in, " << counters[Counter::FRAMES_OUT] << " frames / " << counters[Counter::BYTES_OUT]
+        << " bytes out, " << counters[Counter::SEND_BLOCKED] << " blocked writes" << std::endl;
+
+    out << "By type:";
+    bool any = false;
+    for (size_t type = 0; type < CounterBlock::MESSAGE_TYPES; ++type) {
+        if (counters.messages_by_type[type] == 0) {
+            continue;
+        }
+        const char* name = message_type_name(static_cast<MessageType>(type));
+        out << " " << name;
+        if (std::string_view(name) == "UNKNOWN") {
+            out << "(" << type << ")";
+        }
+        out << "=" << counters.messages_by_type[type];
+        any = true;
+    }
+    out << (any ? "" : " none") << std::endl;
+
+    out << "Drops: " << counters[Counter::MALFORMED] << " malformed, " << counters[Counter::RECV_OVERFLOW]
+        << " receive overflows, " << counters[Counter::SLOW_CLIENT] << " slow clients cut off, "
+        << counters[Counter::STALE_FRAMES] << " stale frames, " << counters[Counter::INGRESS_FULL]
+        << " ingress waits" << std::endl;
+
+    out << "Sessions: " << counters[Counter::LOGINS] << " logins, " << counters[Counter::SEQUENCE_GAPS]
+        << " sequence gaps, " << counters[Counter::DUPLICATES] << " duplicates, "
+        << counters[Counter::IDLE_TIMEOUTS] << " idle timeouts, " << counters[Counter::SESSION_REJECTS]
+        << " rejects" << std::endl;
+}
+
+} // namespace hft
+
+#endif // SERVER_COUNTERS_H
@@ -0,0 +1,59 @@
+#include "session.h"
+
+namespace hft {
+
+// TimerWheel implementation
+TimerWheel::TimerWheel(uint64_t tick_ns, uint64_t now_ns)
+    : tick_ns_(std::max<uint64_t>(tick_ns, 1)),
+      current_(now_ns / tick_ns_) {
+    for (auto& level : slots_) {
+        for (Timer& head : level) {
+            head.next = &head;
+            head.prev = &head;
+        }
+    }
+}
+
+void TimerWheel::schedule(Timer& timer, uint64_t deadline_ns) {
+    cancel(timer);
+    timer.expiry = std::max(deadline_ns / tick_ns_, current_ + 1);
+    insert(timer);
+    ++size_;
+}
+
+void TimerWheel::insert(Timer& timer) {
+    // Beyond the outermost level: park at the horizon, the caller re-arms
+    constexpr uint32_t SPAN_BITS = SLOT_BITS * LEVELS;
+    uint64_t differing = timer.expiry ^ current_;
+    if ((differing >> SPAN_BITS) != 0) {
+        timer.expiry = current_ | ((1ULL << SPAN_BITS) - 1);
+        differing = timer.expiry ^ current_;
+    }
+
+    uint32_t level = 0;
+    while ((differing >> (SLOT_BITS * (level + 1))) != 0) {
+        ++level;
+    }
+    Timer& head = slots_[level][(timer.expiry >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    timer.next = &head;
+    timer.prev = head.prev;
+    head.prev->next = &timer;
+    head.prev = &timer;
+}
+
+void TimerWheel::cascade() {
+    // Outermost first, so a timer can fall through several levels in one tick
+    for (uint32_t level = LEVELS - 1; level > 0; --level) {
+        if ((current_ & ((1ULL << (SLOT_BITS * level)) - 1)) != 0) {
+            continue;
+        }
+        Timer& head = slots_[level][(current_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        while (head.next != &head) {
+            Timer& timer = *head.next;
+            unlink(timer);
+            insert(timer);
+        }
+    }
+}
+
+} // namespace hft
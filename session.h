@@ -0,0 +1,308 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "message.h"
+#include "wire_protocol.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace hft {
+
+/**
+ * @brief Session timers and login policy; a zero interval turns that timer off
+ */
+struct SessionConfig {
+    uint32_t heartbeat_ms = 0;         // HEARTBEAT to every logged-in session this often
+    uint32_t idle_timeout_ms = 0;      // Disconnect any connection that sends nothing for this long
+    bool require_login = false;        // Disconnect a client whose first frame is not LOGIN
+
+    bool timers() const { return heartbeat_ms != 0 || idle_timeout_ms != 0; }
+};
+
+/**
+ * @brief Hierarchical timing wheel with intrusive timers
+ *
+ * LEVELS wheels of SLOTS slots each; level n slots span SLOTS^n ticks. A
+ * timer sits at the level of the highest base-SLOTS digit in which its
+ * expiry differs from the current tick, in the slot that digit names.
+ * Each tick fires one level 0 slot, and whenever a level's lower digits
+ * wrap to zero its current slot is pushed down a level. Scheduling and
+ * cancelling are O(1) list operations, and a tick costs O(1) plus the
+ * timers it fires or moves, however many are pending. Timers further out
+ * than SLOTS^LEVELS ticks fire early at the wheel's horizon, so callers
+ * re-check their deadline on expiry.
+ *
+ * Not thread-safe: one thread at a time schedules, cancels and advances.
+ */
+class TimerWheel {
+public:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t LEVELS = 4;
+
+    struct Timer {
+        Timer* next = nullptr;
+        Timer* prev = nullptr;         // Null while not scheduled
+        uint64_t expiry = 0;           // Tick
+        uint64_t cookie = 0;           // Owner's, e.g. a connection handle
+
+        bool scheduled() const { return prev != nullptr; }
+    };
+
+    TimerWheel(uint64_t tick_ns, uint64_t now_ns);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief (Re)arm timer for deadline_ns; a deadline already past fires on the next tick
+     */
+    void schedule(Timer& timer, uint64_t deadline_ns);
+
+    /**
+     * @brief Disarm timer; a no-op if it is not scheduled
+     */
+    void cancel(Timer& timer) {
+        if (timer.scheduled()) {
+            unlink(timer);
+            --size_;
+        }
+    }
+
+    /**
+     * @brief Run every tick up to now_ns, calling expire(timer) for each timer that comes due
+     *
+     * Timers are unscheduled before their callback runs, which may schedule
+     * them again. Returns the number fired.
+     */
+    template<typename Expire>
+    size_t advance(uint64_t now_ns, Expire&& expire) {
+        uint64_t target = now_ns / tick_ns_;
+        size_t fired = 0;
+        while (current_ < target) {
+            if (size_ == 0) {
+                current_ = target; // Nothing can come due on the way
+                break;
+            }
+            ++current_;
+            cascade();
+
+            Timer& head = slots_[0][current_ & (SLOTS - 1)];
+            while (head.next != &head) {
+                Timer& timer = *head.next;
+                unlink(timer);
+                --size_;
+                ++fired;
+                expire(timer);
+            }
+        }
+        return fired;
+    }
+
+    size_t size() const { return size_; }
+    uint64_t tick_ns() const { return tick_ns_; }
+
+private:
+    static void unlink(Timer& timer) {
+        timer.prev->next = timer.next;
+        timer.next->prev = timer.prev;
+        timer.next = nullptr;
+        timer.prev = nullptr;
+    }
+
+    void insert(Timer& timer);
+    void cascade();
+
+    uint64_t tick_ns_;
+    uint64_t current_;                 // Last tick processed
+    size_t size_ = 0;
+    std::array<std::array<Timer, SLOTS>, LEVELS> slots_; // Circular list heads
+};
+
+/**
+ * @brief Per-connection session state: login, inbound sequencing, liveness
+ *
+ * Until a client logs in its frames pass straight through, as they always
+ * have, unless the server requires a login. LOGIN's header sequence is the
+ * sequence number of the client's next frame (0 means 1). From then on each
+ * application frame must carry the next number: a lower one is a duplicate
+ * and is dropped, a higher one is a gap. The first frame of a gap is
+ * answered with RESEND_REQUEST and dropped, as are later ones until the
+ * missing number arrives, so the client resends from there. HEARTBEAT and
+ * LOGOUT are not sequenced. Sessions do not outlive their connection.
+ *
+ * Outbound, every application frame sent to a logged-in session carries
+ * the session's next number, from 1 after each LOGIN, so the client can
+ * detect a lost frame in turn. Session frames keep the numbers they were
+ * built with, and frames sent before LOGIN are not numbered.
+ *
+ * on_frame() and touch() are called by whichever thread is reading the
+ * connection, on_timer() by the thread advancing its wheel; they share
+ * only the atomics. stamp_outbound() is called by whichever thread queues
+ * the connection's sends, in the order the frames are queued.
+ */
+class Session {
+public:
+    enum class Action : uint8_t {
+        DISPATCH,                      // Application frame, in sequence or unsequenced
+        DROP,                          // Heartbeat, duplicate, or frame inside a reported gap
+        LOGIN,                         // Logged in: acknowledge with LOGIN
+        LOGOUT,                        // Logged out: confirm with LOGOUT
+        RESEND,                        // New gap: send RESEND_REQUEST, drop the frame
+        REJECT                         // Login required or repeated: disconnect
+    };
+
+    /**
+     * @brief Fresh state for a new connection
+     */
+    void reset(uint64_t cookie, uint64_t now_ns) {
+        logged_in_.store(false, std::memory_order_relaxed);
+        next_inbound_.store(0, std::memory_order_relaxed);
+        next_outbound_.store(1, std::memory_order_relaxed);
+        resend_pending_ = false;
+        last_receive_ns_.store(now_ns, std::memory_order_relaxed);
+        heartbeat_due_ns_ = 0;
+        timer.cookie = cookie;
+    }
+
+    Action on_frame(MessageType type, uint32_t sequence, bool require_login) {
+        switch (type) {
+            case MessageType::LOGIN:
+                if (logged_in()) {
+                    return Action::REJECT;
+                }
+                next_inbound_.store(sequence != 0 ? sequence : 1, std::memory_order_relaxed);
+                next_outbound_.store(1, std::memory_order_relaxed);
+                resend_pending_ = false;
+                logged_in_.store(true, std::memory_order_relaxed);
+                return Action::LOGIN;
+            case MessageType::LOGOUT:
+                logged_in_.store(false, std::memory_order_relaxed);
+                return Action::LOGOUT;
+            case MessageType::HEARTBEAT:
+                return Action::DROP;
+            default:
+                break;
+        }
+
+        if (!logged_in()) {
+            return require_login ? Action::REJECT : Action::DISPATCH;
+        }
+        uint32_t expected = next_inbound_.load(std::memory_order_relaxed);
+        if (sequence == expected) {
+            next_inbound_.store(expected + 1, std::memory_order_relaxed);
+            resend_pending_ = false;
+            return Action::DISPATCH;
+        }
+        if (sequence < expected || resend_pending_) {
+            return Action::DROP;
+        }
+        resend_pending_ = true;
+        return Action::RESEND;
+    }
+
+    /**
+     * @brief Number the application frames in a run of encoded frames, if logged in
+     */
+    void stamp_outbound(uint8_t* frames, size_t length) {
+        if (!logged_in()) {
+            return;
+        }
+        for (size_t offset = 0; offset + wire::HEADER_SIZE <= length;) {
+            uint8_t* frame = frames + offset;
+            if (!is_session_frame(wire::frame_type(frame))) {
+                wire::set_frame_sequence(frame, next_outbound_.fetch_add(1, std::memory_order_relaxed));
+            }
+            offset += wire::header_word(frame) & 0xFFFF;
+        }
+    }
+
+    /**
+     * @brief Record that the connection delivered data
+     */
+    void touch(uint64_t now_ns) { last_receive_ns_.store(now_ns, std::memory_order_relaxed); }
+
+    bool logged_in() const { return logged_in_.load(std::memory_order_relaxed); }
+    uint32_t next_inbound() const { return next_inbound_.load(std::memory_order_relaxed); }
+    uint64_t last_receive_ns() const { return last_receive_ns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief What a timer expiry calls for, and when the timer should fire next
+     */
+    struct TimerResult {
+        bool idle = false;             // Nothing received for the idle timeout: disconnect
+        bool heartbeat = false;        // Send a HEARTBEAT
+        uint64_t next_ns = 0;          // Reschedule for this time
+    };
+
+    /**
+     * @brief Deadline for a new connection's first expiry; 0 when no timer applies
+     */
+    static uint64_t first_deadline(const SessionConfig& config, uint64_t now_ns) {
+        return earliest(config.idle_timeout_ms != 0 ? now_ns + config.idle_timeout_ms * 1000000ULL : 0,
+                        config.heartbeat_ms != 0 ? now_ns + config.heartbeat_ms * 1000000ULL : 0);
+    }
+
+    /**
+     * @brief Decide an expiry; the timer thread's only call
+     *
+     * The idle deadline counts from the last receive. Heartbeats go out at a
+     * fixed interval from the first expiry after login, whether or not other
+     * frames were sent in between.
+     */
+    TimerResult on_timer(const SessionConfig& config, uint64_t now_ns) {
+        TimerResult result;
+        uint64_t idle_ns = config.idle_timeout_ms * 1000000ULL;
+        uint64_t heartbeat_ns = config.heartbeat_ms * 1000000ULL;
+
+        // Another thread's clock read may be slightly ahead of this one
+        uint64_t last_receive = last_receive_ns();
+        uint64_t idle_deadline = 0;
+        if (idle_ns != 0) {
+            result.idle = last_receive <= now_ns && now_ns - last_receive >= idle_ns;
+            idle_deadline = result.idle ? now_ns + idle_ns : last_receive + idle_ns;
+        }
+
+        uint64_t heartbeat_deadline = 0;
+        if (heartbeat_ns != 0) {
+            if (!logged_in()) {
+                heartbeat_due_ns_ = 0;
+            } else if (heartbeat_due_ns_ == 0) {
+                heartbeat_due_ns_ = now_ns + heartbeat_ns;
+            } else if (now_ns >= heartbeat_due_ns_) {
+                result.heartbeat = true;
+                heartbeat_due_ns_ = now_ns + heartbeat_ns;
+            }
+            heartbeat_deadline = heartbeat_due_ns_ != 0 ? heartbeat_due_ns_ : now_ns + heartbeat_ns;
+        }
+
+        result.next_ns = earliest(idle_deadline, heartbeat_deadline);
+        return result;
+    }
+
+    TimerWheel::Timer timer;           // Owned by the connection's shard wheel
+
+private:
+    std::atomic<bool> logged_in_{false};
+    std::atomic<uint32_t> next_inbound_{0};
+    std::atomic<uint32_t> next_outbound_{1};
+    bool resend_pending_ = false;
+    std::atomic<uint64_t> last_receive_ns_{0};
+    uint64_t heartbeat_due_ns_ = 0;    // Timer thread only
+
+    static bool is_session_frame(MessageType type) {
+        return type == MessageType::LOGIN || type == MessageType::LOGOUT || type == MessageType::HEARTBEAT ||
+               type == MessageType::RESEND_REQUEST;
+    }
+
+    static uint64_t earliest(uint64_t a, uint64_t b) {
+        return a == 0 ? b : (b == 0 ? a : std::min(a, b));
+    }
+};
+
+} // namespace hft
+
+#endif // SESSION_H
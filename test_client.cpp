@@ -1,4 +1,5 @@
 #include "message.h"
+#include "wire_protocol.h"
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -109,7 +110,9 @@ public:
         log_info(ss.str());
         
         // Send order
-        ssize_t bytes_sent = send(socket_fd_, &order, sizeof(order), 0);
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::encode(order, frame);
+        ssize_t bytes_sent = send(socket_fd_, frame, frame_length, 0);
         if (bytes_sent == -1) {
             log_error("Failed to send order: " + std::string(strerror(errno)));
             return false;
@@ -125,21 +128,20 @@ public:
             return false;
         }
         
-        Message cancel_msg;
+        OrderMessage cancel_msg;
         cancel_msg.message_id = generate_message_id();
         cancel_msg.update_timestamp();
         cancel_msg.message_type = MessageType::ORDER_CANCEL;
         cancel_msg.status = MessageStatus::PENDING;
         cancel_msg.source_id = 1;
         cancel_msg.destination_id = 0;
-        
-        // Store order_id in payload
-        memcpy(cancel_msg.payload.data(), &order_id, sizeof(order_id));
-        cancel_msg.payload_size = sizeof(order_id);
+        cancel_msg.order_id = order_id;
         
         log_info("Sending ORDER_CANCEL for order ID: " + std::to_string(order_id));
         
-        ssize_t bytes_sent = send(socket_fd_, &cancel_msg, sizeof(cancel_msg), 0);
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::encode(cancel_msg, frame);
+        ssize_t bytes_sent = send(socket_fd_, frame, frame_length, 0);
         if (bytes_sent == -1) {
             log_error("Failed to send cancel order: " + std::string(strerror(errno)));
             return false;
@@ -182,7 +184,9 @@ public:
            << " Ask: " << ask_price << "x" << ask_size;
         log_info(ss.str());
         
-        ssize_t bytes_sent = send(socket_fd_, &data, sizeof(data), 0);
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::encode(data, frame);
+        ssize_t bytes_sent = send(socket_fd_, frame, frame_length, 0);
         if (bytes_sent == -1) {
             log_error("Failed to send market data: " + std::string(strerror(errno)));
             return false;
@@ -205,11 +209,12 @@ public:
         heartbeat.status = MessageStatus::PENDING;
         heartbeat.source_id = 1;
         heartbeat.destination_id = 0;
-        heartbeat.payload_size = 0;
         
         log_info("Sending HEARTBEAT");
         
-        ssize_t bytes_sent = send(socket_fd_, &heartbeat, sizeof(heartbeat), 0);
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::encode(heartbeat, frame);
+        ssize_t bytes_sent = send(socket_fd_, frame, frame_length, 0);
         if (bytes_sent == -1) {
             log_error("Failed to send heartbeat: " + std::string(strerror(errno)));
             return false;
@@ -471,6 +476,7 @@ int main(int argc, char* argv[]) {
     std::string test_mode = "comprehensive";
     int num_orders = 1000;
     int num_market_updates = 100;
+    int delay_ms = -1; // -1 keeps each test's default pacing
     
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -485,6 +491,8 @@ int main(int argc, char* argv[]) {
             num_orders = std::stoi(argv[++i]);
         } else if (arg == "--market" && i + 1 < argc) {
             num_market_updates = std::stoi(argv[++i]);
+        } else if (arg == "--delay" && i + 1 < argc) {
+            delay_ms = std::stoi(argv[++i]);
         } else if (arg == "--help") {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
@@ -493,6 +501,7 @@ int main(int argc, char* argv[]) {
                       << "  --mode <mode>    Test mode: comprehensive, performance, market, interactive (default: comprehensive)\n"
                       << "  --orders <n>     Number of orders for performance test (default: 1000)\n"
                       << "  --market <n>     Number of market updates (default: 100)\n"
+                      << "  --delay <ms>     Delay between messages, 0 sends back-to-back (default: 100/200)\n"
                       << "  --help           Show this help message\n";
             return 0;
         }
@@ -509,11 +518,19 @@ int main(int argc, char* argv[]) {
         client.run_comprehensive_test();
     } else if (test_mode == "performance") {
         if (client.connect()) {
-            client.run_performance_test(num_orders);
+            if (delay_ms >= 0) {
+                client.run_performance_test(num_orders, delay_ms);
+            } else {
+                client.run_performance_test(num_orders);
+            }
         }
     } else if (test_mode == "market") {
         if (client.connect()) {
-            client.run_market_data_test(num_market_updates);
+            if (delay_ms >= 0) {
+                client.run_market_data_test(num_market_updates, delay_ms);
+            } else {
+                client.run_market_data_test(num_market_updates);
+            }
         }
     } else if (test_mode == "interactive") {
         if (client.connect()) {
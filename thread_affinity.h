@@ -0,0 +1,111 @@
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Pin the calling thread to a single CPU
+ */
+inline bool pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief Parse a CPU list such as "0,2,4-7" into individual CPU ids
+ */
+inline bool parse_cpu_list(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    const char* p = text.c_str();
+    
+    while (*p) {
+        char* end = nullptr;
+        errno = 0;
+        long first = std::strtol(p, &end, 10);
+        if (end == p || errno != 0 || first < 0 || first >= CPU_SETSIZE) {
+            return false;
+        }
+        
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = std::strtol(p, &end, 10);
+            if (end == p || errno != 0 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            p = end;
+        }
+        
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        
+        if (*p == ',') {
+            ++p;
+        } else if (*p) {
+            return false;
+        }
+    }
+    
+    return !cpus.empty();
+}
+
+/**
+ * @brief Run the calling thread under SCHED_FIFO at priority 1-99
+ *
+ * Needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance. A spinning FIFO thread
+ * never gives its CPU to ordinary threads, so pin it to a core of its own.
+ */
+inline bool set_realtime_priority(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        errno = result; // pthread calls return the error instead of setting it
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief CPUs the kernel keeps the scheduler off (isolcpus=); empty if none
+ */
+inline std::vector<int> isolated_cpus() {
+    std::vector<int> cpus;
+    FILE* file = std::fopen("/sys/devices/system/cpu/isolated", "r");
+    if (!file) {
+        return cpus;
+    }
+    
+    char line[1024] = {};
+    if (std::fgets(line, sizeof(line), file)) {
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+            text.pop_back();
+        }
+        if (!text.empty() && !parse_cpu_list(text, cpus)) {
+            cpus.clear();
+        }
+    }
+    std::fclose(file);
+    return cpus;
+}
+
+} // namespace hft
+
+#endif // THREAD_AFFINITY_H
@@ -0,0 +1,174 @@
+#include "transport.h"
+#include "io_uring_transport.h"
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace hft {
+
+const char* transport_name(TransportKind kind) {
+    switch (kind) {
+        case TransportKind::EPOLL: return "epoll";
+        case TransportKind::IO_URING: return "io_uring";
+    }
+    return "unknown";
+}
+
+bool parse_transport_kind(const std::string& text, TransportKind& kind) {
+    if (text == "epoll") {
+        kind = TransportKind::EPOLL;
+    } else if (text == "io_uring" || text == "uring") {
+        kind = TransportKind::IO_URING;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+EpollTransport::EpollTransport(bool one_shot) : one_shot_(one_shot) {}
+
+EpollTransport::~EpollTransport() {
+    if (writers_fd_ >= 0) {
+        close(writers_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EpollTransport::open() {
+    epoll_fd_ = epoll_create1(0);
+    writers_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0 || writers_fd_ < 0) {
+        std::cerr << "Failed to create epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // Any ready writer makes the nested instance readable
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WRITERS_COOKIE;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, writers_fd_, &ev) < 0) {
+        std::cerr << "Failed to nest the writer epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EpollTransport::add_listener(int fd, uint64_t cookie) {
+    uint32_t count = listener_count_.load(std::memory_order_relaxed);
+    if (count == MAX_LISTENERS) {
+        errno = ENOSPC;
+        return false;
+    }
+    // Published before the first event for fd can reach a waiting worker
+    listeners_[count] = cookie;
+    listener_count_.store(count + 1, std::memory_order_release);
+    
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = cookie;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        int saved = errno;
+        listener_count_.store(count, std::memory_order_release);
+        errno = saved;
+        return false;
+    }
+    return true;
+}
+
+bool EpollTransport::add_connection(int fd, uint64_t cookie) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET | (one_shot_ ? static_cast<uint32_t>(EPOLLONESHOT) : 0u);
+    ev.data.u64 = cookie;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool EpollTransport::rearm_connection(int fd, uint64_t cookie) {
+    if (!one_shot_) {
+        return true; // Edge-triggered interest stays armed
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+    ev.data.u64 = cookie;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EpollTransport::remove_connection(int fd, uint64_t) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    epoll_ctl(writers_fd_, EPOLL_CTL_DEL, fd, nullptr); // ENOENT unless it was ever watched
+}
+
+bool EpollTransport::watch_writable(int fd, uint64_t cookie) {
+    // A fired one-shot watch stays registered, disabled, until re-armed
+    epoll_event ev{};
+    ev.events = EPOLLOUT | EPOLLONESHOT;
+    ev.data.u64 = cookie;
+    if (epoll_ctl(writers_fd_, EPOLL_CTL_MOD, fd, &ev) == 0) {
+        return true;
+    }
+    return errno == ENOENT && epoll_ctl(writers_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+int EpollTransport::wait(TransportEvent* events, int max_events, int timeout_ms) {
+    epoll_event ready[MAX_EVENTS];
+    int count = epoll_wait(epoll_fd_, ready, std::min(max_events, MAX_EVENTS), timeout_ms);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -errno;
+    }
+    
+    int produced = 0;
+    bool writers_ready = false;
+    const uint64_t* listeners_begin = listeners_.data();
+    const uint64_t* listeners_end = listeners_begin + listener_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        uint64_t cookie = ready[i].data.u64;
+        if (cookie == WRITERS_COOKIE) {
+            writers_ready = true;
+            continue;
+        }
+        bool listener = std::find(listeners_begin, listeners_end, cookie) != listeners_end;
+        events[produced++] = TransportEvent{listener ? TransportEvent::ACCEPT : TransportEvent::READABLE,
+                                            cookie, nullptr, 0};
+    }
+    
+    // The nested instance is level-triggered: writers that do not fit this
+    // time are reported by the next wait()
+    if (writers_ready && produced < max_events) {
+        int writable = epoll_wait(writers_fd_, ready, std::min(max_events - produced, MAX_EVENTS), 0);
+        for (int i = 0; i < writable; ++i) {
+            events[produced++] = TransportEvent{TransportEvent::WRITABLE, ready[i].data.u64, nullptr, 0};
+        }
+    }
+    return produced;
+}
+
+ssize_t EpollTransport::send(int fd, uint64_t, const void* data, size_t length) {
+    return ::send(fd, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+std::unique_ptr<Transport> make_transport(const TransportOptions& options, bool one_shot) {
+    switch (options.kind) {
+        case TransportKind::EPOLL: {
+            auto transport = std::make_unique<EpollTransport>(one_shot);
+            if (!transport->open()) {
+                return nullptr;
+            }
+            return transport;
+        }
+        case TransportKind::IO_URING: {
+            auto transport = std::make_unique<IoUringTransport>(options);
+            if (!transport->open()) {
+                return nullptr;
+            }
+            return transport;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace hft
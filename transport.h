@@ -0,0 +1,194 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <errno.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace hft {
+
+/**
+ * @brief Network backend under the servers' socket I/O
+ *
+ * EPOLL waits for readiness and leaves every recv()/send() to the caller.
+ * IO_URING keeps a multishot recv armed on every socket, receiving into a
+ * ring of kernel-registered buffers, and submits queued sends in one batch.
+ * Kernel-bypass backends (AF_XDP, ef_vi) plug in behind the same interface.
+ */
+enum class TransportKind : uint8_t {
+    EPOLL,
+    IO_URING
+};
+
+/**
+ * @brief Backend selection and sizing
+ */
+struct TransportOptions {
+    TransportKind kind = TransportKind::EPOLL;
+    bool sqpoll = false;               // io_uring: a kernel thread polls the submission queue
+    uint32_t sqpoll_idle_ms = 2;       // ... and sleeps after this long without work
+    uint32_t queue_depth = 4096;       // io_uring submission queue entries
+    uint32_t buffer_count = 512;       // io_uring receive buffers per ring, a power of two
+    uint32_t buffer_size = 4096;       // Bytes per receive buffer
+    uint32_t socket_send_buffer = 1024 * 1024;    // SO_SNDBUF on server sockets; 0 = kernel default
+    uint32_t socket_receive_buffer = 1024 * 1024; // SO_RCVBUF on server sockets; 0 = kernel default
+    
+    /**
+     * @brief Whether each thread needs its own instance (epoll is shared per shard)
+     */
+    bool per_thread() const { return kind != TransportKind::EPOLL; }
+};
+
+const char* transport_name(TransportKind kind);
+
+/**
+ * @brief Parse a backend name ("epoll", "io_uring")
+ */
+bool parse_transport_kind(const std::string& text, TransportKind& kind);
+
+/**
+ * @brief One completion handed back by Transport::wait()
+ */
+struct TransportEvent {
+    enum Type : uint8_t {
+        ACCEPT,       // Listener has pending connections; accept them
+        READABLE,     // Socket has data; recv() until EAGAIN, then rearm_connection()
+        DATA,         // Bytes already received, valid until the next wait()
+        WRITABLE,     // Socket watched with watch_writable() has room again
+        CLOSED        // Peer closed or the socket failed
+    };
+    
+    Type type;
+    uint64_t cookie;               // As passed to add_listener() / add_connection()
+    const uint8_t* data;           // DATA only
+    uint32_t length;               // DATA only
+};
+
+/**
+ * @brief Socket event source and send path for one shard or one thread
+ *
+ * Instances with per_thread() options belong to a single thread, which
+ * must call attach_thread() before anything else and is the only caller
+ * afterwards; every byte for a socket must then go through that one
+ * instance, or a short send on one could be overtaken by another.
+ * Senders call remove_connection() too, before the socket is closed. Readiness-based instances may be shared by the workers of a
+ * shard. send() may queue; flush() pushes queued sends to the kernel and
+ * should be called once per loop pass.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+    
+    virtual TransportKind kind() const = 0;
+    
+    /**
+     * @brief Called once on the thread that will drive this transport
+     */
+    virtual bool attach_thread() { return true; }
+    
+    virtual bool add_listener(int fd, uint64_t cookie) = 0;
+    virtual bool add_connection(int fd, uint64_t cookie) = 0;
+    
+    /**
+     * @brief Resume READABLE events after draining a one-shot socket
+     */
+    virtual bool rearm_connection(int fd, uint64_t cookie) = 0;
+    
+    /**
+     * @brief Stop events for a socket; call before closing it
+     */
+    virtual void remove_connection(int fd, uint64_t cookie) = 0;
+    
+    /**
+     * @brief Deliver one WRITABLE event once the socket can take more bytes
+     *
+     * For callers whose send() fell short. Backends whose send() always
+     * takes the whole buffer (io_uring) do not support it.
+     */
+    virtual bool watch_writable(int, uint64_t) {
+        errno = ENOTSUP;
+        return false;
+    }
+    
+    /**
+     * @brief Wait up to timeout_ms for events (0 polls); returns the count or -errno
+     */
+    virtual int wait(TransportEvent* events, int max_events, int timeout_ms) = 0;
+    
+    /**
+     * @brief Send or queue bytes for the connection cookie names; returns the bytes accepted or -1 with errno set
+     *
+     * Queued bytes belong to the cookie, not the descriptor, and
+     * remove_connection() with that cookie discards them, so a reused
+     * descriptor number never receives another connection's bytes.
+     */
+    virtual ssize_t send(int fd, uint64_t cookie, const void* data, size_t length) = 0;
+    
+    /**
+     * @brief Bytes send() accepted for the connection that the kernel has not taken yet
+     */
+    virtual size_t queued(int, uint64_t) const { return 0; }
+    
+    /**
+     * @brief Submit queued sends and collect their completions
+     */
+    virtual void flush() {}
+};
+
+/**
+ * @brief Readiness notification through epoll; the caller does the I/O
+ *
+ * With one_shot every socket must be re-armed after it is drained, which
+ * keeps two workers sharing the instance off the same connection.
+ *
+ * Writability is watched on a second epoll instance nested inside the
+ * first, so a socket's EPOLLOUT interest never disturbs its (possibly
+ * one-shot) EPOLLIN registration.
+ */
+class EpollTransport final : public Transport {
+public:
+    explicit EpollTransport(bool one_shot);
+    ~EpollTransport() override;
+    
+    bool open();
+    
+    TransportKind kind() const override { return TransportKind::EPOLL; }
+    bool add_listener(int fd, uint64_t cookie) override;
+    bool add_connection(int fd, uint64_t cookie) override;
+    bool rearm_connection(int fd, uint64_t cookie) override;
+    void remove_connection(int fd, uint64_t cookie) override;
+    bool watch_writable(int fd, uint64_t cookie) override;
+    int wait(TransportEvent* events, int max_events, int timeout_ms) override;
+    ssize_t send(int fd, uint64_t cookie, const void* data, size_t length) override;
+
+private:
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr uint32_t MAX_LISTENERS = 4;
+    static constexpr uint64_t WRITERS_COOKIE = UINT64_MAX; // The nested instance in epoll_fd_
+    
+    bool one_shot_;
+    int epoll_fd_ = -1;
+    int writers_fd_ = -1;              // EPOLLOUT watches, one-shot
+    
+    // Listener cookies. One thread adds them, possibly while workers already
+    // wait: a cookie is written before the count that publishes it
+    std::array<uint64_t, MAX_LISTENERS> listeners_{};
+    std::atomic<uint32_t> listener_count_{0};
+};
+
+/**
+ * @brief Create and open a backend; nullptr with a logged reason on failure
+ *
+ * one_shot only applies to readiness backends shared between workers.
+ */
+std::unique_ptr<Transport> make_transport(const TransportOptions& options, bool one_shot);
+
+} // namespace hft
+
+#endif // TRANSPORT_H
@@ -1,4 +1,5 @@
 #include "ultra_hft_server.h"
+#include "async_logger.h"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -6,39 +7,300 @@
 #include <sstream>
 #include <iomanip>
 #include <cassert>
+#include <string_view>
 
 namespace ultra_hft {
 
+namespace {
+
+// Arena of the pipeline thread running; null (heap) on any other thread
+thread_local std::pmr::memory_resource* thread_memory = nullptr;
+
+// The directory the calling I/O worker resolves symbols in
+thread_local hft::InstrumentDirectory* thread_instruments = nullptr;
+
+} // namespace
+
 // Ultra-optimized HFT server implementation
 bool UltraHFTServer::initialize() {
     std::cout << "=== Ultra HFT Server Initializing ===" << std::endl;
     std::cout << "Server IP: " << server_ip_ << std::endl;
     std::cout << "Server Port: " << server_port_ << std::endl;
     std::cout << "Worker Threads: " << thread_count_ << std::endl;
+    std::cout << "Mode: " << (sharded_ ? "sharded (listener per worker)" : "shared listener") << std::endl;
+    std::cout << "Pipeline: " << thread_count_ << " I/O -> " << config_.strategy_threads
+              << " strategy -> " << config_.egress_threads << " send threads" << std::endl;
+    std::cout << "Rings: " << config_.ingress_ring_size << " ingress, " << config_.egress_ring_size
+              << " egress slots" << std::endl;
+    std::cout << "Transport: " << hft::transport_name(config_.transport.kind)
+              << (config_.transport.sqpoll ? " (SQPOLL)" : "")
+              << (config_.busy_poll.spin ? ", busy-poll workers" : "") << std::endl;
+    if (config_.multicast.enabled()) {
+        std::cout << "Multicast Feed: " << config_.multicast.group << ":" << config_.multicast.port << std::endl;
+    }
+    if (config_.memory.enabled()) {
+        std::cout << "Memory: " << hft::huge_pages_name(config_.memory.huge_pages) << " pages"
+                  << (config_.memory.numa ? ", NUMA-bound" : "") << (config_.memory.lock ? ", locked" : "")
+                  << ", " << config_.memory.arena_mb << " MB per arena" << std::endl;
+    }
+    if (!config_.metrics_segment.empty()) {
+        std::cout << "Metrics: /dev/shm/" << config_.metrics_segment << ", gauges every "
+                  << config_.metrics_interval_ms << " ms" << std::endl;
+    }
+    if (config_.session.timers() || config_.session.require_login) {
+        std::cout << "Sessions: heartbeat " << config_.session.heartbeat_ms << " ms, idle timeout "
+                  << config_.session.idle_timeout_ms << " ms"
+                  << (config_.session.require_login ? ", login required" : "") << std::endl;
+    }
     std::cout << "Target Latency: < 10μs" << std::endl;
+    std::cout << "Clock: ";
+    hft::TscClock::instance().describe(std::cout); // Calibrates before any thread starts
+    std::cout << std::endl;
     std::cout << "================================" << std::endl;
     
+    if (thread_count_ == 0 || config_.strategy_threads == 0 || config_.egress_threads == 0) {
+        std::cerr << "Every pipeline stage needs at least one thread" << std::endl;
+        return false;
+    }
+    
+    if (!is_ring_size_class(config_.ingress_ring_size) || !is_ring_size_class(config_.egress_ring_size)) {
+        std::cerr << "Ring sizes must be one of 1024, 4096, 16384 or 65536" << std::endl;
+        return false;
+    }
+    if (config_.event_batch == 0 || config_.stage_batch == 0 || config_.send_pool_size == 0) {
+        std::cerr << "Event batch, stage batch and send pool size must be at least 1" << std::endl;
+        return false;
+    }
+    if (config_.metrics_interval_ms == 0) {
+        std::cerr << "Metrics interval must be at least 1 ms" << std::endl;
+        return false;
+    }
+    
+    hft::place_spinning_threads(config_.busy_poll, "I/O worker", cpu_affinity_);
+    
+    // Connection refs pack the shard and slot into 32 bits
+    if ((sharded_ && thread_count_ > MAX_SHARDS) || max_connections_ > MAX_CONNECTIONS_PER_SHARD) {
+        std::cerr << "At most " << MAX_SHARDS << " shards of " << MAX_CONNECTIONS_PER_SHARD
+                  << " connections are supported" << std::endl;
+        return false;
+    }
+    
+    if (config_.memory.enabled()) {
+        if (config_.memory.arena_mb == 0) {
+            std::cerr << "Arena size must be at least 1 MB" << std::endl;
+            return false;
+        }
+        arenas_ = std::make_unique<hft::NumaArenas>(config_.memory);
+    }
+    
+    // One SPSC ring per (producer, consumer) pair between adjacent stages,
+    // each on its producer's node
+    for (uint32_t i = 0; i < thread_count_ * config_.strategy_threads; ++i) {
+        ingress_rings_.push_back(std::make_unique<IngressRing>(
+            config_.ingress_ring_size, arena_for(cpu_affinity_, i / config_.strategy_threads)));
+    }
+    for (uint32_t i = 0; i < config_.strategy_threads * config_.egress_threads; ++i) {
+        egress_rings_.push_back(std::make_unique<EgressRing>(
+            config_.egress_ring_size, arena_for(config_.strategy_cpu_affinity, i / config_.egress_threads)));
+    }
+    uint32_t pipeline_threads = thread_count_ + config_.strategy_threads + config_.egress_threads;
+    if (!config_.metrics_segment.empty()) {
+        hft::MetricsLayout layout;
+        layout.threads = pipeline_threads;
+        layout.shards = sharded_ ? thread_count_ : 1;
+        layout.shard_connections = max_connections_;
+        metrics_ = hft::MetricsSegment::create(config_.metrics_segment, "ultra_hft_server", layout);
+        if (!metrics_) {
+            return false;
+        }
+        latency_ = std::make_unique<hft::LatencyTracker>(metrics_->recorders(), pipeline_threads);
+        counters_ = std::make_unique<hft::CounterSet>(metrics_->counters(), pipeline_threads);
+    } else {
+        latency_ = std::make_unique<hft::LatencyTracker>(pipeline_threads);
+        counters_ = std::make_unique<hft::CounterSet>(pipeline_threads);
+    }
+    
+    instruments_ = config_.instruments.empty()
+                       ? std::make_unique<hft::InstrumentDirectory>()
+                       : std::make_unique<hft::InstrumentDirectory>(config_.instruments);
+    
+    // Symbols never move between lanes, so each lane's positions are complete;
+    // throttles count only the orders a lane sees
+    risk_limits_ = std::make_shared<hft::RiskLimitsStore>(config_.risk);
+    market_state_ = std::make_shared<hft::MarketStateCache>(instruments_->capacity());
+    for (uint32_t i = 0; i < config_.strategy_threads; ++i) {
+        hft::OrderBookConfig books;
+        books.memory = arena_for(config_.strategy_cpu_affinity, i);
+        lanes_.push_back(make_lane(i, books));
+        for (hft::InstrumentId id = i; id < instruments_->size(); id += config_.strategy_threads) {
+            lanes_.back()->engine.configure_book(id, instruments_->book_config(id, books));
+        }
+    }
+    if (config_.journal.enabled() && !recover_journal()) {
+        return false;
+    }
+    
+    hft::FanoutConfig fanout_config;
+    fanout_config.flushers = config_.egress_threads;
+    fanout_config.max_symbols = instruments_->capacity();
+    fanout_ = std::make_unique<hft::MarketDataFanout>(fanout_config);
+    
+    if (config_.multicast.enabled()) {
+        feed_ = std::make_unique<hft::MulticastFeed>(config_.multicast);
+        if (!feed_->start()) {
+            feed_.reset();
+            return false;
+        }
+    }
+    
+    // One shard per worker in sharded mode, otherwise a single shared shard
+    // on worker 0's node
+    uint32_t shard_count = sharded_ ? thread_count_ : 1;
+    for (uint32_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<UltraWorkerShard>(max_connections_, SESSION_TICK_NS,
+                                                        UltraMessage::get_current_timestamp(),
+                                                        arena_for(cpu_affinity_, i));
+        shard->id = i;
+        bool opened = open_shard(*shard);
+        shards_.push_back(std::move(shard));
+        if (!opened) {
+            close_shards();
+            return false;
+        }
+    }
+    
+    // Send threads only write, so their rings need no receive buffers
+    hft::TransportOptions send_only = config_.transport;
+    send_only.buffer_count = 0;
+    if (config_.transport.per_thread()) {
+        for (uint32_t i = 0; i < thread_count_; ++i) {
+            worker_transports_.push_back(hft::make_transport(config_.transport, false));
+        }
+    }
+    for (uint32_t i = 0; i < config_.egress_threads; ++i) {
+        egress_transports_.push_back(hft::make_transport(send_only, false));
+    }
+    for (auto* transports : {&worker_transports_, &egress_transports_}) {
+        if (std::find(transports->begin(), transports->end(), nullptr) != transports->end()) {
+            close_shards();
+            return false;
+        }
+    }
+    paused_reads_.assign(thread_count_, {});
+    if (arenas_) {
+        arenas_->describe(std::cout);
+    }
+
+    std::cout << "Ultra HFT Server initialized on " << server_ip_ << ":" << server_port_
+              << " (" << shard_count << " listener" << (shard_count > 1 ? "s" : "") << ")" << std::endl;
+    return true;
+}
+
+bool UltraHFTServer::recover_journal() {
+    hft::JournalReader reader;
+    if (!reader.open(config_.journal.directory)) return false;
+    
+    // Records are routed by instrument again, so the journal replays into any
+    // number of lanes. A disconnect cancels the owner's orders on every lane
+    auto replay_start = std::chrono::steady_clock::now();
+    hft::JournalOwnerMap owners;
+    hft::JournalRecord record;
+    size_t replayed = 0;
+    while (reader.next(record)) {
+        if (record.kind == hft::JournalRecordKind::DISCONNECT) {
+            if (uint64_t owner = owners.release(record)) {
+                for (auto& lane : lanes_) {
+                    lane->engine.cancel_all(owner);
+                }
+            }
+            ++replayed;
+            continue;
+        }
+        hft::MessageType type = hft::wire::frame_type(record.frame);
+        if (type != hft::MessageType::ORDER_NEW && type != hft::MessageType::ORDER_CANCEL &&
+            type != hft::MessageType::ORDER_REPLACE) {
+            continue;
+        }
+        
+        hft::OrderMessage order;
+        hft::wire::decode(record.frame, order);
+        order.instrument = instruments_->resolve(order.symbol.data());
+        hft::MatchingEngine& engine = lanes_[lane_for(order.instrument)]->engine;
+        uint64_t owner = owners.token(record);
+        if (type == hft::MessageType::ORDER_NEW) {
+            engine.submit_order(order, owner);
+        } else if (type == hft::MessageType::ORDER_CANCEL) {
+            engine.cancel_order(order, owner);
+        } else {
+            engine.replace_order(order, owner);
+        }
+        ++replayed;
+    }
+    
+    // Nobody can cancel or be told about orders of connections that are gone;
+    // with them cancelled the books start empty and the segments can be archived
+    size_t cancelled = 0;
+    for (uint64_t owner : owners.unreleased()) {
+        for (auto& lane : lanes_) {
+            cancelled += lane->engine.cancel_all(owner);
+        }
+    }
+    auto replay_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - replay_start).count();
+    std::cout << "Journal: replayed " << replayed << " records from " << reader.segments() << " segments in "
+              << replay_us << "us, cancelled " << cancelled << " orphaned orders";
+    if (reader.damaged() > 0) {
+        std::cout << " (" << reader.damaged() << " segments cut short)";
+    }
+    std::cout << std::endl;
+    reader.discard_empty_segments();
+    reader.archive_segments();
+    
+    for (auto& lane : lanes_) {
+        lane->journal = std::make_unique<hft::Journal>(config_.journal, "lane" + std::to_string(lane->id));
+        if (!lane->journal->open(reader.next_epoch())) {
+            std::cerr << "Failed to open the journal in " << config_.journal.directory << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UltraHFTServer::open_shard(UltraWorkerShard& shard) {
     // Create server socket
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket_ < 0) {
+    shard.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (shard.listen_fd < 0) {
         std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
         return false;
     }
     
     // Setup socket options for ultra-low latency
-    if (!setup_socket_options(server_socket_)) {
+    if (!setup_socket_options(shard.listen_fd)) {
         std::cerr << "Failed to setup socket options" << std::endl;
-        close(server_socket_);
         return false;
     }
     
+    // Let every shard bind the same address; the kernel spreads incoming
+    // connections across the listeners
+    if (sharded_) {
+        int opt = 1;
+        if (setsockopt(shard.listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+            std::cerr << "Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    
     // Set non-blocking mode
-    if (!set_non_blocking(server_socket_)) {
+    if (!set_non_blocking(shard.listen_fd)) {
         std::cerr << "Failed to set non-blocking mode" << std::endl;
-        close(server_socket_);
         return false;
     }
     
+    // Accepted sockets inherit the listener's busy-poll settings
+    if (!hft::apply_socket_busy_poll(shard.listen_fd, config_.busy_poll)) {
+        std::cerr << "Warning: busy-poll socket options refused (CAP_NET_ADMIN?): " << strerror(errno) << std::endl;
+    }
+    
     // Bind socket
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -46,41 +308,76 @@ bool UltraHFTServer::initialize() {
     server_addr.sin_addr.s_addr = inet_addr(server_ip_.c_str());
     server_addr.sin_port = htons(server_port_);
     
-    if (bind(server_socket_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    // Bound now so a taken port fails initialize(); start() listens on it
+    if (bind(shard.listen_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         std::cerr << "Failed to bind socket: " << strerror(errno) << std::endl;
-        close(server_socket_);
         return false;
     }
     
-    // Listen for connections
-    if (listen(server_socket_, SOMAXCONN) < 0) {
-        std::cerr << "Failed to listen: " << strerror(errno) << std::endl;
-        close(server_socket_);
-        return false;
+    // Per-thread transports register the listener from their own worker
+    if (config_.transport.per_thread()) {
+        return true;
     }
     
-    // Create epoll instance
-    epoll_fd_ = epoll_create1(0);
-    if (epoll_fd_ < 0) {
-        std::cerr << "Failed to create epoll: " << strerror(errno) << std::endl;
-        close(server_socket_);
-        return false;
+    // A shared epoll wakes any worker, so its sockets are one-shot and
+    // re-armed once drained; two workers must never read into the same
+    // reassembly buffer
+    shard.transport = hft::make_transport(config_.transport, !sharded_);
+    return shard.transport != nullptr;
+}
+
+bool UltraHFTServer::open_listeners() {
+    for (auto& shard : shards_) {
+        if (listen(shard->listen_fd, SOMAXCONN) < 0) {
+            std::cerr << "Failed to listen: " << strerror(errno) << std::endl;
+            return false;
+        }
+        
+        // Server socket marker; per-thread transports add the listener
+        // themselves once listening_ is set
+        if (shard->transport &&
+            !shard->transport->add_listener(shard->listen_fd, hft::ConnectionTable<UltraConnection>::INVALID_HANDLE)) {
+            std::cerr << "Failed to add server socket to epoll: " << strerror(errno) << std::endl;
+            return false;
+        }
     }
+    listening_.store(true, std::memory_order_release);
+    return true;
+}
+
+std::unique_ptr<UltraHFTServer::StrategyLane> UltraHFTServer::make_lane(uint32_t id, const hft::OrderBookConfig& books) {
+    hft::RiskConfig risk_config;
+    risk_config.max_clients = (sharded_ ? thread_count_ : 1) * max_connections_;
+    risk_config.max_symbols = instruments_->capacity();
     
-    // Add server socket to epoll
-    struct epoll_event ev;
-    ev.events = EPOLLIN | EPOLLET;
-    ev.data.ptr = nullptr; // Server socket marker
+    auto lane = std::make_unique<StrategyLane>(books);
+    lane->server = this;
+    lane->id = id;
+    lane->engine.set_fill_listener(lane.get());
+    lane->instruments = instruments_.get();
+    lane->risk = std::make_unique<hft::RiskEngine>(risk_config, risk_limits_, market_state_);
+    lane->latency = &latency_->recorder(thread_count_ + id);
+    return lane;
+}
+
+void UltraHFTServer::close_shards() {
+    worker_transports_.clear();
+    egress_transports_.clear();
     
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_socket_, &ev) < 0) {
-        std::cerr << "Failed to add server socket to epoll: " << strerror(errno) << std::endl;
-        close(epoll_fd_);
-        close(server_socket_);
-        return false;
+    for (auto& shard : shards_) {
+        shard->connections.for_each([](uint64_t, UltraConnection& conn) {
+            conn.is_active.store(false);
+            close(conn.fd);
+        });
+        
+        shard->transport.reset();
+        
+        if (shard->listen_fd >= 0) {
+            close(shard->listen_fd);
+            shard->listen_fd = -1;
+        }
     }
-    
-    std::cout << "Ultra HFT Server initialized on " << server_ip_ << ":" << server_port_ << std::endl;
-    return true;
+    shards_.clear();
 }
 
 bool UltraHFTServer::start() {
@@ -89,276 +386,1304 @@ bool UltraHFTServer::start() {
         return false;
     }
     
+    if (shards_.empty()) {
+        std::cerr << "Server not initialized" << std::endl;
+        return false;
+    }
+    
     running_.store(true);
     std::cout << "Ultra HFT Server starting with " << thread_count_ << " worker threads" << std::endl;
     
+    bool warm = config_.warmup.enabled();
+    if (warm) {
+        // Fault in the receive buffers the first clients will get
+        for (auto& shard : shards_) {
+            shard->connections.preallocate(config_.warmup.prefault_connections,
+                                           [](UltraConnection& conn) { conn.recv_buffer.prefault(); });
+        }
+        
+        // Shadow lanes match warm-up orders on books and positions of their
+        // own, on the heap rather than in the lanes' arenas. Against an open
+        // directory their symbols are interned in a private one, so none
+        // outlives the warm-up
+        if (instruments_->open()) {
+            warmup_directory_ = std::make_unique<hft::InstrumentDirectory>(config_.strategy_threads);
+        }
+        for (uint32_t i = 0; i < config_.strategy_threads; ++i) {
+            warmup_lanes_.push_back(make_lane(i, hft::OrderBookConfig{}));
+            if (warmup_directory_) {
+                warmup_lanes_.back()->instruments = warmup_directory_.get();
+            }
+        }
+        warmup_fds_.reset(new std::atomic<int>[thread_count_]);
+        for (uint32_t i = 0; i < thread_count_; ++i) {
+            warmup_fds_[i].store(-1, std::memory_order_relaxed);
+        }
+        warming_.store(true, std::memory_order_release);
+    } else if (!open_listeners()) {
+        running_.store(false);
+        return false;
+    }
+    
+    // Start downstream stages first so the rings are drained from the outset
+    for (uint32_t i = 0; i < config_.egress_threads; ++i) {
+        egress_threads_.emplace_back(&UltraHFTServer::egress_thread, this, i);
+    }
+    for (uint32_t i = 0; i < config_.strategy_threads; ++i) {
+        strategy_threads_.emplace_back(&UltraHFTServer::strategy_thread, this, i);
+    }
+    
     // Start worker threads
     for (uint32_t i = 0; i < thread_count_; ++i) {
-        worker_threads_.emplace_back(&UltraHFTServer::worker_thread, this);
+        worker_threads_.emplace_back(&UltraHFTServer::worker_thread, this, i);
     }
     
+    // The monitor's latency reports would cut into the warm-up's rounds
+    if (warm) {
+        if (!warm_up() || !running_.load() || !open_listeners()) {
+            stop();
+            return false;
+        }
+    }
+    monitor_thread_ = std::thread(&UltraHFTServer::monitor_thread, this);
+    
     std::cout << "Ultra HFT Server started successfully" << std::endl;
     return true;
 }
 
+bool UltraHFTServer::warm_up() {
+    // One loopback connection per I/O worker, trading one instrument per lane
+    hft::WarmupDriver driver(config_.warmup, hft::warmup_instruments(
+        warmup_directory_ ? *warmup_directory_ : *instruments_, config_.strategy_threads));
+    std::vector<int> server_fds;
+    if (driver.connect(thread_count_, server_fds)) {
+        for (size_t i = 0; i < server_fds.size(); ++i) {
+            warmup_fds_[i].store(server_fds[i], std::memory_order_release);
+        }
+        hft::WarmupResult result = hft::run_warmup(config_.warmup, driver, [this] {
+            hft::LatencyReport report;
+            latency_->report(report);
+            return report.interval[static_cast<size_t>(hft::LatencyStage::SEND)].p99_ns;
+        }, running_);
+        hft::print_warmup(std::cout, result);
+    } else {
+        for (int fd : server_fds) {
+            close(fd);
+        }
+    }
+    
+    // Take back connections no worker adopted; the rest close like any
+    // client, and the pipeline drains their disconnects
+    for (uint32_t i = 0; i < thread_count_; ++i) {
+        int fd = warmup_fds_[i].exchange(-1, std::memory_order_acq_rel);
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    driver.close();
+    auto drained = [this] {
+        if (stats_.active_connections.load() != 0) {
+            return false;
+        }
+        for (auto& ring : ingress_rings_) {
+            if (ring->size() != 0) {
+                return false;
+            }
+        }
+        for (auto& ring : egress_rings_) {
+            if (ring->size() != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // Listening now could put live orders on the shadow lanes, so a stuck
+    // warm-up fails startup; the shadows stay alive until stop() joins the lanes
+    if (!hft::wait_until(drained, running_, 5000)) {
+        if (running_.load()) {
+            std::cerr << "Warm-up traffic still in the pipeline after 5 s" << std::endl;
+        }
+        return false;
+    }
+    
+    warming_.store(false, std::memory_order_release);
+    if (!hft::wait_until([this] { return warmed_up_.load(std::memory_order_acquire) == config_.strategy_threads; },
+                         running_, 5000)) {
+        if (running_.load()) {
+            std::cerr << "Not every strategy lane left warm-up within 5 s" << std::endl;
+        }
+        return false;
+    }
+    warmup_lanes_.clear();
+    
+    // Clients see counters and latency of their own traffic only
+    latency_->reset();
+    counters_->reset();
+    stats_.peak_connections.store(0);
+    connection_count_.store(0);
+    return true;
+}
+
+bool UltraHFTServer::poll_warmup(uint32_t worker_index, UltraWorkerShard& shard) {
+    int client_fd = warmup_fds_[worker_index].exchange(-1, std::memory_order_acq_rel);
+    if (client_fd != -1) {
+        sockaddr_in client_addr{};
+        socklen_t addr_len = sizeof(client_addr);
+        getpeername(client_fd, reinterpret_cast<sockaddr*>(&client_addr), &addr_len);
+        open_connection(worker_index, shard, client_fd, client_addr);
+    }
+    if (warming_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    thread_instruments = instruments_.get();
+    return false;
+}
+
 void UltraHFTServer::stop() {
     if (!running_.load()) return;
     
     std::cout << "Stopping Ultra HFT Server..." << std::endl;
     running_.store(false);
+    warming_.store(false);   // Releases strategy threads still on a shadow lane
     
-    // Join worker threads
-    for (auto& thread : worker_threads_) {
-        if (thread.joinable()) {
-            thread.join();
+    // Join worker threads, then the stages they feed
+    for (auto* threads : {&worker_threads_, &strategy_threads_, &egress_threads_}) {
+        for (auto& thread : *threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
         }
+        threads->clear();
     }
-    worker_threads_.clear();
-    
-    // Close sockets
-    if (epoll_fd_ >= 0) {
-        close(epoll_fd_);
-        epoll_fd_ = -1;
+    if (monitor_thread_.joinable()) {
+        monitor_thread_.join();
+    }
+    for (auto& lane : lanes_) {
+        if (lane->journal) {
+            lane->journal->close();
+        }
     }
     
-    if (server_socket_ >= 0) {
-        close(server_socket_);
-        server_socket_ = -1;
+    // Close sockets
+    close_shards();
+    if (feed_) {
+        feed_->stop();
     }
+    hft::AsyncLogger::instance().flush();
     
     std::cout << "Ultra HFT Server stopped" << std::endl;
 }
 
-void UltraHFTServer::worker_thread() {
-    constexpr int MAX_EVENTS = 64;
-    struct epoll_event events[MAX_EVENTS];
+void UltraHFTServer::enter_realtime(const char* role, uint32_t index) {
+    int priority = config_.busy_poll.realtime_priority;
+    if (priority > 0 && !hft::set_realtime_priority(priority)) {
+        std::cerr << role << " " << index << " failed to switch to SCHED_FIFO: " << strerror(errno) << std::endl;
+    }
+}
+
+void UltraHFTServer::worker_thread(uint32_t worker_index) {
+    std::vector<hft::TransportEvent> events(config_.event_batch);
+    
+    if (!cpu_affinity_.empty()) {
+        int cpu = cpu_affinity_[worker_index % cpu_affinity_.size()];
+        if (!hft::pin_current_thread(cpu)) {
+            std::cerr << "Worker " << worker_index << " failed to pin to CPU " << cpu << std::endl;
+        }
+    }
+    enter_realtime("Worker", worker_index);
+    thread_memory = arena_for(cpu_affinity_, worker_index);
+    
+    UltraWorkerShard& shard = *shards_[sharded_ ? worker_index : 0];
+    hft::Transport& transport = worker_transport(worker_index);
+    if (!transport.attach_thread()) {
+        return;
+    }
+    
+    // During warm-up the worker adopts the connection start() hands it; the
+    // listener opens afterwards
+    bool warming = warming_.load(std::memory_order_acquire);
+    thread_instruments = warming && warmup_directory_ ? warmup_directory_.get() : instruments_.get();
+    bool watching_listener = shard.transport != nullptr;  // Shared transports are set up by open_listeners()
+    
+    // Spinning workers never sleep in the kernel, so an idle socket that
+    // turns busy is picked up without a wakeup
+    int timeout_ms = config_.busy_poll.spin ? 0 : 1;
     
     while (running_.load()) {
-        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, 1);
+        if (warming) {
+            warming = poll_warmup(worker_index, shard);
+        }
+        if (!watching_listener && listening_.load(std::memory_order_acquire)) {
+            if (!transport.add_listener(shard.listen_fd, hft::ConnectionTable<UltraConnection>::INVALID_HANDLE)) {
+                HFT_LOG_ERROR("Worker {} failed to watch the listener", worker_index);
+                break;
+            }
+            watching_listener = true;
+        }
+        
+        int nfds = transport.wait(events.data(), static_cast<int>(events.size()), timeout_ms);
         if (nfds < 0) {
-            if (errno == EINTR) continue;
-            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            HFT_LOG_ERROR("Worker {} {} wait failed: {}", worker_index, hft::transport_name(transport.kind()),
+                          strerror(-nfds));
             break;
         }
         
         for (int i = 0; i < nfds; ++i) {
-            if (events[i].data.ptr == nullptr) {
-                // Server socket event - accept new connections
-                accept_connections();
-            } else {
-                // Client socket event
-                UltraConnection* conn = static_cast<UltraConnection*>(events[i].data.ptr);
-                if (conn && conn->is_active.load()) {
-                    handle_client_events(conn->fd);
+            const hft::TransportEvent& event = events[i];
+            switch (event.type) {
+                case hft::TransportEvent::ACCEPT:
+                    // Server socket event - accept new connections
+                    accept_connections(worker_index, shard);
+                    break;
+                case hft::TransportEvent::READABLE:
+                    // Client socket event
+                    handle_client_events(worker_index, shard, event.cookie);
+                    break;
+                case hft::TransportEvent::DATA:
+                    handle_client_data(worker_index, shard, event.cookie, event.data, event.length);
+                    break;
+                case hft::TransportEvent::WRITABLE:
+                    break; // Watched by the send threads' transports only
+                case hft::TransportEvent::CLOSED: {
+                    UltraConnection* conn = shard.connections.find(event.cookie);
+                    if (conn && conn->is_active.load()) {
+                        close_connection(worker_index, conn);
+                    }
+                    break;
                 }
             }
         }
         
-        // Process message queue
-        process_message_queue();
-        
-        // Print stats periodically
-        static uint64_t last_print = 0;
-        uint64_t now = UltraMessage::get_current_timestamp();
-        if (now - last_print > 1000000000) { // Every second
-            print_stats();
-            last_print = now;
+        if (!paused_reads_[worker_index].empty()) {
+            resume_paused_reads(worker_index, shard);
         }
+        
+        expire_sessions(worker_index, shard);
     }
 }
 
-void UltraHFTServer::accept_connections() {
+void UltraHFTServer::accept_connections(uint32_t worker_index, UltraWorkerShard& shard) {
     while (true) {
         struct sockaddr_in client_addr;
         socklen_t addr_len = sizeof(client_addr);
         
-        int client_fd = accept(server_socket_, (struct sockaddr*)&client_addr, &addr_len);
+        int client_fd = accept(shard.listen_fd, (struct sockaddr*)&client_addr, &addr_len);
         if (client_fd < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break; // No more connections to accept
             }
-            std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+            HFT_LOG_WARN("Accept failed: {}", strerror(errno));
             break;
         }
+        open_connection(worker_index, shard, client_fd, client_addr);
+    }
+}
+
+void UltraHFTServer::open_connection(uint32_t worker_index, UltraWorkerShard& shard, int client_fd,
+                                     const sockaddr_in& client_addr) {
+    // Setup client socket for ultra-low latency
+    if (!setup_socket_options(client_fd) || !set_non_blocking(client_fd)) {
+        close(client_fd);
+        return;
+    }
+    
+    // Claim a connection slot (slot objects are reused, so reset every field)
+    uint64_t handle;
+    UltraConnection* conn = shard.connections.acquire(handle);
+    if (!conn) {
+        HFT_LOG_WARN("Connection table full on shard {}", shard.id);
+        close(client_fd);
+        return;
+    }
+    conn->fd = client_fd;
+    conn->addr = client_addr;
+    conn->client_id = connection_count_.fetch_add(1);
+    conn->handle = handle;
+    conn->shard = &shard;
+    conn->market_data_subscriber = hft::MarketDataFanout::INVALID_SUBSCRIBER;
+    conn->account = hft::RiskEngine::NO_ACCOUNT;
+    conn->recv_buffer.reset();
+    conn->send_congested.store(false);
+    conn->read_paused = false;
+    conn->is_authenticated.store(!config_.session.require_login);
+    conn->metrics = metrics_ ? metrics_->connection(shard.id, shard.connections.index_of(handle)) : nullptr;
+    if (conn->metrics) {
+        conn->metrics->opened(make_connection_ref(shard.id, handle), conn->client_id);
+    }
+    conn->is_active.store(true);
+    
+    uint64_t now = UltraMessage::get_current_timestamp();
+    conn->session.reset(handle, now);
+    uint64_t deadline = hft::Session::first_deadline(config_.session, now);
+    if (deadline != 0) {
+        std::lock_guard<std::mutex> lock(shard.timer_lock);
+        shard.timers.schedule(conn->session.timer, deadline);
+    }
+    
+    // The accepting worker's transport owns the socket from here on
+    hft::Transport& transport = worker_transport(worker_index);
+    if (!transport.add_connection(client_fd, handle)) {
+        HFT_LOG_WARN("Failed to add client to {}: {}", hft::transport_name(transport.kind()), strerror(errno));
+        conn->is_active.store(false);
+        {
+            std::lock_guard<std::mutex> lock(shard.timer_lock);
+            shard.timers.cancel(conn->session.timer);
+        }
+        close(client_fd);
+        shard.connections.release(handle);
+        return;
+    }
+    
+    uint64_t client_id = conn->client_id;
+    
+    // Update stats
+    uint64_t active = stats_.active_connections.fetch_add(1) + 1;
+    uint64_t peak = stats_.peak_connections.load();
+    while (active > peak && !stats_.peak_connections.compare_exchange_weak(peak, active)) {}
+    
+    HFT_LOG_INFO("New connection accepted on shard {}: {}:{} (ID: {})", shard.id,
+                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), client_id);
+}
+
+void UltraHFTServer::handle_client_events(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle) {
+    // Stale handles (connection already closed) resolve to nullptr
+    UltraConnection* conn = shard.connections.find(handle);
+    if (!conn || !conn->is_active.load()) return;
+    int client_fd = conn->fd;
+    
+    // Drain the socket into the connection's reassembly buffer
+    hft::FrameBuffer& buffer = conn->recv_buffer;
+    hft::LatencyRecorder& latency = latency_->recorder(worker_index);
+    while (true) {
+        // A client that does not read its responses stops being read; left
+        // un-armed until the send thread clears the flag
+        if (conn->send_congested.load(std::memory_order_acquire)) {
+            if (!conn->read_paused) {
+                conn->read_paused = true;
+                paused_reads_[worker_index].push_back(handle);
+            }
+            return;
+        }
         
-        // Setup client socket for ultra-low latency
-        if (!setup_socket_options(client_fd) || !set_non_blocking(client_fd)) {
-            close(client_fd);
-            continue;
+        size_t space = buffer.writable();
+        if (space == 0) {
+            HFT_LOG_WARN("Receive buffer overflow on fd {}", client_fd);
+            counters_->block(worker_index).add(hft::Counter::RECV_OVERFLOW);
+            close_connection(worker_index, conn);
+            return;
         }
         
-        // Create new connection
-        auto conn = std::make_unique<UltraConnection>();
-        conn->fd = client_fd;
-        conn->addr = client_addr;
-        conn->last_heartbeat = UltraMessage::get_current_timestamp();
-        conn->client_id = connection_count_.fetch_add(1);
-        conn->is_authenticated.store(true);
+        uint64_t read_start = UltraMessage::get_current_timestamp();
+        ssize_t bytes_read = recv(client_fd, buffer.write_ptr(), space, MSG_DONTWAIT);
+        if (bytes_read <= 0) {
+            if (bytes_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                worker_transport(worker_index).rearm_connection(client_fd, handle);
+                return; // No more data available
+            }
+            close_connection(worker_index, conn);
+            return;
+        }
         
-        // Add to epoll
-        struct epoll_event ev;
-        ev.events = EPOLLIN | EPOLLET;
-        ev.data.ptr = conn.get();
+        // Every frame completed by this read shares its receive time
+        uint64_t receive_time = UltraMessage::get_current_timestamp();
+        latency.record(hft::LatencyStage::RECEIVE, receive_time - read_start);
+        counters_->block(worker_index).add(hft::Counter::BYTES_IN, static_cast<uint64_t>(bytes_read));
+        if (conn->metrics) {
+            conn->metrics->received(static_cast<uint64_t>(bytes_read));
+        }
+        buffer.commit(static_cast<size_t>(bytes_read));
         
-        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
-            std::cerr << "Failed to add client to epoll: " << strerror(errno) << std::endl;
-            close(client_fd);
+        if (!drain_frames(worker_index, conn, receive_time)) {
+            close_connection(worker_index, conn);
+            return;
+        }
+    }
+}
+
+void UltraHFTServer::resume_paused_reads(uint32_t worker_index, UltraWorkerShard& shard) {
+    // Resuming can pause the connection again, which appends to the list
+    std::vector<uint64_t> paused;
+    paused.swap(paused_reads_[worker_index]);
+    
+    for (uint64_t handle : paused) {
+        UltraConnection* conn = shard.connections.find(handle);
+        if (!conn || !conn->is_active.load()) continue;
+        if (conn->send_congested.load(std::memory_order_acquire)) {
+            paused_reads_[worker_index].push_back(handle);
             continue;
         }
+        conn->read_paused = false;
+        handle_client_events(worker_index, shard, handle);
+    }
+}
+
+void UltraHFTServer::handle_client_data(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle,
+                                        const uint8_t* data, size_t length) {
+    // Data still queued for a connection that has since closed is dropped
+    UltraConnection* conn = shard.connections.find(handle);
+    if (!conn || !conn->is_active.load()) return;
+    
+    hft::FrameBuffer& buffer = conn->recv_buffer;
+    hft::LatencyRecorder& latency = latency_->recorder(worker_index);
+    while (length > 0) {
+        size_t space = buffer.writable();
+        if (space == 0) {
+            HFT_LOG_WARN("Receive buffer overflow on fd {}", conn->fd);
+            counters_->block(worker_index).add(hft::Counter::RECV_OVERFLOW);
+            close_connection(worker_index, conn);
+            return;
+        }
         
-        // Store connection
-        connections_.push_back(std::move(conn));
+        uint64_t copy_start = UltraMessage::get_current_timestamp();
+        size_t chunk = std::min(space, length);
+        memcpy(buffer.write_ptr(), data, chunk);
+        buffer.commit(chunk);
+        data += chunk;
+        length -= chunk;
         
-        // Update stats
-        uint64_t active = stats_.active_connections.fetch_add(1) + 1;
-        uint64_t peak = stats_.peak_connections.load();
-        while (active > peak && !stats_.peak_connections.compare_exchange_weak(peak, active)) {}
+        uint64_t receive_time = UltraMessage::get_current_timestamp();
+        latency.record(hft::LatencyStage::RECEIVE, receive_time - copy_start);
+        counters_->block(worker_index).add(hft::Counter::BYTES_IN, chunk);
+        if (conn->metrics) {
+            conn->metrics->received(chunk);
+        }
         
-        std::cout << "New connection accepted: " << inet_ntoa(client_addr.sin_addr) 
-                  << ":" << ntohs(client_addr.sin_port) << " (ID: " << conn->client_id << ")" << std::endl;
+        if (!drain_frames(worker_index, conn, receive_time)) {
+            close_connection(worker_index, conn);
+            return;
+        }
     }
 }
 
-void UltraHFTServer::handle_client_events(int client_fd) {
-    // Find connection
-    UltraConnection* conn = nullptr;
-    for (auto& c : connections_) {
-        if (c->fd == client_fd) {
-            conn = c.get();
-            break;
-        }
-    }
-    
-    if (!conn) return;
+bool UltraHFTServer::drain_frames(uint32_t worker_index, UltraConnection* conn, uint64_t receive_time) {
+    hft::FrameBuffer& buffer = conn->recv_buffer;
+    hft::LatencyRecorder& latency = latency_->recorder(worker_index);
+    hft::CounterBlock& counters = counters_->block(worker_index);
+    uint64_t connection = make_connection_ref(conn->shard->id, conn->handle);
+    IngressEvent event;
+    event.connection = connection;
+    event.receive_time = receive_time;
     
-    // Get receive buffer
-    UltraMessage* msg = get_next_recv_buffer();
-    if (!msg) return;
+    uint32_t offsets[hft::wire::SCAN_BATCH];
+    conn->session.touch(receive_time);
     
-    // Receive data
-    ssize_t bytes_read = recv(client_fd, msg, sizeof(UltraMessage), MSG_DONTWAIT);
-    if (bytes_read <= 0) {
-        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-            return; // No data available
+    while (true) {
+        // Headers are located and validated a batch at a time, then decoded in order
+        hft::wire::FrameScan scan = hft::wire::scan_frames(buffer.read_ptr(), buffer.readable(), offsets);
+        for (uint32_t i = 0; i < scan.count; ++i) {
+            const uint8_t* frame = buffer.read_ptr() + offsets[i];
+            hft::MessageType type = hft::wire::frame_type(frame);
+            counters.count_message(static_cast<uint8_t>(type));
+            
+            // Logins, heartbeats and out-of-sequence frames stop here
+            hft::Session::Action action = conn->session.on_frame(type, hft::wire::frame_sequence(frame),
+                                                                 config_.session.require_login);
+            if (action != hft::Session::Action::DISPATCH) {
+                if (!session_frame(worker_index, conn, frame, action)) {
+                    return false;
+                }
+                continue;
+            }
+        
+            // Decode here, match on the strategy lane that owns the symbol
+            switch (type) {
+                case hft::MessageType::ORDER_NEW:
+                case hft::MessageType::ORDER_CANCEL:
+                case hft::MessageType::ORDER_REPLACE: {
+                    event.kind = IngressEvent::ORDER;
+                    decode(frame, event.order);
+                    event.order.instrument = thread_instruments->resolve(event.order.symbol);
+                    event.order.account = conn->account;
+                    latency.record(hft::LatencyStage::DECODE, UltraMessage::get_current_timestamp() - receive_time);
+                    push_ingress(worker_index, lane_for(event.order.instrument), event);
+                    break;
+                }
+                case hft::MessageType::MARKET_DATA: {
+                    event.kind = IngressEvent::MARKET_DATA;
+                    decode(frame, event.market_data);
+                    event.market_data.instrument = thread_instruments->resolve(event.market_data.symbol);
+                    latency.record(hft::LatencyStage::DECODE, UltraMessage::get_current_timestamp() - receive_time);
+                    push_ingress(worker_index, lane_for(event.market_data.instrument), event);
+                    break;
+                }
+                case hft::MessageType::MARKET_DATA_SUBSCRIBE:
+                case hft::MessageType::MARKET_DATA_UNSUBSCRIBE: {
+                    event.kind = IngressEvent::SUBSCRIPTION;
+                    decode(frame, event.subscription);
+                    event.subscription.instrument = thread_instruments->resolve(event.subscription.symbol);
+                
+                    // This worker owns the connection, so registering here cannot race;
+                    // the symbol's lane then subscribes in order with its publishes
+                    if (conn->market_data_subscriber == hft::MarketDataFanout::INVALID_SUBSCRIBER &&
+                        event.subscription.message_type == static_cast<uint32_t>(hft::MessageType::MARKET_DATA_SUBSCRIBE)) {
+                        conn->market_data_subscriber = fanout_->add_subscriber(connection, sender_for(connection));
+                    }
+                    event.subscription.subscriber = conn->market_data_subscriber;
+                    latency.record(hft::LatencyStage::DECODE, UltraMessage::get_current_timestamp() - receive_time);
+                    push_ingress(worker_index, lane_for(event.subscription.instrument), event);
+                    break;
+                }
+                case hft::MessageType::FEED_RETRANSMIT_REQUEST:
+                case hft::MessageType::FEED_SNAPSHOT_REQUEST: {
+                    // Not tied to a symbol: any lane can read the feed's history
+                    event.kind = IngressEvent::RECOVERY;
+                    decode(frame, event.recovery);
+                    latency.record(hft::LatencyStage::DECODE, UltraMessage::get_current_timestamp() - receive_time);
+                    push_ingress(worker_index, static_cast<uint32_t>(conn->handle % config_.strategy_threads), event);
+                    break;
+                }
+                default: {
+                    UltraMessage msg;
+                    decode(frame, msg);
+                    HFT_LOG_WARN("Unknown message type: {}", msg.message_type);
+                        break;
+                }
+            }
+        }
+        buffer.consume(scan.bytes);
+        if (conn->metrics) {
+            conn->metrics->decoded(scan.count);
+        }
+        
+        if (scan.malformed) {
+            HFT_LOG_WARN("Malformed frame on fd {}", conn->fd);
+            counters.add(hft::Counter::MALFORMED);
+            return false;
         }
-        close_connection(conn);
+        if (scan.count < hft::wire::SCAN_BATCH) {
+            return true;
+        }
+    }
+}
+
+bool UltraHFTServer::session_frame(uint32_t worker_index, UltraConnection* conn, const uint8_t* frame,
+                                   hft::Session::Action action) {
+    hft::CounterBlock& counters = counters_->block(worker_index);
+    hft::MessageType type = hft::wire::frame_type(frame);
+    uint32_t sequence = hft::wire::frame_sequence(frame);
+    
+    switch (action) {
+        case hft::Session::Action::LOGIN:
+            // LOGIN's message_id names the account, if any
+            conn->is_authenticated.store(true);
+            conn->account = hft::wire::read_header(frame).message_id;
+            counters.add(hft::Counter::LOGINS);
+            push_session_frame(worker_index, conn, hft::MessageType::LOGIN, conn->session.next_inbound(),
+                               hft::wire::read_header(frame).message_id);
+            break;
+        case hft::Session::Action::LOGOUT:
+            // The client closes the connection, or the idle timeout does
+            conn->is_authenticated.store(!config_.session.require_login);
+            push_session_frame(worker_index, conn, hft::MessageType::LOGOUT, conn->session.next_inbound(),
+                               hft::wire::read_header(frame).message_id);
+            break;
+        case hft::Session::Action::RESEND:
+            // Names the sequence expected; message_id carries the one that arrived
+            counters.add(hft::Counter::SEQUENCE_GAPS);
+            push_session_frame(worker_index, conn, hft::MessageType::RESEND_REQUEST, conn->session.next_inbound(),
+                               sequence);
+            break;
+        case hft::Session::Action::DROP:
+            if (type != hft::MessageType::HEARTBEAT) {
+                counters.add(hft::Counter::DUPLICATES);
+            }
+            break;
+        case hft::Session::Action::REJECT:
+            HFT_LOG_WARN("Session rejected {} on fd {}", hft::message_type_name(type), conn->fd);
+            counters.add(hft::Counter::SESSION_REJECTS);
+            return false;
+        case hft::Session::Action::DISPATCH:
+            break;
+    }
+    return true;
+}
+
+void UltraHFTServer::push_session_frame(uint32_t worker_index, UltraConnection* conn, hft::MessageType type,
+                                        uint32_t sequence, uint64_t message_id) {
+    // Any lane can encode a header-only frame; the connection's recovery lane keeps them in order
+    IngressEvent event;
+    event.kind = IngressEvent::SESSION;
+    event.connection = make_connection_ref(conn->shard->id, conn->handle);
+    event.receive_time = UltraMessage::get_current_timestamp();
+    event.session = UltraMessage();
+    event.session.message_type = static_cast<uint32_t>(type);
+    event.session.message_id = message_id;
+    event.session.timestamp = UltraMessage::get_wall_timestamp();
+    event.session.sequence_number = sequence;
+    push_ingress(worker_index, static_cast<uint32_t>(conn->handle % config_.strategy_threads), event);
+}
+
+void UltraHFTServer::expire_sessions(uint32_t worker_index, UltraWorkerShard& shard) {
+    if (!config_.session.timers() || !shard.timer_lock.try_lock()) {
+        return; // Another worker of the shard is advancing the wheel
+    }
+    std::lock_guard<std::mutex> lock(shard.timer_lock, std::adopt_lock);
+    shard.timers.advance(UltraMessage::get_current_timestamp(), [&](hft::TimerWheel::Timer& timer) {
+        expire_session(worker_index, shard, timer.cookie);
+    });
+}
+
+void UltraHFTServer::expire_session(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle) {
+    // Caller holds timer_lock, and close_connection() cancels under it before
+    // closing the descriptor, so fd stays valid while this runs
+    UltraConnection* conn = shard.connections.find(handle);
+    if (!conn || !conn->is_active.load()) {
         return;
     }
+    hft::Session::TimerResult result = conn->session.on_timer(config_.session, UltraMessage::get_current_timestamp());
     
-    if (bytes_read < sizeof(UltraMessage)) {
-        return; // Incomplete message
+    if (result.idle) {
+        // Like a slow client: the shutdown makes its I/O worker close the connection
+        HFT_LOG_WARN("No data from fd {} for {} ms, disconnecting", conn->fd, config_.session.idle_timeout_ms);
+        counters_->block(worker_index).add(hft::Counter::IDLE_TIMEOUTS);
+        shutdown(conn->fd, SHUT_RDWR);
+        return;
     }
+    if (result.heartbeat) {
+        push_session_frame(worker_index, conn, hft::MessageType::HEARTBEAT, conn->session.next_inbound(), 0);
+    }
+    if (result.next_ns != 0) {
+        shard.timers.schedule(conn->session.timer, result.next_ns);
+    }
+}
+
+void UltraHFTServer::push_ingress(uint32_t worker_index, uint32_t lane_index, const IngressEvent& event) {
+    IngressRing& ring = *ingress_rings_[worker_index * config_.strategy_threads + lane_index];
+    if (ring.push(event)) return;
     
-    // Update timestamp for latency measurement
-    uint64_t receive_time = UltraMessage::get_current_timestamp();
-    uint64_t latency = receive_time - msg->timestamp;
+    // Strategy lane is behind: hold this socket back rather than drop orders
+    counters_->block(worker_index).add(hft::Counter::INGRESS_FULL);
+    Backoff backoff(config_.io_backoff);
+    while (!ring.push(event)) {
+        if (!running_.load(std::memory_order_relaxed)) return;
+        backoff.idle();
+    }
+}
+
+void UltraHFTServer::strategy_thread(uint32_t lane_index) {
+    if (!config_.strategy_cpu_affinity.empty()) {
+        int cpu = config_.strategy_cpu_affinity[lane_index % config_.strategy_cpu_affinity.size()];
+        if (!hft::pin_current_thread(cpu)) {
+            std::cerr << "Strategy thread " << lane_index << " failed to pin to CPU " << cpu << std::endl;
+        }
+    }
+    enter_realtime("Strategy thread", lane_index);
+    thread_memory = arena_for(config_.strategy_cpu_affinity, lane_index);
     
-    // Update statistics
-    update_stats(latency);
+    // Warm-up orders go to a shadow of the lane until start() is done with them
+    if (!warmup_lanes_.empty()) {
+        run_lane(*warmup_lanes_[lane_index], warming_);
+        warmed_up_.fetch_add(1, std::memory_order_release);
+    }
+    run_lane(*lanes_[lane_index], running_);
+}
+
+void UltraHFTServer::run_lane(StrategyLane& lane, const std::atomic<bool>& active) {
+    // Per ring per pass, so one busy worker cannot starve the rest
+    const size_t max_batch = config_.stage_batch;
+    Backoff backoff(config_.strategy_backoff);
     
-    // Process message
-    process_message(msg, conn);
+    while (active.load(std::memory_order_relaxed)) {
+        bool worked = false;
+        for (uint32_t worker = 0; worker < thread_count_; ++worker) {
+            // Events are processed in place and the ring slots released in one publish
+            IngressRing& ring = *ingress_rings_[worker * config_.strategy_threads + lane.id];
+            worked |= ring.consume_bulk([&](const IngressEvent& event) { process_event(lane, event); },
+                                        max_batch) > 0;
+        }
+        
+        if (worked) {
+            backoff.reset();
+        } else {
+            backoff.idle();
+        }
+    }
 }
 
-void UltraHFTServer::process_message(UltraMessage* msg, UltraConnection* conn) {
-    if (!msg || !conn) return;
+void UltraHFTServer::process_event(StrategyLane& lane, const IngressEvent& event) {
+    lane.receive_time = event.receive_time;
     
-    // Dispatch based on message type
-    switch (msg->message_type) {
-        case 1: // ORDER_NEW
-            process_order_message(reinterpret_cast<UltraOrderMessage*>(msg), conn);
+    switch (event.kind) {
+        case IngressEvent::ORDER:
+            process_order_message(lane, &event.order, event.connection);
+            lane.latency->record(hft::LatencyStage::DISPATCH,
+                                 UltraMessage::get_current_timestamp() - event.receive_time);
+            break;
+        case IngressEvent::MARKET_DATA:
+            process_market_data_message(lane, &event.market_data, event.connection);
+            lane.latency->record(hft::LatencyStage::DISPATCH,
+                                 UltraMessage::get_current_timestamp() - event.receive_time);
             break;
-        case 2: // MARKET_DATA
-            process_market_data_message(reinterpret_cast<UltraMarketDataMessage*>(msg), conn);
+        case IngressEvent::SUBSCRIPTION:
+            process_subscription_message(lane, &event.subscription, event.connection);
             break;
+        case IngressEvent::RECOVERY:
+            process_recovery_message(lane, &event.recovery, event.connection);
+            break;
+        case IngressEvent::SESSION:
+            publish_response(lane, event.connection, &event.session);
+            break;
+        case IngressEvent::DISCONNECT: {
+            // Cancel-on-disconnect; arrives after every order the connection sent.
+            // Lanes have stopped before a shutdown closes connections, so
+            // those cancels never reach the journal and a restart keeps the orders
+            size_t cancelled = lane.engine.cancel_all(event.connection);
+            if (cancelled > 0) {
+                HFT_LOG_INFO("Lane {} cancelled {} resting orders on disconnect", lane.id, cancelled);
+                if (lane.journal) {
+                    lane.journal->append_disconnect(event.connection);
+                }
+            }
+            
+            // One lane passes the close on to the send thread, behind the frames it queued
+            if (connection_ref_handle(event.connection) % config_.strategy_threads == lane.id) {
+                EgressEvent close;
+                close.connection = event.connection;
+                close.receive_time = event.receive_time;
+                close.kind = EgressEvent::CLOSE;
+                publish_frame(lane, close);
+            }
+            break;
+        }
         default:
-            std::cout << "Unknown message type: " << msg->message_type << std::endl;
             break;
     }
+}
+
+void UltraHFTServer::process_order_message(StrategyLane& lane, const UltraOrderMessage* msg, uint64_t connection) {
+    if (!msg) return;
+    
+    // Each lane owns its symbols' books and risk state outright, so neither takes a lock
+    auto message_type = static_cast<hft::MessageType>(msg->message_type);
+    auto side = static_cast<hft::OrderSide>(msg->side);
+    auto type = static_cast<hft::OrderType>(msg->order_type);
+    uint64_t check_price = type == hft::OrderType::MARKET ? 0 : msg->price;
+    auto quantity = static_cast<uint32_t>(msg->quantity);
+    hft::OrderResult result = hft::OrderResult::ACCEPTED;
+    if (message_type != hft::MessageType::ORDER_CANCEL) {
+        result = lane.instruments->check_order(msg->instrument, check_price, quantity);
+        if (!hft::is_rejected(result)) {
+            uint32_t replaced = message_type == hft::MessageType::ORDER_REPLACE
+                ? lane.engine.open_quantity(msg->instrument, msg->order_id, connection) : 0;
+            result = lane.risk->check_order(client_index(connection), connection, msg->account, msg->instrument,
+                                            side, check_price, quantity, replaced, lane.receive_time);
+        }
+    }
+    if (!hft::is_rejected(result)) {
+        if (lane.journal) {
+            // Write-ahead, in the same wire form the client sent
+            uint8_t frame[hft::wire::MAX_FRAME_SIZE];
+            size_t length;
+            if (message_type == hft::MessageType::ORDER_CANCEL) {
+                hft::wire::CancelBody body{};
+                memcpy(body.symbol, msg->symbol, sizeof(body.symbol));
+                body.order_id = hft::wire::to_wire(msg->order_id);
+                length = hft::wire::write_frame(frame, message_type, msg->message_id,
+                                                msg->timestamp, msg->sequence_number, &body);
+            } else {
+                hft::wire::OrderBody body = hft::wire::make_order_body(
+                    msg->symbol, sizeof(msg->symbol), msg->order_id, 0, msg->price, 0, quantity, side, type,
+                    static_cast<hft::TimeInForce>(msg->time_in_force));
+                length = hft::wire::write_frame(frame, message_type, msg->message_id,
+                                                msg->timestamp, msg->sequence_number, &body);
+            }
+            lane.journal->append_frame(connection, frame, length);
+        }
+        if (message_type == hft::MessageType::ORDER_CANCEL) {
+            result = lane.engine.cancel_order(msg->instrument, msg->order_id, connection);
+        } else if (message_type == hft::MessageType::ORDER_REPLACE) {
+            result = lane.engine.replace_order(msg->instrument, msg->order_id, msg->price, quantity, connection);
+        } else {
+            result = lane.engine.submit_order(msg->instrument,
+                                              hft::MatchingEngine::symbol_view(msg->symbol, sizeof(msg->symbol)),
+                                              msg->order_id, side, type,
+                                              static_cast<hft::TimeInForce>(msg->time_in_force),
+                                              msg->price, quantity, connection);
+        }
+    }
+    
+    HFT_LOG_DEBUG("Processing {}: {} {} {} @ {} (ID: {}) -> {}", hft::message_type_name(message_type), msg->symbol,
+                  side == hft::OrderSide::BUY ? "BUY" : "SELL", msg->quantity, msg->price, msg->message_id,
+                  hft::order_result_name(result));
+    
+    // Send acknowledgment; the staging message returns to the pool on scope exit
+    hft::PoolPtr<UltraMessage> response = send_message_pool().acquire_owned();
+    if (response) {
+        response->message_id = msg->message_id;
+        response->timestamp = UltraMessage::get_wall_timestamp();
+        response->message_type = static_cast<uint32_t>(hft::is_rejected(result)
+            ? hft::MessageType::ORDER_REJECT : hft::MessageType::ORDER_ACK);
+        response->sequence_number = 0;
+        
+        publish_response(lane, connection, response.get());
+    }
+}
+
+void UltraHFTServer::StrategyLane::on_fill(const hft::FillMessage& fill, uint64_t owner) {
+    // owner is the connection ref the order was submitted with, or a
+    // replayed order's token, which has no connection to report to
+    if (hft::JournalOwnerMap::is_recovered(owner)) return;
+    risk->on_fill(server->client_index(owner), owner, fill.instrument, fill.side, fill.fill_quantity);
+    
+    EgressEvent event;
+    event.connection = owner;
+    event.receive_time = receive_time;
+    event.length = static_cast<uint32_t>(hft::wire::encode(fill, event.frame));
+    server->publish_frame(*this, event);
+}
+
+void UltraHFTServer::StrategyLane::on_resting(hft::InstrumentId instrument, hft::OrderSide side, int64_t change,
+                                              uint64_t owner) {
+    if (hft::JournalOwnerMap::is_recovered(owner)) return;
+    risk->on_resting(server->client_index(owner), owner, instrument, side, change);
+}
+
+void UltraHFTServer::process_market_data_message(StrategyLane& lane, const UltraMarketDataMessage* msg, uint64_t connection) {
+    if (!msg) return;
+    
+    HFT_LOG_DEBUG("Processing MARKET_DATA: {} Bid: {}x{} Ask: {}x{} (ID: {})", msg->symbol,
+                  msg->bid_price, msg->bid_size, msg->ask_price, msg->ask_size, msg->message_id);
+    
+    // Encoded once here; the send threads write it to every subscriber
+    hft::wire::MarketDataBody body = hft::wire::make_market_data_body(
+        msg->symbol, sizeof(msg->symbol), msg->bid_price, static_cast<uint32_t>(msg->bid_size),
+        msg->ask_price, static_cast<uint32_t>(msg->ask_size), msg->last_price, static_cast<uint32_t>(msg->last_size),
+        msg->volume, msg->high_price, msg->low_price);
+    
+    // This lane owns the instrument, so it is the cache line's only writer
+    hft::TopOfBook quote;
+    quote.bid_price = msg->bid_price;
+    quote.bid_size = static_cast<uint32_t>(msg->bid_size);
+    quote.ask_price = msg->ask_price;
+    quote.ask_size = static_cast<uint32_t>(msg->ask_size);
+    quote.last_price = msg->last_price;
+    quote.last_size = static_cast<uint32_t>(msg->last_size);
+    quote.volume = msg->volume;
+    quote.high_price = msg->high_price;
+    quote.low_price = msg->low_price;
+    market_state_->update(msg->instrument, quote);
+    fanout_->publish(msg->instrument, body, msg->message_id);
+    if (feed_ && msg->instrument != hft::NO_INSTRUMENT) {
+        feed_->publish(msg->instrument, body);
+    }
     
-    // Update message count
-    stats_.total_messages.fetch_add(1);
+    // Send acknowledgment; the staging message returns to the pool on scope exit
+    hft::PoolPtr<UltraMessage> response = send_message_pool().acquire_owned();
+    if (response) {
+        response->message_id = msg->message_id;
+        response->timestamp = UltraMessage::get_wall_timestamp();
+        response->message_type = static_cast<uint32_t>(hft::MessageType::MARKET_DATA_ACK);
+        response->sequence_number = 0;
+        
+        publish_response(lane, connection, response.get());
+    }
 }
 
-void UltraHFTServer::process_order_message(UltraOrderMessage* msg, UltraConnection* conn) {
-    if (!msg || !conn) return;
+void UltraHFTServer::process_subscription_message(StrategyLane& lane, const UltraSubscriptionMessage* msg,
+                                                  uint64_t connection) {
+    if (!msg) return;
     
-    std::cout << "Processing ORDER: " << msg->symbol 
-              << " " << (msg->side == 0 ? "BUY" : "SELL")
-              << " " << msg->quantity << " @ " << msg->price
-              << " (ID: " << msg->message_id << ")" << std::endl;
+    std::string_view symbol = hft::MatchingEngine::symbol_view(msg->symbol, sizeof(msg->symbol));
+    bool subscribe = msg->message_type == static_cast<uint32_t>(hft::MessageType::MARKET_DATA_SUBSCRIBE);
+    bool ok = subscribe ? fanout_->subscribe(msg->subscriber, msg->instrument)
+                        : fanout_->unsubscribe(msg->subscriber, msg->instrument);
+    
+    HFT_LOG_INFO("Lane {} {} {} -> {}", lane.id, subscribe ? "subscribe" : "unsubscribe", symbol,
+                 ok ? "OK" : "FAILED");
+    
+    // Cached top of book first, sequenced by the update count it reflects;
+    // live updates at or below it can be discarded
+    hft::TopOfBook state;
+    if (ok && subscribe && market_state_->read(msg->instrument, state)) {
+        hft::wire::MarketDataBody body = hft::wire::make_market_data_body(
+            msg->symbol, sizeof(msg->symbol), state.bid_price, state.bid_size, state.ask_price, state.ask_size,
+            state.last_price, state.last_size, state.volume, state.high_price, state.low_price);
+        EgressEvent event;
+        event.connection = connection;
+        event.receive_time = lane.receive_time;
+        event.length = static_cast<uint32_t>(hft::wire::write_frame(
+            event.frame, hft::MessageType::MARKET_DATA, msg->message_id, UltraMessage::get_wall_timestamp(),
+            state.updates, &body));
+        publish_frame(lane, event);
+    }
     
-    // Send acknowledgment (zero-copy)
-    UltraMessage* response = get_next_send_buffer();
+    hft::PoolPtr<UltraMessage> response = send_message_pool().acquire_owned();
     if (response) {
         response->message_id = msg->message_id;
-        response->timestamp = UltraMessage::get_current_timestamp();
-        response->message_type = 3; // ORDER_ACK
+        response->timestamp = UltraMessage::get_wall_timestamp();
+        response->message_type = static_cast<uint32_t>(ok ? hft::MessageType::MARKET_DATA_ACK
+                                                           : hft::MessageType::ERROR);
+        response->sequence_number = 0;
         
-        send_response(conn, response);
+        publish_response(lane, connection, response.get());
     }
 }
 
-void UltraHFTServer::process_market_data_message(UltraMarketDataMessage* msg, UltraConnection* conn) {
-    if (!msg || !conn) return;
+void UltraHFTServer::process_recovery_message(StrategyLane& lane, const UltraRecoveryMessage* msg,
+                                              uint64_t connection) {
+    if (!msg) return;
+    
+    // Recovered updates as FEED_UPDATE frames, then an ack whose sequence is their count
+    thread_local std::vector<hft::FeedUpdate> updates;
+    bool retransmit = msg->message_type == static_cast<uint32_t>(hft::MessageType::FEED_RETRANSMIT_REQUEST);
+    bool ok = feed_ != nullptr;
+    updates.clear();
+    if (ok && retransmit) {
+        ok = feed_->retransmit(msg->start, msg->count, updates);
+    } else if (ok) {
+        feed_->snapshot(msg->start, msg->count, updates);
+    }
     
-    std::cout << "Processing MARKET_DATA: " << msg->symbol
-              << " Bid: " << msg->bid_price << "x" << msg->bid_size
-              << " Ask: " << msg->ask_price << "x" << msg->ask_size
-              << " (ID: " << msg->message_id << ")" << std::endl;
+    HFT_LOG_INFO("Lane {} {} from {} x{} -> {} updates{}", lane.id, retransmit ? "retransmit" : "snapshot",
+                 msg->start, msg->count, updates.size(), ok ? "" : " (unavailable)");
     
-    // Send acknowledgment (zero-copy)
-    UltraMessage* response = get_next_send_buffer();
+    EgressEvent event;
+    event.connection = connection;
+    event.receive_time = lane.receive_time;
+    uint64_t now = UltraMessage::get_wall_timestamp();
+    for (const hft::FeedUpdate& update : updates) {
+        event.length = static_cast<uint32_t>(
+            hft::wire::encode_feed_update(event.frame, update.sequence, now, update.body));
+        publish_frame(lane, event);
+    }
+    
+    hft::PoolPtr<UltraMessage> response = send_message_pool().acquire_owned();
     if (response) {
         response->message_id = msg->message_id;
-        response->timestamp = UltraMessage::get_current_timestamp();
-        response->message_type = 4; // MARKET_DATA_ACK
+        response->timestamp = now;
+        response->message_type = static_cast<uint32_t>(ok ? hft::MessageType::MARKET_DATA_ACK
+                                                           : hft::MessageType::ERROR);
+        response->sequence_number = static_cast<uint32_t>(updates.size());
         
-        send_response(conn, response);
+        publish_response(lane, connection, response.get());
     }
 }
 
-void UltraHFTServer::process_message_queue() {
-    UltraMessage* msg;
+void UltraHFTServer::publish_response(StrategyLane& lane, uint64_t connection, const UltraMessage* msg) {
+    EgressEvent event;
+    event.connection = connection;
+    event.receive_time = lane.receive_time;
+    event.length = static_cast<uint32_t>(hft::wire::encode_header_only(
+        event.frame, static_cast<hft::MessageType>(msg->message_type),
+        msg->message_id, msg->timestamp, msg->sequence_number));
+    publish_frame(lane, event);
+}
+
+void UltraHFTServer::publish_frame(StrategyLane& lane, const EgressEvent& event) {
+    EgressRing& ring = *egress_rings_[lane.id * config_.egress_threads + sender_for(event.connection)];
+    if (ring.push(event)) return;
+    
+    Backoff backoff(config_.strategy_backoff);
+    while (!ring.push(event)) {
+        if (!running_.load(std::memory_order_relaxed)) return;
+        backoff.idle();
+    }
+}
+
+uint32_t UltraHFTServer::sender_for(uint64_t connection) const {
+    // A connection always maps to the same send thread, keeping its frames in order
+    return static_cast<uint32_t>(connection & 0xFFFFFFFFULL) % config_.egress_threads;
+}
+
+void UltraHFTServer::egress_thread(uint32_t sender_index) {
+    const size_t max_batch = config_.stage_batch;
+    
+    if (!config_.egress_cpu_affinity.empty()) {
+        int cpu = config_.egress_cpu_affinity[sender_index % config_.egress_cpu_affinity.size()];
+        if (!hft::pin_current_thread(cpu)) {
+            std::cerr << "Send thread " << sender_index << " failed to pin to CPU " << cpu << std::endl;
+        }
+    }
+    enter_realtime("Send thread", sender_index);
+    thread_memory = arena_for(config_.egress_cpu_affinity, sender_index);
+    
+    Backoff backoff(config_.egress_backoff);
+    SenderState sender;
+    sender.server = this;
+    sender.latency = &latency_->recorder(thread_count_ + config_.strategy_threads + sender_index);
+    sender.counters = &counters_->block(thread_count_ + config_.strategy_threads + sender_index);
+    sender.transport = egress_transports_[sender_index].get();
+    sender.queues.resize(shards_.size() * static_cast<size_t>(max_connections_));
+    if (!sender.transport->attach_thread()) {
+        return;
+    }
+    
+    while (running_.load(std::memory_order_relaxed)) {
+        bool worked = false;
+        for (uint32_t lane = 0; lane < config_.strategy_threads; ++lane) {
+            EgressRing& ring = *egress_rings_[lane * config_.egress_threads + sender_index];
+            worked |= ring.consume_bulk([&](const EgressEvent& event) {
+                if (event.kind == EgressEvent::CLOSE) {
+                    close_socket(sender, event.connection);
+                } else {
+                    queue_frame(sender, event);
+                }
+            }, max_batch) > 0;
+        }
+        
+        // Market data joins the same queues, behind the pass's responses
+        worked |= fanout_->flush(sender_index, sender) > 0;
+        
+        // One write per connection for everything this pass produced; the
+        // io_uring transport then submits all of them together
+        worked |= !sender.dirty.empty();
+        flush_sends(sender);
+        sender.transport->flush();
+        
+        if (feed_ && sender_index == 0) {
+            worked |= feed_->flush() > 0;
+        }
+        
+        if (worked) {
+            backoff.reset();
+        } else {
+            backoff.idle();
+        }
+    }
+}
+
+UltraHFTServer::SendQueue* UltraHFTServer::send_queue(SenderState& sender, uint64_t connection,
+                                                      UltraConnection*& conn) {
+    // The ref goes stale once its connection closes, so late frames are dropped
+    uint32_t shard = connection_ref_shard(connection);
+    conn = shard < shards_.size() ? shards_[shard]->connections.find(connection_ref_handle(connection)) : nullptr;
+    if (!conn || !conn->is_active.load()) {
+        return nullptr;
+    }
+    
+    auto& slot = sender.queues[shard * static_cast<size_t>(max_connections_) + (connection & 0xFFFFFF)];
+    if (!slot) {
+        slot = std::make_unique<SendQueue>();
+    }
+    SendQueue& queue = *slot;
+    if (queue.connection != connection) {
+        // Left over from the slot's previous connection
+        queue.queue.clear();
+        queue.connection = connection;
+        queue.blocked = false;     // Pruned from sender.blocked on the next flush
+        queue.failed = false;
+        queue.metrics = conn->metrics;
+        if (queue.metrics) {
+            queue.metrics->sending_to(connection);
+        }
+    }
+    return &queue;
+}
+
+void UltraHFTServer::schedule_queue(SenderState& sender, SendQueue& queue, uint32_t frames) {
+    if (!queue.scheduled && !queue.blocked) {
+        queue.scheduled = true;
+        sender.dirty.push_back(&queue);
+    }
+    sender.counters->add(hft::Counter::FRAMES_OUT, frames);
+    if (queue.metrics) {
+        queue.metrics->queued(frames);
+    }
+}
+
+int UltraHFTServer::SenderState::deliver(uint64_t target, const struct iovec* frames, int count) {
+    return server->queue_market_data(*this, target, frames, count);
+}
+
+int UltraHFTServer::queue_market_data(SenderState& sender, uint64_t connection, const struct iovec* frames,
+                                      int count) {
     UltraConnection* conn;
+    SendQueue* queue = send_queue(sender, connection, conn);
+    if (!queue || queue->failed) return -1;
     
-    // Process message queue
-    while (message_queue_.pop(msg)) {
-        // Process message (implement your business logic here)
-        // For now, just update stats
-        stats_.total_messages.fetch_add(1);
+    // A backed-up connection takes nothing more; the fan-out conflates instead
+    int taken = 0;
+    size_t backlog = queue->queue.size() + sender.transport->queued(conn->fd, connection);
+    while (taken < count && backlog < config_.outbound.high_water) {
+        // The frames are shared by every subscriber; the copy is numbered
+        uint8_t* tail = queue->queue.reserve(frames[taken].iov_len);
+        memcpy(tail, frames[taken].iov_base, frames[taken].iov_len);
+        conn->session.stamp_outbound(tail, frames[taken].iov_len);
+        queue->queue.commit(frames[taken].iov_len);
+        backlog += frames[taken].iov_len;
+        ++taken;
+    }
+    if (taken > 0) {
+        schedule_queue(sender, *queue, static_cast<uint32_t>(taken));
+    }
+    return taken;
+}
+
+bool UltraHFTServer::queue_frame(SenderState& sender, const EgressEvent& event) {
+    UltraConnection* conn;
+    SendQueue* slot = send_queue(sender, event.connection, conn);
+    if (!slot) {
+        sender.counters->add(hft::Counter::STALE_FRAMES);
+        return false;
     }
+    SendQueue& queue = *slot;
+    if (queue.failed) return false;
     
-    // Process connection queue
-    while (connection_queue_.pop(conn)) {
-        // Process connection events
-        // For now, just update stats
+    // A connection has one send thread, so its numbers follow its byte stream
+    uint8_t* tail = queue.queue.reserve(event.length);
+    memcpy(tail, event.frame, event.length);
+    conn->session.stamp_outbound(tail, event.length);
+    queue.queue.commit(event.length);
+    size_t backlog = queue.queue.size() + sender.transport->queued(conn->fd, event.connection);
+    if (backlog > config_.outbound.limit) {
+        // Dropping frames would corrupt the client's view of its orders;
+        // the shutdown makes its I/O worker close the connection
+        HFT_LOG_WARN("Send backlog of {} bytes on fd {}, disconnecting slow client", backlog, conn->fd);
+        sender.counters->add(hft::Counter::SLOW_CLIENT);
+        shutdown(conn->fd, SHUT_RDWR);
+        queue.queue.clear();
+        queue.failed = true;
+        return false;
     }
+    if (backlog >= config_.outbound.high_water) {
+        conn->send_congested.store(true, std::memory_order_release);
+    }
+    
+    schedule_queue(sender, queue, 1);
+    sender.latency->record(hft::LatencyStage::SEND, UltraMessage::get_current_timestamp() - event.receive_time);
+    return true;
 }
 
-bool UltraHFTServer::send_response(UltraConnection* conn, const UltraMessage* msg) {
-    if (!conn || !msg || !conn->is_active.load()) return false;
+void UltraHFTServer::flush_sends(SenderState& sender) {
+    // Only a backlogged socket can turn writable, so an idle pass skips the wait
+    if (!sender.blocked.empty()) {
+        constexpr int MAX_EVENTS = 64;
+        hft::TransportEvent events[MAX_EVENTS];
+        int count = sender.transport->wait(events, MAX_EVENTS, 0);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].type != hft::TransportEvent::WRITABLE) continue;
+            uint64_t ref = events[i].cookie;
+            const auto& slot = sender.queues[connection_ref_shard(ref) * static_cast<size_t>(max_connections_) +
+                                             (ref & 0xFFFFFF)];
+            if (!slot || slot->connection != ref || !slot->blocked) continue;
+            slot->blocked = false;
+            if (!slot->scheduled) {
+                slot->scheduled = true;
+                sender.dirty.push_back(slot.get());
+            }
+        }
+        
+        // Drop queues that were written, reset, or whose connection closed
+        // while blocked; a closed socket never reports WRITABLE
+        auto unblocked = std::remove_if(sender.blocked.begin(), sender.blocked.end(), [&](SendQueue* queue) {
+            if (queue->blocked && !shards_[connection_ref_shard(queue->connection)]->connections.find(
+                                      connection_ref_handle(queue->connection))) {
+                queue->blocked = false;
+                queue->queue.clear();
+            }
+            return !queue->blocked;
+        });
+        sender.blocked.erase(unblocked, sender.blocked.end());
+    }
+    
+    for (SendQueue* queue : sender.dirty) {
+        queue->scheduled = false;
+        write_queue(sender, *queue);
+    }
+    sender.dirty.clear();
+}
+
+void UltraHFTServer::write_queue(SenderState& sender, SendQueue& queue) {
+    UltraConnection* conn = shards_[connection_ref_shard(queue.connection)]->connections.find(
+        connection_ref_handle(queue.connection));
+    if (!conn || !conn->is_active.load()) {
+        queue.queue.clear();
+        return;
+    }
+    
+    size_t queued = queue.queue.size();
+    hft::OutboundQueue::Result result = queue.queue.flush(conn->fd, queue.connection, sender.transport);
+    if (result != hft::OutboundQueue::Result::FAILED) {
+        sender.counters->add(hft::Counter::BYTES_OUT, queued - queue.queue.size());
+        if (queue.metrics) {
+            queue.metrics->sent(queued - queue.queue.size());
+        }
+    }
+    switch (result) {
+        case hft::OutboundQueue::Result::DRAINED:
+            break;
+        case hft::OutboundQueue::Result::BLOCKED:
+            // The rest waits in the queue; later frames line up behind it
+            sender.counters->add(hft::Counter::SEND_BLOCKED);
+            if (sender.transport->watch_writable(conn->fd, queue.connection)) {
+                queue.blocked = true;
+                sender.blocked.push_back(&queue);
+            }
+            break;
+        case hft::OutboundQueue::Result::FAILED:
+            // The I/O worker sees the same error and closes the connection
+            queue.failed = true;
+            break;
+    }
     
-    ssize_t bytes_sent = send(conn->fd, msg, sizeof(UltraMessage), MSG_DONTWAIT);
-    return bytes_sent == sizeof(UltraMessage);
+    if (conn->send_congested.load(std::memory_order_relaxed) &&
+        queue.queue.size() + sender.transport->queued(conn->fd, queue.connection) <= config_.outbound.high_water / 2) {
+        conn->send_congested.store(false, std::memory_order_release);
+    }
 }
 
-void UltraHFTServer::close_connection(UltraConnection* conn) {
+void UltraHFTServer::close_connection(uint32_t worker_index, UltraConnection* conn) {
     if (!conn) return;
     
-    conn->is_active.store(false);
+    // Only the first close of a connection does the teardown
+    if (!conn->is_active.exchange(false)) return;
     
-    // Remove from epoll
-    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+    // Cancel-on-disconnect: every lane may hold resting orders for this connection
+    IngressEvent event;
+    event.kind = IngressEvent::DISCONNECT;
+    event.connection = make_connection_ref(conn->shard->id, conn->handle);
+    event.receive_time = UltraMessage::get_current_timestamp();
+    for (uint32_t lane = 0; lane < config_.strategy_threads; ++lane) {
+        push_ingress(worker_index, lane, event);
+    }
     
-    // Close socket
-    close(conn->fd);
+    // Stop market data before the descriptor can be reused
+    if (conn->market_data_subscriber != hft::MarketDataFanout::INVALID_SUBSCRIBER) {
+        fanout_->remove_subscriber(conn->market_data_subscriber);
+        conn->market_data_subscriber = hft::MarketDataFanout::INVALID_SUBSCRIBER;
+    }
+    
+    // No timer may fire for the connection once its descriptor goes
+    {
+        std::lock_guard<std::mutex> lock(conn->shard->timer_lock);
+        conn->shard->timers.cancel(conn->session.timer);
+    }
+    
+    // Stop receiving. The descriptor stays open: its send thread may be
+    // writing to it, so that thread closes it once the lanes pass the
+    // disconnect on, and releases the handle after it
+    worker_transport(worker_index).remove_connection(conn->fd, conn->handle);
     
     // Update stats
     stats_.active_connections.fetch_sub(1);
+    if (conn->metrics) {
+        conn->metrics->closed();
+    }
     
-    std::cout << "Connection closed: " << inet_ntoa(conn->addr.sin_addr) 
-              << ":" << ntohs(conn->addr.sin_port) << std::endl;
+    HFT_LOG_INFO("Connection closed: {}:{}", inet_ntoa(conn->addr.sin_addr), ntohs(conn->addr.sin_port));
+}
+
+void UltraHFTServer::close_socket(SenderState& sender, uint64_t connection) {
+    uint32_t shard = connection_ref_shard(connection);
+    UltraConnection* conn = shard < shards_.size()
+        ? shards_[shard]->connections.find(connection_ref_handle(connection)) : nullptr;
+    if (!conn) return;
+    
+    // Anything still queued has nowhere to go; a blocked queue is pruned on the next flush
+    const auto& slot = sender.queues[shard * static_cast<size_t>(max_connections_) + (connection & 0xFFFFFF)];
+    if (slot && slot->connection == connection) {
+        slot->queue.clear();
+        slot->failed = true;
+    }
+    sender.transport->remove_connection(conn->fd, connection);
+    close(conn->fd);
+    
+    // Invalidate the handle last; the slot object stays allocated for reuse.
+    // Frames for it still in other lanes' rings are dropped as stale
+    shards_[shard]->connections.release(connection_ref_handle(connection));
 }
 
 bool UltraHFTServer::setup_socket_options(int sock) {
@@ -379,15 +1704,15 @@ bool UltraHFTServer::setup_socket_options(int sock) {
         return false;
     }
     
-    // Large send/receive buffers
-    int send_buf_size = 1024 * 1024; // 1MB
-    int recv_buf_size = 1024 * 1024; // 1MB
+    // Large send/receive buffers, unless configured to the kernel default
+    int send_buf_size = static_cast<int>(config_.transport.socket_send_buffer);
+    int recv_buf_size = static_cast<int>(config_.transport.socket_receive_buffer);
     
-    if (setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
+    if (send_buf_size > 0 && setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
         return false;
     }
     
-    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size)) < 0) {
+    if (recv_buf_size > 0 && setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size)) < 0) {
         return false;
     }
     
@@ -401,37 +1726,174 @@ bool UltraHFTServer::set_non_blocking(int sock) {
     return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
 }
 
-UltraMessage* UltraHFTServer::get_next_send_buffer() {
-    size_t index = send_buffer_index_.fetch_add(1) % send_buffer_.size();
-    return &send_buffer_[index];
+hft::ObjectPool<UltraMessage>& UltraHFTServer::send_message_pool() {
+    // One pool per thread: no shared index to contend on, and a slot is not
+    // reused until the message in it has been released
+    static thread_local hft::ObjectPool<UltraMessage> pool(config_.send_pool_size, thread_memory);
+    return pool;
+}
+
+bool UltraHFTServer::get_latency_report(hft::LatencyReport& report) const {
+    if (!latency_) return false;
+    latency_->report(report);
+    return true;
+}
+
+bool UltraHFTServer::get_counters(hft::CounterSnapshot& counters) const {
+    if (!counters_) return false;
+    counters_->snapshot(counters);
+    return true;
+}
+
+void UltraHFTServer::reload_risk_limits(const hft::RiskLimits& limits) {
+    if (risk_limits_) {
+        risk_limits_->publish(limits);
+    }
 }
 
-UltraMessage* UltraHFTServer::get_next_recv_buffer() {
-    size_t index = recv_buffer_index_.fetch_add(1) % recv_buffer_.size();
-    return &recv_buffer_[index];
+hft::RiskStats UltraHFTServer::get_risk_stats() const {
+    hft::RiskStats total;
+    for (const auto& lane : lanes_) {
+        hft::RiskStats stats = lane->risk->stats();
+        total.checked += stats.checked;
+        total.rejected_quantity += stats.rejected_quantity;
+        total.rejected_notional += stats.rejected_notional;
+        total.rejected_price += stats.rejected_price;
+        total.rejected_position += stats.rejected_position;
+        total.rejected_throttle += stats.rejected_throttle;
+    }
+    return total;
+}
+
+hft::JournalStats UltraHFTServer::get_journal_stats() const {
+    hft::JournalStats total;
+    for (const auto& lane : lanes_) {
+        if (!lane->journal) continue;
+        hft::JournalStats stats = lane->journal->stats();
+        total.records += stats.records;
+        total.bytes += stats.bytes;
+        total.segments += stats.segments;
+        total.syncs += stats.syncs;
+        total.lost += stats.lost;
+    }
+    return total;
 }
 
-void UltraHFTServer::update_stats(uint64_t latency) {
-    stats_.total_latency.fetch_add(latency);
-    stats_.message_count.fetch_add(1);
+void UltraHFTServer::monitor_thread() {
+    const auto interval = std::chrono::milliseconds(config_.metrics_interval_ms);
+    const auto stats_interval = std::chrono::milliseconds(config_.stats_interval_ms);
+    auto last_print = std::chrono::steady_clock::now();
+    
+    while (running_.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(interval);
+        if (metrics_) {
+            publish_metrics();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (config_.stats_interval_ms != 0 && now - last_print >= stats_interval) {
+            print_stats();
+            last_print = now;
+        }
+    }
+}
+
+void UltraHFTServer::publish_metrics() {
+    // Per-thread counters and histograms are already in the segment; only
+    // state nobody counts as it happens is sampled here
+    metrics_->set(hft::Gauge::ACTIVE_CONNECTIONS, stats_.active_connections.load(std::memory_order_relaxed));
+    metrics_->set(hft::Gauge::PEAK_CONNECTIONS, stats_.peak_connections.load(std::memory_order_relaxed));
+    metrics_->set(hft::Gauge::TOTAL_CONNECTIONS, connection_count_.load(std::memory_order_relaxed));
+    
+    size_t ingress_depth = 0;
+    size_t egress_depth = 0;
+    for (const auto& ring : ingress_rings_) ingress_depth += ring->size();
+    for (const auto& ring : egress_rings_) egress_depth += ring->size();
+    metrics_->set(hft::Gauge::INGRESS_DEPTH, ingress_depth);
+    metrics_->set(hft::Gauge::EGRESS_DEPTH, egress_depth);
+    
+    if (fanout_) {
+        hft::FanoutStats fanout = fanout_->stats();
+        metrics_->set(hft::Gauge::MARKET_DATA_UPDATES, fanout.updates);
+        metrics_->set(hft::Gauge::MARKET_DATA_FRAMES, fanout.frames_sent);
+        metrics_->set(hft::Gauge::MARKET_DATA_CONFLATED, fanout.conflated);
+        metrics_->set(hft::Gauge::MARKET_DATA_DROPPED, fanout.dropped);
+        metrics_->set(hft::Gauge::MARKET_DATA_SUBSCRIBERS, fanout.subscribers);
+    }
+    if (feed_) {
+        hft::MulticastStats multicast = feed_->stats();
+        metrics_->set(hft::Gauge::MULTICAST_PACKETS, multicast.packets);
+        metrics_->set(hft::Gauge::MULTICAST_SEND_ERRORS, multicast.send_errors);
+    }
+    hft::RiskStats risk = get_risk_stats();
+    metrics_->set(hft::Gauge::RISK_CHECKED, risk.checked);
+    metrics_->set(hft::Gauge::RISK_REJECTED, risk.rejected());
+    if (config_.journal.enabled()) {
+        hft::JournalStats journal = get_journal_stats();
+        metrics_->set(hft::Gauge::JOURNAL_RECORDS, journal.records);
+        metrics_->set(hft::Gauge::JOURNAL_BYTES, journal.bytes);
+        metrics_->set(hft::Gauge::JOURNAL_LOST, journal.lost);
+    }
+    metrics_->mark_updated();
 }
 
 void UltraHFTServer::print_stats() {
     const UltraServerStats& current_stats = get_stats();
     
     std::cout << "=== Ultra HFT Server Statistics ===" << std::endl;
-    std::cout << "Total Messages: " << current_stats.total_messages.load() << std::endl;
+    hft::CounterSnapshot counters;
+    get_counters(counters);
+    std::cout << "Total Messages: " << counters[hft::Counter::MESSAGES] << std::endl;
     std::cout << "Active Connections: " << current_stats.active_connections.load() << std::endl;
     std::cout << "Peak Connections: " << current_stats.peak_connections.load() << std::endl;
+    hft::print_counters(std::cout, counters);
     
-    double avg_latency = current_stats.get_average_latency();
-    std::cout << "Average Latency: " << std::fixed << std::setprecision(2) 
-              << (avg_latency / 1000.0) << " μs" << std::endl;
+    // Sampled, so only a rough picture of where the pipeline backs up
+    size_t ingress_depth = 0;
+    size_t egress_depth = 0;
+    for (const auto& ring : ingress_rings_) ingress_depth += ring->size();
+    for (const auto& ring : egress_rings_) egress_depth += ring->size();
+    std::cout << "Queue Depth: " << ingress_depth << " ingress, " << egress_depth << " egress events"
+              << std::endl;
     
-    if (avg_latency < 10000) { // < 10μs
-        std::cout << "✓ Ultra-low latency target met (< 10μs)" << std::endl;
-    } else {
-        std::cout << "⚠ Latency above target" << std::endl;
+    if (fanout_) {
+        hft::FanoutStats fanout = fanout_->stats();
+        std::cout << "Market Data: " << fanout.updates << " updates -> " << fanout.frames_sent
+                  << " frames sent, " << fanout.conflated << " conflated, " << fanout.dropped
+                  << " dropped, " << fanout.subscribers << " subscribers" << std::endl;
+    }
+    if (feed_) {
+        hft::MulticastStats multicast = feed_->stats();
+        std::cout << "Multicast: " << multicast.updates << " updates in " << multicast.packets
+                  << " datagrams, " << multicast.send_errors << " send errors, "
+                  << multicast.retransmit_requests << " retransmits, "
+                  << multicast.snapshot_requests << " snapshots" << std::endl;
+    }
+    hft::RiskStats risk = get_risk_stats();
+    std::cout << "Risk: " << risk.checked << " checked, " << risk.rejected() << " rejected ("
+              << risk.rejected_quantity << " size, " << risk.rejected_notional << " notional, "
+              << risk.rejected_price << " price, " << risk.rejected_position << " position, "
+              << risk.rejected_throttle << " throttle)" << std::endl;
+    if (config_.journal.enabled()) {
+        hft::JournalStats journal = get_journal_stats();
+        std::cout << "Journal: " << journal.records << " records, " << journal.bytes << " bytes in "
+                  << journal.segments << " segments, " << journal.syncs << " syncs, " << journal.lost << " lost"
+                  << std::endl;
+    }
+    
+    hft::LatencyReport report;
+    if (get_latency_report(report)) {
+        hft::print_latency_summaries(std::cout, "Latency, last interval", report.interval);
+        hft::print_latency_summaries(std::cout, "Latency, since start", report.cumulative);
+        
+        // Judge the target on the tail, not the mean
+        const hft::LatencySummary& send = report.interval[static_cast<size_t>(hft::LatencyStage::SEND)];
+        if (send.count == 0) {
+            std::cout << "No responses sent this interval" << std::endl;
+        } else if (send.p99_ns < 10000) { // < 10μs
+            std::cout << "✓ Ultra-low latency target met (p99 < 10μs)" << std::endl;
+        } else {
+            std::cout << "⚠ p99 latency above target" << std::endl;
+        }
     }
     
     std::cout << "=================================" << std::endl;
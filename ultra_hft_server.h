@@ -6,194 +6,529 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <sys/epoll.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <thread>
+#include <mutex>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <string>
+#include <chrono>
+#include "frame_buffer.h"
+#include "wire_protocol.h"
+#include "frame_scanner.h"
+#include "order_book.h"
+#include "thread_affinity.h"
+#include "connection_table.h"
+#include "object_pool.h"
+#include "lock_free_queue.h"
+#include "latency_histogram.h"
+#include "tsc_clock.h"
+#include "market_data_fanout.h"
+#include "market_state.h"
+#include "multicast_feed.h"
+#include "transport.h"
+#include "busy_poll.h"
+#include "outbound_queue.h"
+#include "risk_engine.h"
+#include "instrument_directory.h"
+#include "session.h"
+#include "journal.h"
+#include "numa_memory.h"
+#include "metrics_segment.h"
+#include "server_counters.h"
+#include "warmup.h"
 
 namespace ultra_hft {
 
-// Lock-free ring buffer for ultra-low latency
-template<typename T, size_t SIZE>
-class LockFreeRingBuffer {
-    static_assert(SIZE > 0 && ((SIZE & (SIZE - 1)) == 0), "Size must be a power of 2");
-    
-private:
-    std::array<T, SIZE> buffer_;
-    std::atomic<size_t> head_{0};
-    std::atomic<size_t> tail_{0};
-    static constexpr size_t MASK = SIZE - 1;
-    
-public:
-    LockFreeRingBuffer() = default;
-    
-    bool push(const T& item) noexcept {
-        size_t current_tail = tail_.load(std::memory_order_relaxed);
-        size_t next_tail = (current_tail + 1) & MASK;
-        
-        if (next_tail == head_.load(std::memory_order_acquire)) {
-            return false; // Full
-        }
-        
-        buffer_[current_tail] = item;
-        tail_.store(next_tail, std::memory_order_release);
-        return true;
-    }
-    
-    bool pop(T& item) noexcept {
-        size_t current_head = head_.load(std::memory_order_relaxed);
-        
-        if (current_head == tail_.load(std::memory_order_acquire)) {
-            return false; // Empty
-        }
-        
-        item = buffer_[current_head];
-        head_.store((current_head + 1) & MASK, std::memory_order_release);
-        return true;
-    }
-    
-    bool empty() const noexcept {
-        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
-    }
-    
-    bool full() const noexcept {
-        size_t next_tail = (tail_.load(std::memory_order_relaxed) + 1) & MASK;
-        return next_tail == head_.load(std::memory_order_acquire);
-    }
-    
-    size_t size() const noexcept {
-        size_t head = head_.load(std::memory_order_acquire);
-        size_t tail = tail_.load(std::memory_order_acquire);
-        return (tail - head) & MASK;
-    }
-    
-    size_t capacity() const noexcept {
-        return SIZE - 1; // Leave one slot empty for full detection
-    }
-};
-
 // Ultra-optimized message structure (cache-line aligned)
+// message_type holds an hft::MessageType value; type-specific fields live in
+// the derived structs and travel in the compact wire format
 struct alignas(64) UltraMessage {
     uint64_t message_id;
     uint64_t timestamp;
     uint32_t message_type;
-    uint32_t payload_size;
-    std::array<uint8_t, 1024> payload;
+    uint32_t sequence_number;
     
-    UltraMessage() : message_id(0), timestamp(0), message_type(0), payload_size(0) {}
+    UltraMessage() : message_id(0), timestamp(0), message_type(0), sequence_number(0) {}
     
     void update_timestamp() {
         timestamp = get_current_timestamp();
     }
     
+    // Monotonic TSC nanoseconds, for intervals inside this process only
     static uint64_t get_current_timestamp() {
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        return hft::TscClock::instance().now_ns();
+    }
+    
+    // Nanoseconds since the epoch, for timestamps sent to clients
+    static uint64_t get_wall_timestamp() {
+        return hft::TscClock::instance().wall_ns();
     }
 };
 
 // Ultra-optimized order message
 struct alignas(64) UltraOrderMessage : public UltraMessage {
     char symbol[16];
-    uint32_t side;      // 0=BUY, 1=SELL
+    uint32_t instrument; // Resolved from symbol at decode
+    uint32_t side;      // hft::OrderSide as sent; the engine rejects other values
     uint64_t quantity;
     uint64_t price;
-    uint32_t order_type;
-    uint32_t time_in_force;
+    uint64_t order_id;
+    uint32_t order_type;    // hft::OrderType
+    uint32_t time_in_force; // hft::TimeInForce
+    uint64_t account;       // Sender's LOGIN account for risk, stamped at decode; 0 = none
     
-    UltraOrderMessage() : UltraMessage(), side(0), quantity(0), price(0), order_type(0), time_in_force(0) {
-        message_type = 1; // ORDER_NEW
+    UltraOrderMessage() : UltraMessage(), instrument(hft::NO_INSTRUMENT), side(0), quantity(0), price(0), order_id(0), order_type(0), time_in_force(0), account(0) {
+        message_type = static_cast<uint32_t>(hft::MessageType::ORDER_NEW);
         std::fill(symbol, symbol + 16, 0);
     }
 };
 
+// Idle policy for a polling loop: pause-spin, then yield, then sleep
+struct BackoffPolicy {
+    uint32_t spin_iterations = 4096;  // UINT32_MAX = never stop spinning
+    uint32_t yield_iterations = 64;
+    uint32_t sleep_us = 50;           // 0 = keep yielding instead of sleeping
+    
+    static BackoffPolicy busy_poll() { return BackoffPolicy{UINT32_MAX, 0, 0}; }
+};
+
+// Per-thread backoff state driven by a BackoffPolicy. Call idle() after an
+// empty poll and reset() as soon as work shows up.
+class Backoff {
+    BackoffPolicy policy_;
+    uint32_t idle_rounds_ = 0;
+    
+public:
+    explicit Backoff(const BackoffPolicy& policy) : policy_(policy) {}
+    
+    void reset() noexcept { idle_rounds_ = 0; }
+    
+    void idle() noexcept {
+        if (policy_.spin_iterations == UINT32_MAX || idle_rounds_ < policy_.spin_iterations) {
+            if (policy_.spin_iterations != UINT32_MAX) ++idle_rounds_;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            return;
+        }
+        if (idle_rounds_ - policy_.spin_iterations < policy_.yield_iterations || policy_.sleep_us == 0) {
+            ++idle_rounds_;
+            std::this_thread::yield();
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(policy_.sleep_us));
+    }
+};
+
 // Ultra-optimized market data message
 struct alignas(64) UltraMarketDataMessage : public UltraMessage {
     char symbol[16];
+    uint32_t instrument; // Resolved from symbol at decode
     uint64_t bid_price;
     uint64_t bid_size;
     uint64_t ask_price;
     uint64_t ask_size;
     uint64_t last_price;
+    uint64_t last_size;
     uint64_t volume;
+    uint64_t high_price;
+    uint64_t low_price;
+    
+    UltraMarketDataMessage() : UltraMessage(), instrument(hft::NO_INSTRUMENT), bid_price(0), bid_size(0), ask_price(0), ask_size(0), last_price(0), last_size(0), volume(0), high_price(0), low_price(0) {
+        message_type = static_cast<uint32_t>(hft::MessageType::MARKET_DATA);
+        std::fill(symbol, symbol + 16, 0);
+    }
+};
+
+// Market data subscribe/unsubscribe request. subscriber is filled in by the
+// I/O worker, which registers the connection with the fan-out on first use.
+struct alignas(64) UltraSubscriptionMessage : public UltraMessage {
+    char symbol[16];
+    uint32_t instrument; // Resolved from symbol at decode
+    uint64_t subscriber;
     
-    UltraMarketDataMessage() : UltraMessage(), bid_price(0), bid_size(0), ask_price(0), ask_size(0), last_price(0), volume(0) {
-        message_type = 2; // MARKET_DATA
+    UltraSubscriptionMessage() : UltraMessage(), instrument(hft::NO_INSTRUMENT), subscriber(hft::MarketDataFanout::INVALID_SUBSCRIBER) {
+        message_type = static_cast<uint32_t>(hft::MessageType::MARKET_DATA_SUBSCRIBE);
         std::fill(symbol, symbol + 16, 0);
     }
 };
 
+// Wire codec for the ultra message structs (layout in wire_protocol.h).
+// Frames must already have been validated with hft::wire::peek_frame.
+inline void decode(const uint8_t* frame, UltraMessage& msg) noexcept {
+    hft::wire::FrameHeader header = hft::wire::read_header(frame);
+    msg.message_id = header.message_id;
+    msg.timestamp = header.timestamp;
+    msg.message_type = header.type;
+    msg.sequence_number = header.sequence;
+}
+
+inline void decode(const uint8_t* frame, UltraOrderMessage& msg) noexcept {
+    using hft::wire::from_wire;
+    decode(frame, static_cast<UltraMessage&>(msg));
+    if (msg.message_type == static_cast<uint32_t>(hft::MessageType::ORDER_CANCEL)) {
+        auto body = hft::wire::read_body<hft::wire::CancelBody>(frame);
+        memcpy(msg.symbol, body.symbol, sizeof(msg.symbol));
+        msg.order_id = from_wire(body.order_id);
+        return;
+    }
+    auto body = hft::wire::read_body<hft::wire::OrderBody>(frame);
+    memcpy(msg.symbol, body.symbol, sizeof(msg.symbol));
+    msg.side = body.side;
+    msg.quantity = from_wire(body.quantity);
+    msg.price = from_wire(body.price);
+    msg.order_id = from_wire(body.order_id);
+    msg.order_type = body.order_type;
+    msg.time_in_force = body.time_in_force;
+}
+
+inline void decode(const uint8_t* frame, UltraMarketDataMessage& msg) noexcept {
+    using hft::wire::from_wire;
+    decode(frame, static_cast<UltraMessage&>(msg));
+    auto body = hft::wire::read_body<hft::wire::MarketDataBody>(frame);
+    memcpy(msg.symbol, body.symbol, sizeof(msg.symbol));
+    msg.bid_price = from_wire(body.bid_price);
+    msg.bid_size = from_wire(body.bid_size);
+    msg.ask_price = from_wire(body.ask_price);
+    msg.ask_size = from_wire(body.ask_size);
+    msg.last_price = from_wire(body.last_price);
+    msg.last_size = from_wire(body.last_size);
+    msg.volume = from_wire(body.volume);
+    msg.high_price = from_wire(body.high_price);
+    msg.low_price = from_wire(body.low_price);
+}
+
+// Multicast feed retransmit or snapshot request; fields as in RecoveryRequestMessage
+struct alignas(64) UltraRecoveryMessage : public UltraMessage {
+    uint64_t start;
+    uint32_t count;
+    
+    UltraRecoveryMessage() : UltraMessage(), start(0), count(0) {
+        message_type = static_cast<uint32_t>(hft::MessageType::FEED_RETRANSMIT_REQUEST);
+    }
+};
+
+inline void decode(const uint8_t* frame, UltraRecoveryMessage& msg) noexcept {
+    decode(frame, static_cast<UltraMessage&>(msg));
+    auto body = hft::wire::read_body<hft::wire::RecoveryBody>(frame);
+    msg.start = hft::wire::from_wire(body.start);
+    msg.count = hft::wire::from_wire(body.count);
+}
+
+inline void decode(const uint8_t* frame, UltraSubscriptionMessage& msg) noexcept {
+    decode(frame, static_cast<UltraMessage&>(msg));
+    auto body = hft::wire::read_body<hft::wire::SubscriptionBody>(frame);
+    memcpy(msg.symbol, body.symbol, sizeof(msg.symbol));
+}
+
+struct UltraWorkerShard;
+
 // Ultra-optimized connection structure
 struct alignas(64) UltraConnection {
     int fd;
     struct sockaddr_in addr;
-    uint64_t last_heartbeat;
     uint64_t client_id;
+    uint64_t handle;               // Connection table handle, also the transport cookie
+    UltraWorkerShard* shard;       // Shard whose table owns this connection
     std::atomic<bool> is_authenticated{false};
-    std::atomic<bool> is_active{true};
-    
-    UltraConnection() : fd(-1), last_heartbeat(0), client_id(0) {}
+    std::atomic<bool> is_active{false};
+    std::atomic<bool> send_congested{false}; // Set by the send thread above the high-water mark
+    bool read_paused = false;      // Worker stopped reading until send_congested clears
+    uint64_t market_data_subscriber; // Fan-out registration, once the client subscribes
+    hft::FrameBuffer recv_buffer;  // Reassembly buffer for partial frames
+    hft::Session session;          // Login, inbound sequence and liveness; timer on the shard wheel
+    uint64_t account = hft::RiskEngine::NO_ACCOUNT; // Named by LOGIN; risk state follows it across connections
+    hft::ConnectionMetrics* metrics = nullptr; // Traffic counts in the metrics segment; null when off
+    
+    // memory holds the receive buffer; null = heap
+    explicit UltraConnection(std::pmr::memory_resource* memory = nullptr)
+        : fd(-1), client_id(0), handle(0), shard(nullptr),
+          market_data_subscriber(hft::MarketDataFanout::INVALID_SUBSCRIBER),
+          recv_buffer(hft::FrameBuffer::DEFAULT_CAPACITY, memory) {}
+};
+
+// Per-worker I/O state. In sharded mode every worker owns one shard: its own
+// SO_REUSEPORT listener, transport and connections, so workers never
+// touch each other's sockets. Otherwise all workers share one. Per-thread
+// transports (io_uring) leave the shard without one: each worker's ring
+// watches the listener and owns the connections that worker accepts.
+struct alignas(64) UltraWorkerShard {
+    UltraWorkerShard(uint32_t max_connections, uint64_t tick_ns, uint64_t now_ns,
+                     std::pmr::memory_resource* memory = nullptr)
+        : connections(max_connections, memory), timers(tick_ns, now_ns) {}
+    
+    uint32_t id = 0;
+    int listen_fd = -1;
+    std::unique_ptr<hft::Transport> transport;  // Shared by the shard's workers, or null
+    
+    // O(1) handle -> connection lookup with stale-handle detection
+    hft::ConnectionTable<UltraConnection> connections;
+    
+    // Session timers of the shard's connections. Whichever worker gets the
+    // lock advances the wheel; the others skip it for that pass
+    std::mutex timer_lock;
+    hft::TimerWheel timers;
+};
+
+// Cross-thread connection reference: shard id plus the generation-tagged
+// table handle, packed as generation:32 | shard:8 | slot:24. It is unique for
+// the lifetime of one connection, so it also serves as the engine's order owner.
+constexpr uint32_t MAX_SHARDS = 1u << 8;
+constexpr uint32_t MAX_CONNECTIONS_PER_SHARD = 1u << 24;
+
+inline uint64_t make_connection_ref(uint32_t shard, uint64_t handle) noexcept {
+    return (handle & 0xFFFFFFFF00000000ULL) | (static_cast<uint64_t>(shard) << 24) | (handle & 0xFFFFFFULL);
+}
+inline uint32_t connection_ref_shard(uint64_t ref) noexcept {
+    return static_cast<uint32_t>(ref >> 24) & 0xFF;
+}
+inline uint64_t connection_ref_handle(uint64_t ref) noexcept {
+    return ref & 0xFFFFFFFF00FFFFFFULL;
+}
+
+// Decoded inbound work handed from an I/O worker to a strategy thread
+struct alignas(64) IngressEvent {
+    enum Kind : uint32_t { ORDER, MARKET_DATA, SUBSCRIPTION, RECOVERY, SESSION, DISCONNECT };
+    
+    uint64_t connection;   // make_connection_ref
+    uint64_t receive_time;
+    uint32_t kind;
+    union {
+        UltraOrderMessage order;
+        UltraMarketDataMessage market_data;
+        UltraSubscriptionMessage subscription;
+        UltraRecoveryMessage recovery;
+        UltraMessage session;      // Header-only reply the I/O worker decided on
+    };
+    
+    IngressEvent() : connection(0), receive_time(0), kind(ORDER), order() {}
+};
+
+// Encoded outbound frame handed from a strategy thread to a send thread
+struct alignas(64) EgressEvent {
+    static constexpr size_t MAX_FRAME = hft::wire::MAX_FRAME_SIZE; // Still one 128-byte slot
+    
+    enum Kind : uint8_t {
+        FRAME,     // Queue frame for the connection
+        CLOSE      // Its I/O worker has let go: close the socket, release the slot
+    };
+    
+    uint64_t connection;   // make_connection_ref
+    uint64_t receive_time; // Read completion of the message that caused this frame
+    uint32_t length;
+    Kind kind;
+    uint8_t frame[MAX_FRAME];
+    
+    EgressEvent() : connection(0), receive_time(0), length(0), kind(FRAME) {}
 };
 
-// Ultra-optimized server statistics
+// Server configuration
+struct UltraServerConfig {
+    std::string ip = "127.0.0.1";
+    uint16_t port = 8888;
+    uint32_t threads = 4;
+    bool sharded = false;            // One listener + epoll per worker (SO_REUSEPORT)
+    std::vector<int> cpu_affinity;   // Worker i runs on cpu_affinity[i % size]; empty = unpinned
+    uint32_t max_connections = 16384; // Connection table capacity per shard
+    uint32_t event_batch = 64;       // Transport events an I/O worker takes per wait
+    
+    // Pipeline: I/O workers -> strategy threads -> send threads, linked by SPSC rings
+    uint32_t strategy_threads = 1;   // Symbols are partitioned across strategy threads
+    uint32_t egress_threads = 1;     // Connections are partitioned across send threads
+    std::vector<int> strategy_cpu_affinity;
+    std::vector<int> egress_cpu_affinity;
+    uint32_t ingress_ring_size = 4096; // Per worker/lane ring; one of RING_SIZE_CLASSES
+    uint32_t egress_ring_size = 4096;  // Per lane/sender ring; one of RING_SIZE_CLASSES
+    uint32_t stage_batch = 64;       // Events a strategy or send thread takes from one ring per pass
+    uint32_t send_pool_size = 256;   // Outbound staging messages per thread
+    BackoffPolicy io_backoff;        // I/O worker waiting for ingress ring space
+    BackoffPolicy strategy_backoff;  // Strategy thread with empty rings
+    BackoffPolicy egress_backoff;    // Send thread with empty rings
+    
+    hft::MulticastConfig multicast;  // Optional UDP feed of every market data update
+    hft::TransportOptions transport; // Socket I/O backend for workers and send threads
+    hft::BusyPollOptions busy_poll;  // Spinning I/O workers, socket busy polling, SCHED_FIFO
+    hft::OutboundLimits outbound;    // Per-connection send backlog marks
+    hft::RiskLimits risk;            // Pre-trade checks on every order; reload_risk_limits() swaps them
+    hft::JournalConfig journal;      // Per-lane order journal, replayed at startup; off by default
+    std::vector<hft::InstrumentSpec> instruments; // Instrument master; empty = accept any symbol
+    hft::SessionConfig session;      // Heartbeat and idle timers, login policy
+    hft::MemoryOptions memory;       // Huge page, NUMA-bound arenas for rings, pools, tables and books
+    std::string metrics_segment;     // Shared memory object for metrics_exporter; empty = off
+    uint32_t metrics_interval_ms = 100; // How often the monitor thread samples gauges
+    uint32_t stats_interval_ms = 1000;  // How often it prints statistics; 0 = never
+    hft::WarmupConfig warmup;        // Synthetic orders through the pipeline before the listeners open; off by default
+};
+
+// Connection counts; only accepts and closes touch them. Per-message
+// counts live in each thread's CounterBlock
 struct alignas(64) UltraServerStats {
-    std::atomic<uint64_t> total_messages{0};
     std::atomic<uint64_t> active_connections{0};
     std::atomic<uint64_t> peak_connections{0};
-    std::atomic<uint64_t> total_latency{0};
-    std::atomic<uint64_t> message_count{0};
-    
-    double get_average_latency() const {
-        uint64_t count = message_count.load();
-        if (count == 0) return 0.0;
-        return static_cast<double>(total_latency.load()) / count;
-    }
 };
 
 // Ultra-optimized HFT server class
 class UltraHFTServer {
 private:
+    // Drives process_event() on an initialized server without its threads (hot_path_benchmark.cpp)
+    friend class DispatchBenchmark;
+    
+    // One strategy thread's state: its share of the order books and the
+    // listener that turns fills into egress frames
+    struct StrategyLane : public hft::IFillListener {
+        explicit StrategyLane(const hft::OrderBookConfig& books) : engine(books) {}
+        
+        UltraHFTServer* server = nullptr;
+        uint32_t id = 0;
+        hft::MatchingEngine engine;
+        hft::InstrumentDirectory* instruments = nullptr; // Where this lane's symbols were resolved
+        std::unique_ptr<hft::RiskEngine> risk; // Positions and throttles for orders on this lane
+        std::unique_ptr<hft::Journal> journal; // Orders that reach this lane's engine; null when off
+        hft::LatencyRecorder* latency = nullptr;
+        uint64_t receive_time = 0; // Of the event being processed, stamped on its egress frames
+        
+        void on_fill(const hft::FillMessage& fill, uint64_t owner) override;
+        void on_resting(hft::InstrumentId instrument, hft::OrderSide side, int64_t change, uint64_t owner) override;
+    };
+    
+    // A connection's unsent frames, owned by its send thread
+    struct SendQueue {
+        uint64_t connection = 0;   // Ref the queue currently belongs to
+        hft::ConnectionMetrics* metrics = nullptr;
+        hft::OutboundQueue queue;
+        bool scheduled = false;    // On the sender's dirty list
+        bool blocked = false;      // Waiting for WRITABLE
+        bool failed = false;       // Broken or cut off
+    };
+    
+    // One send thread's state. Queues are indexed by shard and slot and
+    // created on first use; a stale ref resets its slot's queue. Market data
+    // reaches the same queues as the sink of the fan-out's flush
+    struct SenderState : public hft::FanoutSink {
+        UltraHFTServer* server = nullptr;
+        hft::Transport* transport = nullptr;
+        hft::LatencyRecorder* latency = nullptr;
+        hft::CounterBlock* counters = nullptr;
+        std::vector<std::unique_ptr<SendQueue>> queues;
+        std::vector<SendQueue*> dirty;
+        std::vector<SendQueue*> blocked;   // Waiting for WRITABLE
+        
+        int deliver(uint64_t target, const struct iovec* frames, int count) override;
+    };
+    
     // Server configuration
+    UltraServerConfig config_;
     std::string server_ip_;
     uint16_t server_port_;
     uint32_t thread_count_;
+    bool sharded_;
+    std::vector<int> cpu_affinity_;
+    uint32_t max_connections_;
     
     // Server state
     std::atomic<bool> running_{false};
-    int server_socket_;
-    int epoll_fd_;
-    
-    // Lock-free queues for message processing
-    static constexpr size_t QUEUE_SIZE = 65536; // Power of 2 for efficient masking
-    LockFreeRingBuffer<UltraMessage*, QUEUE_SIZE> message_queue_;
-    LockFreeRingBuffer<UltraConnection*, QUEUE_SIZE> connection_queue_;
+    std::atomic<bool> listening_{false};  // Listeners open; per-thread transports then watch theirs
+    
+    // Warm-up: start() hands each I/O worker one loopback connection through
+    // its slot (-1 = empty), and the strategy threads run shadow lanes until
+    // warming_ clears, counting themselves in warmed_up_ as they switch
+    std::atomic<bool> warming_{false};
+    std::atomic<uint32_t> warmed_up_{0};
+    std::unique_ptr<std::atomic<int>[]> warmup_fds_;
+    std::vector<std::unique_ptr<StrategyLane>> warmup_lanes_;
+    std::unique_ptr<hft::InstrumentDirectory> warmup_directory_;  // Warm-up symbols when instruments_ is open
+    
+    // Arenas per NUMA node; null when config_.memory is all off. Declared
+    // ahead of everything that allocates from them, so destroyed after
+    std::unique_ptr<hft::NumaArenas> arenas_;
+    
+    // Shared memory holding every thread's counters and latency recorders
+    // and every connection's traffic counts; null when off. Outlives the
+    // shards and trackers that point into it
+    std::unique_ptr<hft::MetricsSegment> metrics_;
+    
+    // Listener, transport and connections per shard
+    std::vector<std::unique_ptr<UltraWorkerShard>> shards_;
+    
+    // Per-thread transports: one per I/O worker when the backend needs
+    // them, and always a send-only one per send thread, which also
+    // watches backlogged sockets for writability
+    std::vector<std::unique_ptr<hft::Transport>> worker_transports_;
+    std::vector<std::unique_ptr<hft::Transport>> egress_transports_;
+    
+    // Connections each I/O worker stopped reading because their send
+    // backlog is congested
+    std::vector<std::vector<uint64_t>> paused_reads_;
+    
+    // Pipeline rings. Every producer/consumer pair gets its own SPSC ring:
+    // ingress_rings_[worker * strategy_threads + lane] and
+    // egress_rings_[lane * egress_threads + sender], sized by
+    // config_.ingress_ring_size and egress_ring_size.
+    using IngressRing = SizedRingBuffer<IngressEvent>;
+    using EgressRing = SizedRingBuffer<EgressEvent>;
+    std::vector<std::unique_ptr<IngressRing>> ingress_rings_;
+    std::vector<std::unique_ptr<EgressRing>> egress_rings_;
+    std::vector<std::unique_ptr<StrategyLane>> lanes_;
     
     // Worker threads
     std::vector<std::thread> worker_threads_;
+    std::vector<std::thread> strategy_threads_;
+    std::vector<std::thread> egress_threads_;
+    std::thread monitor_thread_;
     
-    // Connections (lock-free access)
-    std::vector<std::unique_ptr<UltraConnection>> connections_;
+    // Connection id source
     std::atomic<size_t> connection_count_{0};
     
     // Statistics
     UltraServerStats stats_;
     
-    // Pre-allocated buffers for zero-copy operations
-    std::array<UltraMessage, 1024> send_buffer_;
-    std::array<UltraMessage, 1024> recv_buffer_;
-    std::atomic<size_t> send_buffer_index_{0};
-    std::atomic<size_t> recv_buffer_index_{0};
+    // One latency recorder and one counter block per pipeline thread:
+    // workers, then strategy lanes, then send threads
+    std::unique_ptr<hft::LatencyTracker> latency_;
+    std::unique_ptr<hft::CounterSet> counters_;
+    
+    // Market data distribution: lanes publish, each send thread flushes
+    // the subscribers on its connections
+    std::unique_ptr<hft::MarketDataFanout> fanout_;
+    
+    // Optional multicast feed: lanes publish, send thread 0 flushes partial
+    // datagrams
+    std::unique_ptr<hft::MulticastFeed> feed_;
+    
+    // Risk limits shared by every lane's RiskEngine
+    std::shared_ptr<hft::RiskLimitsStore> risk_limits_;
+    
+    // Top of book per instrument: written by the lane that owns the
+    // instrument, read by every lane's risk checks and by subscribe snapshots
+    std::shared_ptr<hft::MarketStateCache> market_state_;
+    
+    // Symbols resolved by the I/O workers at decode; lanes, books, risk and
+    // fan-out work by instrument id from there on
+    std::unique_ptr<hft::InstrumentDirectory> instruments_;
     
     // Performance monitoring
     std::atomic<uint64_t> last_stats_time_{0};
     
+    // Defaults for everything but the address and worker count
+    static UltraServerConfig basic_config(const std::string& ip, uint16_t port, uint32_t threads) {
+        UltraServerConfig config;
+        config.ip = ip;
+        config.port = port;
+        config.threads = threads;
+        return config;
+    }
+    
 public:
+    explicit UltraHFTServer(const UltraServerConfig& config)
+        : config_(config), server_ip_(config.ip), server_port_(config.port), thread_count_(config.threads),
+          sharded_(config.sharded), cpu_affinity_(config.cpu_affinity),
+          max_connections_(config.max_connections) {}
+    
     UltraHFTServer(const std::string& ip = "127.0.0.1", uint16_t port = 8888, uint32_t threads = 4)
-        : server_ip_(ip), server_port_(port), thread_count_(threads) {}
+        : UltraHFTServer(basic_config(ip, port, threads)) {}
     
     ~UltraHFTServer() {
         stop();
@@ -217,24 +552,128 @@ public:
     // Get statistics (return reference to avoid atomic copy issues)
     const UltraServerStats& get_stats() const { return stats_; }
     
-    // Process message (lock-free)
-    void process_message(UltraMessage* msg, UltraConnection* conn);
+    // Merge every thread's latency histograms; the interval view covers
+    // everything recorded since the previous call
+    bool get_latency_report(hft::LatencyReport& report) const;
+    
+    // Sum every thread's counters
+    bool get_counters(hft::CounterSnapshot& counters) const;
+    
+    // Swap in new pre-trade limits; lanes pick them up on their next order
+    void reload_risk_limits(const hft::RiskLimits& limits);
+    
+    // Risk counters summed over the lanes
+    hft::RiskStats get_risk_stats() const;
+    
+    // Journal counters summed over the lanes
+    hft::JournalStats get_journal_stats() const;
     
 private:
-    // Worker thread function
-    void worker_thread();
+    // Pipeline stage thread functions
+    void enter_realtime(const char* role, uint32_t index);
+    void worker_thread(uint32_t worker_index);
+    void strategy_thread(uint32_t lane_index);
+    void run_lane(StrategyLane& lane, const std::atomic<bool>& active);
+    void egress_thread(uint32_t sender_index);
+    
+    // Samples gauges into the metrics segment and prints statistics, so no
+    // pipeline thread formats or writes anything for monitoring
+    void monitor_thread();
+    void publish_metrics();
+    
+    // Replay the journal, cancel what it left resting and archive it, then open a journal per lane
+    bool recover_journal();
+    
+    // Create a shard's bound socket and transport; open_listeners() starts listening
+    bool open_shard(UltraWorkerShard& shard);
+    bool open_listeners();
+    void close_shards();
+    
+    // A strategy lane with its own book and risk state, recording into the lane thread's recorder
+    std::unique_ptr<StrategyLane> make_lane(uint32_t id, const hft::OrderBookConfig& books);
+    
+    // Push synthetic orders through the pipeline until p99 settles, then reset the statistics
+    bool warm_up();
+    
+    // Adopt the warm-up connection handed to this worker; false once warm-up is over
+    bool poll_warmup(uint32_t worker_index, UltraWorkerShard& shard);
+    
+    // The transport an I/O worker waits on and registers its connections with
+    hft::Transport& worker_transport(uint32_t worker_index) {
+        return worker_transports_.empty() ? *shards_[sharded_ ? worker_index : 0]->transport
+                                          : *worker_transports_[worker_index];
+    }
     
     // Accept new connections
-    void accept_connections();
+    void accept_connections(uint32_t worker_index, UltraWorkerShard& shard);
+    void open_connection(uint32_t worker_index, UltraWorkerShard& shard, int client_fd, const sockaddr_in& client_addr);
     
     // Handle client events
-    void handle_client_events(int client_fd);
+    void handle_client_events(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle);
+    
+    // Read again from connections whose send backlog has drained
+    void resume_paused_reads(uint32_t worker_index, UltraWorkerShard& shard);
+    
+    // Reassemble bytes the transport has already received
+    void handle_client_data(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle,
+                            const uint8_t* data, size_t length);
+    
+    // Decode every complete frame in the connection buffer and route it to a strategy lane
+    bool drain_frames(uint32_t worker_index, UltraConnection* conn, uint64_t receive_time);
+    
+    // Act on a frame the session consumed instead of dispatching; false disconnects
+    bool session_frame(uint32_t worker_index, UltraConnection* conn, const uint8_t* frame,
+                       hft::Session::Action action);
+    
+    // Have a lane send a session frame: LOGIN/LOGOUT ack, RESEND_REQUEST or HEARTBEAT
+    void push_session_frame(uint32_t worker_index, UltraConnection* conn, hft::MessageType type,
+                            uint32_t sequence, uint64_t message_id);
+    
+    // Fire the shard's due session timers, unless another worker is already
+    void expire_sessions(uint32_t worker_index, UltraWorkerShard& shard);
+    void expire_session(uint32_t worker_index, UltraWorkerShard& shard, uint64_t handle);
     
-    // Send response (zero-copy)
-    bool send_response(UltraConnection* conn, const UltraMessage* msg);
+    // Push to a worker's ingress ring for a lane, backing off while it is full
+    void push_ingress(uint32_t worker_index, uint32_t lane_index, const IngressEvent& event);
+    uint32_t lane_for(hft::InstrumentId instrument) const {
+        // Ids are dense, so a modulo spreads them evenly; unknown symbols go to lane 0 to be rejected
+        return instrument == hft::NO_INSTRUMENT ? 0 : instrument % config_.strategy_threads;
+    }
+    
+    // Dense per-client index for risk state: shard and table slot
+    uint32_t client_index(uint64_t connection) const {
+        return connection_ref_shard(connection) * max_connections_ + static_cast<uint32_t>(connection & 0xFFFFFF);
+    }
+    
+    // Process one ingress event on its strategy lane
+    void process_event(StrategyLane& lane, const IngressEvent& event);
+    
+    // Queue an encoded response for the connection's send thread
+    void publish_response(StrategyLane& lane, uint64_t connection, const UltraMessage* msg);
+    void publish_frame(StrategyLane& lane, const EgressEvent& event);
+    
+    // Send thread that owns a connection's socket writes
+    uint32_t sender_for(uint64_t connection) const;
+    
+    // Queue an egress frame for its connection, if that connection still exists
+    bool queue_frame(SenderState& sender, const EgressEvent& event);
+    
+    // Queue fan-out frames up to the high-water mark; how many were taken, or -1 once closed
+    int queue_market_data(SenderState& sender, uint64_t connection, const struct iovec* frames, int count);
+    
+    // The connection's queue, reset for a new connection in the slot; nullptr for a stale ref
+    SendQueue* send_queue(SenderState& sender, uint64_t connection, UltraConnection*& conn);
+    void schedule_queue(SenderState& sender, SendQueue& queue, uint32_t frames);
+    
+    // Close a connection the I/O worker has torn down; the send thread is its last writer
+    void close_socket(SenderState& sender, uint64_t connection);
+    
+    // Write every queue the pass touched, or that became writable again
+    void flush_sends(SenderState& sender);
+    void write_queue(SenderState& sender, SendQueue& queue);
     
     // Close connection
-    void close_connection(UltraConnection* conn);
+    void close_connection(uint32_t worker_index, UltraConnection* conn);
     
     // Setup socket options for ultra-low latency
     bool setup_socket_options(int sock);
@@ -242,19 +681,26 @@ private:
     // Set non-blocking mode
     bool set_non_blocking(int sock);
     
-    // Get next buffer slot (lock-free)
-    UltraMessage* get_next_send_buffer();
-    UltraMessage* get_next_recv_buffer();
+    // Calling thread's pool of config_.send_pool_size outbound staging
+    // messages, on its arena when it is a pipeline thread. Inbound frames
+    // are reassembled per connection and decoded into typed messages on
+    // the stack.
+    hft::ObjectPool<UltraMessage>& send_message_pool();
+    
+    // Arena of the thread pinned per affinity[index % size]; null = heap
+    std::pmr::memory_resource* arena_for(const std::vector<int>& affinity, size_t index) {
+        return arenas_ ? &arenas_->for_thread(affinity, index) : nullptr;
+    }
     
-    // Process specific message types
-    void process_order_message(UltraOrderMessage* msg, UltraConnection* conn);
-    void process_market_data_message(UltraMarketDataMessage* msg, UltraConnection* conn);
+    static constexpr uint64_t SESSION_TICK_NS = 1000000; // Timer wheel resolution
     
-    // Process message queue (lock-free)
-    void process_message_queue();
+    // Process specific message types (strategy lane)
+    void process_order_message(StrategyLane& lane, const UltraOrderMessage* msg, uint64_t connection);
+    void process_market_data_message(StrategyLane& lane, const UltraMarketDataMessage* msg, uint64_t connection);
+    void process_subscription_message(StrategyLane& lane, const UltraSubscriptionMessage* msg, uint64_t connection);
+    void process_recovery_message(StrategyLane& lane, const UltraRecoveryMessage* msg, uint64_t connection);
     
     // Performance monitoring
-    void update_stats(uint64_t latency);
     void print_stats();
 };
 
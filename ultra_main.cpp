@@ -1,16 +1,26 @@
 #include "ultra_hft_server.h"
+#include "config_file.h"
 #include <iostream>
 #include <csignal>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 
 namespace ultra_hft {
 
 // Global server instance for signal handling
 UltraHFTServer* g_server = nullptr;
 
+// Risk limits file, reloaded by the main loop after SIGHUP
+std::string g_risk_limits_path;
+volatile sig_atomic_t g_reload_risk = 0;
+
 // Signal handler for graceful shutdown
 void signal_handler(int signal) {
+    if (signal == SIGHUP) {
+        g_reload_risk = 1;
+        return;
+    }
     if (g_server) {
         std::cout << "\nReceived signal " << signal << ", shutting down gracefully..." << std::endl;
         g_server->stop();
@@ -23,9 +33,41 @@ void print_usage(const char* program_name) {
     std::cout << "=================================================================" << std::endl;
     std::cout << "Usage: " << program_name << " [options]" << std::endl;
     std::cout << "Options:" << std::endl;
+    std::cout << "  --config <file>  Read settings from a key = value file; other options override it" << std::endl;
+    std::cout << "  --set <key=value>  Override one config file setting" << std::endl;
     std::cout << "  --ip <ip>        Server IP address (default: 127.0.0.1)" << std::endl;
     std::cout << "  --port <port>    Server port (default: 8888)" << std::endl;
     std::cout << "  --threads <n>    Number of worker threads (default: 4)" << std::endl;
+    std::cout << "  --sharded        Give each worker its own SO_REUSEPORT listener and epoll" << std::endl;
+    std::cout << "  --cpus <list>    Pin workers to CPUs, e.g. 2,3 or 4-7 (round robin)" << std::endl;
+    std::cout << "  --strategy-threads <n>  Matching threads; symbols are split across them (default: 1)" << std::endl;
+    std::cout << "  --strategy-cpus <list>  Pin strategy threads to CPUs" << std::endl;
+    std::cout << "  --egress-threads <n>    Send threads; connections are split across them (default: 1)" << std::endl;
+    std::cout << "  --egress-cpus <list>    Pin send threads to CPUs" << std::endl;
+    std::cout << "  --transport <epoll|io_uring>  Socket I/O backend (default: epoll)" << std::endl;
+    std::cout << "  --sqpoll         io_uring: kernel threads poll the submission queues" << std::endl;
+    std::cout << "  --busy-poll      Every pipeline thread spins; I/O workers poll with zero timeout" << std::endl;
+    std::cout << "  --so-busy-poll <us>     SO_BUSY_POLL on client sockets" << std::endl;
+    std::cout << "  --prefer-busy-poll      SO_PREFER_BUSY_POLL on client sockets" << std::endl;
+    std::cout << "  --sched-fifo <prio>     Run pipeline threads under SCHED_FIFO (1-99)" << std::endl;
+    std::cout << "  --send-high-water <bytes>  Stop reading a client with this much unsent (default: 262144)" << std::endl;
+    std::cout << "  --send-limit <bytes>       Disconnect a client with this much unsent (default: 4194304)" << std::endl;
+    std::cout << "  --heartbeat <ms>           HEARTBEAT logged-in sessions this often (default: off)" << std::endl;
+    std::cout << "  --idle-timeout <ms>        Disconnect a client silent this long (default: off)" << std::endl;
+    std::cout << "  --require-login            Disconnect a client whose first frame is not LOGIN" << std::endl;
+    std::cout << "  --huge-pages <2m|1g>       Rings, pools, connection slots and books on huge pages" << std::endl;
+    std::cout << "  --numa                     Bind each thread's memory to the node of its pinned CPU" << std::endl;
+    std::cout << "  --mlock                    Pre-fault and lock that memory at startup" << std::endl;
+    std::cout << "  --metrics <name>           Publish counters, latency and gauges in /dev/shm/<name> for metrics_exporter" << std::endl;
+    std::cout << "  --warmup <rounds>          Run up to this many rounds of synthetic orders before listening (default: off)" << std::endl;
+    std::cout << "  --multicast <group:port>  Also publish market data on a UDP multicast feed" << std::endl;
+    std::cout << "  --multicast-if <ip>       Interface for the feed (default: routing table)" << std::endl;
+    std::cout << "  --multicast-ttl <n>       Feed TTL (default: 1)" << std::endl;
+    std::cout << "  --risk-limits <file>      Pre-trade risk limits, reloaded on SIGHUP" << std::endl;
+    std::cout << "  --instruments <file>      Instrument master; other symbols are rejected" << std::endl;
+    std::cout << "  --journal <dir>           Journal orders to dir and replay it at startup" << std::endl;
+    std::cout << "  --journal-segment-mb <n>  Journal segment file size (default: 64)" << std::endl;
+    std::cout << "  --journal-flush-ms <ms>   Journal msync interval; 0 = on segment roll only (default: 10)" << std::endl;
     std::cout << "  --help           Show this help message" << std::endl;
     std::cout << std::endl;
     std::cout << "Features:" << std::endl;
@@ -38,25 +80,148 @@ void print_usage(const char* program_name) {
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
     std::cout << "  " << program_name << " --ip 0.0.0.0 --port 9999 --threads 8" << std::endl;
+    std::cout << "  " << program_name << " --threads 4 --sharded --cpus 2-5" << std::endl;
+    std::cout << "  " << program_name << " --threads 2 --cpus 2,3 --strategy-cpus 4 --egress-cpus 5" << std::endl;
+    std::cout << "  " << program_name << " --multicast 239.1.1.1:30001 --multicast-if 10.0.0.5" << std::endl;
+    std::cout << "  " << program_name << " --threads 2 --transport io_uring --sqpoll" << std::endl;
+    std::cout << "  " << program_name << " --threads 2 --cpus 2,3 --strategy-cpus 4 --egress-cpus 5 --busy-poll --sched-fifo 50" << std::endl;
+    std::cout << "  " << program_name << " --config /etc/hft/ultra.conf --set ingress_ring_size=16384" << std::endl;
+}
+
+// "busy", or "spin,yield,sleep_us" as in BackoffPolicy
+bool parse_backoff(std::string_view text, BackoffPolicy& policy) {
+    if (text == "busy") {
+        policy = BackoffPolicy::busy_poll();
+        return true;
+    }
+    size_t first = text.find(',');
+    size_t second = first == std::string_view::npos ? first : text.find(',', first + 1);
+    if (second == std::string_view::npos) {
+        return false;
+    }
+    BackoffPolicy parsed;
+    if (!hft::parse_setting(text.substr(0, first), parsed.spin_iterations) ||
+        !hft::parse_setting(text.substr(first + 1, second - first - 1), parsed.yield_iterations) ||
+        !hft::parse_setting(text.substr(second + 1), parsed.sleep_us)) {
+        return false;
+    }
+    policy = parsed;
+    return true;
+}
+
+// One config file or --set setting; keys are the UltraServerConfig field names
+bool apply_config_setting(UltraServerConfig& config, std::string_view key, std::string_view value,
+                          std::string& error) {
+    if (key == "ip") {
+        config.ip = std::string(value);
+        return !config.ip.empty();
+    } else if (key == "port") {
+        return hft::parse_setting(value, config.port) && config.port != 0;
+    } else if (key == "threads") {
+        return hft::parse_setting(value, config.threads) && config.threads != 0;
+    } else if (key == "sharded") {
+        return hft::parse_setting(value, config.sharded);
+    } else if (key == "cpus" || key == "strategy_cpus" || key == "egress_cpus") {
+        std::vector<int>& cpus = key == "cpus" ? config.cpu_affinity
+            : key == "strategy_cpus" ? config.strategy_cpu_affinity : config.egress_cpu_affinity;
+        cpus.clear();
+        return value.empty() || hft::parse_cpu_list(std::string(value), cpus);
+    } else if (key == "max_connections") {
+        return hft::parse_setting(value, config.max_connections) && config.max_connections != 0;
+    } else if (key == "event_batch") {
+        return hft::parse_setting(value, config.event_batch) && config.event_batch != 0;
+    } else if (key == "strategy_threads") {
+        return hft::parse_setting(value, config.strategy_threads) && config.strategy_threads != 0;
+    } else if (key == "egress_threads") {
+        return hft::parse_setting(value, config.egress_threads) && config.egress_threads != 0;
+    } else if (key == "ingress_ring_size" || key == "egress_ring_size") {
+        uint32_t& size = key == "ingress_ring_size" ? config.ingress_ring_size : config.egress_ring_size;
+        if (!hft::parse_setting(value, size) || !is_ring_size_class(size)) {
+            error = std::string(key) + " must be one of 1024, 4096, 16384 or 65536";
+            return false;
+        }
+        return true;
+    } else if (key == "stage_batch") {
+        return hft::parse_setting(value, config.stage_batch) && config.stage_batch != 0;
+    } else if (key == "send_pool_size") {
+        return hft::parse_setting(value, config.send_pool_size) && config.send_pool_size != 0;
+    } else if (key == "io_backoff") {
+        return parse_backoff(value, config.io_backoff);
+    } else if (key == "strategy_backoff") {
+        return parse_backoff(value, config.strategy_backoff);
+    } else if (key == "egress_backoff") {
+        return parse_backoff(value, config.egress_backoff);
+    } else if (key == "busy_poll") {
+        // As --busy-poll; later *_backoff lines can still relax a stage
+        if (!hft::parse_setting(value, config.busy_poll.spin)) {
+            return false;
+        }
+        BackoffPolicy policy = config.busy_poll.spin ? BackoffPolicy::busy_poll() : BackoffPolicy{};
+        config.io_backoff = config.strategy_backoff = config.egress_backoff = policy;
+        return true;
+    } else if (key == "huge_pages") {
+        if (!hft::parse_huge_pages(std::string(value), config.memory.huge_pages)) {
+            error = "huge_pages must be off, 2m or 1g";
+            return false;
+        }
+        return true;
+    } else if (key == "numa") {
+        return hft::parse_setting(value, config.memory.numa);
+    } else if (key == "mlock") {
+        return hft::parse_setting(value, config.memory.lock);
+    } else if (key == "arena_mb") {
+        return hft::parse_setting(value, config.memory.arena_mb) && config.memory.arena_mb != 0;
+    } else if (key == "metrics_segment") {
+        config.metrics_segment = std::string(value);
+        return true;
+    } else if (key == "metrics_interval_ms") {
+        return hft::parse_setting(value, config.metrics_interval_ms) && config.metrics_interval_ms != 0;
+    } else if (key == "stats_interval_ms") {
+        return hft::parse_setting(value, config.stats_interval_ms);
+    }
+    return hft::apply_common_setting(key, value,
+                                     {config.transport, config.busy_poll, config.outbound, config.session,
+                                      config.warmup}, error);
 }
 
 // Parse command line arguments
-bool parse_arguments(int argc, char* argv[], std::string& ip, uint16_t& port, uint32_t& threads) {
+bool parse_arguments(int argc, char* argv[], UltraServerConfig& config) {
+    auto apply = [&config](std::string_view key, std::string_view value, std::string& error) {
+        return apply_config_setting(config, key, value, error);
+    };
+    
+    // The config file goes first wherever it appears, so options override it
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--config") == 0 && !hft::load_settings(argv[i + 1], apply)) {
+            return false;
+        }
+    }
+    
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return false;
+        } else if (strcmp(argv[i], "--config") == 0 ||
+                   strcmp(argv[i], "--set") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            ++i;
+            if (strcmp(argv[i - 1], "--set") == 0 && !hft::apply_setting(argv[i], apply)) {
+                return false;
+            }
         } else if (strcmp(argv[i], "--ip") == 0) {
             if (i + 1 < argc) {
-                ip = argv[++i];
+                config.ip = argv[++i];
             } else {
                 std::cerr << "Error: --ip requires an argument" << std::endl;
                 return false;
             }
         } else if (strcmp(argv[i], "--port") == 0) {
             if (i + 1 < argc) {
-                port = static_cast<uint16_t>(atoi(argv[++i]));
-                if (port == 0) {
+                config.port = static_cast<uint16_t>(atoi(argv[++i]));
+                if (config.port == 0) {
                     std::cerr << "Error: Invalid port number" << std::endl;
                     return false;
                 }
@@ -66,8 +231,8 @@ bool parse_arguments(int argc, char* argv[], std::string& ip, uint16_t& port, ui
             }
         } else if (strcmp(argv[i], "--threads") == 0) {
             if (i + 1 < argc) {
-                threads = static_cast<uint32_t>(atoi(argv[++i]));
-                if (threads == 0) {
+                config.threads = static_cast<uint32_t>(atoi(argv[++i]));
+                if (config.threads == 0) {
                     std::cerr << "Error: Invalid thread count" << std::endl;
                     return false;
                 }
@@ -75,6 +240,167 @@ bool parse_arguments(int argc, char* argv[], std::string& ip, uint16_t& port, ui
                 std::cerr << "Error: --threads requires an argument" << std::endl;
                 return false;
             }
+        } else if (strcmp(argv[i], "--sharded") == 0) {
+            config.sharded = true;
+        } else if (strcmp(argv[i], "--cpus") == 0 ||
+                   strcmp(argv[i], "--strategy-cpus") == 0 ||
+                   strcmp(argv[i], "--egress-cpus") == 0) {
+            std::vector<int>& cpus = strcmp(argv[i], "--cpus") == 0 ? config.cpu_affinity
+                : strcmp(argv[i], "--strategy-cpus") == 0 ? config.strategy_cpu_affinity
+                : config.egress_cpu_affinity;
+            if (i + 1 < argc) {
+                const char* option = argv[i];
+                if (!hft::parse_cpu_list(argv[++i], cpus)) {
+                    std::cerr << "Error: Invalid CPU list for " << option << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--strategy-threads") == 0 ||
+                   strcmp(argv[i], "--egress-threads") == 0) {
+            uint32_t& count = strcmp(argv[i], "--strategy-threads") == 0
+                ? config.strategy_threads : config.egress_threads;
+            if (i + 1 < argc) {
+                const char* option = argv[i];
+                count = static_cast<uint32_t>(atoi(argv[++i]));
+                if (count == 0) {
+                    std::cerr << "Error: Invalid thread count for " << option << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--multicast") == 0 ||
+                   strcmp(argv[i], "--multicast-if") == 0 ||
+                   strcmp(argv[i], "--multicast-ttl") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            const char* option = argv[i++];
+            if (strcmp(option, "--multicast-if") == 0) {
+                config.multicast.interface_ip = argv[i];
+            } else if (strcmp(option, "--multicast-ttl") == 0) {
+                config.multicast.ttl = static_cast<uint8_t>(atoi(argv[i]));
+            } else if (!hft::parse_multicast_endpoint(argv[i], config.multicast)) {
+                std::cerr << "Error: Invalid multicast endpoint (want group:port): " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--risk-limits") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --risk-limits requires an argument" << std::endl;
+                return false;
+            }
+            g_risk_limits_path = argv[++i];
+            if (!hft::load_risk_limits(g_risk_limits_path, config.risk)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--instruments") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --instruments requires an argument" << std::endl;
+                return false;
+            }
+            if (!hft::load_instruments(argv[++i], config.instruments)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--journal") == 0 ||
+                   strcmp(argv[i], "--journal-segment-mb") == 0 ||
+                   strcmp(argv[i], "--journal-flush-ms") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            const char* option = argv[i++];
+            if (strcmp(option, "--journal") == 0) {
+                config.journal.directory = argv[i];
+            } else if (strcmp(option, "--journal-segment-mb") == 0) {
+                config.journal.segment_bytes = strtoull(argv[i], nullptr, 10) << 20;
+            } else {
+                config.journal.flush_interval_ms = static_cast<uint32_t>(strtoul(argv[i], nullptr, 10));
+            }
+        } else if (strcmp(argv[i], "--transport") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --transport requires an argument" << std::endl;
+                return false;
+            }
+            if (!hft::parse_transport_kind(argv[++i], config.transport.kind)) {
+                std::cerr << "Error: Unknown transport (want epoll or io_uring): " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--sqpoll") == 0) {
+            config.transport.sqpoll = true;
+        } else if (strcmp(argv[i], "--busy-poll") == 0) {
+            // Nothing on the order path sleeps: I/O workers poll, stages spin
+            config.busy_poll.spin = true;
+            config.io_backoff = BackoffPolicy::busy_poll();
+            config.strategy_backoff = BackoffPolicy::busy_poll();
+            config.egress_backoff = BackoffPolicy::busy_poll();
+        } else if (strcmp(argv[i], "--prefer-busy-poll") == 0) {
+            config.busy_poll.prefer_busy_poll = true;
+        } else if (strcmp(argv[i], "--send-high-water") == 0 ||
+                   strcmp(argv[i], "--send-limit") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            uint32_t& mark = strcmp(argv[i], "--send-limit") == 0
+                ? config.outbound.limit : config.outbound.high_water;
+            mark = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--heartbeat") == 0 ||
+                   strcmp(argv[i], "--idle-timeout") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            uint32_t& interval = strcmp(argv[i], "--heartbeat") == 0
+                ? config.session.heartbeat_ms : config.session.idle_timeout_ms;
+            interval = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--require-login") == 0) {
+            config.session.require_login = true;
+        } else if (strcmp(argv[i], "--huge-pages") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --huge-pages requires an argument" << std::endl;
+                return false;
+            }
+            if (!hft::parse_huge_pages(argv[++i], config.memory.huge_pages)) {
+                std::cerr << "Error: Unknown page size (want off, 2m or 1g): " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --metrics requires an argument" << std::endl;
+                return false;
+            }
+            config.metrics_segment = argv[++i];
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --warmup requires an argument" << std::endl;
+                return false;
+            }
+            config.warmup.rounds = static_cast<uint32_t>(std::max(atoi(argv[++i]), 0));
+        } else if (strcmp(argv[i], "--numa") == 0) {
+            config.memory.numa = true;
+        } else if (strcmp(argv[i], "--mlock") == 0) {
+            config.memory.lock = true;
+        } else if (strcmp(argv[i], "--so-busy-poll") == 0 ||
+                   strcmp(argv[i], "--sched-fifo") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << argv[i] << " requires an argument" << std::endl;
+                return false;
+            }
+            const char* option = argv[i++];
+            int value = atoi(argv[i]);
+            if (strcmp(option, "--so-busy-poll") == 0) {
+                config.busy_poll.socket_busy_poll_us = static_cast<uint32_t>(std::max(value, 0));
+            } else if (value < 1 || value > 99) {
+                std::cerr << "Error: SCHED_FIFO priority must be 1-99" << std::endl;
+                return false;
+            } else {
+                config.busy_poll.realtime_priority = value;
+            }
         } else {
             std::cerr << "Error: Unknown option " << argv[i] << std::endl;
             print_usage(argv[0]);
@@ -90,22 +416,21 @@ int main(int argc, char* argv[]) {
     using namespace ultra_hft;
     
     // Default configuration
-    std::string server_ip = "127.0.0.1";
-    uint16_t server_port = 8888;
-    uint32_t thread_count = 4;
+    UltraServerConfig config;
     
     // Parse command line arguments
-    if (!parse_arguments(argc, argv, server_ip, server_port, thread_count)) {
+    if (!parse_arguments(argc, argv, config)) {
         return 1;
     }
     
     // Create server instance
-    UltraHFTServer server(server_ip, server_port, thread_count);
+    UltraHFTServer server(config);
     g_server = &server;
     
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGHUP, signal_handler);
     
     std::cout << "Starting Ultra HFT Server..." << std::endl;
     std::cout << "Press Ctrl+C to stop" << std::endl;
@@ -126,6 +451,17 @@ int main(int argc, char* argv[]) {
     while (true) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         
+        if (g_reload_risk) {
+            g_reload_risk = 0;
+            hft::RiskLimits limits;
+            if (g_risk_limits_path.empty()) {
+                std::cerr << "SIGHUP ignored: no --risk-limits file to reload" << std::endl;
+            } else if (hft::load_risk_limits(g_risk_limits_path, limits)) {
+                server.reload_risk_limits(limits);
+                std::cout << "Reloaded risk limits from " << g_risk_limits_path << std::endl;
+            }
+        }
+        
         // Check if server is still running
         if (!g_server) {
             break;
@@ -11,6 +11,15 @@
 #include <iomanip>
 #include <sstream>
 #include <csignal>
+#include <fstream>
+#include <memory>
+#include <algorithm>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include "wire_protocol.h"
+#include "latency_histogram.h"
+#include "thread_affinity.h"
 
 // Global flag for graceful shutdown
 std::atomic<bool> g_running{true};
@@ -84,57 +93,14 @@ void log_performance(const std::string& message) {
               << std::setfill('0') << std::setw(3) << ms.count() << "] " << message << std::endl;
 }
 
-// Ultra HFT message structures (matching ultra_hft_server.h)
-struct alignas(64) UltraMessage {
-    uint64_t message_id;
-    uint64_t timestamp;
-    uint32_t message_type;
-    uint32_t payload_size;
-    std::array<uint8_t, 1024> payload;
-    
-    UltraMessage() : message_id(0), timestamp(0), message_type(0), payload_size(0) {}
-    
-    void update_timestamp() {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto duration = now.time_since_epoch();
-        timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
-    }
-    
-    static uint64_t get_current_timestamp() {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto duration = now.time_since_epoch();
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
-    }
-};
+// Ultra HFT messages are encoded with the shared compact wire protocol
+using namespace hft;
 
-struct alignas(64) UltraOrderMessage : public UltraMessage {
-    char symbol[16];
-    uint32_t side;      // 0=BUY, 1=SELL
-    uint64_t quantity;
-    uint64_t price;
-    uint32_t order_type;
-    uint32_t time_in_force;
-    
-    UltraOrderMessage() : UltraMessage(), side(0), quantity(0), price(0), order_type(0), time_in_force(0) {
-        message_type = 1; // ORDER_NEW
-        std::fill(symbol, symbol + 16, 0);
-    }
-};
-
-struct alignas(64) UltraMarketDataMessage : public UltraMessage {
-    char symbol[16];
-    uint64_t bid_price;
-    uint64_t bid_size;
-    uint64_t ask_price;
-    uint64_t ask_size;
-    uint64_t last_price;
-    uint64_t volume;
-    
-    UltraMarketDataMessage() : UltraMessage(), bid_price(0), bid_size(0), ask_price(0), ask_size(0), last_price(0), volume(0) {
-        message_type = 2; // MARKET_DATA
-        std::fill(symbol, symbol + 16, 0);
-    }
-};
+static uint64_t get_current_timestamp() {
+    auto now = std::chrono::high_resolution_clock::now();
+    auto duration = now.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
 
 // Ultra Test Client class
 class UltraTestClient {
@@ -227,19 +193,18 @@ public:
     bool send_ultra_order(const std::string& symbol, uint32_t side, uint64_t quantity, uint64_t price) {
         if (sock_fd_ < 0) return false;
         
-        UltraOrderMessage msg;
-        msg.message_id = message_id_counter_.fetch_add(1);
-        msg.update_timestamp();
-        strncpy(msg.symbol, symbol.c_str(), 15);
-        msg.symbol[15] = '\0';
-        msg.side = side;
-        msg.quantity = quantity;
-        msg.price = price;
-        msg.order_type = 1; // MARKET
-        msg.time_in_force = 1; // DAY
-        
-        ssize_t bytes_sent = send(sock_fd_, &msg, sizeof(msg), MSG_DONTWAIT);
-        if (bytes_sent == sizeof(msg)) {
+        uint64_t message_id = message_id_counter_.fetch_add(1);
+        wire::OrderBody body = wire::make_order_body(
+            symbol.data(), symbol.size(), message_id, message_id, price, 0,
+            static_cast<uint32_t>(quantity), side == 0 ? OrderSide::BUY : OrderSide::SELL,
+            OrderType::MARKET, TimeInForce::DAY);
+        
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::write_frame(frame, MessageType::ORDER_NEW, message_id,
+                                                get_current_timestamp(), 0, &body);
+        
+        ssize_t bytes_sent = send(sock_fd_, frame, frame_length, MSG_DONTWAIT);
+        if (bytes_sent == static_cast<ssize_t>(frame_length)) {
             metrics_.successful_messages.fetch_add(1);
             return true;
         } else {
@@ -252,20 +217,17 @@ public:
                                 uint64_t ask_price, uint64_t ask_size, uint64_t last_price, uint64_t volume) {
         if (sock_fd_ < 0) return false;
         
-        UltraMarketDataMessage msg;
-        msg.message_id = message_id_counter_.fetch_add(1);
-        msg.update_timestamp();
-        strncpy(msg.symbol, symbol.c_str(), 15);
-        msg.symbol[15] = '\0';
-        msg.bid_price = bid_price;
-        msg.bid_size = bid_size;
-        msg.ask_price = ask_price;
-        msg.ask_size = ask_size;
-        msg.last_price = last_price;
-        msg.volume = volume;
-        
-        ssize_t bytes_sent = send(sock_fd_, &msg, sizeof(msg), MSG_DONTWAIT);
-        if (bytes_sent == sizeof(msg)) {
+        wire::MarketDataBody body = wire::make_market_data_body(
+            symbol.data(), symbol.size(), bid_price, static_cast<uint32_t>(bid_size),
+            ask_price, static_cast<uint32_t>(ask_size), last_price, 0, volume, 0, 0);
+        
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length = wire::write_frame(frame, MessageType::MARKET_DATA,
+                                                message_id_counter_.fetch_add(1),
+                                                get_current_timestamp(), 0, &body);
+        
+        ssize_t bytes_sent = send(sock_fd_, frame, frame_length, MSG_DONTWAIT);
+        if (bytes_sent == static_cast<ssize_t>(frame_length)) {
             metrics_.successful_messages.fetch_add(1);
             return true;
         } else {
@@ -501,6 +463,506 @@ private:
     }
 };
 
+// Open-loop benchmark. Messages go out on a fixed schedule whether or not
+// earlier ones have been answered, and each round trip is measured from
+// the time its message was due. A server stall then shows up as the
+// queueing delay it really causes instead of as a lower send rate, which
+// is what a closed loop (send, wait, send) reports (coordinated omission).
+struct BenchmarkConfig {
+    std::string server_ip = "127.0.0.1";
+    uint16_t server_port = 8888;
+    uint32_t connections = 8;
+    uint32_t threads = 1;
+    std::vector<int> cpus;              // Threads are pinned round robin; empty leaves them unpinned
+    uint64_t rate = 100000;             // Messages per second over every connection
+    uint32_t duration_seconds = 10;     // Measured period, after the warm-up
+    uint32_t warmup_seconds = 1;        // Sent on schedule but not recorded
+    bool orders = false;                // ORDER_NEW instead of MARKET_DATA
+    std::string csv_path;
+    std::string json_path;
+};
+
+// One thread's share of the schedule and of the connections
+class BenchmarkWorker {
+public:
+    // Sent messages wait here for their ack; one still unanswered when its
+    // slot comes round again is given up on, and a later ack is unmatched
+    static constexpr size_t PENDING_SLOTS = 1 << 20;
+    static constexpr uint64_t SEQUENCE_MASK = (1ULL << 48) - 1;
+    static constexpr size_t RECV_BUFFER_SIZE = 64 * 1024;
+    
+    std::atomic<uint64_t> sent{0};           // Messages sent in the measured period
+    std::atomic<uint64_t> acked{0};          // ORDER_ACK / MARKET_DATA_ACK recorded
+    std::atomic<uint64_t> rejected{0};       // ORDER_REJECT recorded
+    std::atomic<uint64_t> unmatched{0};      // Acks for no pending message
+    std::atomic<uint64_t> max_lag_ns{0};     // Furthest a send fell behind its schedule
+    std::atomic<bool> failed{false};
+    
+    // Measured from the intended send time, and from the actual one
+    LatencyHistogram response_time;
+    LatencyHistogram service_time;
+    
+    BenchmarkWorker(const BenchmarkConfig& config, uint32_t index)
+        : config_(config), index_(index), tag_(static_cast<uint64_t>(index + 1) << 48),
+          pending_(new Pending[PENDING_SLOTS]()) {}
+    
+    ~BenchmarkWorker() {
+        for (Connection& connection : connections_) {
+            if (connection.fd >= 0) close(connection.fd);
+        }
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+    }
+    
+    bool connect(uint32_t count) {
+        epoll_fd_ = epoll_create1(0);
+        if (epoll_fd_ < 0) {
+            log_error("Failed to create epoll instance: " + std::string(strerror(errno)));
+            return false;
+        }
+        
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(config_.server_port);
+        server_addr.sin_addr.s_addr = inet_addr(config_.server_ip.c_str());
+        
+        connections_.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Connection& connection = connections_[i];
+            connection.fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (connection.fd < 0) {
+                log_error("Failed to create socket: " + std::string(strerror(errno)));
+                return false;
+            }
+            
+            int opt = 1;
+            setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            if (::connect(connection.fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+                log_error("Failed to connect: " + std::string(strerror(errno)));
+                return false;
+            }
+            fcntl(connection.fd, F_SETFL, fcntl(connection.fd, F_GETFL, 0) | O_NONBLOCK);
+            
+            connection.in.reset(new uint8_t[RECV_BUFFER_SIZE]);
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u32 = i;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connection.fd, &event) < 0) {
+                log_error("Failed to register connection: " + std::string(strerror(errno)));
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Message k of this thread is due at start + (k * threads + index) / rate,
+    // so the threads interleave into one even stream at the total rate
+    void run(uint64_t start_ns, uint64_t measure_ns, uint64_t end_ns, uint64_t drain_ns) {
+        if (!config_.cpus.empty() && !pin_current_thread(config_.cpus[index_ % config_.cpus.size()])) {
+            log_warning("Failed to pin benchmark thread " + std::to_string(index_));
+        }
+        
+        const TscClock& clock = TscClock::instance();
+        uint64_t k = 0;
+        uint64_t due = schedule(start_ns, 0);
+        
+        while (g_running.load(std::memory_order_relaxed)) {
+            uint64_t now = clock.now_ns();
+            
+            // Everything that has come due goes out now, however late
+            bool queued = false;
+            while (due <= now && due < end_ns) {
+                queue_message(now, k, due, due >= measure_ns);
+                queued = true;
+                due = schedule(start_ns, ++k);
+            }
+            if (queued) {
+                flush();
+            }
+            
+            int timeout_ms = 0;
+            if (due >= end_ns) {
+                if (now >= drain_ns || pending_count_ == 0) break;
+                timeout_ms = 1;
+            } else if (due > now + 2000000) {
+                timeout_ms = static_cast<int>((due - now) / 1000000) - 1;
+            }
+            if (!poll(timeout_ms)) break;
+        }
+    }
+
+private:
+    struct Pending {
+        uint64_t message_id;                 // 0 when free
+        uint64_t intended_ns;
+        uint64_t sent_ns;
+        bool measured;
+    };
+    
+    struct Connection {
+        int fd = -1;
+        std::vector<uint8_t> out;            // Frames queued since the last flush
+        size_t out_head = 0;                 // Bytes of out already written
+        std::unique_ptr<uint8_t[]> in;
+        size_t in_length = 0;
+    };
+    
+    // Counters have one writer, so no locked increment
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    uint64_t schedule(uint64_t start_ns, uint64_t k) const {
+        return start_ns + (k * config_.threads + index_) * 1000000000ULL / config_.rate;
+    }
+    
+    void queue_message(uint64_t now, uint64_t k, uint64_t intended, bool measured) {
+        uint64_t message_id = tag_ | k;
+        Pending& slot = pending_[k & (PENDING_SLOTS - 1)];
+        if (slot.message_id != 0) {
+            --pending_count_;
+        }
+        slot.message_id = message_id;
+        slot.intended_ns = intended;
+        slot.sent_ns = now;
+        slot.measured = measured;
+        ++pending_count_;
+        
+        if (measured) {
+            bump(sent);
+            if (now - intended > max_lag_ns.load(std::memory_order_relaxed)) {
+                max_lag_ns.store(now - intended, std::memory_order_relaxed);
+            }
+        }
+        
+        char symbol[16];
+        int symbol_length = snprintf(symbol, sizeof(symbol), "SYMBOL%u", static_cast<unsigned>(k % 10));
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t frame_length;
+        if (config_.orders) {
+            wire::OrderBody body = wire::make_order_body(
+                symbol, symbol_length, message_id, message_id, 1500000 + k % 1000, 0, 100,
+                k % 2 == 0 ? OrderSide::BUY : OrderSide::SELL, OrderType::MARKET, TimeInForce::DAY);
+            frame_length = wire::write_frame(frame, MessageType::ORDER_NEW, message_id, now, 0, &body);
+        } else {
+            uint64_t bid_price = 1500000 + k % 1000;
+            wire::MarketDataBody body = wire::make_market_data_body(
+                symbol, symbol_length, bid_price, 1000, bid_price + 100, 1000, bid_price + 50, 0,
+                10000 + k % 10000, 0, 0);
+            frame_length = wire::write_frame(frame, MessageType::MARKET_DATA, message_id, now, 0, &body);
+        }
+        
+        Connection& connection = connections_[k % connections_.size()];
+        if (connection.fd < 0) return;  // Failed; the message stays unacked
+        connection.out.insert(connection.out.end(), frame, frame + frame_length);
+    }
+    
+    // Write what each connection has queued; a full socket keeps the rest for the next pass
+    void flush() {
+        for (Connection& connection : connections_) {
+            size_t length = connection.out.size() - connection.out_head;
+            if (connection.fd < 0 || length == 0) continue;
+            
+            ssize_t written = send(connection.fd, connection.out.data() + connection.out_head, length,
+                                   MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (written > 0) {
+                connection.out_head += static_cast<size_t>(written);
+            } else if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(connection, "send failed: " + std::string(strerror(errno)));
+                continue;
+            }
+            if (connection.out_head == connection.out.size()) {
+                connection.out.clear();
+                connection.out_head = 0;
+            }
+        }
+    }
+    
+    bool poll(int timeout_ms) {
+        struct epoll_event events[64];
+        int ready = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            log_error("epoll_wait failed: " + std::string(strerror(errno)));
+            failed.store(true);
+            return false;
+        }
+        
+        for (int i = 0; i < ready; ++i) {
+            Connection& connection = connections_[events[i].data.u32];
+            ssize_t received = recv(connection.fd, connection.in.get() + connection.in_length,
+                                    RECV_BUFFER_SIZE - connection.in_length, 0);
+            if (received <= 0) {
+                if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+                fail(connection, received == 0 ? std::string("server closed the connection")
+                                               : "recv failed: " + std::string(strerror(errno)));
+                continue;
+            }
+            uint64_t now = TscClock::instance().now_ns();
+            connection.in_length += static_cast<size_t>(received);
+            
+            size_t offset = 0;
+            size_t frame_length = 0;
+            wire::FrameStatus status;
+            while ((status = wire::peek_frame(connection.in.get() + offset, connection.in_length - offset,
+                                              frame_length)) == wire::FrameStatus::COMPLETE) {
+                on_frame(connection.in.get() + offset, now);
+                offset += frame_length;
+            }
+            if (status == wire::FrameStatus::MALFORMED) {
+                fail(connection, "malformed frame from server");
+                continue;
+            }
+            memmove(connection.in.get(), connection.in.get() + offset, connection.in_length - offset);
+            connection.in_length -= offset;
+        }
+        
+        // Stop once every connection has failed
+        for (const Connection& connection : connections_) {
+            if (connection.fd >= 0) return true;
+        }
+        return false;
+    }
+    
+    void on_frame(const uint8_t* frame, uint64_t now) {
+        MessageType type = wire::frame_type(frame);
+        if (type != MessageType::ORDER_ACK && type != MessageType::MARKET_DATA_ACK &&
+            type != MessageType::ORDER_REJECT) {
+            return;  // Fills and anything unsolicited
+        }
+        
+        wire::FrameHeader header;
+        memcpy(&header, frame, wire::HEADER_SIZE);
+        uint64_t message_id = wire::from_wire(header.message_id);
+        Pending& slot = pending_[(message_id & SEQUENCE_MASK) & (PENDING_SLOTS - 1)];
+        if (slot.message_id != message_id) {
+            bump(unmatched);
+            return;
+        }
+        slot.message_id = 0;
+        --pending_count_;
+        if (!slot.measured) return;
+        
+        response_time.record(now - slot.intended_ns);
+        service_time.record(now - slot.sent_ns);
+        bump(type == MessageType::ORDER_REJECT ? rejected : acked);
+    }
+    
+    void fail(Connection& connection, const std::string& reason) {
+        log_error("Benchmark connection closed: " + reason);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+        close(connection.fd);
+        connection.fd = -1;
+        failed.store(true);
+    }
+    
+    const BenchmarkConfig& config_;
+    uint32_t index_;
+    uint64_t tag_;                           // Thread index in the top bits of every message ID
+    int epoll_fd_ = -1;
+    std::vector<Connection> connections_;
+    std::unique_ptr<Pending[]> pending_;
+    uint64_t pending_count_ = 0;
+};
+
+// Percentiles reported by the benchmark, in percent
+static const double BENCHMARK_PERCENTILES[] = {0.0, 50.0, 75.0, 90.0, 95.0, 99.0, 99.5, 99.9, 99.95, 99.99, 99.999, 100.0};
+
+static std::string percentile_label(double percentile) {
+    if (percentile == 0.0) return "min";
+    if (percentile == 100.0) return "max";
+    std::ostringstream label;
+    label << "p" << percentile;
+    return label.str();
+}
+
+static double to_us(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+static bool write_benchmark_csv(const std::string& path, const HistogramSnapshot& response,
+                                const HistogramSnapshot& service) {
+    std::ofstream out(path);
+    if (!out) {
+        log_error("Failed to open " + path + " for writing");
+        return false;
+    }
+    
+    out << "percentile,response_time_us,service_time_us" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (double percentile : BENCHMARK_PERCENTILES) {
+        out << percentile << "," << to_us(response.value_at(percentile / 100.0)) << ","
+            << to_us(service.value_at(percentile / 100.0)) << std::endl;
+    }
+    return static_cast<bool>(out);
+}
+
+static bool write_benchmark_json(const std::string& path, const BenchmarkConfig& config,
+                                 const std::string& results, const HistogramSnapshot& response,
+                                 const HistogramSnapshot& service) {
+    std::ofstream out(path);
+    if (!out) {
+        log_error("Failed to open " + path + " for writing");
+        return false;
+    }
+    
+    auto percentiles = [&out](const HistogramSnapshot& histogram) {
+        out << "{";
+        const char* separator = "";
+        for (double percentile : BENCHMARK_PERCENTILES) {
+            out << separator << "\"" << percentile_label(percentile) << "\": "
+                << to_us(histogram.value_at(percentile / 100.0));
+            separator = ", ";
+        }
+        out << "}";
+    };
+    
+    out << std::fixed << std::setprecision(3);
+    out << "{" << std::endl;
+    out << "  \"message\": \"" << (config.orders ? "order" : "market_data") << "\"," << std::endl;
+    out << "  \"target_rate\": " << config.rate << "," << std::endl;
+    out << "  \"connections\": " << config.connections << "," << std::endl;
+    out << "  \"threads\": " << config.threads << "," << std::endl;
+    out << "  \"warmup_seconds\": " << config.warmup_seconds << "," << std::endl;
+    out << "  \"duration_seconds\": " << config.duration_seconds << "," << std::endl;
+    out << results;
+    out << "  \"response_time_us\": ";
+    percentiles(response);
+    out << "," << std::endl << "  \"service_time_us\": ";
+    percentiles(service);
+    out << std::endl << "}" << std::endl;
+    return static_cast<bool>(out);
+}
+
+static bool run_open_loop_benchmark(const BenchmarkConfig& config) {
+    log_performance("Starting Open-Loop Benchmark");
+    log_performance("Target: " + std::to_string(config.rate) + " " + (config.orders ? "orders" : "market data updates") +
+                    "/second over " + std::to_string(config.connections) + " connections on " +
+                    std::to_string(config.threads) + " threads");
+    log_performance("Duration: " + std::to_string(config.warmup_seconds) + "s warm-up, " +
+                    std::to_string(config.duration_seconds) + "s measured");
+    
+    std::vector<std::unique_ptr<BenchmarkWorker>> workers;
+    for (uint32_t t = 0; t < config.threads; ++t) {
+        uint32_t count = config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0);
+        workers.emplace_back(new BenchmarkWorker(config, t));
+        if (!workers.back()->connect(count)) {
+            return false;
+        }
+    }
+    log_success("Connected " + std::to_string(config.connections) + " benchmark connections to " +
+                config.server_ip + ":" + std::to_string(config.server_port));
+    
+    const TscClock& clock = TscClock::instance();
+    uint64_t start_ns = clock.now_ns() + 100000000ULL;
+    uint64_t measure_ns = start_ns + config.warmup_seconds * 1000000000ULL;
+    uint64_t end_ns = measure_ns + config.duration_seconds * 1000000000ULL;
+    uint64_t drain_ns = end_ns + 2000000000ULL;
+    
+    std::atomic<uint32_t> finished{0};
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&, w = worker.get()]() {
+            w->run(start_ns, measure_ns, end_ns, drain_ns);
+            finished.fetch_add(1);
+        });
+    }
+    
+    // Progress once a second over the measured period, from the live histograms
+    HistogramSnapshot previous;
+    HistogramSnapshot current;
+    uint64_t next_report_ns = measure_ns + 1000000000ULL;
+    while (finished.load() < workers.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t now = clock.now_ns();
+        if (now < next_report_ns || next_report_ns > end_ns) continue;
+        
+        current.clear();
+        uint64_t sent = 0;
+        for (auto& worker : workers) {
+            current.add(worker->response_time);
+            sent += worker->sent.load(std::memory_order_relaxed);
+        }
+        HistogramSnapshot interval = current;
+        interval.subtract(previous);
+        previous = current;
+        
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(2) << "Benchmark progress: "
+             << (next_report_ns - measure_ns) / 1000000000ULL << "s, " << sent << " sent, interval p50 "
+             << to_us(interval.value_at(0.50)) << "μs p99 " << to_us(interval.value_at(0.99)) << "μs max "
+             << to_us(interval.value_at(1.0)) << "μs";
+        log_performance(line.str());
+        next_report_ns += 1000000000ULL;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    HistogramSnapshot response;
+    HistogramSnapshot service;
+    uint64_t sent = 0, acked = 0, rejected = 0, unmatched = 0, max_lag_ns = 0;
+    bool failed = false;
+    for (auto& worker : workers) {
+        response.add(worker->response_time);
+        service.add(worker->service_time);
+        sent += worker->sent.load();
+        acked += worker->acked.load();
+        rejected += worker->rejected.load();
+        unmatched += worker->unmatched.load();
+        max_lag_ns = std::max(max_lag_ns, worker->max_lag_ns.load());
+        failed = failed || worker->failed.load();
+    }
+    uint64_t unacked = sent - acked - rejected;
+    double seconds = static_cast<double>(config.duration_seconds);
+    double send_rate = static_cast<double>(sent) / seconds;
+    double answer_rate = static_cast<double>(acked + rejected) / seconds;
+    
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2);
+    log_performance("=== Open-Loop Benchmark Results ===");
+    line << "Rate: " << config.rate << " target, " << send_rate << " sent, " << answer_rate << " answered (msgs/second)";
+    log_performance(line.str());
+    log_performance("Sent: " + std::to_string(sent) + ", Acked: " + std::to_string(acked) + ", Rejected: " +
+                    std::to_string(rejected) + ", Unacked: " + std::to_string(unacked) + ", Unmatched: " +
+                    std::to_string(unmatched));
+    line.str("");
+    line << "Max Send Lag: " << to_us(max_lag_ns) << "μs behind schedule";
+    log_performance(line.str());
+    
+    log_performance("Round trip (μs)  response = from intended send, service = from actual send");
+    for (double percentile : BENCHMARK_PERCENTILES) {
+        line.str("");
+        line << "  " << std::left << std::setw(8) << percentile_label(percentile) << std::right
+             << std::setw(12) << to_us(response.value_at(percentile / 100.0))
+             << std::setw(12) << to_us(service.value_at(percentile / 100.0));
+        log_performance(line.str());
+    }
+    log_performance("=====================================");
+    
+    if (unacked > 0) {
+        log_warning(std::to_string(unacked) + " messages were not answered within 2s of the last send");
+    }
+    
+    bool ok = !failed && sent > 0;
+    if (!config.csv_path.empty()) {
+        ok = write_benchmark_csv(config.csv_path, response, service) && ok;
+    }
+    if (!config.json_path.empty()) {
+        std::ostringstream results;
+        results << std::fixed << std::setprecision(3)
+                << "  \"sent\": " << sent << "," << std::endl
+                << "  \"acked\": " << acked << "," << std::endl
+                << "  \"rejected\": " << rejected << "," << std::endl
+                << "  \"unacked\": " << unacked << "," << std::endl
+                << "  \"unmatched\": " << unmatched << "," << std::endl
+                << "  \"send_rate\": " << send_rate << "," << std::endl
+                << "  \"answer_rate\": " << answer_rate << "," << std::endl
+                << "  \"max_send_lag_us\": " << to_us(max_lag_ns) << "," << std::endl;
+        ok = write_benchmark_json(config.json_path, config, results.str(), response, service) && ok;
+    }
+    return ok;
+}
+
 // Print usage information
 void print_usage(const char* program_name) {
     std::cout << "Ultra HFT Test Client - Specialized for Ultra HFT Server Testing" << std::endl;
@@ -509,10 +971,17 @@ void print_usage(const char* program_name) {
     std::cout << "Options:" << std::endl;
     std::cout << "  --ip <ip>        Server IP address (default: 127.0.0.1)" << std::endl;
     std::cout << "  --port <port>    Server port (default: 8888)" << std::endl;
-    std::cout << "  --mode <mode>    Test mode: latency, throughput, stress, streaming (default: latency)" << std::endl;
+    std::cout << "  --mode <mode>    Test mode: latency, throughput, stress, streaming, benchmark (default: latency)" << std::endl;
     std::cout << "  --count <n>      Number of messages for test (default: 1000)" << std::endl;
     std::cout << "  --duration <n>   Test duration in seconds (default: 60)" << std::endl;
     std::cout << "  --rate <n>       Messages per second (default: 1000)" << std::endl;
+    std::cout << "  --connections <n> Benchmark connections (default: 8)" << std::endl;
+    std::cout << "  --threads <n>    Benchmark sending threads (default: 1)" << std::endl;
+    std::cout << "  --cpus <list>    Pin benchmark threads to these CPUs, e.g. 2-5 (default: unpinned)" << std::endl;
+    std::cout << "  --warmup <n>     Benchmark warm-up seconds, not recorded (default: 1)" << std::endl;
+    std::cout << "  --message <type> Benchmark message: market_data or order (default: market_data)" << std::endl;
+    std::cout << "  --csv <file>     Write benchmark percentiles as CSV" << std::endl;
+    std::cout << "  --json <file>    Write benchmark results as JSON" << std::endl;
     std::cout << "  --help           Show this help message" << std::endl;
     std::cout << std::endl;
     std::cout << "Test Modes:" << std::endl;
@@ -520,12 +989,14 @@ void print_usage(const char* program_name) {
     std::cout << "  throughput      Maximum throughput test" << std::endl;
     std::cout << "  stress          Sustained high-load stress test" << std::endl;
     std::cout << "  streaming       Real-time market data streaming" << std::endl;
+    std::cout << "  benchmark       Open-loop round trip latency at a fixed rate" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << program_name << " --mode latency --count 10000" << std::endl;
     std::cout << "  " << program_name << " --mode throughput --count 100000" << std::endl;
     std::cout << "  " << program_name << " --mode stress --duration 300 --rate 5000" << std::endl;
     std::cout << "  " << program_name << " --mode streaming --duration 120 --rate 1000" << std::endl;
+    std::cout << "  " << program_name << " --mode benchmark --rate 200000 --connections 32 --threads 4 --cpus 4-7 --duration 30 --json rtt.json" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
@@ -536,6 +1007,7 @@ int main(int argc, char* argv[]) {
     uint32_t message_count = 1000;
     uint32_t duration_seconds = 60;
     uint32_t messages_per_second = 1000;
+    BenchmarkConfig benchmark;
     
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--help") == 0) {
@@ -553,6 +1025,23 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) duration_seconds = static_cast<uint32_t>(atoi(argv[++i]));
         } else if (strcmp(argv[i], "--rate") == 0) {
             if (i + 1 < argc) messages_per_second = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--connections") == 0) {
+            if (i + 1 < argc) benchmark.connections = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            if (i + 1 < argc) benchmark.threads = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--cpus") == 0) {
+            if (i + 1 < argc && !parse_cpu_list(argv[++i], benchmark.cpus)) {
+                log_error("Invalid CPU list: " + std::string(argv[i]));
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            if (i + 1 < argc) benchmark.warmup_seconds = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--message") == 0) {
+            if (i + 1 < argc) benchmark.orders = strcmp(argv[++i], "order") == 0;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            if (i + 1 < argc) benchmark.csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            if (i + 1 < argc) benchmark.json_path = argv[++i];
         }
     }
     
@@ -565,6 +1054,25 @@ int main(int argc, char* argv[]) {
     std::cout << "Mode: " << test_mode << std::endl;
     std::cout << "========================" << std::endl;
     
+    // The benchmark opens its own connections across its threads
+    if (test_mode == "benchmark") {
+        benchmark.server_ip = server_ip;
+        benchmark.server_port = server_port;
+        benchmark.rate = messages_per_second;
+        benchmark.duration_seconds = duration_seconds;
+        if (benchmark.threads == 0 || benchmark.connections < benchmark.threads || benchmark.rate == 0 ||
+            benchmark.duration_seconds == 0) {
+            log_error("Benchmark needs --rate, --duration and --threads above 0, and at least one connection per thread");
+            return 1;
+        }
+        if (!run_open_loop_benchmark(benchmark)) {
+            log_error("Open-loop benchmark failed");
+            return 1;
+        }
+        log_success("Ultra HFT test completed successfully");
+        return 0;
+    }
+    
     // Create and connect client
     UltraTestClient client(server_ip, server_port);
     
@@ -0,0 +1,307 @@
+#include "warmup.h"
+#include "tsc_clock.h"
+#include "wire_protocol.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace hft {
+
+std::vector<WarmupInstrument> warmup_instruments(InstrumentDirectory& directory, uint32_t count) {
+    std::vector<WarmupInstrument> instruments;
+    for (uint32_t i = 0; i < count; ++i) {
+        InstrumentId id = i;
+        if (i >= directory.size()) {
+            if (!directory.open()) {
+                break;
+            }
+            id = directory.resolve(std::string_view("WARMUP" + std::to_string(i)));
+            if (id == NO_INSTRUMENT) {
+                break;
+            }
+        }
+
+        // A round price inside the instrument's band, on its tick
+        uint64_t tick = std::max<uint64_t>(directory.tick_size(id), 1);
+        uint64_t price = std::max<uint64_t>(directory.min_price(id), 100 * tick);
+        price = (price + tick - 1) / tick * tick;
+        if (directory.max_price(id) != 0 && price > directory.max_price(id)) {
+            price = directory.max_price(id) / tick * tick;
+        }
+
+        WarmupInstrument instrument{};
+        std::string_view symbol = directory.symbol(id);
+        memcpy(instrument.symbol, symbol.data(), std::min(symbol.size(), sizeof(instrument.symbol)));
+        instrument.price = price;
+        instrument.quantity = std::max<uint32_t>(directory.lot_size(id), 1);
+        instruments.push_back(instrument);
+    }
+    return instruments;
+}
+
+WarmupDriver::WarmupDriver(const WarmupConfig& config, std::vector<WarmupInstrument> instruments)
+    : config_(config), instruments_(std::move(instruments)) {}
+
+WarmupDriver::~WarmupDriver() {
+    close();
+}
+
+bool WarmupDriver::connect(size_t count, std::vector<int>& server_fds) {
+    if (instruments_.empty()) {
+        std::cerr << "Warm-up has no instrument to trade" << std::endl;
+        return false;
+    }
+
+    // A private listener on an ephemeral loopback port; clients never see it
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Failed to create warm-up socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, static_cast<int>(count)) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length) != 0) {
+        std::cerr << "Failed to listen for warm-up connections: " << strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        Client client;
+        client.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (client.fd < 0 || ::connect(client.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            std::cerr << "Failed to open a warm-up connection: " << strerror(errno) << std::endl;
+            if (client.fd >= 0) {
+                ::close(client.fd);
+            }
+            ok = false;
+            break;
+        }
+        int server_fd = accept(listener, nullptr, nullptr);
+        if (server_fd < 0) {
+            std::cerr << "Failed to accept a warm-up connection: " << strerror(errno) << std::endl;
+            ::close(client.fd);
+            ok = false;
+            break;
+        }
+        int nodelay = 1;
+        setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        fcntl(client.fd, F_SETFL, fcntl(client.fd, F_GETFL, 0) | O_NONBLOCK);
+
+        // Log in so sequenced sessions see the same frames a real client sends
+        uint8_t frame[wire::MAX_FRAME_SIZE];
+        size_t length = wire::encode_header_only(frame, MessageType::LOGIN, 0,
+                                                 TscClock::instance().wall_ns(), 1);
+        client.outbox.assign(frame, frame + length);
+        clients_.push_back(std::move(client));
+        server_fds.push_back(server_fd);
+    }
+    ::close(listener);
+    return ok;
+}
+
+bool WarmupDriver::flush(Client& client) {
+    size_t sent = 0;
+    while (sent < client.outbox.size()) {
+        ssize_t n = ::send(client.fd, client.outbox.data() + sent, client.outbox.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            std::cerr << "Warm-up send failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    client.outbox.erase(client.outbox.begin(), client.outbox.begin() + static_cast<ptrdiff_t>(sent));
+    return true;
+}
+
+bool WarmupDriver::receive(Client& client, size_t& answered) {
+    uint8_t buffer[16 * 1024];
+    while (true) {
+        ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            client.inbox.insert(client.inbox.end(), buffer, buffer + n);
+        } else if (n == 0) {
+            std::cerr << "Server closed a warm-up connection" << std::endl;
+            return false;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            std::cerr << "Warm-up receive failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    // Fills, heartbeats and the login ack pass by; each order gets one ack or reject
+    size_t offset = 0;
+    size_t frame_length = 0;
+    while (true) {
+        const uint8_t* frame = client.inbox.data() + offset;
+        wire::FrameStatus status = wire::peek_frame(frame, client.inbox.size() - offset, frame_length);
+        if (status == wire::FrameStatus::INCOMPLETE) {
+            break;
+        }
+        if (status == wire::FrameStatus::MALFORMED) {
+            std::cerr << "Malformed frame on a warm-up connection" << std::endl;
+            return false;
+        }
+        MessageType type = wire::frame_type(frame);
+        if ((type == MessageType::ORDER_ACK || type == MessageType::ORDER_REJECT) && client.outstanding > 0) {
+            --client.outstanding;
+            ++answered;
+        }
+        offset += frame_length;
+    }
+    client.inbox.erase(client.inbox.begin(), client.inbox.begin() + static_cast<ptrdiff_t>(offset));
+    return true;
+}
+
+bool WarmupDriver::run_round() {
+    if (clients_.empty()) {
+        return false;
+    }
+
+    std::vector<size_t> quota(clients_.size(), config_.orders / clients_.size());
+    for (size_t i = 0; i < config_.orders % clients_.size(); ++i) {
+        ++quota[i];
+    }
+    std::vector<pollfd> polled(clients_.size());
+    size_t answered = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ROUND_TIMEOUT_MS);
+
+    while (answered < config_.orders) {
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            Client& client = clients_[i];
+            uint64_t now = TscClock::instance().wall_ns();
+            for (; client.outstanding < WINDOW && quota[i] > 0; --quota[i], ++client.outstanding) {
+                // Buy then sell the same instrument at the same price: each pair crosses
+                const WarmupInstrument& instrument = instruments_[(client.sent / 2) % instruments_.size()];
+                OrderSide side = client.sent % 2 == 0 ? OrderSide::BUY : OrderSide::SELL;
+                uint64_t order_id = next_order_id_++;
+                wire::OrderBody body = wire::make_order_body(instrument.symbol, strnlen(instrument.symbol, sizeof(instrument.symbol)),
+                                                       order_id, order_id, instrument.price, 0, instrument.quantity,
+                                                       side, OrderType::LIMIT, TimeInForce::DAY);
+                size_t offset = client.outbox.size();
+                client.outbox.resize(offset + wire::MAX_FRAME_SIZE);
+                size_t length = wire::write_frame(client.outbox.data() + offset, MessageType::ORDER_NEW,
+                                                  order_id, now, ++client.sequence, &body);
+                client.outbox.resize(offset + length);
+                ++client.sent;
+            }
+            if (!flush(client)) {
+                return false;
+            }
+            polled[i] = pollfd{client.fd, static_cast<short>(POLLIN | (client.outbox.empty() ? 0 : POLLOUT)), 0};
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            std::cerr << "Warm-up round timed out with " << answered << " of " << config_.orders
+                      << " orders answered" << std::endl;
+            return false;
+        }
+        int ready = poll(polled.data(), polled.size(), static_cast<int>(left.count()));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Warm-up poll failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            if ((polled[i].revents & (POLLIN | POLLHUP | POLLERR)) && !receive(clients_[i], answered)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void WarmupDriver::close() {
+    for (Client& client : clients_) {
+        ::close(client.fd);
+    }
+    clients_.clear();
+}
+
+WarmupResult run_warmup(const WarmupConfig& config, WarmupDriver& driver,
+                        const std::function<uint64_t()>& round_p99, const std::atomic<bool>& running) {
+    WarmupResult result;
+    round_p99();   // Start the first round from a clean interval
+    uint32_t steady = 0;
+
+    while (result.rounds < config.rounds && running.load(std::memory_order_relaxed)) {
+        if (!driver.run_round()) {
+            result.failed = true;
+            break;
+        }
+        uint64_t p99 = round_p99();
+        if (result.rounds == 0) {
+            result.first_p99_ns = p99;
+        } else {
+            uint64_t previous = result.last_p99_ns;
+            uint64_t change = p99 > previous ? p99 - previous : previous - p99;
+            steady = change * 100 <= previous * config.tolerance_pct ? steady + 1 : 0;
+        }
+        result.last_p99_ns = p99;
+        ++result.rounds;
+        if (steady >= config.settle_rounds) {
+            result.settled = true;
+            break;
+        }
+    }
+    return result;
+}
+
+void print_warmup(std::ostream& out, const WarmupResult& result) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "Warm-up: ";
+    if (result.settled) {
+        out << "p99 settled at " << us(result.last_p99_ns) << " μs after " << result.rounds << " rounds";
+    } else if (result.failed) {
+        out << "stopped after " << result.rounds << " rounds, p99 " << us(result.last_p99_ns) << " μs";
+    } else {
+        out << "p99 still moving after " << result.rounds << " rounds, last " << us(result.last_p99_ns) << " μs";
+    }
+    out << " (first round " << us(result.first_p99_ns) << " μs)" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool wait_until(const std::function<bool()>& done, const std::atomic<bool>& running, uint32_t timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!done()) {
+        if (!running.load(std::memory_order_relaxed) || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace hft
@@ -0,0 +1,134 @@
+#ifndef WARMUP_H
+#define WARMUP_H
+
+#include "instrument_directory.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+namespace hft {
+
+/**
+ * @brief Synthetic order flow run through a server before its listener opens
+ *
+ * A fresh process answers its first orders slowly: cold caches and branch
+ * predictors, pages not yet faulted in, cores still at idle clocks. Warm-up
+ * sends rounds of crossing orders over loopback connections through the
+ * full decode, risk, book and encode path until the p99 of each round holds
+ * steady, so the first real client meets a hot server.
+ */
+struct WarmupConfig {
+    uint32_t rounds = 0;                 // Most rounds to run; 0 = off
+    uint32_t orders = 2000;              // Orders per round, spread over the connections
+    uint32_t settle_rounds = 3;          // Consecutive steady rounds that count as settled
+    uint32_t tolerance_pct = 10;         // A round is steady within this much of the one before
+    uint32_t prefault_connections = 64;  // Connection slots per shard whose buffers are faulted in first
+
+    bool enabled() const { return rounds > 0; }
+};
+
+/**
+ * @brief A symbol to trade during warm-up, at a price and size its instrument accepts
+ */
+struct WarmupInstrument {
+    char symbol[InstrumentDirectory::SYMBOL_SIZE];
+    uint64_t price;
+    uint32_t quantity;
+};
+
+/**
+ * @brief Up to count instruments with consecutive ids starting at the first
+ *
+ * A master's instruments are used as loaded; an open directory interns
+ * WARMUP0, WARMUP1, ..., so the servers pass a private one of their own.
+ * Consecutive ids reach every lane that partitions books by id modulo count.
+ */
+std::vector<WarmupInstrument> warmup_instruments(InstrumentDirectory& directory, uint32_t count);
+
+/**
+ * @brief Client side of the warm-up: loopback connections trading crossing pairs
+ *
+ * Each connection logs in and keeps a window of orders outstanding,
+ * alternating buys and sells at one price so every pair fills and the
+ * books end each round as empty as they started.
+ */
+class WarmupDriver {
+public:
+    WarmupDriver(const WarmupConfig& config, std::vector<WarmupInstrument> instruments);
+    ~WarmupDriver();
+
+    WarmupDriver(const WarmupDriver&) = delete;
+    WarmupDriver& operator=(const WarmupDriver&) = delete;
+
+    /**
+     * @brief Open count loopback connections; server_fds gets the accepted ends for the server to adopt
+     */
+    bool connect(size_t count, std::vector<int>& server_fds);
+
+    /**
+     * @brief Send one round of orders and wait for every ack or reject; false on timeout or a lost connection
+     */
+    bool run_round();
+
+    /**
+     * @brief Close the client ends; the server sees an ordinary disconnect
+     */
+    void close();
+
+private:
+    static constexpr uint32_t WINDOW = 32;            // Orders outstanding per connection
+    static constexpr int ROUND_TIMEOUT_MS = 5000;
+
+    struct Client {
+        int fd = -1;
+        uint32_t sequence = 0;                        // Last sequence sent
+        uint32_t outstanding = 0;
+        uint64_t sent = 0;                            // Orders sent, for side and symbol rotation
+        std::vector<uint8_t> outbox;
+        std::vector<uint8_t> inbox;
+    };
+
+    bool flush(Client& client);
+    bool receive(Client& client, size_t& answered);
+
+    WarmupConfig config_;
+    std::vector<WarmupInstrument> instruments_;
+    std::vector<Client> clients_;
+    uint64_t next_order_id_ = 1;
+};
+
+/**
+ * @brief How a warm-up went; p99 values in nanoseconds
+ */
+struct WarmupResult {
+    uint32_t rounds = 0;
+    uint64_t first_p99_ns = 0;
+    uint64_t last_p99_ns = 0;
+    bool settled = false;
+    bool failed = false;                              // A round timed out or lost a connection
+};
+
+/**
+ * @brief Run rounds until p99 settles, config.rounds is reached or running clears
+ *
+ * round_p99 returns the p99 the server recorded since it was last called.
+ */
+WarmupResult run_warmup(const WarmupConfig& config, WarmupDriver& driver,
+                        const std::function<uint64_t()>& round_p99, const std::atomic<bool>& running);
+
+/**
+ * @brief One line on whether and where p99 settled
+ */
+void print_warmup(std::ostream& out, const WarmupResult& result);
+
+/**
+ * @brief Check done every millisecond until it holds; false after timeout_ms or once running clears
+ */
+bool wait_until(const std::function<bool()>& done, const std::atomic<bool>& running, uint32_t timeout_ms);
+
+} // namespace hft
+
+#endif // WARMUP_H
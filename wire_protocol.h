@@ -0,0 +1,497 @@
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+#include "message.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace hft {
+namespace wire {
+
+/**
+ * @brief Compact binary protocol shared by both servers and test clients
+ *
+ * Every frame is a fixed 24-byte header followed by a body whose layout is
+ * determined by the header type. All integers are little-endian on the wire;
+ * on little-endian hosts the byte-order helpers compile away.
+ */
+constexpr uint8_t PROTOCOL_VERSION = 1;
+
+#pragma pack(push, 1)
+
+/**
+ * @brief Common frame header
+ */
+struct FrameHeader {
+    uint16_t length;               // Total frame length including this header
+    uint8_t type;                  // MessageType
+    uint8_t version;               // PROTOCOL_VERSION
+    uint32_t sequence;             // Sender sequence number
+    uint64_t message_id;           // Unique message identifier
+    uint64_t timestamp;            // Sender timestamp in nanoseconds
+};
+
+/**
+ * @brief Body of ORDER_NEW and ORDER_REPLACE
+ */
+struct OrderBody {
+    char symbol[16];
+    uint64_t order_id;
+    uint64_t client_order_id;
+    uint64_t price;                // Price in ticks
+    uint64_t stop_price;
+    uint32_t quantity;
+    uint8_t side;                  // OrderSide
+    uint8_t order_type;            // OrderType
+    uint8_t time_in_force;         // TimeInForce
+    uint8_t reserved;
+};
+
+/**
+ * @brief Body of ORDER_CANCEL
+ */
+struct CancelBody {
+    char symbol[16];
+    uint64_t order_id;
+};
+
+/**
+ * @brief Body of ORDER_FILL
+ */
+struct FillBody {
+    uint64_t order_id;
+    uint64_t fill_id;
+    uint64_t fill_price;
+    uint64_t commission;
+    uint32_t fill_quantity;
+    uint32_t reserved;
+    char execution_venue[16];
+};
+
+/**
+ * @brief Body of MARKET_DATA
+ */
+struct MarketDataBody {
+    char symbol[16];
+    uint64_t bid_price;
+    uint64_t ask_price;
+    uint64_t last_price;
+    uint64_t volume;
+    uint64_t high_price;
+    uint64_t low_price;
+    uint32_t bid_size;
+    uint32_t ask_size;
+    uint32_t last_size;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Body of MARKET_DATA_SUBSCRIBE and MARKET_DATA_UNSUBSCRIBE
+ */
+struct SubscriptionBody {
+    char symbol[16];
+};
+
+/**
+ * @brief Body of FEED_RETRANSMIT_REQUEST and FEED_SNAPSHOT_REQUEST
+ */
+struct RecoveryBody {
+    uint64_t start;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Leading header of every multicast feed datagram
+ *
+ * Followed by count MarketDataBody updates carrying feed sequences
+ * sequence, sequence + 1, ... A new session means the publisher restarted
+ * and sequences begin again at 1.
+ */
+struct FeedPacketHeader {
+    uint64_t sequence;             // Feed sequence of the first update
+    uint32_t session;
+    uint16_t count;
+    uint16_t reserved;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeader) == 24, "FrameHeader layout changed");
+static_assert(sizeof(OrderBody) == 56, "OrderBody layout changed");
+static_assert(sizeof(CancelBody) == 24, "CancelBody layout changed");
+static_assert(sizeof(FillBody) == 56, "FillBody layout changed");
+static_assert(sizeof(MarketDataBody) == 80, "MarketDataBody layout changed");
+static_assert(sizeof(SubscriptionBody) == 16, "SubscriptionBody layout changed");
+static_assert(sizeof(RecoveryBody) == 16, "RecoveryBody layout changed");
+static_assert(sizeof(FeedPacketHeader) == 16, "FeedPacketHeader layout changed");
+
+constexpr size_t HEADER_SIZE = sizeof(FrameHeader);
+constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + sizeof(MarketDataBody);
+
+/**
+ * @brief Convert an integer between host and wire (little-endian) byte order
+ */
+template<typename T>
+constexpr T to_wire(T value) noexcept {
+    if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        return static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    } else if constexpr (sizeof(T) == 4) {
+        return static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    } else {
+        return static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+    }
+}
+
+template<typename T>
+constexpr T from_wire(T value) noexcept {
+    return to_wire(value);
+}
+
+/**
+ * @brief Body size carried by a given message type, or -1 if the type is not valid on the wire
+ */
+constexpr int body_size(MessageType type) noexcept {
+    switch (type) {
+        case MessageType::ORDER_NEW:
+        case MessageType::ORDER_REPLACE:
+            return sizeof(OrderBody);
+        case MessageType::ORDER_CANCEL:
+            return sizeof(CancelBody);
+        case MessageType::ORDER_FILL:
+            return sizeof(FillBody);
+        case MessageType::MARKET_DATA:
+        case MessageType::FEED_UPDATE:
+            return sizeof(MarketDataBody);
+        case MessageType::FEED_RETRANSMIT_REQUEST:
+        case MessageType::FEED_SNAPSHOT_REQUEST:
+            return sizeof(RecoveryBody);
+        case MessageType::MARKET_DATA_SUBSCRIBE:
+        case MessageType::MARKET_DATA_UNSUBSCRIBE:
+            return sizeof(SubscriptionBody);
+        case MessageType::ORDER_REJECT:
+        case MessageType::ORDER_ACK:
+        case MessageType::MARKET_DATA_ACK:
+        case MessageType::HEARTBEAT:
+        case MessageType::LOGIN:
+        case MessageType::LOGOUT:
+        case MessageType::RESEND_REQUEST:
+        case MessageType::ERROR:
+            return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief First four header bytes (length, type, version) a valid frame of each type starts with
+ *
+ * Read as one little-endian word, a header is valid exactly when it equals
+ * HEADER_WORDS[type]. Entries for types that are not valid on the wire
+ * carry a different type byte, so no header can match them.
+ */
+inline constexpr std::array<uint32_t, 256> HEADER_WORDS = [] {
+    std::array<uint32_t, 256> words{};
+    for (uint32_t type = 0; type < 256; ++type) {
+        int body = body_size(static_cast<MessageType>(type));
+        words[type] = body < 0 ? (~type & 0xFF) << 16
+                               : static_cast<uint32_t>(HEADER_SIZE + body) | type << 16 |
+                                 static_cast<uint32_t>(PROTOCOL_VERSION) << 24;
+    }
+    return words;
+}();
+
+/**
+ * @brief The length, type and version bytes at the front of a header as one word
+ */
+inline uint32_t header_word(const uint8_t* frame) noexcept {
+    uint32_t word;
+    memcpy(&word, frame, sizeof(word));
+    return from_wire(word);
+}
+
+/**
+ * @brief Result of inspecting the bytes at the front of a receive buffer
+ */
+enum class FrameStatus : uint8_t {
+    COMPLETE,      // A full, well-formed frame is available
+    INCOMPLETE,    // More bytes are needed
+    MALFORMED      // Header is invalid; the stream cannot be resynchronised
+};
+
+/**
+ * @brief Validate the frame header at the front of a buffer
+ *
+ * On COMPLETE, frame_length holds the number of bytes to consume.
+ */
+inline FrameStatus peek_frame(const uint8_t* data, size_t available, size_t& frame_length) noexcept {
+    if (available < HEADER_SIZE) {
+        return FrameStatus::INCOMPLETE;
+    }
+    
+    // Type, version and the type's length in one compare
+    uint32_t word = header_word(data);
+    if (word != HEADER_WORDS[(word >> 16) & 0xFF]) {
+        return FrameStatus::MALFORMED;
+    }
+    
+    frame_length = word & 0xFFFF;
+    return available >= frame_length ? FrameStatus::COMPLETE : FrameStatus::INCOMPLETE;
+}
+
+/**
+ * @brief Message type of a frame already validated by peek_frame
+ */
+inline MessageType frame_type(const uint8_t* frame) noexcept {
+    return static_cast<MessageType>(frame[offsetof(FrameHeader, type)]);
+}
+
+/**
+ * @brief Header sequence of a frame already validated by peek_frame
+ */
+inline uint32_t frame_sequence(const uint8_t* frame) noexcept {
+    uint32_t sequence;
+    memcpy(&sequence, frame + offsetof(FrameHeader, sequence), sizeof(sequence));
+    return from_wire(sequence);
+}
+
+/**
+ * @brief Overwrite the header sequence of an encoded frame
+ */
+inline void set_frame_sequence(uint8_t* frame, uint32_t sequence) noexcept {
+    sequence = to_wire(sequence);
+    memcpy(frame + offsetof(FrameHeader, sequence), &sequence, sizeof(sequence));
+}
+
+template<typename Body>
+constexpr size_t body_bytes_v = sizeof(Body);
+
+template<>
+constexpr size_t body_bytes_v<void> = 0;
+
+/**
+ * @brief Write a header and an already byte-swapped body into out
+ *
+ * out must have room for at least MAX_FRAME_SIZE bytes.
+ */
+template<typename Body>
+inline size_t write_frame(uint8_t* out, MessageType type, uint64_t message_id,
+                          uint64_t timestamp, uint32_t sequence, const Body* body) noexcept {
+    constexpr size_t body_bytes = body_bytes_v<Body>;
+    FrameHeader header;
+    header.length = to_wire(static_cast<uint16_t>(HEADER_SIZE + body_bytes));
+    header.type = static_cast<uint8_t>(type);
+    header.version = PROTOCOL_VERSION;
+    header.sequence = to_wire(sequence);
+    header.message_id = to_wire(message_id);
+    header.timestamp = to_wire(timestamp);
+    memcpy(out, &header, HEADER_SIZE);
+    if constexpr (!std::is_void_v<Body>) {
+        memcpy(out + HEADER_SIZE, body, body_bytes);
+    }
+    return HEADER_SIZE + body_bytes;
+}
+
+/**
+ * @brief Header-only frame (acks, heartbeats, session messages)
+ */
+inline size_t encode_header_only(uint8_t* out, MessageType type, uint64_t message_id,
+                                 uint64_t timestamp, uint32_t sequence) noexcept {
+    return write_frame<void>(out, type, message_id, timestamp, sequence, nullptr);
+}
+
+inline FrameHeader read_header(const uint8_t* frame) noexcept {
+    FrameHeader header;
+    memcpy(&header, frame, HEADER_SIZE);
+    header.length = from_wire(header.length);
+    header.sequence = from_wire(header.sequence);
+    header.message_id = from_wire(header.message_id);
+    header.timestamp = from_wire(header.timestamp);
+    return header;
+}
+
+template<typename Body>
+inline Body read_body(const uint8_t* frame) noexcept {
+    Body body;
+    memcpy(&body, frame + HEADER_SIZE, sizeof(Body));
+    return body;
+}
+
+// Body builders: host values in, wire-order body out
+
+inline OrderBody make_order_body(const char* symbol, size_t symbol_len, uint64_t order_id,
+                                 uint64_t client_order_id, uint64_t price, uint64_t stop_price,
+                                 uint32_t quantity, OrderSide side, OrderType order_type,
+                                 TimeInForce time_in_force) noexcept {
+    OrderBody body{};
+    memcpy(body.symbol, symbol, symbol_len < sizeof(body.symbol) ? symbol_len : sizeof(body.symbol));
+    body.order_id = to_wire(order_id);
+    body.client_order_id = to_wire(client_order_id);
+    body.price = to_wire(price);
+    body.stop_price = to_wire(stop_price);
+    body.quantity = to_wire(quantity);
+    body.side = static_cast<uint8_t>(side);
+    body.order_type = static_cast<uint8_t>(order_type);
+    body.time_in_force = static_cast<uint8_t>(time_in_force);
+    return body;
+}
+
+inline MarketDataBody make_market_data_body(const char* symbol, size_t symbol_len,
+                                            uint64_t bid_price, uint32_t bid_size,
+                                            uint64_t ask_price, uint32_t ask_size,
+                                            uint64_t last_price, uint32_t last_size,
+                                            uint64_t volume, uint64_t high_price,
+                                            uint64_t low_price) noexcept {
+    MarketDataBody body{};
+    memcpy(body.symbol, symbol, symbol_len < sizeof(body.symbol) ? symbol_len : sizeof(body.symbol));
+    body.bid_price = to_wire(bid_price);
+    body.bid_size = to_wire(bid_size);
+    body.ask_price = to_wire(ask_price);
+    body.ask_size = to_wire(ask_size);
+    body.last_price = to_wire(last_price);
+    body.last_size = to_wire(last_size);
+    body.volume = to_wire(volume);
+    body.high_price = to_wire(high_price);
+    body.low_price = to_wire(low_price);
+    return body;
+}
+
+// Encoders for the in-memory message structs
+
+inline size_t encode(const Message& msg, uint8_t* out) noexcept {
+    return encode_header_only(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number);
+}
+
+inline size_t encode(const OrderMessage& msg, uint8_t* out) noexcept {
+    if (msg.message_type == MessageType::ORDER_CANCEL) {
+        CancelBody body{};
+        memcpy(body.symbol, msg.symbol.data(), sizeof(body.symbol));
+        body.order_id = to_wire(msg.order_id);
+        return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+    }
+    OrderBody body = make_order_body(msg.symbol.data(), msg.symbol.size(), msg.order_id,
+                                     msg.client_order_id, msg.price, msg.stop_price,
+                                     msg.quantity, msg.side, msg.order_type, msg.time_in_force);
+    return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+}
+
+inline size_t encode(const MarketDataMessage& msg, uint8_t* out) noexcept {
+    MarketDataBody body = make_market_data_body(msg.symbol.data(), msg.symbol.size(),
+                                                msg.bid_price, msg.bid_size, msg.ask_price,
+                                                msg.ask_size, msg.last_price, msg.last_size,
+                                                msg.volume, msg.high_price, msg.low_price);
+    return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+}
+
+inline size_t encode(const SubscriptionMessage& msg, uint8_t* out) noexcept {
+    SubscriptionBody body{};
+    memcpy(body.symbol, msg.symbol.data(), sizeof(body.symbol));
+    return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+}
+
+inline size_t encode(const RecoveryRequestMessage& msg, uint8_t* out) noexcept {
+    RecoveryBody body{};
+    body.start = to_wire(msg.start);
+    body.count = to_wire(msg.count);
+    return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+}
+
+/**
+ * @brief Recovered feed update: a MARKET_DATA body whose message_id is its feed sequence
+ */
+inline size_t encode_feed_update(uint8_t* out, uint64_t feed_sequence, uint64_t timestamp,
+                                 const MarketDataBody& body) noexcept {
+    return write_frame(out, MessageType::FEED_UPDATE, feed_sequence, timestamp, 0, &body);
+}
+
+inline size_t encode(const FillMessage& msg, uint8_t* out) noexcept {
+    FillBody body{};
+    body.order_id = to_wire(msg.order_id);
+    body.fill_id = to_wire(msg.fill_id);
+    body.fill_price = to_wire(msg.fill_price);
+    body.commission = to_wire(msg.commission);
+    body.fill_quantity = to_wire(msg.fill_quantity);
+    memcpy(body.execution_venue, msg.execution_venue.data(), sizeof(body.execution_venue));
+    return write_frame(out, msg.message_type, msg.message_id, msg.timestamp, msg.sequence_number, &body);
+}
+
+// Decoders for the in-memory message structs. The frame must already have
+// been validated with peek_frame.
+
+inline void decode(const uint8_t* frame, Message& msg) noexcept {
+    FrameHeader header = read_header(frame);
+    msg.message_id = header.message_id;
+    msg.timestamp = header.timestamp;
+    msg.sequence_number = header.sequence;
+    msg.message_type = static_cast<MessageType>(header.type);
+    msg.status = MessageStatus::PENDING;
+}
+
+inline void decode(const uint8_t* frame, OrderMessage& msg) noexcept {
+    decode(frame, static_cast<Message&>(msg));
+    if (msg.message_type == MessageType::ORDER_CANCEL) {
+        CancelBody body = read_body<CancelBody>(frame);
+        memcpy(msg.symbol.data(), body.symbol, sizeof(body.symbol));
+        msg.order_id = from_wire(body.order_id);
+        return;
+    }
+    OrderBody body = read_body<OrderBody>(frame);
+    memcpy(msg.symbol.data(), body.symbol, sizeof(body.symbol));
+    msg.order_id = from_wire(body.order_id);
+    msg.client_order_id = from_wire(body.client_order_id);
+    msg.price = from_wire(body.price);
+    msg.stop_price = from_wire(body.stop_price);
+    msg.quantity = from_wire(body.quantity);
+    msg.side = static_cast<OrderSide>(body.side);
+    msg.order_type = static_cast<OrderType>(body.order_type);
+    msg.time_in_force = static_cast<TimeInForce>(body.time_in_force);
+}
+
+inline void decode(const uint8_t* frame, MarketDataMessage& msg) noexcept {
+    decode(frame, static_cast<Message&>(msg));
+    MarketDataBody body = read_body<MarketDataBody>(frame);
+    memcpy(msg.symbol.data(), body.symbol, sizeof(body.symbol));
+    msg.bid_price = from_wire(body.bid_price);
+    msg.bid_size = from_wire(body.bid_size);
+    msg.ask_price = from_wire(body.ask_price);
+    msg.ask_size = from_wire(body.ask_size);
+    msg.last_price = from_wire(body.last_price);
+    msg.last_size = from_wire(body.last_size);
+    msg.volume = from_wire(body.volume);
+    msg.high_price = from_wire(body.high_price);
+    msg.low_price = from_wire(body.low_price);
+}
+
+inline void decode(const uint8_t* frame, SubscriptionMessage& msg) noexcept {
+    decode(frame, static_cast<Message&>(msg));
+    SubscriptionBody body = read_body<SubscriptionBody>(frame);
+    memcpy(msg.symbol.data(), body.symbol, sizeof(body.symbol));
+}
+
+inline void decode(const uint8_t* frame, RecoveryRequestMessage& msg) noexcept {
+    decode(frame, static_cast<Message&>(msg));
+    RecoveryBody body = read_body<RecoveryBody>(frame);
+    msg.start = from_wire(body.start);
+    msg.count = from_wire(body.count);
+}
+
+inline void decode(const uint8_t* frame, FillMessage& msg) noexcept {
+    decode(frame, static_cast<Message&>(msg));
+    FillBody body = read_body<FillBody>(frame);
+    msg.order_id = from_wire(body.order_id);
+    msg.fill_id = from_wire(body.fill_id);
+    msg.fill_price = from_wire(body.fill_price);
+    msg.commission = from_wire(body.commission);
+    msg.fill_quantity = from_wire(body.fill_quantity);
+    memcpy(msg.execution_venue.data(), body.execution_venue, sizeof(body.execution_venue));
+}
+
+} // namespace wire
+} // namespace hft
+
+#endif // WIRE_PROTOCOL_H